@@ -505,82 +505,103 @@ abf_input_inline (vlib_main_t * vm,
 		  vlib_node_runtime_t * node,
 		  vlib_frame_t * frame, fib_protocol_t fproto)
 {
-  u32 n_left_from, *from, *to_next, next_index, matches, misses;
+  vlib_buffer_t *bufs[VLIB_FRAME_SIZE], **b;
+  u16 nexts[VLIB_FRAME_SIZE], *next;
+  u32 n_left, *from, matches, misses;
+  int is_ip6 = (FIB_PROTOCOL_IP6 == fproto);
 
   from = vlib_frame_vector_args (frame);
-  n_left_from = frame->n_vectors;
-  next_index = node->cached_next_index;
+  n_left = frame->n_vectors;
+  vlib_get_buffers (vm, from, bufs, n_left);
+  b = bufs;
+  next = nexts;
   matches = misses = 0;
 
-  while (n_left_from > 0)
+  /*
+   * The packets are classified four at a time so that the ACL lookups
+   * of the four can overlap their memory accesses.
+   */
+  while (n_left > 0)
     {
-      u32 n_left_to_next;
+      fa_5tuple_opaque_t fa_5tuple[4];
+      u32 lc_index[4], match_acl_index[4], match_acl_pos[4];
+      u32 match_rule_index[4];
+      u32 trace_bitmap = 0;
+      int is_match[4];
+      u8 action[4];
+      u32 i, n;
 
-      vlib_get_next_frame (vm, node, next_index, to_next, n_left_to_next);
+      n = clib_min (n_left, 4);
 
-      while (n_left_from > 0 && n_left_to_next > 0)
+      if (n_left >= 8)
 	{
-	  const u32 *attachments0;
-	  const abf_itf_attach_t *aia0;
-	  abf_next_t next0 = ABF_NEXT_DROP;
-	  vlib_buffer_t *b0;
-	  u32 bi0, sw_if_index0;
-	  fa_5tuple_opaque_t fa_5tuple0;
-	  u32 match_acl_index = ~0;
-	  u32 match_acl_pos = ~0;
-	  u32 match_rule_index = ~0;
-	  u32 trace_bitmap = 0;
-	  u32 lc_index;
-	  u8 action;
-
-	  bi0 = from[0];
-	  to_next[0] = bi0;
-	  from += 1;
-	  to_next += 1;
-	  n_left_from -= 1;
-	  n_left_to_next -= 1;
-
-	  b0 = vlib_get_buffer (vm, bi0);
-	  sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX];
+	  for (i = 4; i < 8; i++)
+	    {
+	      vlib_prefetch_buffer_header (b[i], LOAD);
+	      CLIB_PREFETCH (vlib_buffer_get_current (b[i]),
+			     CLIB_CACHE_LINE_BYTES, LOAD);
+	    }
+	}
 
-	  ASSERT (vec_len (abf_per_itf[fproto]) > sw_if_index0);
-	  attachments0 = abf_per_itf[fproto][sw_if_index0];
+      for (i = 0; i < n; i++)
+	{
+	  u32 sw_if_index0 = vnet_buffer (b[i])->sw_if_index[VLIB_RX];
 
 	  ASSERT (vec_len (abf_alctx_per_itf[fproto]) > sw_if_index0);
 	  /*
 	   * check if any of the policies attached to this interface matches.
 	   */
-	  lc_index = abf_alctx_per_itf[fproto][sw_if_index0];
+	  lc_index[i] = abf_alctx_per_itf[fproto][sw_if_index0];
 
 	  /*
 	     A non-inline version looks like this:
 
-	     acl_plugin.fill_5tuple (lc_index, b0, (FIB_PROTOCOL_IP6 == fproto),
-	     1, 0, &fa_5tuple0);
-	     if (acl_plugin.match_5tuple
-	     (lc_index, &fa_5tuple0, (FIB_PROTOCOL_IP6 == fproto), &action,
-	     &match_acl_pos, &match_acl_index, &match_rule_index,
-	     &trace_bitmap))
+	     acl_plugin.fill_5tuple (lc_index[i], b[i], is_ip6,
+	     1, 0, &fa_5tuple[i]);
+	     ...
+	     acl_plugin.match_5tuple_xN
+	     (n, lc_index, fa_5tuple, is_ip6, is_match, action,
+	     match_acl_pos, match_acl_index, match_rule_index,
+	     &trace_bitmap);
 	     . . .
 	   */
-	  acl_plugin_fill_5tuple_inline (acl_plugin.p_acl_main, lc_index, b0,
-					 (FIB_PROTOCOL_IP6 == fproto), 1, 0,
-					 &fa_5tuple0);
-
-	  if (acl_plugin_match_5tuple_inline (
-		acl_plugin.p_acl_main, lc_index, &fa_5tuple0,
-		(FIB_PROTOCOL_IP6 == fproto), &action, &match_acl_pos,
-		&match_acl_index, &match_rule_index, &trace_bitmap) &&
-	      action > 0)
+	  acl_plugin_fill_5tuple_inline (acl_plugin.p_acl_main, lc_index[i],
+					 b[i], is_ip6, 1, 0, &fa_5tuple[i]);
+	}
+
+      if (PREDICT_TRUE (n == 4))
+	acl_plugin_match_5tuple_inline_x4 (acl_plugin.p_acl_main, lc_index,
+					   fa_5tuple, is_ip6, is_match,
+					   action, match_acl_pos,
+					   match_acl_index, match_rule_index,
+					   &trace_bitmap);
+      else
+	acl_plugin_match_5tuple_inline_xN (acl_plugin.p_acl_main, n,
+					   lc_index, fa_5tuple, is_ip6,
+					   is_match, action, match_acl_pos,
+					   match_acl_index, match_rule_index,
+					   &trace_bitmap);
+
+      for (i = 0; i < n; i++)
+	{
+	  const u32 *attachments0;
+	  const abf_itf_attach_t *aia0;
+	  u32 sw_if_index0, next0;
+
+	  sw_if_index0 = vnet_buffer (b[i])->sw_if_index[VLIB_RX];
+	  ASSERT (vec_len (abf_per_itf[fproto]) > sw_if_index0);
+	  attachments0 = abf_per_itf[fproto][sw_if_index0];
+
+	  if (is_match[i] && action[i] > 0)
 	    {
 	      /*
 	       * match:
 	       *  follow the DPO chain
 	       */
-	      aia0 = abf_itf_attach_get (attachments0[match_acl_pos]);
+	      aia0 = abf_itf_attach_get (attachments0[match_acl_pos[i]]);
 
 	      next0 = aia0->aia_dpo.dpoi_next_node;
-	      vnet_buffer (b0)->ip.adj_index[VLIB_TX] =
+	      vnet_buffer (b[i])->ip.adj_index[VLIB_TX] =
 		aia0->aia_dpo.dpoi_index;
 	      matches++;
 	    }
@@ -590,28 +611,29 @@ abf_input_inline (vlib_main_t * vm,
 	       * miss:
 	       *  move on down the feature arc
 	       */
-	      vnet_feature_next (&next0, b0);
+	      vnet_feature_next (&next0, b[i]);
 	      misses++;
 	    }
 
-	  if (PREDICT_FALSE (b0->flags & VLIB_BUFFER_IS_TRACED))
+	  if (PREDICT_FALSE (b[i]->flags & VLIB_BUFFER_IS_TRACED))
 	    {
 	      abf_input_trace_t *tr;
 
-	      tr = vlib_add_trace (vm, node, b0, sizeof (*tr));
+	      tr = vlib_add_trace (vm, node, b[i], sizeof (*tr));
 	      tr->next = next0;
-	      tr->index = vnet_buffer (b0)->ip.adj_index[VLIB_TX];
+	      tr->index = vnet_buffer (b[i])->ip.adj_index[VLIB_TX];
 	    }
 
-	  /* verify speculative enqueue, maybe switch current next frame */
-	  vlib_validate_buffer_enqueue_x1 (vm, node, next_index,
-					   to_next, n_left_to_next, bi0,
-					   next0);
+	  next[i] = next0;
 	}
 
-      vlib_put_next_frame (vm, node, next_index, n_left_to_next);
+      b += n;
+      next += n;
+      n_left -= n;
     }
 
+  vlib_buffer_enqueue_to_next (vm, node, from, nexts, frame->n_vectors);
+
   vlib_node_increment_counter (vm,
 			       (fproto = FIB_PROTOCOL_IP6 ?
 				abf_ip4_node.index :
@@ -39,6 +39,8 @@
 
 #include "fa_node.h"
 #include "public_inlines.h"
+#include "hash_lookup.h"
+#include "session_inlines.h"
 
 acl_main_t acl_main;
 
@@ -322,6 +324,8 @@ acl_add_list (u32 count, vl_api_acl_rule_t rules[],
   acl_list_t *a;
   acl_rule_t *r;
   acl_rule_t *acl_new_rules = 0;
+  acl_rule_t *old_rules = 0;
+  int is_replace = 0;
   size_t tag_len;
   int i;
 
@@ -403,9 +407,9 @@ acl_add_list (u32 count, vl_api_acl_rule_t rules[],
   else
     {
       a = am->acls + *acl_list_index;
-      /* Get rid of the old rules */
-      if (a->rules)
-	vec_free (a->rules);
+      /* Keep the old rules to update the lookups by the difference */
+      old_rules = a->rules;
+      is_replace = 1;
     }
   a->rules = acl_new_rules;
   memcpy (a->tag, tag, tag_len + 1);
@@ -417,7 +421,14 @@ acl_add_list (u32 count, vl_api_acl_rule_t rules[],
       policy_notify_acl_change (am, *acl_list_index);
     }
   validate_and_reset_acl_counters (am, *acl_list_index);
-  acl_plugin_lookup_context_notify_acl_change (*acl_list_index);
+  if (is_replace)
+    {
+      acl_plugin_lookup_context_notify_acl_replace (*acl_list_index,
+						    old_rules);
+      vec_free (old_rules);
+    }
+  else
+    acl_plugin_lookup_context_notify_acl_change (*acl_list_index);
   return 0;
 }
 
@@ -2564,6 +2575,7 @@ acl_set_aclplugin_fn (vlib_main_t * vm,
   u32 timeout = 0;
   u32 val = 0;
   u32 eh_val = 0;
+  u32 lc_index = 0;
   uword memory_size = 0;
   acl_main_t *am = &acl_main;
 
@@ -2580,6 +2592,30 @@ acl_set_aclplugin_fn (vlib_main_t * vm,
       am->use_hash_acl_matching = (val != 0);
       goto done;
     }
+  if (unformat (input, "use-compiled-lookup %u", &val))
+    {
+      acl_lookup_context_t *acontext;
+
+      am->use_compiled_lookup = (val != 0);
+      /* *INDENT-OFF* */
+      pool_foreach (acontext, am->acl_lookup_contexts)
+       {
+        acl_ct_set_lookup_context (am, acontext - am->acl_lookup_contexts,
+                                   val);
+      }
+      /* *INDENT-ON* */
+      goto done;
+    }
+  if (unformat (input, "compiled-lookup lc_index %u %u", &lc_index, &val))
+    {
+      if (pool_is_free_index (am->acl_lookup_contexts, lc_index))
+	{
+	  error = clib_error_return (0, "no lookup context %u", lc_index);
+	  goto done;
+	}
+      acl_ct_set_lookup_context (am, lc_index, val);
+      goto done;
+    }
   if (unformat (input, "l4-match-nonfirst-fragment %u", &val))
     {
       am->l4_match_nonfirst_fragment = (val != 0);
@@ -2675,6 +2711,25 @@ acl_set_aclplugin_fn (vlib_main_t * vm,
 		  goto done;
 		}
 	    }
+	  if (unformat (input, "per-worker"))
+	    {
+	      /* the tables can not be moved once the sessions exist */
+	      if (am->fa_sessions_hash_is_initialized)
+		error = clib_error_return (0,
+					   "session tables are already allocated");
+	      else if (unformat (input, "handoff"))
+		am->fa_session_tables =
+		  ACL_FA_SESSION_TABLES_PER_WORKER_HANDOFF;
+	      else if (unformat (input, "rss"))
+		am->fa_session_tables = ACL_FA_SESSION_TABLES_PER_WORKER_RSS;
+	      else if (unformat (input, "off"))
+		am->fa_session_tables = ACL_FA_SESSION_TABLES_SHARED;
+	      else
+		error = clib_error_return (0,
+					   "expecting handoff, rss or off, got `%U`",
+					   format_unformat_error, input);
+	      goto done;
+	    }
 	  if (unformat (input, "event-trace"))
 	    {
 	      if (!unformat (input, "%u", &val))
@@ -3325,13 +3380,23 @@ acl_plugin_show_sessions (acl_main_t * am,
       acl_fa_per_worker_data_t *pw = &am->per_worker_data[wk];
       vlib_cli_output (vm, "Thread #%d:", wk);
       if (show_session_thread_id == wk
-	  && show_session_session_index < pool_len (pw->fa_sessions_pool))
+	  && show_session_session_index < acl_fa_session_pool_len (am, pw))
 	{
 	  vlib_cli_output (vm, "  session index %u:",
 			   show_session_session_index);
 	  fa_session_t *sess =
-	    pw->fa_sessions_pool + show_session_session_index;
-	  u64 *m = (u64 *) & sess->info;
+	    get_session_ptr_no_check (am, wk, show_session_session_index);
+	  clib_bihash_kv_40_8_t kv = { 0 };
+	  u64 *m = (u64 *) & kv;
+	  if (sess->is_ip6)
+	    acl_fa_session_get_kv_40_8 (sess, &kv);
+	  else
+	    {
+	      /* the IPv4 addresses are in the fourth u64 of a 5-tuple */
+	      kv.key[3] = sess->l3_key_tail;
+	      kv.key[4] = sess->l4.as_u64;
+	      kv.value = sess->value;
+	    }
 	  vlib_cli_output (vm,
 			   "    info: %016llx %016llx %016llx %016llx %016llx %016llx",
 			   m[0], m[1], m[2], m[3], m[4], m[5]);
@@ -3348,6 +3413,7 @@ acl_plugin_show_sessions (acl_main_t * am,
 	  vlib_cli_output (vm, "    link prev index: %u",
 			   sess->link_prev_idx);
 	  vlib_cli_output (vm, "    link list id: %u", sess->link_list_id);
+	  vlib_cli_output (vm, "    timer handle: %u", sess->timer_handle);
 	}
       vlib_cli_output (vm, "  connection add/del stats:", wk);
       /* *INDENT-OFF* */
@@ -3386,7 +3452,8 @@ acl_plugin_show_sessions (acl_main_t * am,
 			   head_session_index);
 	  if (~0 != head_session_index)
 	    {
-	      fa_session_t *sess = pw->fa_sessions_pool + head_session_index;
+	      fa_session_t *sess =
+		get_session_ptr_no_check (am, wk, head_session_index);
 	      vlib_cli_output (vm, "    last active time: %lu",
 			       sess->last_active_time);
 	      vlib_cli_output (vm, "    link enqueue time: %lu",
@@ -3440,6 +3507,20 @@ acl_plugin_show_sessions (acl_main_t * am,
 		   ((f64) am->fa_current_cleaner_timer_wait_interval) *
 		   1000.0 / (f64) vm->clib_time.clocks_per_second);
   vlib_cli_output (vm, "Reclassify sessions: %d", am->reclassify_sessions);
+  vlib_cli_output (vm, "Session tables: %s",
+		   am->fa_session_tables ==
+		   ACL_FA_SESSION_TABLES_PER_WORKER_HANDOFF ?
+		   "per-worker, handoff to owner" :
+		   am->fa_session_tables ==
+		   ACL_FA_SESSION_TABLES_PER_WORKER_RSS ?
+		   "per-worker, symmetric rss" : "shared");
+  vlib_cli_output (vm, "Session aging: %s",
+		   am->fa_use_session_timer_wheel ?
+		   "timer wheel, no TCP transient session recycling" :
+		   "timeout lists");
+  vlib_cli_output (vm, "Session layout: %s",
+		   am->fa_use_compact_sessions ?
+		   "compact, IPv4 only" : "full");
 }
 
 static clib_error_t *
@@ -3477,6 +3558,7 @@ acl_show_aclplugin_tables_fn (vlib_main_t * vm,
   int show_mask_type = 0;
   int show_bihash = 0;
   u32 show_bihash_verbose = 0;
+  int show_compiled = 0;
 
   if (unformat (input, "acl"))
     {
@@ -3499,16 +3581,22 @@ acl_show_aclplugin_tables_fn (vlib_main_t * vm,
       show_bihash = 1;
       unformat (input, "verbose %u", &show_bihash_verbose);
     }
+  else if (unformat (input, "compiled"))
+    {
+      show_compiled = 1;
+      unformat (input, "lc_index %u", &lc_index);
+    }
 
   if (!
       (show_mask_type || show_acl_hash_info || show_applied_info
-       || show_bihash))
+       || show_bihash || show_compiled))
     {
       /* if no qualifiers specified, show all */
       show_mask_type = 1;
       show_acl_hash_info = 1;
       show_applied_info = 1;
       show_bihash = 1;
+      show_compiled = 1;
     }
   vlib_cli_output (vm, "Stats counters enabled for interface ACLs: %d",
 		   acl_main.interface_acl_counters_enabled);
@@ -3522,10 +3610,276 @@ acl_show_aclplugin_tables_fn (vlib_main_t * vm,
     acl_plugin_show_tables_applied_info (lc_index);
   if (show_bihash)
     acl_plugin_show_tables_bihash (show_bihash_verbose);
+  if (show_compiled)
+    acl_plugin_show_tables_compiled (lc_index);
 
   return error;
 }
 
+/* a random address, within the prefix three times out of four */
+static void
+acl_test_random_addr (u32 * seed, int is_ip6, ip46_address_t * prefix,
+		      int prefixlen, ip46_address_t * addr)
+{
+  u32 *pfx = is_ip6 ? prefix->ip6.as_u32 : &prefix->ip4.as_u32;
+  u32 *a = is_ip6 ? addr->ip6.as_u32 : &addr->ip4.as_u32;
+  int i, bits;
+  u32 mask;
+
+  if (0 == (random_u32 (seed) & 3))
+    prefixlen = 0;
+  for (i = 0; i < (is_ip6 ? 4 : 1); i++)
+    {
+      bits = clib_max (0, clib_min (32, prefixlen - 32 * i));
+      mask = bits ? clib_host_to_net_u32 (~0 << (32 - bits)) : 0;
+      a[i] = (pfx[i] & mask) | (random_u32 (seed) & ~mask);
+    }
+}
+
+static u16
+acl_test_random_port (u32 * seed, u16 first, u16 last)
+{
+  if (0 == (random_u32 (seed) & 3) || first > last)
+    return random_u32 (seed);
+  return first + random_u32 (seed) % ((u32) last - first + 1);
+}
+
+/* a tuple near the rule, that it may or may not match */
+static void
+acl_test_random_5tuple (u32 * seed, acl_rule_t * r, fa_5tuple_t * t)
+{
+  static const u8 protos[] = { IP_PROTOCOL_TCP, IP_PROTOCOL_UDP,
+    IP_PROTOCOL_ICMP, IP_PROTOCOL_ICMP6, IP_PROTOCOL_GRE
+  };
+  ip46_address_t addr;
+  u8 proto;
+  int i;
+
+  clib_memset (t, 0, sizeof (*t));
+  for (i = 0; i < 2; i++)
+    {
+      acl_test_random_addr (seed, r->is_ipv6, i ? &r->dst : &r->src,
+			    i ? r->dst_prefixlen : r->src_prefixlen, &addr);
+      if (r->is_ipv6)
+	t->ip6_addr[i] = addr.ip6;
+      else
+	t->ip4_addr[i] = addr.ip4;
+    }
+
+  proto = r->proto;
+  if (0 == proto || 0 == (random_u32 (seed) & 3))
+    proto = protos[random_u32 (seed) % ARRAY_LEN (protos)];
+  t->l4.proto = proto;
+  t->pkt.is_ip6 = r->is_ipv6;
+  t->pkt.mask_type_index_lsb = ~0;
+
+  /* non-first fragments have no L4 information */
+  if (0 == (random_u32 (seed) & 3))
+    {
+      t->pkt.is_nonfirst_fragment = 1;
+      return;
+    }
+  t->pkt.l4_valid = 1;
+  t->l4.port[0] = acl_test_random_port (seed, r->src_port_or_type_first,
+					r->src_port_or_type_last);
+  t->l4.port[1] = acl_test_random_port (seed, r->dst_port_or_code_first,
+					r->dst_port_or_code_last);
+  if (IP_PROTOCOL_TCP == proto)
+    {
+      t->pkt.tcp_flags = random_u32 (seed);
+      t->pkt.tcp_flags_valid = 1;
+    }
+  else if (IP_PROTOCOL_UDP != proto)
+    t->l4.l4_flags = FA_SK_L4_FLAG_IS_SLOWPATH;
+}
+
+typedef struct
+{
+  int *is_match;
+  u8 *action;
+  u32 *acl_pos;
+  u32 *acl_match;
+  u32 *rule_match;
+} acl_test_match_results_t;
+
+static void
+acl_test_match_results_validate (acl_test_match_results_t * r, u32 n)
+{
+  vec_validate (r->is_match, n);
+  vec_validate (r->action, n);
+  vec_validate (r->acl_pos, n);
+  vec_validate (r->acl_match, n);
+  vec_validate (r->rule_match, n);
+}
+
+static void
+acl_test_match_results_free (acl_test_match_results_t * r)
+{
+  vec_free (r->is_match);
+  vec_free (r->action);
+  vec_free (r->acl_pos);
+  vec_free (r->acl_match);
+  vec_free (r->rule_match);
+}
+
+/* the results of the batched match that differ from the single ones */
+static u32
+acl_test_match_results_compare (vlib_main_t * vm, const char *what,
+				acl_test_match_results_t * expected,
+				acl_test_match_results_t * got,
+				fa_5tuple_t * tuples, u32 n)
+{
+  u32 i, n_mismatch = 0;
+
+  for (i = 0; i < n; i++)
+    {
+      if (expected->is_match[i] == got->is_match[i] &&
+	  (!expected->is_match[i] ||
+	   (expected->action[i] == got->action[i] &&
+	    expected->acl_pos[i] == got->acl_pos[i] &&
+	    expected->acl_match[i] == got->acl_match[i] &&
+	    expected->rule_match[i] == got->rule_match[i])))
+	continue;
+      if (n_mismatch++ < 8)
+	vlib_cli_output (vm, "%s mismatch on tuple %u: %U: "
+			 "match %d acl %u rule %u, expected %d acl %u rule %u",
+			 what, i, format_acl_plugin_5tuple, &tuples[i],
+			 got->is_match[i], got->acl_match[i],
+			 got->rule_match[i], expected->is_match[i],
+			 expected->acl_match[i], expected->rule_match[i]);
+    }
+  return n_mismatch;
+}
+
+/*
+ * Check that matching tuples in batches, acl_plugin_match_5tuple_inline_x4
+ * and _xN, gives the same results as matching them one at a time. The
+ * tuples are drawn near the rules of the ACLs of the given lookup contexts,
+ * some of them non-first fragments.
+ */
+static clib_error_t *
+acl_test_match_batch_fn (vlib_main_t * vm,
+			 unformat_input_t * input, vlib_cli_command_t * cmd)
+{
+  acl_main_t *am = &acl_main;
+  acl_test_match_results_t expected = { }, got = { };
+  u32 *lc_indices = 0, *lcs = 0, lc_index;
+  u32 count = 1000, seed = 0xdeadbeef;
+  u32 i, n, n_matched, n_mismatch, trace_bitmap = 0;
+  acl_lookup_context_t *acontext;
+  fa_5tuple_t *tuples = 0, *t;
+  clib_error_t *error = 0;
+  acl_list_t *acl;
+  acl_rule_t *r;
+  int is_ip6;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "lc_index %u", &lc_index))
+	{
+	  if (pool_is_free_index (am->acl_lookup_contexts, lc_index))
+	    {
+	      error = clib_error_return (0, "no lookup context %u", lc_index);
+	      goto done;
+	    }
+	  vec_add1 (lc_indices, lc_index);
+	}
+      else if (unformat (input, "count %u", &count))
+	;
+      else if (unformat (input, "seed %u", &seed))
+	;
+      else
+	{
+	  error = clib_error_return (0, "unknown input `%U'",
+				     format_unformat_error, input);
+	  goto done;
+	}
+    }
+  if (!vec_len (lc_indices))
+    {
+      error = clib_error_return (0, "expecting lc_index");
+      goto done;
+    }
+
+  for (is_ip6 = 0; is_ip6 <= 1; is_ip6++)
+    {
+      vec_reset_length (tuples);
+      vec_reset_length (lcs);
+      for (i = 0; i < count; i++)
+	{
+	  lc_index = lc_indices[random_u32 (&seed) % vec_len (lc_indices)];
+	  acontext = pool_elt_at_index (am->acl_lookup_contexts, lc_index);
+	  if (!vec_len (acontext->acl_indices))
+	    continue;
+	  acl = am->acls + acontext->acl_indices[random_u32 (&seed) %
+						 vec_len
+						 (acontext->acl_indices)];
+	  if (!vec_len (acl->rules))
+	    continue;
+	  r = acl->rules + random_u32 (&seed) % vec_len (acl->rules);
+	  if (r->is_ipv6 != is_ip6)
+	    continue;
+	  vec_add2 (tuples, t, 1);
+	  acl_test_random_5tuple (&seed, r, t);
+	  vec_add1 (lcs, lc_index);
+	}
+      n = vec_len (tuples);
+      if (!n)
+	continue;
+      acl_test_match_results_validate (&expected, n);
+      acl_test_match_results_validate (&got, n);
+
+      for (i = n_matched = 0; i < n; i++)
+	n_matched += expected.is_match[i] =
+	  acl_plugin_match_5tuple_inline (am, lcs[i],
+					  (fa_5tuple_opaque_t *) & tuples[i],
+					  is_ip6, &expected.action[i],
+					  &expected.acl_pos[i],
+					  &expected.acl_match[i],
+					  &expected.rule_match[i],
+					  &trace_bitmap);
+
+      /* four at a time, then the rest */
+      for (i = 0; i + 4 <= n; i += 4)
+	acl_plugin_match_5tuple_inline_x4 (am, lcs + i,
+					   (fa_5tuple_opaque_t *) (tuples +
+								   i),
+					   is_ip6, got.is_match + i,
+					   got.action + i, got.acl_pos + i,
+					   got.acl_match + i,
+					   got.rule_match + i, &trace_bitmap);
+      acl_plugin_match_5tuple_inline_xN (am, n - i, lcs + i,
+					 (fa_5tuple_opaque_t *) (tuples + i),
+					 is_ip6, got.is_match + i,
+					 got.action + i, got.acl_pos + i,
+					 got.acl_match + i, got.rule_match + i,
+					 &trace_bitmap);
+      n_mismatch =
+	acl_test_match_results_compare (vm, "x4", &expected, &got, tuples, n);
+
+      /* all of them at once */
+      clib_memset (got.is_match, 0xff, n * sizeof (got.is_match[0]));
+      acl_plugin_match_5tuple_inline_xN (am, n, lcs,
+					 (fa_5tuple_opaque_t *) tuples,
+					 is_ip6, got.is_match, got.action,
+					 got.acl_pos, got.acl_match,
+					 got.rule_match, &trace_bitmap);
+      n_mismatch +=
+	acl_test_match_results_compare (vm, "xN", &expected, &got, tuples, n);
+
+      vlib_cli_output (vm, "%s: %u tuples, %u matched, %u mismatches",
+		       is_ip6 ? "ip6" : "ip4", n, n_matched, n_mismatch);
+    }
+
+done:
+  acl_test_match_results_free (&expected);
+  acl_test_match_results_free (&got);
+  vec_free (lc_indices);
+  vec_free (lcs);
+  vec_free (tuples);
+  return error;
+}
+
 static clib_error_t *
 acl_clear_aclplugin_fn (vlib_main_t * vm,
 			unformat_input_t * input, vlib_cli_command_t * cmd)
@@ -3588,7 +3942,7 @@ VLIB_CLI_COMMAND (aclplugin_show_sessions_command, static) = {
 
 VLIB_CLI_COMMAND (aclplugin_show_tables_command, static) = {
     .path = "show acl-plugin tables",
-    .short_help = "show acl-plugin tables [ acl [index N] | applied [ lc_index N ] | mask | hash [verbose N] ]",
+    .short_help = "show acl-plugin tables [ acl [index N] | applied [ lc_index N ] | mask | hash [verbose N] | compiled [ lc_index N ] ]",
     .function = acl_show_aclplugin_tables_fn,
 };
 
@@ -3604,6 +3958,12 @@ VLIB_CLI_COMMAND (aclplugin_show_macip_interface_command, static) = {
     .function = acl_show_aclplugin_macip_interface_fn,
 };
 
+VLIB_CLI_COMMAND (aclplugin_test_match_batch_command, static) = {
+    .path = "test acl-plugin match-batch",
+    .short_help = "test acl-plugin match-batch lc_index N [lc_index N ...] [count N] [seed N]",
+    .function = acl_test_match_batch_fn,
+};
+
 VLIB_CLI_COMMAND (aclplugin_clear_command, static) = {
     .path = "clear acl-plugin sessions",
     .short_help = "clear acl-plugin sessions",
@@ -3682,6 +4042,9 @@ acl_plugin_config (vlib_main_t * vm, unformat_input_t * input)
   u32 reclassify_sessions;
   u32 use_tuple_merge;
   u32 tuple_merge_split_threshold;
+  u32 use_compiled_lookup;
+  u32 use_session_timer_wheel;
+  u32 use_compact_sessions;
 
   while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
     {
@@ -3696,6 +4059,16 @@ acl_plugin_config (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "connection count max %d",
 			 &conn_table_max_entries))
 	am->fa_conn_table_max_entries = conn_table_max_entries;
+      else if (unformat (input, "per-worker sessions handoff"))
+	am->fa_session_tables = ACL_FA_SESSION_TABLES_PER_WORKER_HANDOFF;
+      else if (unformat (input, "per-worker sessions rss"))
+	am->fa_session_tables = ACL_FA_SESSION_TABLES_PER_WORKER_RSS;
+      else if (unformat (input, "use session timer wheel %d",
+			 &use_session_timer_wheel))
+	am->fa_use_session_timer_wheel = use_session_timer_wheel;
+      else if (unformat (input, "use compact sessions %d",
+			 &use_compact_sessions))
+	am->fa_use_compact_sessions = use_compact_sessions;
       else
 	if (unformat
 	    (input, "main heap size %U", unformat_memory_size,
@@ -3719,6 +4092,9 @@ acl_plugin_config (vlib_main_t * vm, unformat_input_t * input)
 	am->hash_lookup_hash_memory = hash_lookup_hash_memory;
       else if (unformat (input, "use tuple merge %d", &use_tuple_merge))
 	am->use_tuple_merge = use_tuple_merge;
+      else if (unformat (input, "use compiled lookup %d",
+			 &use_compiled_lookup))
+	am->use_compiled_lookup = use_compiled_lookup;
       else
 	if (unformat
 	    (input, "tuple merge split threshold %d",
@@ -3805,6 +4181,7 @@ acl_init (vlib_main_t * vm)
 				 FA_SESSION_BOGUS_INDEX);
 	vec_validate_init_empty (pw->fa_conn_list_head_expiry_time,
 				 ACL_N_TIMEOUTS - 1, ~0ULL);
+	pw->next_expiry_time = ~0ULL;
       }
   }
 
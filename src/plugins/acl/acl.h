@@ -42,6 +42,7 @@
 #define TCP_SESSION_TRANSIENT_TIMEOUT_SEC 120
 
 #define SESSION_PURGATORY_TIMEOUT_USEC 10
+#define SESSION_TIMER_WHEEL_TICK_SEC 0.1
 
 #define ACL_PLUGIN_HASH_LOOKUP_HASH_BUCKETS 65536
 #define ACL_PLUGIN_HASH_LOOKUP_HASH_MEMORY (2 << 25)
@@ -189,6 +190,17 @@ typedef struct {
   /* vec of vectors of all info of all mask types present in ACEs contained in each lc_index */
   hash_applied_mask_info_t **hash_applied_mask_info_vec_by_lc_index;
 
+  /* Do new lookup contexts use the compiled classifier */
+  int use_compiled_lookup;
+
+  /* compiled classifier per lc_index, NULL until (re)built */
+  acl_ct_t **compiled_lookup_by_lc_index;
+
+  /* lc_index-es with the compiled classifier waiting to be built */
+  uword *compiled_lookup_pending_bitmap;
+  u64 compiled_lookup_n_builds;
+  u64 compiled_lookup_n_failed;
+
   /*
    * Classify tables used to grab the packets for the ACL check,
    * and serving as the 5-tuple session tables at the same time
@@ -222,6 +234,16 @@ typedef struct {
   int fa_sessions_hash_is_initialized;
   clib_bihash_40_8_t fa_ip6_sessions_hash;
   clib_bihash_16_8_t fa_ip4_sessions_hash;
+  /* acl_fa_session_tables_t, fixed once the tables are allocated */
+  u8 fa_session_tables;
+  /* per-node frame queues to hand off packets to the session owner */
+  u32 *fa_handoff_fq_index_by_node_index;
+  /* age the sessions by a per-worker timer wheel rather than the lists */
+  u8 fa_use_session_timer_wheel;
+  /* the timer wheel tick, in CPU clocks */
+  u64 fa_session_timer_tick_clocks;
+  /* keep the sessions in one cache line each, IPv4 only */
+  u8 fa_use_compact_sessions;
   /* The process node which orchestrates the cleanup */
   u32 fa_cleaner_node_index;
   /* FA session timeouts, in seconds */
@@ -0,0 +1,622 @@
+/*
+ *------------------------------------------------------------------
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *------------------------------------------------------------------
+ */
+
+/*
+ * Compiled classifier
+ *
+ * A HiCuts [1] style decision tree built from the applied ACEs of
+ * a lookup context. Every node cuts its region of the (src, dst,
+ * proto, sport, dport) space along the dimension which best separates
+ * the rules, until the rules left in a region are few enough to match
+ * linearly. A rule which alone decides the match and covers the whole
+ * region hides the rules after it, so those are not copied into the
+ * region's subtree.
+ *
+ * The tree is built by a process node, while the workers keep
+ * matching with the hash tables, then published with a single store.
+ * Any change to the applied ACEs drops it with the workers held.
+ *
+ * [1] Pankaj Gupta, Nick McKeown "Packet Classification using
+ * Hierarchical Intelligent Cuttings", Hot Interconnects VII, 1999
+ */
+
+#include <vlib/vlib.h>
+#include <vnet/vnet.h>
+#include <acl/acl.h>
+
+#include "hash_lookup.h"
+
+/* rules in a leaf, unless the depth is exhausted first */
+#define ACL_CT_LEAF_SIZE 8
+#define ACL_CT_MAX_DEPTH 12
+#define ACL_CT_MAX_CUTS_LOG2 6
+/* a node's children hold at most this many times its rules */
+#define ACL_CT_SPACE_FACTOR 4
+/*
+ * Abandon the tree if it replicates the rules, or grows the nodes,
+ * more than this per applied entry, past a floor for small rulesets.
+ */
+#define ACL_CT_MAX_REPLICATION 64
+#define ACL_CT_MAX_NODES 1024
+#define ACL_CT_MIN_LIMIT (1 << 16)
+
+/* The extent of a rule in each dimension */
+typedef struct {
+  u32 lo[ACL_CT_N_DIM];
+  u32 hi[ACL_CT_N_DIM];
+  /* set if matching the box is matching the rule */
+  u8 is_exact;
+  u8 is_valid;
+} acl_ct_box_t;
+
+/* A node's region, aligned to its size in each dimension */
+typedef struct {
+  u32 base[ACL_CT_N_DIM];
+  u8 width_log2[ACL_CT_N_DIM];
+} acl_ct_region_t;
+
+typedef struct {
+  acl_ct_t *ct;
+  /* per applied entry */
+  acl_rule_t *rules;
+  acl_ct_box_t *boxes;
+  u32 max_rules;
+  u32 max_nodes;
+  int failed;
+} acl_ct_build_t;
+
+static const u8 acl_ct_dim_width_log2[ACL_CT_N_DIM] = {
+  [ACL_CT_DIM_SRC] = 32,
+  [ACL_CT_DIM_DST] = 32,
+  [ACL_CT_DIM_PROTO] = 8,
+  [ACL_CT_DIM_SPORT] = 16,
+  [ACL_CT_DIM_DPORT] = 16,
+};
+
+vlib_node_registration_t acl_ct_process_node;
+
+static u32
+acl_ct_region_hi (acl_ct_region_t *rg, int d)
+{
+  return (rg->base[d] + pow2_mask (rg->width_log2[d]));
+}
+
+/*
+ * Only the bits that fa_acl_match_ip4_addr/fa_acl_match_ip6_addr
+ * compare in full bound the box, so it holds every address matched.
+ * For IPv6 those are the bits in the 32 bit word the tree cuts.
+ */
+static int
+acl_ct_addr_range (acl_rule_t *r, ip46_address_t *a, u8 plen, u8 word,
+                   u32 *lo, u32 *hi)
+{
+  u32 addr, mask;
+  int is_exact, bits;
+
+  if (r->is_ipv6)
+    {
+      is_exact = (0 == plen) ||
+        ((0 == word) && (plen % 8 == 0) && (plen <= 32));
+      bits = clib_min (clib_max ((int) (plen & ~7) - 32 * word, 0), 32);
+      addr = clib_net_to_host_u32 (a->ip6.as_u32[word]);
+    }
+  else
+    {
+      bits = clib_min (plen, 32);
+      addr = clib_net_to_host_u32 (a->ip4.as_u32);
+      is_exact = 1;
+    }
+  mask = bits ? (u32) (~0 << (32 - bits)) : 0;
+  if (!r->is_ipv6 && (addr & ~mask))
+    /* host bits set: matches nothing, so hides nothing */
+    is_exact = 0;
+
+  *lo = addr & mask;
+  *hi = *lo | ~mask;
+  return (is_exact);
+}
+
+static void
+acl_ct_make_box (acl_ct_t *ct, acl_rule_t *r, acl_ct_box_t *box)
+{
+  int src_exact, dst_exact;
+
+  src_exact = acl_ct_addr_range (r, &r->src, r->src_prefixlen,
+                                 ct->ip6_word[0],
+                                 &box->lo[ACL_CT_DIM_SRC],
+                                 &box->hi[ACL_CT_DIM_SRC]);
+  dst_exact = acl_ct_addr_range (r, &r->dst, r->dst_prefixlen,
+                                 ct->ip6_word[1],
+                                 &box->lo[ACL_CT_DIM_DST],
+                                 &box->hi[ACL_CT_DIM_DST]);
+  if (r->proto)
+    {
+      box->lo[ACL_CT_DIM_PROTO] = box->hi[ACL_CT_DIM_PROTO] = r->proto;
+      box->lo[ACL_CT_DIM_SPORT] = r->src_port_or_type_first;
+      box->hi[ACL_CT_DIM_SPORT] = r->src_port_or_type_last;
+      box->lo[ACL_CT_DIM_DPORT] = r->dst_port_or_code_first;
+      box->hi[ACL_CT_DIM_DPORT] = r->dst_port_or_code_last;
+    }
+  else
+    {
+      box->lo[ACL_CT_DIM_PROTO] = 0;
+      box->hi[ACL_CT_DIM_PROTO] = 0xff;
+      box->lo[ACL_CT_DIM_SPORT] = box->lo[ACL_CT_DIM_DPORT] = 0;
+      box->hi[ACL_CT_DIM_SPORT] = box->hi[ACL_CT_DIM_DPORT] = 0xffff;
+    }
+  box->is_valid = (box->lo[ACL_CT_DIM_SPORT] <= box->hi[ACL_CT_DIM_SPORT]
+                   && box->lo[ACL_CT_DIM_DPORT] <= box->hi[ACL_CT_DIM_DPORT]);
+  /*
+   * With a protocol the L4 validity and the TCP flags matter too,
+   * which the box does not capture.
+   */
+  box->is_exact = src_exact && dst_exact && (0 == r->proto);
+}
+
+static int
+acl_ct_u64_cmp (void *a1, void *a2)
+{
+  u64 *v1 = a1, *v2 = a2;
+
+  return (*v1 > *v2) - (*v1 < *v2);
+}
+
+/*
+ * IPv6 prefixes often share the most significant word, so cut the
+ * word of the source or destination in which the rules differ most.
+ */
+static u8
+acl_ct_pick_ip6_word (acl_rule_t *rules, int is_dst)
+{
+  u32 lo, hi, n_distinct, best_n_distinct = 0;
+  u8 word, best_word = 0;
+  acl_rule_t *r;
+  u64 *v = 0;
+  int i;
+
+  for (word = 0; word < 4; word++)
+    {
+      vec_reset_length (v);
+      vec_foreach (r, rules)
+      {
+        if (!r->is_ipv6)
+          continue;
+        if (is_dst)
+          acl_ct_addr_range (r, &r->dst, r->dst_prefixlen, word, &lo, &hi);
+        else
+          acl_ct_addr_range (r, &r->src, r->src_prefixlen, word, &lo, &hi);
+        vec_add1 (v, ((u64) lo << 32) | hi);
+      }
+      vec_sort_with_function (v, acl_ct_u64_cmp);
+
+      n_distinct = 0;
+      for (i = 0; i < vec_len (v); i++)
+        if (0 == i || v[i] != v[i - 1])
+          n_distinct++;
+      if (n_distinct > best_n_distinct)
+        {
+          best_n_distinct = n_distinct;
+          best_word = word;
+        }
+    }
+  vec_free (v);
+
+  return (best_word);
+}
+
+static int
+acl_ct_box_covers (acl_ct_box_t *box, acl_ct_region_t *rg, int d)
+{
+  return (box->lo[d] <= rg->base[d] && box->hi[d] >= acl_ct_region_hi (rg, d));
+}
+
+static void
+acl_ct_make_leaf (acl_ct_build_t *b, u32 node_index, u32 *rules, u32 depth)
+{
+  acl_ct_t *ct = b->ct;
+  acl_ct_node_t *node = vec_elt_at_index (ct->nodes, node_index);
+  acl_ct_rule_t *r;
+  u32 *ri;
+
+  node->dim = ACL_CT_LEAF;
+  node->index = vec_len (ct->rules);
+  node->n_rules = vec_len (rules);
+
+  vec_foreach (ri, rules)
+  {
+    vec_add2 (ct->rules, r, 1);
+    r->rule = b->rules[*ri];
+    r->applied_entry_index = *ri;
+  }
+
+  ct->n_leaves++;
+  ct->max_depth = clib_max (ct->max_depth, depth);
+  ct->max_leaf_rules = clib_max (ct->max_leaf_rules, vec_len (rules));
+  if (vec_len (ct->rules) > b->max_rules)
+    b->failed = 1;
+}
+
+/*
+ * Count the rules each of the 2^k children along d would get.
+ * Returns the largest count, and the total in *sum.
+ */
+static u32
+acl_ct_count_cuts (acl_ct_build_t *b, u32 *rules, acl_ct_region_t *rg,
+                   int d, u32 k, u32 *counts, u32 *sum)
+{
+  u32 shift = rg->width_log2[d] - k;
+  u32 hi = acl_ct_region_hi (rg, d);
+  u32 *ri, c, first, last, max = 0;
+
+  clib_memset (counts, 0, sizeof (counts[0]) << k);
+  *sum = 0;
+
+  vec_foreach (ri, rules)
+  {
+    acl_ct_box_t *box = &b->boxes[*ri];
+
+    first = (clib_max (box->lo[d], rg->base[d]) - rg->base[d]) >> shift;
+    last = (clib_min (box->hi[d], hi) - rg->base[d]) >> shift;
+    for (c = first; c <= last; c++)
+      counts[c]++;
+    *sum += last - first + 1;
+  }
+  for (c = 0; c < (1 << k); c++)
+    max = clib_max (max, counts[c]);
+
+  return (max);
+}
+
+static void
+acl_ct_build_node (acl_ct_build_t *b, u32 node_index, u32 *rules,
+                   acl_ct_region_t *rg, u32 depth)
+{
+  u32 counts[1 << ACL_CT_MAX_CUTS_LOG2];
+  u32 best_max = ~0, best_sum = ~0, best_k = 0;
+  u32 k, max, sum, n_rules, first, c, shift;
+  u32 *child = 0, *prev_child = 0, *ri;
+  int d, best_d = -1, prev_covers = 0;
+  acl_ct_region_t crg;
+  acl_ct_node_t *node;
+
+  /* drop the rules hidden behind one matching all of the region */
+  vec_foreach (ri, rules)
+  {
+    acl_ct_box_t *box = &b->boxes[*ri];
+
+    if (!box->is_exact)
+      continue;
+    for (d = 0; d < ACL_CT_N_DIM; d++)
+      if (!acl_ct_box_covers (box, rg, d))
+        break;
+    if (d == ACL_CT_N_DIM)
+      {
+        vec_set_len (rules, ri - rules + 1);
+        break;
+      }
+  }
+
+  n_rules = vec_len (rules);
+  if (n_rules <= ACL_CT_LEAF_SIZE || depth >= ACL_CT_MAX_DEPTH)
+    {
+      acl_ct_make_leaf (b, node_index, rules, depth);
+      return;
+    }
+
+  /*
+   * Cut along the dimension giving the smallest largest child, as
+   * finely as the space factor allows.
+   */
+  for (d = 0; d < ACL_CT_N_DIM; d++)
+    {
+      u32 d_max = ~0, d_sum = ~0, d_k = 0;
+
+      for (k = 1; k <= clib_min (ACL_CT_MAX_CUTS_LOG2, rg->width_log2[d]);
+           k++)
+        {
+          max = acl_ct_count_cuts (b, rules, rg, d, k, counts, &sum);
+          if (k > 1 && sum + (1 << k) > ACL_CT_SPACE_FACTOR * n_rules)
+            break;
+          d_max = max;
+          d_sum = sum;
+          d_k = k;
+        }
+      if (0 == d_k)
+        continue;
+      /* a cut which gives every child all the rules achieves nothing */
+      if (d_sum == n_rules << d_k)
+        continue;
+      if (d_max < best_max || (d_max == best_max && d_sum < best_sum))
+        {
+          best_max = d_max;
+          best_sum = d_sum;
+          best_k = d_k;
+          best_d = d;
+        }
+    }
+
+  if (best_d < 0)
+    {
+      acl_ct_make_leaf (b, node_index, rules, depth);
+      return;
+    }
+
+  first = vec_len (b->ct->nodes);
+  vec_validate (b->ct->nodes, first + (1 << best_k) - 1);
+  if (vec_len (b->ct->nodes) > b->max_nodes)
+    {
+      b->failed = 1;
+      return;
+    }
+
+  shift = rg->width_log2[best_d] - best_k;
+  node = vec_elt_at_index (b->ct->nodes, node_index);
+  node->dim = best_d;
+  node->shift = shift;
+  node->n_cuts_log2 = best_k;
+  node->index = first;
+
+  for (c = 0; c < (1 << best_k); c++)
+    {
+      int covers = 1;
+
+      crg = *rg;
+      crg.base[best_d] += c << shift;
+      crg.width_log2[best_d] = shift;
+
+      vec_reset_length (child);
+      vec_foreach (ri, rules)
+      {
+        acl_ct_box_t *box = &b->boxes[*ri];
+
+        if (box->hi[best_d] < crg.base[best_d] ||
+            box->lo[best_d] > acl_ct_region_hi (&crg, best_d))
+          continue;
+        vec_add1 (child, *ri);
+        covers &= acl_ct_box_covers (box, &crg, best_d);
+      }
+
+      /*
+       * Siblings with the same rules, all spanning both, match the
+       * same way, so can share the subtree.
+       */
+      if (c > 0 && covers && prev_covers && vec_is_equal (child, prev_child))
+        {
+          b->ct->nodes[first + c] = b->ct->nodes[first + c - 1];
+          continue;
+        }
+
+      acl_ct_build_node (b, first + c, child, &crg, depth + 1);
+      if (b->failed)
+        break;
+
+      prev_covers = covers;
+      vec_reset_length (prev_child);
+      vec_append (prev_child, child);
+    }
+
+  vec_free (child);
+  vec_free (prev_child);
+}
+
+static void
+acl_ct_free (acl_ct_t *ct)
+{
+  if (!ct)
+    return;
+  vec_free (ct->nodes);
+  vec_free (ct->rules);
+  clib_mem_free (ct);
+}
+
+static acl_ct_t *
+acl_ct_build (acl_main_t *am, u32 lc_index)
+{
+  applied_hash_ace_entry_t *aces, *pae;
+  acl_ct_build_t b = { 0 };
+  acl_ct_region_t rg;
+  f64 start = vlib_time_now (am->vlib_main);
+  u32 *rules = 0, i;
+  int is_ip6, d;
+
+  if (lc_index >= vec_len (am->hash_entry_vec_by_lc_index))
+    return (NULL);
+  aces = am->hash_entry_vec_by_lc_index[lc_index];
+  if (0 == vec_len (aces))
+    return (NULL);
+
+  b.ct = clib_mem_alloc (sizeof (*b.ct));
+  clib_memset (b.ct, 0, sizeof (*b.ct));
+  b.ct->n_applied = vec_len (aces);
+  b.max_rules =
+    clib_max (ACL_CT_MAX_REPLICATION * vec_len (aces), ACL_CT_MIN_LIMIT);
+  b.max_nodes = clib_max (ACL_CT_MAX_NODES * vec_len (aces), ACL_CT_MIN_LIMIT);
+
+  vec_validate (b.rules, vec_len (aces) - 1);
+  vec_validate (b.boxes, vec_len (aces) - 1);
+  vec_foreach (pae, aces)
+  {
+    b.rules[pae - aces] = am->acls[pae->acl_index].rules[pae->ace_index];
+  }
+  b.ct->ip6_word[0] = acl_ct_pick_ip6_word (b.rules, 0);
+  b.ct->ip6_word[1] = acl_ct_pick_ip6_word (b.rules, 1);
+  for (i = 0; i < vec_len (aces); i++)
+    acl_ct_make_box (b.ct, &b.rules[i], &b.boxes[i]);
+
+  for (is_ip6 = 0; is_ip6 < 2 && !b.failed; is_ip6++)
+    {
+      vec_reset_length (rules);
+      for (i = 0; i < vec_len (aces); i++)
+        if (b.rules[i].is_ipv6 == is_ip6 && b.boxes[i].is_valid)
+          vec_add1 (rules, i);
+
+      for (d = 0; d < ACL_CT_N_DIM; d++)
+        {
+          rg.base[d] = 0;
+          rg.width_log2[d] = acl_ct_dim_width_log2[d];
+        }
+
+      b.ct->root[is_ip6] = vec_len (b.ct->nodes);
+      vec_validate (b.ct->nodes, b.ct->root[is_ip6]);
+      acl_ct_build_node (&b, b.ct->root[is_ip6], rules, &rg, 0);
+    }
+
+  vec_free (rules);
+  vec_free (b.rules);
+  vec_free (b.boxes);
+
+  if (b.failed)
+    {
+      acl_ct_free (b.ct);
+      return (NULL);
+    }
+  b.ct->build_time = vlib_time_now (am->vlib_main) - start;
+  return (b.ct);
+}
+
+void
+acl_ct_invalidate (acl_main_t *am, u32 lc_index)
+{
+  acl_lookup_context_t *acontext;
+  acl_ct_t *ct;
+
+  vec_validate (am->compiled_lookup_by_lc_index, lc_index);
+  ct = am->compiled_lookup_by_lc_index[lc_index];
+  am->compiled_lookup_by_lc_index[lc_index] = NULL;
+  /* the workers are held, so none is walking it */
+  acl_ct_free (ct);
+
+  if (pool_is_free_index (am->acl_lookup_contexts, lc_index))
+    return;
+  acontext = pool_elt_at_index (am->acl_lookup_contexts, lc_index);
+  if (!acontext->use_compiled_lookup)
+    return;
+
+  am->compiled_lookup_pending_bitmap =
+    clib_bitmap_set (am->compiled_lookup_pending_bitmap, lc_index, 1);
+  vlib_process_signal_event (am->vlib_main, acl_ct_process_node.index, 0, 0);
+}
+
+void
+acl_ct_set_lookup_context (acl_main_t *am, u32 lc_index, int enable)
+{
+  acl_lookup_context_t *acontext =
+    pool_elt_at_index (am->acl_lookup_contexts, lc_index);
+
+  acontext->use_compiled_lookup = (enable != 0);
+  acl_ct_invalidate (am, lc_index);
+}
+
+static uword
+acl_ct_process (vlib_main_t *vm, vlib_node_runtime_t *rt, vlib_frame_t *f)
+{
+  acl_main_t *am = &acl_main;
+  acl_lookup_context_t *acontext;
+  acl_ct_t *ct;
+  uword lc_index;
+
+  while (1)
+    {
+      vlib_process_wait_for_event (vm);
+      vlib_process_get_events (vm, NULL);
+
+      /*
+       * Nothing changes the applied ACEs while a tree is being built,
+       * so what is built is current when published.
+       */
+      while (~0 != (lc_index = clib_bitmap_first_set (
+                      am->compiled_lookup_pending_bitmap)))
+        {
+          am->compiled_lookup_pending_bitmap =
+            clib_bitmap_set (am->compiled_lookup_pending_bitmap, lc_index, 0);
+
+          if (pool_is_free_index (am->acl_lookup_contexts, lc_index))
+            continue;
+          acontext = pool_elt_at_index (am->acl_lookup_contexts, lc_index);
+          if (!acontext->use_compiled_lookup ||
+              am->compiled_lookup_by_lc_index[lc_index])
+            continue;
+
+          ct = acl_ct_build (am, lc_index);
+          if (ct)
+            {
+              clib_atomic_store_rel_n (
+                &am->compiled_lookup_by_lc_index[lc_index], ct);
+              am->compiled_lookup_n_builds++;
+            }
+          else if (vec_len (am->hash_entry_vec_by_lc_index) > lc_index &&
+                   vec_len (am->hash_entry_vec_by_lc_index[lc_index]))
+            am->compiled_lookup_n_failed++;
+
+          vlib_process_suspend (vm, 1e-4);
+        }
+    }
+
+  /* not reached */
+  return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (acl_ct_process_node) = {
+  .function = acl_ct_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "acl-plugin-compiled-lookup",
+};
+/* *INDENT-ON* */
+
+void
+acl_plugin_show_tables_compiled (u32 lc_index)
+{
+  acl_main_t *am = &acl_main;
+  vlib_main_t *vm = am->vlib_main;
+  acl_lookup_context_t *acontext;
+  acl_ct_t *ct;
+  u32 lci;
+
+  vlib_cli_output (vm, "Compiled lookup: default %d, %lld built, %lld failed",
+                   am->use_compiled_lookup, am->compiled_lookup_n_builds,
+                   am->compiled_lookup_n_failed);
+
+  /* *INDENT-OFF* */
+  pool_foreach (acontext, am->acl_lookup_contexts)
+   {
+    lci = acontext - am->acl_lookup_contexts;
+    if ((lc_index != ~0) && (lc_index != lci))
+      continue;
+    if (!acontext->use_compiled_lookup)
+      continue;
+
+    ct = (lci < vec_len (am->compiled_lookup_by_lc_index)) ?
+      am->compiled_lookup_by_lc_index[lci] : NULL;
+    if (!ct)
+      {
+        vlib_cli_output (vm, "lc_index %d: not built%s", lci,
+                         clib_bitmap_get (am->compiled_lookup_pending_bitmap,
+                                          lci) ? " (pending)" : "");
+        continue;
+      }
+    vlib_cli_output (vm, "lc_index %d: %d applied entries, %d nodes, "
+                     "%d leaves, %d leaf rules, depth %d, largest leaf %d, "
+                     "%U, built in %.3fms",
+                     lci, ct->n_applied, vec_len (ct->nodes), ct->n_leaves,
+                     vec_len (ct->rules), ct->max_depth, ct->max_leaf_rules,
+                     format_memory_size,
+                     vec_mem_size (ct->nodes) + vec_mem_size (ct->rules),
+                     ct->build_time * 1e3);
+  }
+  /* *INDENT-ON* */
+}
@@ -53,6 +53,9 @@ _(ACL_EXIST_SESSION, "existing session packets") \
 _(ACL_CHECK, "checked packets") \
 _(ACL_RESTART_SESSION_TIMER, "restart session timer") \
 _(ACL_TOO_MANY_SESSIONS, "too many sessions to add new") \
+_(ACL_NO_IP6_SESSIONS, "no IPv6 sessions in compact mode") \
+_(ACL_HANDOFF, "packets handed off to the session owner") \
+_(ACL_HANDOFF_CONGESTION_DROP, "session owner handoff congestion drops") \
 /* end  of errors */
 
 typedef enum
@@ -176,7 +179,8 @@ prefetch_session_entry (acl_main_t * am, fa_full_session_id_t f_sess_id)
 {
   fa_session_t *sess = get_session_ptr_no_check (am, f_sess_id.thread_index,
 						 f_sess_id.session_index);
-  CLIB_PREFETCH (sess, sizeof (*sess), STORE);
+  /* the dataplane only needs the first cache line of the session */
+  CLIB_PREFETCH (sess, sizeof (fa_session_compact_t), STORE);
 }
 
 always_inline u8
@@ -227,14 +231,69 @@ process_established_session (vlib_main_t * vm, acl_main_t * am,
 
 }
 
+/*
+ * With per-worker session tables, pass the packets of the flows owned
+ * by another worker over to it, and keep the rest compacted in the
+ * per-worker arrays. Returns the number of packets to process here.
+ */
+always_inline u32
+acl_fa_handoff_to_session_owner (vlib_main_t * vm,
+				 vlib_node_runtime_t * node,
+				 acl_fa_per_worker_data_t * pw, u32 * from,
+				 u32 n_vectors, int is_ip6)
+{
+  acl_main_t *am = &acl_main;
+  u32 n_workers = vlib_num_workers ();
+  u32 i, n_local = 0, n_handoff = 0, n_enq;
+  u32 fq_index;
+
+  for (i = 0; i < n_vectors; i++)
+    {
+      u16 owner = acl_fa_session_owner_thread (is_ip6, &pw->fa_5tuples[i],
+					       n_workers);
+      if (owner == vm->thread_index)
+	{
+	  pw->local_bis[n_local] = from[i];
+	  pw->bufs[n_local] = pw->bufs[i];
+	  pw->sw_if_indices[n_local] = pw->sw_if_indices[i];
+	  pw->fa_5tuples[n_local] = pw->fa_5tuples[i];
+	  pw->hashes[n_local] = pw->hashes[i];
+	  n_local++;
+	}
+      else
+	{
+	  pw->handoff_bis[n_handoff] = from[i];
+	  pw->handoff_threads[n_handoff] = owner;
+	  n_handoff++;
+	}
+    }
+
+  if (n_handoff)
+    {
+      fq_index = am->fa_handoff_fq_index_by_node_index[node->node_index];
+      n_enq = vlib_buffer_enqueue_to_thread (vm, node, fq_index,
+					     pw->handoff_bis,
+					     pw->handoff_threads, n_handoff,
+					     1 /* drop on congestion */ );
+      vlib_node_increment_counter (vm, node->node_index,
+				   ACL_FA_ERROR_ACL_HANDOFF, n_enq);
+      if (n_enq < n_handoff)
+	vlib_node_increment_counter (vm, node->node_index,
+				     ACL_FA_ERROR_ACL_HANDOFF_CONGESTION_DROP,
+				     n_handoff - n_enq);
+    }
+  return n_local;
+}
+
 #define ACL_PLUGIN_VECTOR_SIZE 4
 #define ACL_PLUGIN_PREFETCH_GAP 3
 
-always_inline void
+always_inline u32
 acl_fa_node_common_prepare_fn (vlib_main_t * vm,
 			       vlib_node_runtime_t * node,
 			       vlib_frame_t * frame, int is_ip6, int is_input,
-			       int is_l2_path, int with_stateful_datapath)
+			       int is_l2_path, int with_stateful_datapath,
+			       int with_handoff)
 	/* , int node_trace_on,
 	   int reclassify_sessions) */
 {
@@ -316,12 +375,17 @@ acl_fa_node_common_prepare_fn (vlib_main_t * vm,
       sw_if_index += vec_sz;
       hash += vec_sz;
     }
+
+  if (with_handoff)
+    return acl_fa_handoff_to_session_owner (vm, node, pw, from,
+					    frame->n_vectors, is_ip6);
+  return frame->n_vectors;
 }
 
 
 always_inline uword
 acl_fa_inner_node_fn (vlib_main_t * vm,
-		      vlib_node_runtime_t * node, vlib_frame_t * frame,
+		      vlib_node_runtime_t * node, u32 n_vectors,
 		      int is_ip6, int is_input, int is_l2_path,
 		      int with_stateful_datapath, int node_trace_on,
 		      int reclassify_sessions)
@@ -375,7 +439,7 @@ acl_fa_inner_node_fn (vlib_main_t * vm,
     acl_fa_find_session_with_hash (am, is_ip6, sw_if_index[0], hash[0],
 				   &fa_5tuple[0], &f_sess_id_next.as_u64);
 
-  n_left = frame->n_vectors;
+  n_left = n_vectors;
   while (n_left > 0)
     {
       u8 action = 0;
@@ -505,7 +569,14 @@ acl_fa_inner_node_fn (vlib_main_t * vm,
 	      if (1 == action)
 		pkts_acl_permit++;
 
-	      if (2 == action)
+	      if (2 == action && is_ip6 && am->fa_use_compact_sessions)
+		{
+		  /* the compact sessions have no room for IPv6 addresses */
+		  action = 0;
+		  b[0]->error =
+		    error_node->errors[ACL_FA_ERROR_ACL_NO_IP6_SESSIONS];
+		}
+	      else if (2 == action)
 		{
 		  if (!acl_fa_can_add_session (am, is_input, sw_if_index[0]))
 		    acl_fa_try_recycle_session (am, is_input,
@@ -589,7 +660,7 @@ acl_fa_inner_node_fn (vlib_main_t * vm,
 				   saved_packet_count, saved_byte_count);
 
   vlib_node_increment_counter (vm, node->node_index,
-			       ACL_FA_ERROR_ACL_CHECK, frame->n_vectors);
+			       ACL_FA_ERROR_ACL_CHECK, n_vectors);
   vlib_node_increment_counter (vm, node->node_index,
 			       ACL_FA_ERROR_ACL_EXIST_SESSION,
 			       pkts_exist_session);
@@ -598,45 +669,55 @@ acl_fa_inner_node_fn (vlib_main_t * vm,
 			       pkts_new_session);
   vlib_node_increment_counter (vm, node->node_index,
 			       ACL_FA_ERROR_ACL_PERMIT, pkts_acl_permit);
-  return frame->n_vectors;
+  return n_vectors;
 }
 
 always_inline uword
 acl_fa_outer_node_fn (vlib_main_t * vm,
 		      vlib_node_runtime_t * node, vlib_frame_t * frame,
 		      int is_ip6, int is_input, int is_l2_path,
-		      int do_stateful_datapath)
+		      int do_stateful_datapath, int do_handoff)
 {
   acl_main_t *am = &acl_main;
+  u32 n;
 
-  acl_fa_node_common_prepare_fn (vm, node, frame, is_ip6, is_input,
-				 is_l2_path, do_stateful_datapath);
+  n = acl_fa_node_common_prepare_fn (vm, node, frame, is_ip6, is_input,
+				     is_l2_path, do_stateful_datapath,
+				     do_handoff);
 
   if (am->reclassify_sessions)
     {
       if (PREDICT_FALSE (node->flags & VLIB_NODE_FLAG_TRACE))
-	return acl_fa_inner_node_fn (vm, node, frame, is_ip6, is_input,
+	return acl_fa_inner_node_fn (vm, node, n, is_ip6, is_input,
 				     is_l2_path, do_stateful_datapath,
 				     1 /* trace */ ,
 				     1 /* reclassify */ );
       else
-	return acl_fa_inner_node_fn (vm, node, frame, is_ip6, is_input,
+	return acl_fa_inner_node_fn (vm, node, n, is_ip6, is_input,
 				     is_l2_path, do_stateful_datapath, 0,
 				     1 /* reclassify */ );
     }
   else
     {
       if (PREDICT_FALSE (node->flags & VLIB_NODE_FLAG_TRACE))
-	return acl_fa_inner_node_fn (vm, node, frame, is_ip6, is_input,
+	return acl_fa_inner_node_fn (vm, node, n, is_ip6, is_input,
 				     is_l2_path, do_stateful_datapath,
 				     1 /* trace */ ,
 				     0);
       else
-	return acl_fa_inner_node_fn (vm, node, frame, is_ip6, is_input,
+	return acl_fa_inner_node_fn (vm, node, n, is_ip6, is_input,
 				     is_l2_path, do_stateful_datapath, 0, 0);
     }
 }
 
+always_inline int
+acl_fa_node_does_handoff (acl_main_t * am, u32 node_index)
+{
+  return (am->fa_session_tables == ACL_FA_SESSION_TABLES_PER_WORKER_HANDOFF
+	  && node_index < vec_len (am->fa_handoff_fq_index_by_node_index)
+	  && am->fa_handoff_fq_index_by_node_index[node_index] != ~0);
+}
+
 always_inline uword
 acl_fa_node_fn (vlib_main_t * vm,
 		vlib_node_runtime_t * node, vlib_frame_t * frame, int is_ip6,
@@ -645,18 +726,25 @@ acl_fa_node_fn (vlib_main_t * vm,
   /* select the reclassify/no-reclassify version of the datapath */
   acl_main_t *am = &acl_main;
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[vm->thread_index];
-  uword rv;
+  u32 *from = vlib_frame_vector_args (frame);
+  uword n;
 
-  if (am->fa_sessions_hash_is_initialized)
-    rv = acl_fa_outer_node_fn (vm, node, frame, is_ip6, is_input,
-			       is_l2_path, 1);
+  if (!am->fa_sessions_hash_is_initialized)
+    n = acl_fa_outer_node_fn (vm, node, frame, is_ip6, is_input,
+			      is_l2_path, 0, 0);
+  else if (acl_fa_node_does_handoff (am, node->node_index))
+    {
+      n = acl_fa_outer_node_fn (vm, node, frame, is_ip6, is_input,
+				is_l2_path, 1, 1);
+      /* only the packets owned by this worker are left */
+      from = pw->local_bis;
+    }
   else
-    rv = acl_fa_outer_node_fn (vm, node, frame, is_ip6, is_input,
-			       is_l2_path, 0);
+    n = acl_fa_outer_node_fn (vm, node, frame, is_ip6, is_input,
+			      is_l2_path, 1, 0);
 
-  vlib_buffer_enqueue_to_next (vm, node, vlib_frame_vector_args (frame),
-			       pw->nexts, frame->n_vectors);
-  return rv;
+  vlib_buffer_enqueue_to_next (vm, node, from, pw->nexts, n);
+  return frame->n_vectors;
 }
 
 
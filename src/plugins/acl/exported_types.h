@@ -74,6 +74,22 @@ typedef int (*acl_plugin_match_5tuple_fn_t) (u32 lc_index,
                                            u32 * r_rule_match_p,
                                            u32 * trace_bitmap);
 
+/*
+ * Match n_tuples tuples at once, overlapping the memory accesses
+ * of the individual lookups. lc_index, pkt_5tuple and the r_ results
+ * have n_tuples elements; trace_bitmap is a single bitmap for the batch.
+ */
+
+typedef void (*acl_plugin_match_5tuple_xN_fn_t) (u32 n_tuples,
+                                           u32 * lc_index,
+                                           fa_5tuple_opaque_t * pkt_5tuple,
+                                           int is_ip6, int * r_is_match,
+                                           u8 * r_action,
+                                           u32 * r_acl_pos_p,
+                                           u32 * r_acl_match_p,
+                                           u32 * r_rule_match_p,
+                                           u32 * trace_bitmap);
+
 
 #define foreach_acl_plugin_exported_method_name \
 _(acl_exists)                          \
@@ -82,7 +98,8 @@ _(get_lookup_context_index)            \
 _(put_lookup_context_index)            \
 _(set_acl_vec_for_context)             \
 _(fill_5tuple)                         \
-_(match_5tuple)                        
+_(match_5tuple)                        \
+_(match_5tuple_xN)
 
 #define _(name) acl_plugin_ ## name ## _fn_t name;
 typedef struct {
@@ -4,6 +4,7 @@
 #include <stddef.h>
 #include <vppinfra/bihash_16_8.h>
 #include <vppinfra/bihash_40_8.h>
+#include <vppinfra/tw_timer_1t_3w_1024sl_ov.h>
 
 #include <plugins/acl/exported_types.h>
 
@@ -103,24 +104,49 @@ format_fa_session_l4_key(u8 * s, va_list * args)
 }
 
 typedef struct {
-  fa_5tuple_t info; /* (5+1)*8 = 48 bytes */
-  u64 last_active_time;   /* +8 bytes = 56 */
-  u32 sw_if_index;        /* +4 bytes = 60 */
+  /*
+   * The first cache line has all there is to an IPv4 session, and all
+   * the dataplane and the aging need to look at for an IPv6 one.
+   */
+  union {
+    /* the key and value of an IPv4 session in the 16_8 table */
+    clib_bihash_kv_16_8_t kv_16_8;
+    struct {
+      /* IPv4 addresses, or the last 8 bytes of the IPv6 ones */
+      u64 l3_key_tail;
+      fa_session_l4_key_t l4;
+      /* the session id, as the value in the session tables */
+      u64 value;
+    };
+  };                      /* 3*8 bytes = 24 */
+  u64 last_active_time;   /* +8 bytes = 32 */
+  u32 sw_if_index;        /* +4 bytes = 36 */
   union {
     u8 as_u8[2];
     u16 as_u16;
-  } tcp_flags_seen; ;     /* +2 bytes = 62 */
-  u16 thread_index;          /* +2 bytes = 64 */
-  u64 link_enqueue_time;  /* 8 byte = 8 */
-  u32 link_prev_idx;      /* +4 bytes = 12 */
-  u32 link_next_idx;      /* +4 bytes = 16 */
-  u8 link_list_id;        /* +1 bytes = 17 */
-  u8 deleted;             /* +1 bytes = 18 */
-  u8 is_ip6;              /* +1 bytes = 19 */
-  u8 reserved1[5];        /* +5 bytes = 24 */
+  } tcp_flags_seen; ;     /* +2 bytes = 38 */
+  u16 thread_index;       /* +2 bytes = 40 */
+  u64 link_enqueue_time;  /* +8 bytes = 48 */
+  u32 link_prev_idx;      /* +4 bytes = 52 */
+  u32 link_next_idx;      /* +4 bytes = 56 */
+  u8 link_list_id;        /* +1 bytes = 57 */
+  u8 deleted;             /* +1 bytes = 58 */
+  u8 is_ip6;              /* +1 bytes = 59 */
+  u8 reserved1[1];        /* +1 bytes = 60 */
+  u32 timer_handle;       /* +4 bytes = 64 */
+  /* The second cache line is not there in the compact layout */
+  u64 ip6_key_head[3];    /* 3*8 bytes = 24 */
   u64 reserved2[5];       /* +5*8 bytes = 64 */
 } fa_session_t;
 
+/*
+ * The element of the session pools with the compact layout, which only
+ * has the first cache line of fa_session_t and no room for IPv6 keys.
+ */
+typedef struct {
+  u64 as_u64[8];
+} fa_session_compact_t;
+
 #define FA_POLICY_EPOCH_MASK 0x7fff
 /* input policy epochs have the MSB set */
 #define FA_POLICY_EPOCH_IS_INPUT 0x8000
@@ -156,6 +182,11 @@ CT_ASSERT_EQUAL(fa_ip4_and_ip6_kv_value_match, offsetof(fa_5tuple_t, kv_16_8.val
 
 /* Let's try to fit within two cachelines */
 CT_ASSERT_EQUAL(fa_session_t_size_is_128, sizeof(fa_session_t), 128);
+/* ... and have the compact layout fit within one */
+CT_ASSERT_EQUAL(fa_session_compact_t_size_is_64, sizeof(fa_session_compact_t), 64);
+CT_ASSERT_EQUAL(fa_session_compact_part_is_64, offsetof(fa_session_t, ip6_key_head), sizeof(fa_session_compact_t));
+CT_ASSERT_EQUAL(fa_session_kv_16_8_at_key, offsetof(fa_session_t, l4), offsetof(clib_bihash_kv_16_8_t, key[1]));
+CT_ASSERT_EQUAL(fa_session_kv_16_8_value, offsetof(fa_session_t, value), offsetof(clib_bihash_kv_16_8_t, value));
 
 /* Session ID MUST be the same as u64 */
 CT_ASSERT_EQUAL(fa_full_session_id_size_is_64, sizeof(fa_full_session_id_t), sizeof(u64));
@@ -165,9 +196,24 @@ CT_ASSERT_EQUAL(fa_5tuple_opaque_t_must_match_5tuple, sizeof(fa_5tuple_opaque_t)
 
 #define FA_SESSION_BOGUS_INDEX ~0
 
+/* Where the session lookup tables live */
+typedef enum {
+  /* one table shared by all the workers */
+  ACL_FA_SESSION_TABLES_SHARED = 0,
+  /* a table per worker, packets are handed off to the owner of the flow */
+  ACL_FA_SESSION_TABLES_PER_WORKER_HANDOFF,
+  /* a table per worker, symmetric RSS keeps a flow on its owner */
+  ACL_FA_SESSION_TABLES_PER_WORKER_RSS,
+} acl_fa_session_tables_t;
+
 typedef struct {
   /* The pool of sessions managed by this worker */
   fa_session_t *fa_sessions_pool;
+  /* ... or the pool of them in the compact layout */
+  fa_session_compact_t *fa_compact_sessions_pool;
+  /* The session lookup tables, if they are per-worker */
+  clib_bihash_40_8_t fa_ip6_sessions_hash;
+  clib_bihash_16_8_t fa_ip4_sessions_hash;
   /* incoming session change requests from other workers */
   clib_spinlock_t pending_session_change_request_lock;
   u64 *pending_session_change_requests;
@@ -188,6 +234,10 @@ typedef struct {
   u32 *expired;
   /* the earliest next expiry time */
   u64 next_expiry_time;
+  /* session expiry timers, if the timer wheel is used for aging */
+  tw_timer_wheel_1t_3w_1024sl_ov_t session_timer_wheel;
+  /* next session to look at when swiping with the timer wheel */
+  u32 swipe_session_index;
   /* if not zero, look at all the elements until their enqueue timestamp is after below one */
   u64 requeue_until_time;
   /* Current time between the checks */
@@ -231,6 +281,10 @@ typedef struct {
   fa_5tuple_t fa_5tuples[VLIB_FRAME_SIZE];
   u64 hashes[VLIB_FRAME_SIZE];
   u16 nexts[VLIB_FRAME_SIZE];
+  /* buffers processed here and those handed off to their session owner */
+  u32 local_bis[VLIB_FRAME_SIZE];
+  u32 handoff_bis[VLIB_FRAME_SIZE];
+  u16 handoff_threads[VLIB_FRAME_SIZE];
 
 } acl_fa_per_worker_data_t;
 
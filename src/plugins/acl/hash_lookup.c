@@ -620,6 +620,32 @@ check_collision_count_and_maybe_split(acl_main_t *am, u32 lc_index, int is_ip6,
   }
 }
 
+static void
+fill_and_activate_applied_ace(acl_main_t *am, u32 lc_index,
+                              applied_hash_ace_entry_t **applied_hash_aces,
+                              u32 new_index, int acl_index, u32 acl_position,
+                              u32 hash_ace_info_index)
+{
+  hash_acl_info_t *ha = vec_elt_at_index(am->hash_acl_infos, acl_index);
+  hash_ace_info_t *ace_info = vec_elt_at_index(ha->rules, hash_ace_info_index);
+  int is_ip6 = ace_info->match.pkt.is_ip6;
+  applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), new_index);
+  pae->acl_index = acl_index;
+  pae->ace_index = ace_info->ace_index;
+  pae->acl_position = acl_position;
+  pae->action = ace_info->action;
+  pae->hitcount = 0;
+  pae->hash_ace_info_index = hash_ace_info_index;
+  /* we might link it in later */
+  pae->collision_head_ae_index = ~0;
+  pae->colliding_rules = NULL;
+  pae->mask_type_index = ~0;
+  assign_mask_type_index_to_pae(am, lc_index, is_ip6, pae);
+  u32 first_index = activate_applied_ace_hash_entry(am, lc_index, applied_hash_aces, new_index);
+  if (am->use_tuple_merge)
+    check_collision_count_and_maybe_split(am, lc_index, is_ip6, first_index);
+}
+
 void
 hash_acl_apply(acl_main_t *am, u32 lc_index, int acl_index, u32 acl_position)
 {
@@ -692,26 +718,11 @@ hash_acl_apply(acl_main_t *am, u32 lc_index, int acl_index, u32 acl_position)
      * One by one not to upset split_partition() if it is called.
      */
     vec_resize((*applied_hash_aces), 1);
-
-    int is_ip6 = ha->rules[i].match.pkt.is_ip6;
-    u32 new_index = base_offset + i;
-    applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), new_index);
-    pae->acl_index = acl_index;
-    pae->ace_index = ha->rules[i].ace_index;
-    pae->acl_position = acl_position;
-    pae->action = ha->rules[i].action;
-    pae->hitcount = 0;
-    pae->hash_ace_info_index = i;
-    /* we might link it in later */
-    pae->collision_head_ae_index = ~0;
-    pae->colliding_rules = NULL;
-    pae->mask_type_index = ~0;
-    assign_mask_type_index_to_pae(am, lc_index, is_ip6, pae);
-    u32 first_index = activate_applied_ace_hash_entry(am, lc_index, applied_hash_aces, new_index);
-    if (am->use_tuple_merge)
-      check_collision_count_and_maybe_split(am, lc_index, is_ip6, first_index);
+    fill_and_activate_applied_ace(am, lc_index, applied_hash_aces,
+                                  base_offset + i, acl_index, acl_position, i);
   }
   remake_hash_applied_mask_info_vec(am, applied_hash_aces, lc_index);
+  acl_ct_invalidate(am, lc_index);
 }
 
 static u32
@@ -765,6 +776,7 @@ move_applied_ace_hash_entry(acl_main_t *am,
     collision_match_rule_t *cr = vec_elt_at_index (new_pae->colliding_rules, 0);
     ASSERT(cr->applied_entry_index == old_index);
     cr->applied_entry_index = new_index;
+    cr->ace_index = new_pae->ace_index;
     set_collision_head_ae_index(applied_hash_aces, new_pae->colliding_rules, new_index);
   } else {
     /* find the index in the collision rule entry on the head element */
@@ -777,6 +789,7 @@ move_applied_ace_hash_entry(acl_main_t *am,
       collision_match_rule_t *cr = vec_elt_at_index (head_pae->colliding_rules, i);
       if (cr->applied_entry_index == old_index) {
         cr->applied_entry_index = new_index;
+        cr->ace_index = new_pae->ace_index;
       }
     }
     if (ACL_HASH_LOOKUP_DEBUG > 0) {
@@ -906,6 +919,7 @@ hash_acl_unapply(acl_main_t *am, u32 lc_index, int acl_index)
   vec_dec_len ((*applied_hash_aces), vec_len (ha->rules));
 
   remake_hash_applied_mask_info_vec(am, applied_hash_aces, lc_index);
+  acl_ct_invalidate(am, lc_index);
 
   if (vec_len((*applied_hash_aces)) == 0) {
     vec_free((*applied_hash_aces));
@@ -1059,6 +1073,23 @@ int hash_acl_exists(acl_main_t *am, int acl_index)
   return ha->hash_acl_exists;
 }
 
+static void
+make_hash_ace_info(acl_main_t *am, int acl_index, u32 ace_index,
+                   acl_rule_t *rule, hash_ace_info_t *ace_info)
+{
+  fa_5tuple_t mask;
+  clib_memset(ace_info, 0, sizeof(*ace_info));
+  ace_info->acl_index = acl_index;
+  ace_info->ace_index = ace_index;
+
+  make_mask_and_match_from_rule(&mask, rule, ace_info);
+  mask.pkt.flags_reserved = 0b000;
+  ace_info->base_mask_type_index = assign_mask_type_index(am, &mask);
+  /* assign the mask type index for matching itself */
+  ace_info->match.pkt.mask_type_index_lsb = ace_info->base_mask_type_index;
+  DBG("ACE: %d mask_type_index: %d", ace_index, ace_info->base_mask_type_index);
+}
+
 void hash_acl_add(acl_main_t *am, int acl_index)
 {
   DBG("HASH ACL add : %d", acl_index);
@@ -1080,17 +1111,7 @@ void hash_acl_add(acl_main_t *am, int acl_index)
 
   for(i=0; i < vec_len(acl_rules); i++) {
     hash_ace_info_t ace_info;
-    fa_5tuple_t mask;
-    clib_memset(&ace_info, 0, sizeof(ace_info));
-    ace_info.acl_index = acl_index;
-    ace_info.ace_index = i;
-
-    make_mask_and_match_from_rule(&mask, &acl_rules[i], &ace_info);
-    mask.pkt.flags_reserved = 0b000;
-    ace_info.base_mask_type_index = assign_mask_type_index(am, &mask);
-    /* assign the mask type index for matching itself */
-    ace_info.match.pkt.mask_type_index_lsb = ace_info.base_mask_type_index;
-    DBG("ACE: %d mask_type_index: %d", i, ace_info.base_mask_type_index);
+    make_hash_ace_info(am, acl_index, i, &acl_rules[i], &ace_info);
     vec_add1(ha->rules, ace_info);
   }
   /*
@@ -1143,6 +1164,159 @@ void hash_acl_delete(acl_main_t *am, int acl_index)
   vec_free(ha->rules);
 }
 
+static int
+acl_rules_equal(acl_rule_t *r1, acl_rule_t *r2)
+{
+  return (r1->is_permit == r2->is_permit)
+         && (r1->is_ipv6 == r2->is_ipv6)
+         && ip46_address_is_equal(&r1->src, &r2->src)
+         && (r1->src_prefixlen == r2->src_prefixlen)
+         && ip46_address_is_equal(&r1->dst, &r2->dst)
+         && (r1->dst_prefixlen == r2->dst_prefixlen)
+         && (r1->proto == r2->proto)
+         && (r1->src_port_or_type_first == r2->src_port_or_type_first)
+         && (r1->src_port_or_type_last == r2->src_port_or_type_last)
+         && (r1->dst_port_or_code_first == r2->dst_port_or_code_first)
+         && (r1->dst_port_or_code_last == r2->dst_port_or_code_last)
+         && (r1->tcp_flags_value == r2->tcp_flags_value)
+         && (r1->tcp_flags_mask == r2->tcp_flags_mask);
+}
+
+/*
+ * The index of the first applied entry of the ACL within the lookup context,
+ * which is the sum of the lengths of the ACLs applied in front of it.
+ */
+static u32
+hash_acl_applied_base(acl_main_t *am, u32 lc_index, int acl_index)
+{
+  applied_hash_acl_info_t *pal = vec_elt_at_index(am->applied_hash_acl_info_by_lc_index, lc_index);
+  u32 base = 0;
+  u32 *pacl;
+  vec_foreach(pacl, pal->applied_acls) {
+    if (*pacl == acl_index)
+      break;
+    base += vec_len(vec_elt_at_index(am->hash_acl_infos, *pacl)->rules);
+  }
+  return base;
+}
+
+/*
+ * The rules of an already added ACL were replaced, old_rules holding
+ * the previous ruleset. Rather than unapplying and reapplying the ACL and
+ * all the ACLs after it in every lookup context it is applied in, find the
+ * range of ACEs which differ between the old and the new ruleset, and only
+ * deactivate the old and activate the new entries for that range,
+ * shifting the applied entries behind it as needed.
+ */
+void
+hash_acl_update(acl_main_t *am, int acl_index, acl_rule_t *old_rules)
+{
+  acl_rule_t *new_rules = am->acls[acl_index].rules;
+  hash_acl_info_t *ha = vec_elt_at_index(am->hash_acl_infos, acl_index);
+  u32 n_old = vec_len(old_rules);
+  u32 n_new = vec_len(new_rules);
+  u32 head = 0, tail = 0;
+  u32 *lc_index;
+  int i;
+
+  ASSERT(vec_len(ha->rules) == n_old);
+
+  while ((head < n_old) && (head < n_new)
+         && acl_rules_equal(&old_rules[head], &new_rules[head]))
+    head++;
+  while ((tail < n_old - head) && (tail < n_new - head)
+         && acl_rules_equal(&old_rules[n_old - 1 - tail], &new_rules[n_new - 1 - tail]))
+    tail++;
+
+  u32 n_del = n_old - head - tail;
+  u32 n_add = n_new - head - tail;
+  DBG0("HASH ACL update : %d head %d tail %d del %d add %d", acl_index, head, tail, n_del, n_add);
+  if ((n_del == 0) && (n_add == 0))
+    return;
+
+  /*
+   * Remove the changed entries from every lookup context while the
+   * hash ACE infos still describe the old rules, closing the gap.
+   */
+  vec_foreach(lc_index, ha->lc_index_list) {
+    applied_hash_ace_entry_t **applied_hash_aces = get_applied_hash_aces(am, *lc_index);
+    u32 base = hash_acl_applied_base(am, *lc_index, acl_index);
+    u32 del_offset = base + head;
+    u32 tail_offset = del_offset + n_del;
+    u32 tail_len = vec_len((*applied_hash_aces)) - tail_offset;
+
+    if (n_del == 0)
+      continue;
+    for(i=0; i < n_del; i++) {
+      deactivate_applied_ace_hash_entry(am, *lc_index,
+                                        applied_hash_aces, del_offset + i);
+    }
+    for(i=0; i < tail_len; i++) {
+      applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), tail_offset + i);
+      /* the unchanged tail of this ACL gets renumbered */
+      if (i < tail)
+        pae->ace_index -= n_del;
+      move_applied_ace_hash_entry(am, *lc_index, applied_hash_aces, tail_offset + i, del_offset + i);
+    }
+    vec_dec_len ((*applied_hash_aces), n_del);
+    remake_hash_applied_mask_info_vec(am, applied_hash_aces, *lc_index);
+  }
+
+  /* Rebuild the hash ACE infos: keep the unchanged ones, make the new */
+  hash_ace_info_t *new_ha_rules = 0;
+  if (n_new > 0)
+    vec_validate(new_ha_rules, n_new - 1);
+  for(i=0; i < head; i++) {
+    new_ha_rules[i] = ha->rules[i];
+  }
+  for(i=head; i < head + n_add; i++) {
+    make_hash_ace_info(am, acl_index, i, &new_rules[i], &new_ha_rules[i]);
+  }
+  for(i=head + n_add; i < n_new; i++) {
+    new_ha_rules[i] = ha->rules[i - n_add + n_del];
+    new_ha_rules[i].ace_index = i;
+  }
+  /* release only now, so the mask types common to old and new are kept */
+  for(i=head; i < head + n_del; i++) {
+    release_mask_type_index(am, ha->rules[i].base_mask_type_index);
+  }
+  vec_free(ha->rules);
+  ha->rules = new_ha_rules;
+
+  /* Open the gap for the new entries and activate them */
+  vec_foreach(lc_index, ha->lc_index_list) {
+    acl_lookup_context_t *acontext = pool_elt_at_index(am->acl_lookup_contexts, *lc_index);
+    applied_hash_ace_entry_t **applied_hash_aces = get_applied_hash_aces(am, *lc_index);
+    u32 acl_position = vec_search(acontext->acl_indices, acl_index);
+    u32 base = hash_acl_applied_base(am, *lc_index, acl_index);
+    u32 add_offset = base + head;
+    u32 old_len = vec_len((*applied_hash_aces));
+    u32 tail_len = old_len - add_offset;
+
+    /* the unchanged tail of this ACL refers to the moved hash ACE infos */
+    for(i=0; i < tail; i++) {
+      applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), add_offset + i);
+      pae->hash_ace_info_index += n_add;
+      pae->hash_ace_info_index -= n_del;
+      pae->ace_index += n_add;
+    }
+    if (n_add > 0) {
+      vec_validate((*applied_hash_aces), old_len + n_add - 1);
+      for(i=tail_len - 1; i >= 0; i--) {
+        move_applied_ace_hash_entry(am, *lc_index, applied_hash_aces,
+                                    add_offset + i, add_offset + n_add + i);
+      }
+      for(i=0; i < n_add; i++) {
+        fill_and_activate_applied_ace(am, *lc_index, applied_hash_aces,
+                                      add_offset + i, acl_index, acl_position,
+                                      head + i);
+      }
+    }
+    remake_hash_applied_mask_info_vec(am, applied_hash_aces, *lc_index);
+    acl_ct_invalidate(am, *lc_index);
+  }
+}
+
 
 void
 show_hash_acl_hash (vlib_main_t * vm, acl_main_t *am, u32 verbose)
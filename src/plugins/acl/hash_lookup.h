@@ -41,7 +41,23 @@ void hash_acl_unapply(acl_main_t *am, u32 lc_index, int acl_index);
 void hash_acl_add(acl_main_t *am, int acl_index);
 void hash_acl_delete(acl_main_t *am, int acl_index);
 
+/*
+ * The rules of an added ACL were replaced, old_rules are the previous ones:
+ * update the applied entries only for the ACEs which changed.
+ */
+void hash_acl_update(acl_main_t *am, int acl_index, acl_rule_t *old_rules);
+
 /* return if there is already a filled-in hash acl info */
 int hash_acl_exists(acl_main_t *am, int acl_index);
 
+/*
+ * The applied ACEs of the lookup context changed: drop its compiled
+ * classifier, and schedule the rebuild if the context uses one.
+ * Called with the workers held.
+ */
+void acl_ct_invalidate(acl_main_t *am, u32 lc_index);
+
+/* Match with the compiled classifier (1) or the hash tables (0) */
+void acl_ct_set_lookup_context(acl_main_t *am, u32 lc_index, int enable);
+
 #endif
@@ -110,6 +110,60 @@ typedef struct {
 } hash_applied_mask_info_t;
 
 
+/*
+ * The compiled (cut tree) classifier of a lookup context.
+ *
+ * Each interior node cuts one dimension of its region of the 5-tuple
+ * space into 2^n_cuts_log2 equal parts, the children being contiguous
+ * in the node vector. The leaves hold copies of the few rules
+ * intersecting their region, in the applied order, so the lookup is
+ * at most ACL_CT_MAX_DEPTH node reads followed by a short linear match.
+ */
+typedef enum {
+  /* the source and destination, one 32 bit word of them for IPv6 */
+  ACL_CT_DIM_SRC,
+  ACL_CT_DIM_DST,
+  ACL_CT_DIM_PROTO,
+  ACL_CT_DIM_SPORT,
+  ACL_CT_DIM_DPORT,
+  ACL_CT_N_DIM,
+} acl_ct_dim_t;
+
+#define ACL_CT_LEAF ACL_CT_N_DIM
+
+typedef struct {
+  /* dimension cut, or ACL_CT_LEAF */
+  u8 dim;
+  /* child is (key >> shift) & ((1 << n_cuts_log2) - 1) */
+  u8 shift;
+  u8 n_cuts_log2;
+  u8 reserved;
+  /* first child node, or first rule of the leaf */
+  u32 index;
+  u32 n_rules;
+} acl_ct_node_t;
+
+typedef struct {
+  acl_rule_t rule;
+  u32 applied_entry_index;
+} acl_ct_rule_t;
+
+typedef struct {
+  acl_ct_node_t *nodes;
+  acl_ct_rule_t *rules;
+  /* root node for IPv4 and IPv6 */
+  u32 root[2];
+  /* the word of the IPv6 source and destination cut */
+  u8 ip6_word[2];
+  /* Debug Information */
+  u32 n_applied;
+  u32 n_leaves;
+  u32 max_depth;
+  u32 max_leaf_rules;
+  f64 build_time;
+} acl_ct_t;
+
+
 #define CT_ASSERT_EQUAL(name, x,y) typedef int assert_ ## name ## _compile_time_assertion_failed[((x) == (y))-1]
 
 CT_ASSERT_EQUAL(hash_acl_lookup_value_t_is_u64, sizeof(hash_acl_lookup_value_t), sizeof(u64));
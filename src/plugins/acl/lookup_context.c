@@ -114,6 +114,7 @@ static int acl_plugin_get_lookup_context_index (u32 acl_user_id, u32 val1, u32 v
   acontext->context_user_id = acl_user_id;
   acontext->user_val1 = val1;
   acontext->user_val2 = val2;
+  acontext->use_compiled_lookup = am->use_compiled_lookup;
 
   u32 new_context_id = acontext - am->acl_lookup_contexts;
   vec_add1(am->acl_users[acl_user_id].lookup_contexts, new_context_id);
@@ -282,6 +283,20 @@ void acl_plugin_lookup_context_notify_acl_change(u32 acl_num)
   }
 }
 
+/*
+ * The rules of an existing ACL were replaced by acl_add_replace,
+ * old_rules being the previous ruleset: update the lookups by the
+ * difference rather than deleting and re-adding the whole ACL.
+ */
+void acl_plugin_lookup_context_notify_acl_replace(u32 acl_num, acl_rule_t *old_rules)
+{
+  acl_main_t *am = &acl_main;
+  if (hash_acl_exists(am, acl_num))
+    hash_acl_update(am, acl_num, old_rules);
+  else
+    hash_acl_add(am, acl_num);
+}
+
 
 /* Fill the 5-tuple from the packet */
 
@@ -302,6 +317,18 @@ static int acl_plugin_match_5tuple (u32 lc_index,
   return acl_plugin_match_5tuple_inline (&acl_main, lc_index, pkt_5tuple, is_ip6, r_action, r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
 }
 
+static void acl_plugin_match_5tuple_xN (u32 n_tuples, u32 * lc_index,
+                                           fa_5tuple_opaque_t * pkt_5tuple,
+                                           int is_ip6, int * r_is_match,
+                                           u8 * r_action,
+                                           u32 * r_acl_pos_p,
+                                           u32 * r_acl_match_p,
+                                           u32 * r_rule_match_p,
+                                           u32 * trace_bitmap)
+{
+  acl_plugin_match_5tuple_inline_xN (&acl_main, n_tuples, lc_index, pkt_5tuple, is_ip6, r_is_match, r_action, r_acl_pos_p, r_acl_match_p, r_rule_match_p, trace_bitmap);
+}
+
 
 void
 acl_plugin_show_lookup_user (u32 user_index)
@@ -36,9 +36,12 @@ typedef struct {
   u32 user_val1;
   /* per-instance user value 2 */
   u32 user_val2;
+  /* match with the compiled classifier once it is built */
+  u8 use_compiled_lookup;
 } acl_lookup_context_t;
 
 void acl_plugin_lookup_context_notify_acl_change(u32 acl_num);
+void acl_plugin_lookup_context_notify_acl_replace(u32 acl_num, acl_rule_t *old_rules);
 
 void acl_plugin_show_lookup_context (u32 lc_index);
 void acl_plugin_show_lookup_user (u32 user_index);
@@ -48,6 +51,7 @@ void acl_plugin_show_tables_mask_type (void);
 void acl_plugin_show_tables_acl_hash_info (u32 acl_index);
 void acl_plugin_show_tables_applied_info (u32 sw_if_index);
 void acl_plugin_show_tables_bihash (u32 show_bihash_verbose);
+void acl_plugin_show_tables_compiled (u32 lc_index);
 
 #endif
 
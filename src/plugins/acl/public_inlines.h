@@ -627,6 +627,69 @@ multi_acl_match_get_applied_ace_index (acl_main_t * am, int is_ip6, fa_5tuple_t
   return curr_match_index;
 }
 
+always_inline void
+compiled_acl_match_make_key (acl_ct_t * ct, int is_ip6, fa_5tuple_t * match,
+			     u32 * key)
+{
+  if (is_ip6)
+    {
+      key[ACL_CT_DIM_SRC] =
+	clib_net_to_host_u32 (match->ip6_addr[0].as_u32[ct->ip6_word[0]]);
+      key[ACL_CT_DIM_DST] =
+	clib_net_to_host_u32 (match->ip6_addr[1].as_u32[ct->ip6_word[1]]);
+    }
+  else
+    {
+      key[ACL_CT_DIM_SRC] = clib_net_to_host_u32 (match->ip4_addr[0].as_u32);
+      key[ACL_CT_DIM_DST] = clib_net_to_host_u32 (match->ip4_addr[1].as_u32);
+    }
+  key[ACL_CT_DIM_PROTO] = match->l4.proto;
+  key[ACL_CT_DIM_SPORT] = match->l4.port[0];
+  key[ACL_CT_DIM_DPORT] = match->l4.port[1];
+}
+
+always_inline acl_ct_node_t *
+compiled_acl_match_next_node (acl_ct_t * ct, acl_ct_node_t * node, u32 * key)
+{
+  return ct->nodes + node->index +
+    ((key[node->dim] >> node->shift) & pow2_mask (node->n_cuts_log2));
+}
+
+always_inline u32
+compiled_acl_match_leaf (acl_ct_t * ct, acl_ct_node_t * node, int is_ip6,
+			 fa_5tuple_t * match)
+{
+  acl_ct_rule_t *r = ct->rules + node->index;
+  u32 i;
+
+  for (i = 0; i < node->n_rules; i++)
+    {
+      if (single_rule_match_5tuple (&r[i].rule, is_ip6, match))
+	return r[i].applied_entry_index;
+    }
+  return ~0;
+}
+
+/*
+ * Walk the compiled classifier down to the leaf for the packet,
+ * then match the few rules there in order.
+ */
+always_inline u32
+compiled_acl_match_get_applied_ace_index (acl_ct_t * ct, int is_ip6,
+					  fa_5tuple_t * match)
+{
+  u32 key[ACL_CT_N_DIM];
+  acl_ct_node_t *node;
+
+  compiled_acl_match_make_key (ct, is_ip6, match, key);
+
+  node = ct->nodes + ct->root[is_ip6];
+  while (node->dim != ACL_CT_LEAF)
+    node = compiled_acl_match_next_node (ct, node, key);
+
+  return compiled_acl_match_leaf (ct, node, is_ip6, match);
+}
+
 always_inline int
 hash_multi_acl_match_5tuple (void *p_acl_main, u32 lc_index, fa_5tuple_t * pkt_5tuple,
                        int is_ip6, u8 *action, u32 *acl_pos_p, u32 * acl_match_p,
@@ -634,7 +697,16 @@ hash_multi_acl_match_5tuple (void *p_acl_main, u32 lc_index, fa_5tuple_t * pkt_5
 {
   acl_main_t *am = p_acl_main;
   applied_hash_ace_entry_t **applied_hash_aces = vec_elt_at_index(am->hash_entry_vec_by_lc_index, lc_index);
-  u32 match_index = multi_acl_match_get_applied_ace_index(am, is_ip6, pkt_5tuple);
+  acl_ct_t *ct = NULL;
+  u32 match_index;
+
+  /* published by the main thread once built, hash tables until then */
+  if (lc_index < vec_len(am->compiled_lookup_by_lc_index))
+    ct = clib_atomic_load_acq_n(&am->compiled_lookup_by_lc_index[lc_index]);
+  if (ct)
+    match_index = compiled_acl_match_get_applied_ace_index(ct, is_ip6, pkt_5tuple);
+  else
+    match_index = multi_acl_match_get_applied_ace_index(am, is_ip6, pkt_5tuple);
   if (match_index < vec_len((*applied_hash_aces))) {
     applied_hash_ace_entry_t *pae = vec_elt_at_index((*applied_hash_aces), match_index);
     pae->hitcount++;
@@ -722,6 +794,274 @@ acl_plugin_match_5tuple_inline_and_count (void *p_acl_main, u32 lc_index,
 }
 
 
+/*
+ * Batched matching. The tuples of a batch are resolved in lockstep:
+ * for every mask type the bihash buckets of all of them are prefetched
+ * before any of them is searched, and the compiled classifier walks
+ * descend one level for all of them at a time, so the cache misses
+ * which the one-at-a-time API takes back to back overlap instead.
+ */
+
+#define ACL_PLUGIN_MATCH_BATCH_SIZE 4
+
+always_inline void
+multi_acl_match_make_key (acl_main_t * am, fa_5tuple_t * match,
+			  u32 mask_type_index, clib_bihash_kv_48_8_t * kv)
+{
+  ace_mask_type_entry_t *mte =
+    vec_elt_at_index (am->ace_mask_type_pool, mask_type_index);
+  fa_5tuple_t *kv_key = (fa_5tuple_t *) kv->key;
+  u64 *pmatch = (u64 *) match;
+  u64 *pmask = (u64 *) & mte->mask;
+  u64 *pkey = kv->key;
+  fa_packet_info_t tmp_pkt;
+
+  *pkey++ = *pmatch++ & *pmask++;
+  *pkey++ = *pmatch++ & *pmask++;
+  *pkey++ = *pmatch++ & *pmask++;
+  *pkey++ = *pmatch++ & *pmask++;
+  *pkey++ = *pmatch++ & *pmask++;
+  *pkey++ = *pmatch++ & *pmask++;
+
+  tmp_pkt = kv_key->pkt;
+  tmp_pkt.mask_type_index_lsb = mask_type_index;
+  kv_key->pkt.as_u64 = tmp_pkt.as_u64;
+}
+
+always_inline void
+multi_acl_match_get_applied_ace_index_x4 (acl_main_t * am, u32 n, int is_ip6,
+					  fa_5tuple_t ** match, u32 * r_index)
+{
+  clib_bihash_48_8_t *h = &am->acl_lookup_hash;
+  clib_bihash_kv_48_8_t kv[ACL_PLUGIN_MATCH_BATCH_SIZE];
+  clib_bihash_kv_48_8_t result;
+  hash_acl_lookup_value_t *result_val =
+    (hash_acl_lookup_value_t *) & result.value;
+  applied_hash_ace_entry_t *aces[ACL_PLUGIN_MATCH_BATCH_SIZE];
+  hash_applied_mask_info_t *minfo[ACL_PLUGIN_MATCH_BATCH_SIZE];
+  acl_ct_t *ct[ACL_PLUGIN_MATCH_BATCH_SIZE];
+  acl_ct_node_t *node[ACL_PLUGIN_MATCH_BATCH_SIZE];
+  u32 key[ACL_PLUGIN_MATCH_BATCH_SIZE][ACL_CT_N_DIM];
+  u64 hash[ACL_PLUGIN_MATCH_BATCH_SIZE];
+  u32 walk = 0, probe = 0;
+  u32 i, j, order_index;
+
+  for (i = 0; i < n; i++)
+    {
+      u32 lc_index = match[i]->pkt.lc_index;
+
+      r_index[i] = (~0 - 1);
+      ct[i] = 0;
+      if (lc_index < vec_len (am->compiled_lookup_by_lc_index))
+	ct[i] =
+	  clib_atomic_load_acq_n (&am->compiled_lookup_by_lc_index[lc_index]);
+      if (ct[i])
+	{
+	  compiled_acl_match_make_key (ct[i], is_ip6, match[i], key[i]);
+	  node[i] = ct[i]->nodes + ct[i]->root[is_ip6];
+	  walk |= 1 << i;
+	}
+      else
+	{
+	  aces[i] = am->hash_entry_vec_by_lc_index[lc_index];
+	  minfo[i] = am->hash_applied_mask_info_vec_by_lc_index[lc_index];
+	  probe |= 1 << i;
+	}
+    }
+
+  /* compiled classifier: one tree level per tuple per round */
+  while (walk)
+    {
+      for (i = 0; i < n; i++)
+	{
+	  if (!(walk & (1 << i)))
+	    continue;
+	  if (node[i]->dim == ACL_CT_LEAF)
+	    {
+	      CLIB_PREFETCH (ct[i]->rules + node[i]->index,
+			     CLIB_CACHE_LINE_BYTES, LOAD);
+	      walk &= ~(1 << i);
+	      continue;
+	    }
+	  node[i] = compiled_acl_match_next_node (ct[i], node[i], key[i]);
+	  CLIB_PREFETCH (node[i], sizeof (node[i][0]), LOAD);
+	}
+    }
+  for (i = 0; i < n; i++)
+    {
+      if (ct[i])
+	r_index[i] = compiled_acl_match_leaf (ct[i], node[i], is_ip6,
+					      match[i]);
+    }
+
+  /* hash tables: one mask type per tuple per round */
+  for (order_index = 0; probe; order_index++)
+    {
+      for (i = 0; i < n; i++)
+	{
+	  if (!(probe & (1 << i)))
+	    continue;
+	  /*
+	   * Past the last mask type, or all the rules in this and the
+	   * following partitions are after our candidate.
+	   */
+	  if (order_index >= vec_len (minfo[i])
+	      || minfo[i][order_index].first_rule_index > r_index[i])
+	    {
+	      probe &= ~(1 << i);
+	      continue;
+	    }
+	  multi_acl_match_make_key (am, match[i],
+				    minfo[i][order_index].mask_type_index,
+				    &kv[i]);
+	  hash[i] = clib_bihash_hash_48_8 (&kv[i]);
+	  clib_bihash_prefetch_bucket_48_8 (h, hash[i]);
+	}
+      for (i = 0; i < n; i++)
+	{
+	  if (probe & (1 << i))
+	    clib_bihash_prefetch_data_48_8 (h, hash[i]);
+	}
+      for (i = 0; i < n; i++)
+	{
+	  applied_hash_ace_entry_t *pae;
+	  collision_match_rule_t *crs;
+
+	  if (!(probe & (1 << i)))
+	    continue;
+	  if (clib_bihash_search_inline_2_with_hash_48_8 (h, hash[i], &kv[i],
+							  &result))
+	    continue;
+	  /* There is a hit in the hash, so check the collision vector */
+	  pae = vec_elt_at_index (aces[i], result_val->applied_entry_index);
+	  crs = pae->colliding_rules;
+	  for (j = 0; j < vec_len (crs); j++)
+	    {
+	      if (crs[j].applied_entry_index >= r_index[i])
+		continue;
+	      if (single_rule_match_5tuple (&crs[j].rule, is_ip6, match[i]))
+		r_index[i] = crs[j].applied_entry_index;
+	    }
+	}
+    }
+}
+
+/*
+ * Match n <= ACL_PLUGIN_MATCH_BATCH_SIZE tuples; r_is_match[i] tells
+ * whether the other results for tuple i were filled in.
+ */
+always_inline void
+acl_plugin_match_5tuple_batch_inline (void *p_acl_main, u32 n,
+				      u32 * lc_index,
+				      fa_5tuple_opaque_t * pkt_5tuple,
+				      int is_ip6, int *r_is_match,
+				      u8 * r_action, u32 * r_acl_pos_p,
+				      u32 * r_acl_match_p,
+				      u32 * r_rule_match_p,
+				      u32 * trace_bitmap)
+{
+  acl_main_t *am = p_acl_main;
+  fa_5tuple_t *match[ACL_PLUGIN_MATCH_BATCH_SIZE];
+  u32 slot[ACL_PLUGIN_MATCH_BATCH_SIZE];
+  u32 index[ACL_PLUGIN_MATCH_BATCH_SIZE];
+  u32 i, n_hash = 0;
+
+  for (i = 0; i < n; i++)
+    {
+      fa_5tuple_t *t = (fa_5tuple_t *) (pkt_5tuple + i);
+
+      t->pkt.lc_index = lc_index[i];
+      /* non-first fragments are matched linearly, see above */
+      if (PREDICT_TRUE (am->use_hash_acl_matching
+			&& !t->pkt.is_nonfirst_fragment))
+	{
+	  match[n_hash] = t;
+	  slot[n_hash++] = i;
+	}
+      else
+	r_is_match[i] =
+	  linear_multi_acl_match_5tuple (p_acl_main, lc_index[i], t, is_ip6,
+					 r_action + i, r_acl_pos_p + i,
+					 r_acl_match_p + i,
+					 r_rule_match_p + i, trace_bitmap);
+    }
+
+  if (!n_hash)
+    return;
+
+  multi_acl_match_get_applied_ace_index_x4 (am, n_hash, is_ip6, match,
+					    index);
+
+  for (i = 0; i < n_hash; i++)
+    {
+      u32 j = slot[i];
+      applied_hash_ace_entry_t *aces =
+	am->hash_entry_vec_by_lc_index[lc_index[j]];
+      applied_hash_ace_entry_t *pae;
+
+      r_is_match[j] = 0;
+      if (index[i] >= vec_len (aces))
+	continue;
+      pae = vec_elt_at_index (aces, index[i]);
+      pae->hitcount++;
+      r_acl_pos_p[j] = pae->acl_position;
+      r_acl_match_p[j] = pae->acl_index;
+      r_rule_match_p[j] = pae->ace_index;
+      r_action[j] = pae->action;
+      r_is_match[j] = 1;
+    }
+}
+
+/*
+ * Batched counterparts of acl_plugin_match_5tuple_inline: all the
+ * arguments after is_ip6 are arrays with one element per tuple,
+ * except trace_bitmap. The tuples must have been filled in for the
+ * same address family.
+ */
+always_inline void
+acl_plugin_match_5tuple_inline_x4 (void *p_acl_main, u32 * lc_index,
+				   fa_5tuple_opaque_t * pkt_5tuple,
+				   int is_ip6, int *r_is_match,
+				   u8 * r_action, u32 * r_acl_pos_p,
+				   u32 * r_acl_match_p, u32 * r_rule_match_p,
+				   u32 * trace_bitmap)
+{
+  acl_plugin_match_5tuple_batch_inline (p_acl_main, 4, lc_index, pkt_5tuple,
+					is_ip6, r_is_match, r_action,
+					r_acl_pos_p, r_acl_match_p,
+					r_rule_match_p, trace_bitmap);
+}
+
+always_inline void
+acl_plugin_match_5tuple_inline_xN (void *p_acl_main, u32 n_tuples,
+				   u32 * lc_index,
+				   fa_5tuple_opaque_t * pkt_5tuple,
+				   int is_ip6, int *r_is_match,
+				   u8 * r_action, u32 * r_acl_pos_p,
+				   u32 * r_acl_match_p, u32 * r_rule_match_p,
+				   u32 * trace_bitmap)
+{
+  u32 n;
+
+  while (n_tuples)
+    {
+      n = clib_min (n_tuples, ACL_PLUGIN_MATCH_BATCH_SIZE);
+      acl_plugin_match_5tuple_batch_inline (p_acl_main, n, lc_index,
+					    pkt_5tuple, is_ip6, r_is_match,
+					    r_action, r_acl_pos_p,
+					    r_acl_match_p, r_rule_match_p,
+					    trace_bitmap);
+      lc_index += n;
+      pkt_5tuple += n;
+      r_is_match += n;
+      r_action += n;
+      r_acl_pos_p += n;
+      r_acl_match_p += n;
+      r_rule_match_p += n;
+      n_tuples -= n;
+    }
+}
+
 
 
 #endif
@@ -81,6 +81,65 @@ format_ip4_session_bihash_kv (u8 * s, va_list * args)
 }
 
 
+/*
+ * Each thread gets its own pair of tables, with the buckets split
+ * between them. In the handoff mode every dataplane node also gets
+ * a frame queue, over which the packets of a flow are passed to the
+ * worker owning its sessions.
+ */
+static void
+acl_fa_init_per_worker_session_tables (acl_main_t * am)
+{
+  static char *dataplane_nodes[] = {
+    "acl-plugin-in-ip6-l2", "acl-plugin-in-ip4-l2",
+    "acl-plugin-out-ip6-l2", "acl-plugin-out-ip4-l2",
+    "acl-plugin-in-ip6-fa", "acl-plugin-in-ip4-fa",
+    "acl-plugin-out-ip6-fa", "acl-plugin-out-ip4-fa",
+  };
+  u32 n_tables = vec_len (am->per_worker_data);
+  u32 n_buckets =
+    clib_max (am->fa_conn_table_hash_num_buckets / n_tables, 1024);
+  uword memory_size =
+    clib_max (am->fa_conn_table_hash_memory_size / n_tables, 16 << 20);
+  u16 wk;
+  int i;
+
+  for (wk = 0; wk < n_tables; wk++)
+    {
+      acl_fa_per_worker_data_t *pw = &am->per_worker_data[wk];
+
+      clib_bihash_init_40_8 (&pw->fa_ip6_sessions_hash,
+			     (char *) format (0,
+					      "ACL plugin FA IPv6 session "
+					      "bihash thread %u%c", wk, 0),
+			     n_buckets, memory_size);
+      clib_bihash_set_kvp_format_fn_40_8 (&pw->fa_ip6_sessions_hash,
+					  format_ip6_session_bihash_kv);
+
+      clib_bihash_init_16_8 (&pw->fa_ip4_sessions_hash,
+			     (char *) format (0,
+					      "ACL plugin FA IPv4 session "
+					      "bihash thread %u%c", wk, 0),
+			     n_buckets, memory_size);
+      clib_bihash_set_kvp_format_fn_16_8 (&pw->fa_ip4_sessions_hash,
+					  format_ip4_session_bihash_kv);
+    }
+
+  if (am->fa_session_tables != ACL_FA_SESSION_TABLES_PER_WORKER_HANDOFF
+      || n_tables < 2)
+    return;
+
+  for (i = 0; i < ARRAY_LEN (dataplane_nodes); i++)
+    {
+      vlib_node_t *n = vlib_get_node_by_name (am->vlib_main,
+					      (u8 *) dataplane_nodes[i]);
+      vec_validate_init_empty (am->fa_handoff_fq_index_by_node_index,
+			       n->index, ~0);
+      am->fa_handoff_fq_index_by_node_index[n->index] =
+	vlib_frame_queue_main_init (n->index, 0);
+    }
+}
+
 static void
 acl_fa_verify_init_sessions (acl_main_t * am)
 {
@@ -97,24 +156,45 @@ acl_fa_verify_init_sessions (acl_main_t * am)
 	   * pool_alloc_aligned(pw->fa_sessions_pool, am->fa_conn_table_max_entries, CLIB_CACHE_LINE_BYTES);
 	   * clib_bitmap_validate(pool_header(pw->fa_sessions_pool)->free_bitmap, am->fa_conn_table_max_entries);
 	   */
-	  pool_init_fixed (pw->fa_sessions_pool,
-			   am->fa_conn_table_max_entries);
+	  if (am->fa_use_compact_sessions)
+	    {
+	      pool_init_fixed (pw->fa_compact_sessions_pool,
+			       am->fa_conn_table_max_entries);
+	    }
+	  else
+	    {
+	      pool_init_fixed (pw->fa_sessions_pool,
+			       am->fa_conn_table_max_entries);
+	    }
+	  if (am->fa_use_session_timer_wheel)
+	    tw_timer_wheel_init_1t_3w_1024sl_ov (
+	      &pw->session_timer_wheel, 0 /* no callback */,
+	      SESSION_TIMER_WHEEL_TICK_SEC,
+	      am->fa_max_deleted_sessions_per_interval);
 	}
+      am->fa_session_timer_tick_clocks =
+	am->vlib_main->clib_time.clocks_per_second *
+	SESSION_TIMER_WHEEL_TICK_SEC;
 
-      /* ... and the interface session hash table */
-      clib_bihash_init_40_8 (&am->fa_ip6_sessions_hash,
-			     "ACL plugin FA IPv6 session bihash",
-			     am->fa_conn_table_hash_num_buckets,
-			     am->fa_conn_table_hash_memory_size);
-      clib_bihash_set_kvp_format_fn_40_8 (&am->fa_ip6_sessions_hash,
-					  format_ip6_session_bihash_kv);
-
-      clib_bihash_init_16_8 (&am->fa_ip4_sessions_hash,
-			     "ACL plugin FA IPv4 session bihash",
-			     am->fa_conn_table_hash_num_buckets,
-			     am->fa_conn_table_hash_memory_size);
-      clib_bihash_set_kvp_format_fn_16_8 (&am->fa_ip4_sessions_hash,
-					  format_ip4_session_bihash_kv);
+      /* ... and the interface session hash table(s) */
+      if (am->fa_session_tables == ACL_FA_SESSION_TABLES_SHARED)
+	{
+	  clib_bihash_init_40_8 (&am->fa_ip6_sessions_hash,
+				 "ACL plugin FA IPv6 session bihash",
+				 am->fa_conn_table_hash_num_buckets,
+				 am->fa_conn_table_hash_memory_size);
+	  clib_bihash_set_kvp_format_fn_40_8 (&am->fa_ip6_sessions_hash,
+					      format_ip6_session_bihash_kv);
+
+	  clib_bihash_init_16_8 (&am->fa_ip4_sessions_hash,
+				 "ACL plugin FA IPv4 session bihash",
+				 am->fa_conn_table_hash_num_buckets,
+				 am->fa_conn_table_hash_memory_size);
+	  clib_bihash_set_kvp_format_fn_16_8 (&am->fa_ip4_sessions_hash,
+					      format_ip4_session_bihash_kv);
+	}
+      else
+	acl_fa_init_per_worker_session_tables (am);
 
       am->fa_sessions_hash_is_initialized = 1;
     }
@@ -140,6 +220,9 @@ acl_fa_get_list_head_expiry_time (acl_main_t * am,
 				  acl_fa_per_worker_data_t * pw, u64 now,
 				  u16 thread_index, int timeout_type)
 {
+  /* the lists are not used with the timer wheel, only the first slot */
+  if (am->fa_use_session_timer_wheel)
+    return timeout_type ? ~0ULL : pw->next_expiry_time;
   return pw->fa_conn_list_head_expiry_time[timeout_type];
 }
 
@@ -156,6 +239,59 @@ acl_fa_conn_time_to_check (acl_main_t * am, acl_fa_per_worker_data_t * pw,
     || (sess->link_enqueue_time <= pw->swipe_end_time);
 }
 
+/*
+ * Collect the sessions whose timers have fired, and while swiping,
+ * the sessions of the interfaces being cleared. The pool is swiped
+ * in chunks, so a huge session table does not stall the worker.
+ */
+static void
+acl_fa_expire_session_timers (acl_main_t * am, u16 thread_index, u64 now)
+{
+  acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  tw_timer_wheel_1t_3w_1024sl_ov_t *tw = &pw->session_timer_wheel;
+  f64 now_sec = vlib_time_now (vlib_get_main_by_index (thread_index));
+  u32 *psid;
+
+  pw->expired =
+    tw_timer_expire_timers_vec_1t_3w_1024sl_ov (tw, now_sec, pw->expired);
+  vec_foreach (psid, pw->expired)
+  {
+    /* the fired timer is gone already */
+    if (!acl_fa_session_is_free_index (am, pw, *psid))
+      get_session_ptr (am, thread_index, *psid)->timer_handle = ~0;
+  }
+
+  if (pw->swipe_end_time)
+    {
+      u32 n_sessions = acl_fa_session_pool_len (am, pw);
+      u32 n_swiped = 0;
+      u32 n_scan = 64 * am->fa_max_deleted_sessions_per_interval;
+
+      while (pw->swipe_session_index < n_sessions
+	     && n_swiped < am->fa_max_deleted_sessions_per_interval
+	     && n_scan-- > 0)
+	{
+	  u32 si = pw->swipe_session_index++;
+	  fa_session_t *sess;
+
+	  if (acl_fa_session_is_free_index (am, pw, si))
+	    continue;
+	  sess = get_session_ptr (am, thread_index, si);
+	  /* those without a timer are in the expired vector already */
+	  if (~0 == sess->timer_handle
+	      || !clib_bitmap_get (pw->pending_clear_sw_if_index_bitmap,
+				   sess->sw_if_index))
+	    continue;
+	  tw_timer_stop_1t_3w_1024sl_ov (tw, sess->timer_handle);
+	  sess->timer_handle = ~0;
+	  vec_add1 (pw->expired, si);
+	  n_swiped++;
+	}
+      if (pw->swipe_session_index >= n_sessions)
+	pw->swipe_end_time = 0;
+    }
+}
+
 /*
  * see if there are sessions ready to be checked,
  * do the maintenance (requeue or delete), and
@@ -190,6 +326,9 @@ acl_fa_check_idle_sessions (acl_main_t * am, u16 thread_index, u64 now)
   if (pw->wip_session_change_requests)
     vec_set_len (pw->wip_session_change_requests, 0);
 
+  if (am->fa_use_session_timer_wheel)
+    acl_fa_expire_session_timers (am, thread_index, now);
+  else
   {
     u8 tt = 0;
     int n_pending_swipes = 0;
@@ -235,7 +374,7 @@ acl_fa_check_idle_sessions (acl_main_t * am, u16 thread_index, u64 now)
   vec_foreach (psid, pw->expired)
   {
     fsid.session_index = *psid;
-    if (!pool_is_free_index (pw->fa_sessions_pool, fsid.session_index))
+    if (!acl_fa_session_is_free_index (am, pw, fsid.session_index))
       {
 	fa_session_t *sess =
 	  get_session_ptr (am, thread_index, fsid.session_index);
@@ -312,9 +451,21 @@ acl_fa_check_idle_sessions (acl_main_t * am, u16 thread_index, u64 now)
   /* if we were advancing and reached the end
    * (no more sessions to recycle), reset the fast-forward timestamp */
 
-  if (pw->swipe_end_time && 0 == total_expired)
+  if (pw->swipe_end_time && 0 == total_expired
+      && !am->fa_use_session_timer_wheel)
     pw->swipe_end_time = 0;
 
+  if (am->fa_use_session_timer_wheel)
+    {
+      tw_timer_wheel_1t_3w_1024sl_ov_t *tw = &pw->session_timer_wheel;
+      if (acl_fa_session_pool_elts (am, pw) == 0)
+	pw->next_expiry_time = ~0ULL;
+      else
+	pw->next_expiry_time =
+	  now + am->fa_session_timer_tick_clocks *
+	  tw_timer_first_expires_in_ticks_1t_3w_1024sl_ov (tw);
+    }
+
   elog_acl_maybe_trace_X1 (am,
 			   "acl_fa_check_idle_sessions: done, total sessions expired: %d",
 			   "i4", (u32) total_expired);
@@ -413,6 +564,9 @@ purgatory_has_connections (vlib_main_t * vm, acl_main_t * am,
 {
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
 
+  /* the purgatory timers fire on the next tick of the wheel anyway */
+  if (am->fa_use_session_timer_wheel)
+    return 0;
   return (FA_SESSION_BOGUS_INDEX !=
 	  pw->fa_conn_list_head[ACL_TIMEOUT_PURGATORY]);
 
@@ -496,6 +650,7 @@ acl_fa_worker_conn_cleaner_process (vlib_main_t * vm,
 				       "i8", now);
 	      /* swipe through the connection lists until enqueue timestamps become above "now" */
 	      pw->swipe_end_time = now;
+	      pw->swipe_session_index = 0;
 	    }
 	}
     }
@@ -621,7 +776,8 @@ acl_fa_session_cleaner_process (vlib_main_t * vm, vlib_node_runtime_t * rt,
 					   "i8i8", head_expiry, next_expire);
 		  next_expire = head_expiry;
 		}
-	      if (FA_SESSION_BOGUS_INDEX != pw->fa_conn_list_head[tt])
+	      if (FA_SESSION_BOGUS_INDEX != pw->fa_conn_list_head[tt]
+		  || (am->fa_use_session_timer_wheel && ~0ULL != head_expiry))
 		{
 		  has_pending_conns = 1;
 		}
@@ -909,7 +1065,25 @@ void
 show_fa_sessions_hash (vlib_main_t * vm, u32 verbose)
 {
   acl_main_t *am = &acl_main;
-  if (am->fa_sessions_hash_is_initialized)
+  if (am->fa_sessions_hash_is_initialized
+      && am->fa_session_tables != ACL_FA_SESSION_TABLES_SHARED)
+    {
+      u16 wk;
+      for (wk = 0; wk < vec_len (am->per_worker_data); wk++)
+	{
+	  acl_fa_per_worker_data_t *pw = &am->per_worker_data[wk];
+
+	  vlib_cli_output (vm,
+			   "\nThread %u IPv6 Session lookup hash table:"
+			   "\n%U\n\n", wk, format_bihash_40_8,
+			   &pw->fa_ip6_sessions_hash, verbose);
+	  vlib_cli_output (vm,
+			   "\nThread %u IPv4 Session lookup hash table:"
+			   "\n%U\n\n", wk, format_bihash_16_8,
+			   &pw->fa_ip4_sessions_hash, verbose);
+	}
+    }
+  else if (am->fa_sessions_hash_is_initialized)
     {
       vlib_cli_output (vm, "\nIPv6 Session lookup hash table:\n%U\n\n",
 		       format_bihash_40_8, &am->fa_ip6_sessions_hash,
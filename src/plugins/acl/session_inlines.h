@@ -45,6 +45,47 @@ static const u8 icmp6_valid_new[] = {
 /* IP4 and IP6 protocol numbers of ICMP */
 static u8 icmp_protos[] = { IP_PROTOCOL_ICMP, IP_PROTOCOL_ICMP6 };
 
+/* The session lookup tables used by a given thread */
+always_inline clib_bihash_40_8_t *
+acl_fa_ip6_sessions_hash (acl_main_t * am, u16 thread_index)
+{
+  if (am->fa_session_tables == ACL_FA_SESSION_TABLES_SHARED)
+    return &am->fa_ip6_sessions_hash;
+  return &am->per_worker_data[thread_index].fa_ip6_sessions_hash;
+}
+
+always_inline clib_bihash_16_8_t *
+acl_fa_ip4_sessions_hash (acl_main_t * am, u16 thread_index)
+{
+  if (am->fa_session_tables == ACL_FA_SESSION_TABLES_SHARED)
+    return &am->fa_ip4_sessions_hash;
+  return &am->per_worker_data[thread_index].fa_ip4_sessions_hash;
+}
+
+/*
+ * The worker which owns the sessions of a flow when the session tables
+ * are per-worker. The hash is symmetric, so both directions of a flow
+ * map to the same worker. The ICMP type and code differ between the
+ * request and the reply, and the non-first fragments carry no ports,
+ * so only the addresses and the protocol are used for those.
+ */
+always_inline u16
+acl_fa_session_owner_thread (int is_ip6, fa_5tuple_t * p5t, u32 n_workers)
+{
+  u64 h;
+
+  if (is_ip6)
+    h = p5t->ip6_addr[0].as_u64[0] ^ p5t->ip6_addr[0].as_u64[1] ^
+      p5t->ip6_addr[1].as_u64[0] ^ p5t->ip6_addr[1].as_u64[1];
+  else
+    h = p5t->ip4_addr[0].as_u32 ^ p5t->ip4_addr[1].as_u32;
+  h ^= (u64) p5t->l4.proto << 32;
+  if (p5t->pkt.l4_valid && p5t->l4.proto != icmp_protos[is_ip6])
+    h ^= (u64) (p5t->l4.port[0] ^ p5t->l4.port[1]) << 40;
+
+  return 1 + clib_xxhash (h) % n_workers;
+}
+
 
 
 always_inline int
@@ -74,7 +115,7 @@ fa_session_get_timeout_type (acl_main_t * am, fa_session_t * sess)
   u16 masked_flags =
     sess->tcp_flags_seen.as_u16 & ((TCP_FLAGS_RSTFINACKSYN << 8) +
 				   TCP_FLAGS_RSTFINACKSYN);
-  switch (sess->info.l4.proto)
+  switch (sess->l4.proto)
     {
     case IPPROTO_TCP:
       if (((TCP_FLAGS_ACKSYN << 8) + TCP_FLAGS_ACKSYN) == masked_flags)
@@ -114,33 +155,111 @@ fa_session_get_timeout (acl_main_t * am, fa_session_t * sess)
   return timeout;
 }
 
+/*
+ * The session pools hold either the full sessions, or only their first
+ * cache line with the compact layout. Either way the fields up to
+ * ip6_key_head are at the same place, so the rest of the code uses
+ * fa_session_t and does not care.
+ */
 always_inline fa_session_t *
 get_session_ptr_no_check (acl_main_t * am, u16 thread_index,
 			  u32 session_index)
 {
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  if (am->fa_use_compact_sessions)
+    return (fa_session_t *) pool_elt_at_index (pw->fa_compact_sessions_pool,
+					       session_index);
   return pool_elt_at_index (pw->fa_sessions_pool, session_index);
 }
 
+always_inline u32
+acl_fa_session_pool_len (acl_main_t * am, acl_fa_per_worker_data_t * pw)
+{
+  if (am->fa_use_compact_sessions)
+    return pool_len (pw->fa_compact_sessions_pool);
+  return pool_len (pw->fa_sessions_pool);
+}
+
+always_inline u32
+acl_fa_session_pool_elts (acl_main_t * am, acl_fa_per_worker_data_t * pw)
+{
+  if (am->fa_use_compact_sessions)
+    return pool_elts (pw->fa_compact_sessions_pool);
+  return pool_elts (pw->fa_sessions_pool);
+}
+
+always_inline int
+acl_fa_session_is_free_index (acl_main_t * am, acl_fa_per_worker_data_t * pw,
+			      u32 session_index)
+{
+  if (am->fa_use_compact_sessions)
+    return pool_is_free_index (pw->fa_compact_sessions_pool, session_index);
+  return pool_is_free_index (pw->fa_sessions_pool, session_index);
+}
+
 
 always_inline fa_session_t *
 get_session_ptr (acl_main_t * am, u16 thread_index, u32 session_index)
 {
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
 
-  if (PREDICT_FALSE (session_index >= vec_len (pw->fa_sessions_pool)))
+  if (PREDICT_FALSE (session_index >= acl_fa_session_pool_len (am, pw)))
     return 0;
 
-  return pool_elt_at_index (pw->fa_sessions_pool, session_index);
+  return get_session_ptr_no_check (am, thread_index, session_index);
 }
 
 always_inline int
 is_valid_session_ptr (acl_main_t * am, u16 thread_index, fa_session_t * sess)
 {
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
-  return ((sess != 0)
-	  && ((sess - pw->fa_sessions_pool) <
-	      pool_len (pw->fa_sessions_pool)));
+  uword offset;
+
+  if (sess == 0)
+    return 0;
+  if (am->fa_use_compact_sessions)
+    offset = (fa_session_compact_t *) sess - pw->fa_compact_sessions_pool;
+  else
+    offset = sess - pw->fa_sessions_pool;
+  return (offset < acl_fa_session_pool_len (am, pw));
+}
+
+/* Reassemble the session table key and value of an IPv6 session */
+always_inline void
+acl_fa_session_get_kv_40_8 (fa_session_t * sess, clib_bihash_kv_40_8_t * kv)
+{
+  kv->key[0] = sess->ip6_key_head[0];
+  kv->key[1] = sess->ip6_key_head[1];
+  kv->key[2] = sess->ip6_key_head[2];
+  kv->key[3] = sess->l3_key_tail;
+  kv->key[4] = sess->l4.as_u64;
+  kv->value = sess->value;
+}
+
+/*
+ * With the timer wheel, the session timer is armed for the time its
+ * idle timeout would pass if there were no more traffic. The traffic
+ * only updates the last active time, and when the timer fires the
+ * session is either deleted or the timer is armed again for the rest.
+ */
+always_inline void
+acl_fa_session_timer_start (acl_main_t * am, acl_fa_per_worker_data_t * pw,
+			    fa_session_t * sess, u32 session_index, u64 now)
+{
+  u64 timeout = fa_session_get_timeout (am, sess);
+  u64 expiry_time =
+    (sess->deleted ? now : sess->last_active_time) + timeout;
+  u64 ticks = 1;
+
+  if (expiry_time > now)
+    ticks = clib_max ((expiry_time - now) / am->fa_session_timer_tick_clocks,
+		      1);
+  sess->timer_handle =
+    tw_timer_start_1t_3w_1024sl_ov (&pw->session_timer_wheel, session_index,
+				    0, ticks);
+  expiry_time = now + ticks * am->fa_session_timer_tick_clocks;
+  if (expiry_time < pw->next_expiry_time)
+    pw->next_expiry_time = expiry_time;
 }
 
 always_inline void
@@ -160,6 +279,14 @@ acl_fa_conn_list_add_session (acl_main_t * am, fa_full_session_id_t sess_id,
   ASSERT (sess->thread_index == thread_index);
   sess->link_enqueue_time = now;
   sess->link_list_id = list_id;
+  if (am->fa_use_session_timer_wheel)
+    {
+      pw->serviced_sw_if_index_bitmap =
+	clib_bitmap_set (pw->serviced_sw_if_index_bitmap, sess->sw_if_index,
+			 1);
+      acl_fa_session_timer_start (am, pw, sess, sess_id.session_index, now);
+      return;
+    }
   sess->link_next_idx = FA_SESSION_BOGUS_INDEX;
   sess->link_prev_idx = pw->fa_conn_list_tail[list_id];
   if (FA_SESSION_BOGUS_INDEX != pw->fa_conn_list_tail[list_id])
@@ -213,6 +340,14 @@ acl_fa_conn_list_delete_session (acl_main_t * am,
 	("Attempting to delete session belonging to thread %d by thread %d",
 	 sess->thread_index, thread_index);
     }
+  if (am->fa_use_session_timer_wheel)
+    {
+      if (~0 != sess->timer_handle)
+	tw_timer_stop_1t_3w_1024sl_ov (&pw->session_timer_wheel,
+				       sess->timer_handle);
+      sess->timer_handle = ~0;
+      return 1;
+    }
   if (FA_SESSION_BOGUS_INDEX != sess->link_prev_idx)
     {
       fa_session_t *prev_sess =
@@ -356,7 +491,7 @@ reverse_l4_u64_slowpath_valid (u64 l4, int is_ip6, u64 * out)
 }
 
 always_inline void
-reverse_session_add_del_ip6 (acl_main_t * am,
+reverse_session_add_del_ip6 (clib_bihash_40_8_t * h,
 			     clib_bihash_kv_40_8_t * pkv, int is_add)
 {
   clib_bihash_kv_40_8_t kv2;
@@ -369,17 +504,17 @@ reverse_session_add_del_ip6 (acl_main_t * am,
   if (PREDICT_FALSE (is_session_l4_key_u64_slowpath (pkv->key[4])))
     {
       if (reverse_l4_u64_slowpath_valid (pkv->key[4], 1, &kv2.key[4]))
-	clib_bihash_add_del_40_8 (&am->fa_ip6_sessions_hash, &kv2, is_add);
+	clib_bihash_add_del_40_8 (h, &kv2, is_add);
     }
   else
     {
       kv2.key[4] = reverse_l4_u64_fastpath (pkv->key[4], 1);
-      clib_bihash_add_del_40_8 (&am->fa_ip6_sessions_hash, &kv2, is_add);
+      clib_bihash_add_del_40_8 (h, &kv2, is_add);
     }
 }
 
 always_inline void
-reverse_session_add_del_ip4 (acl_main_t * am,
+reverse_session_add_del_ip4 (clib_bihash_16_8_t * h,
 			     clib_bihash_kv_16_8_t * pkv, int is_add)
 {
   clib_bihash_kv_16_8_t kv2;
@@ -390,12 +525,12 @@ reverse_session_add_del_ip4 (acl_main_t * am,
   if (PREDICT_FALSE (is_session_l4_key_u64_slowpath (pkv->key[1])))
     {
       if (reverse_l4_u64_slowpath_valid (pkv->key[1], 0, &kv2.key[1]))
-	clib_bihash_add_del_16_8 (&am->fa_ip4_sessions_hash, &kv2, is_add);
+	clib_bihash_add_del_16_8 (h, &kv2, is_add);
     }
   else
     {
       kv2.key[1] = reverse_l4_u64_fastpath (pkv->key[1], 0);
-      clib_bihash_add_del_16_8 (&am->fa_ip4_sessions_hash, &kv2, is_add);
+      clib_bihash_add_del_16_8 (h, &kv2, is_add);
     }
 }
 
@@ -408,15 +543,19 @@ acl_fa_deactivate_session (acl_main_t * am, u32 sw_if_index,
   ASSERT (sess->thread_index == os_get_thread_index ());
   if (sess->is_ip6)
     {
-      clib_bihash_add_del_40_8 (&am->fa_ip6_sessions_hash,
-				&sess->info.kv_40_8, 0);
-      reverse_session_add_del_ip6 (am, &sess->info.kv_40_8, 0);
+      clib_bihash_40_8_t *h =
+	acl_fa_ip6_sessions_hash (am, sess_id.thread_index);
+      clib_bihash_kv_40_8_t kv;
+      acl_fa_session_get_kv_40_8 (sess, &kv);
+      clib_bihash_add_del_40_8 (h, &kv, 0);
+      reverse_session_add_del_ip6 (h, &kv, 0);
     }
   else
     {
-      clib_bihash_add_del_16_8 (&am->fa_ip4_sessions_hash,
-				&sess->info.kv_16_8, 0);
-      reverse_session_add_del_ip4 (am, &sess->info.kv_16_8, 0);
+      clib_bihash_16_8_t *h =
+	acl_fa_ip4_sessions_hash (am, sess_id.thread_index);
+      clib_bihash_add_del_16_8 (h, &sess->kv_16_8, 0);
+      reverse_session_add_del_ip4 (h, &sess->kv_16_8, 0);
     }
 
   sess->deleted = 1;
@@ -434,7 +573,10 @@ acl_fa_put_session (acl_main_t * am, u32 sw_if_index,
 	 sess_id.thread_index, os_get_thread_index ());
     }
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[sess_id.thread_index];
-  pool_put_index (pw->fa_sessions_pool, sess_id.session_index);
+  if (am->fa_use_compact_sessions)
+    pool_put_index (pw->fa_compact_sessions_pool, sess_id.session_index);
+  else
+    pool_put_index (pw->fa_sessions_pool, sess_id.session_index);
   /* Deleting from timer structures not needed,
      as the caller must have dealt with the timers. */
   vec_validate (pw->fa_session_dels_by_sw_if_index, sw_if_index);
@@ -477,6 +619,12 @@ acl_fa_try_recycle_session (acl_main_t * am, int is_input, u16 thread_index,
 {
   /* try to recycle a TCP transient session */
   acl_fa_per_worker_data_t *pw = &am->per_worker_data[thread_index];
+  /*
+   * The timer wheel does not keep the sessions in the timeout order,
+   * so there is nothing to pick the oldest ones from.
+   */
+  if (am->fa_use_session_timer_wheel)
+    return;
   fa_full_session_id_t volatile sess_id;
   int n_recycled = 0;
 
@@ -528,25 +676,37 @@ acl_fa_add_session (acl_main_t * am, int is_input, int is_ip6,
       clib_error ("Adding session with invalid value");
     }
 
-  pool_get_aligned (pw->fa_sessions_pool, sess, CLIB_CACHE_LINE_BYTES);
-  f_sess_id.session_index = sess - pw->fa_sessions_pool;
+  if (am->fa_use_compact_sessions)
+    {
+      fa_session_compact_t *csess;
+      /* there is no room for the IPv6 addresses */
+      ASSERT (!is_ip6);
+      pool_get_aligned (pw->fa_compact_sessions_pool, csess,
+			CLIB_CACHE_LINE_BYTES);
+      f_sess_id.session_index = csess - pw->fa_compact_sessions_pool;
+      sess = (fa_session_t *) csess;
+    }
+  else
+    {
+      pool_get_aligned (pw->fa_sessions_pool, sess, CLIB_CACHE_LINE_BYTES);
+      f_sess_id.session_index = sess - pw->fa_sessions_pool;
+    }
   f_sess_id.intf_policy_epoch = current_policy_epoch;
 
   if (is_ip6)
     {
-      sess->info.kv_40_8.key[0] = p5tuple->kv_40_8.key[0];
-      sess->info.kv_40_8.key[1] = p5tuple->kv_40_8.key[1];
-      sess->info.kv_40_8.key[2] = p5tuple->kv_40_8.key[2];
-      sess->info.kv_40_8.key[3] = p5tuple->kv_40_8.key[3];
-      sess->info.kv_40_8.key[4] = p5tuple->kv_40_8.key[4];
-      sess->info.kv_40_8.value = f_sess_id.as_u64;
+      sess->ip6_key_head[0] = p5tuple->kv_40_8.key[0];
+      sess->ip6_key_head[1] = p5tuple->kv_40_8.key[1];
+      sess->ip6_key_head[2] = p5tuple->kv_40_8.key[2];
+      sess->l3_key_tail = p5tuple->kv_40_8.key[3];
+      sess->l4.as_u64 = p5tuple->kv_40_8.key[4];
     }
   else
     {
-      sess->info.kv_16_8.key[0] = p5tuple->kv_16_8.key[0];
-      sess->info.kv_16_8.key[1] = p5tuple->kv_16_8.key[1];
-      sess->info.kv_16_8.value = f_sess_id.as_u64;
+      sess->l3_key_tail = p5tuple->kv_16_8.key[0];
+      sess->l4.as_u64 = p5tuple->kv_16_8.key[1];
     }
+  sess->value = f_sess_id.as_u64;
 
   sess->last_active_time = now;
   sess->sw_if_index = sw_if_index;
@@ -555,6 +715,7 @@ acl_fa_add_session (acl_main_t * am, int is_input, int is_ip6,
   sess->link_list_id = ACL_TIMEOUT_UNUSED;
   sess->link_prev_idx = FA_SESSION_BOGUS_INDEX;
   sess->link_next_idx = FA_SESSION_BOGUS_INDEX;
+  sess->timer_handle = ~0;
   sess->deleted = 0;
   sess->is_ip6 = is_ip6;
 
@@ -563,15 +724,17 @@ acl_fa_add_session (acl_main_t * am, int is_input, int is_ip6,
   ASSERT (am->fa_sessions_hash_is_initialized == 1);
   if (is_ip6)
     {
-      reverse_session_add_del_ip6 (am, &sess->info.kv_40_8, 1);
-      clib_bihash_add_del_40_8 (&am->fa_ip6_sessions_hash,
-				&sess->info.kv_40_8, 1);
+      clib_bihash_40_8_t *h = acl_fa_ip6_sessions_hash (am, thread_index);
+      clib_bihash_kv_40_8_t kv;
+      acl_fa_session_get_kv_40_8 (sess, &kv);
+      reverse_session_add_del_ip6 (h, &kv, 1);
+      clib_bihash_add_del_40_8 (h, &kv, 1);
     }
   else
     {
-      reverse_session_add_del_ip4 (am, &sess->info.kv_16_8, 1);
-      clib_bihash_add_del_16_8 (&am->fa_ip4_sessions_hash,
-				&sess->info.kv_16_8, 1);
+      clib_bihash_16_8_t *h = acl_fa_ip4_sessions_hash (am, thread_index);
+      reverse_session_add_del_ip4 (h, &sess->kv_16_8, 1);
+      clib_bihash_add_del_16_8 (h, &sess->kv_16_8, 1);
     }
 
   vec_validate (pw->fa_session_adds_by_sw_if_index, sw_if_index);
@@ -589,14 +752,16 @@ acl_fa_find_session (acl_main_t * am, int is_ip6, u32 sw_if_index0,
     {
       clib_bihash_kv_40_8_t kv_result;
       res = (clib_bihash_search_inline_2_40_8
-	     (&am->fa_ip6_sessions_hash, &p5tuple->kv_40_8, &kv_result) == 0);
+	     (acl_fa_ip6_sessions_hash (am, os_get_thread_index ()),
+	      &p5tuple->kv_40_8, &kv_result) == 0);
       *pvalue_sess = kv_result.value;
     }
   else
     {
       clib_bihash_kv_16_8_t kv_result;
       res = (clib_bihash_search_inline_2_16_8
-	     (&am->fa_ip4_sessions_hash, &p5tuple->kv_16_8, &kv_result) == 0);
+	     (acl_fa_ip4_sessions_hash (am, os_get_thread_index ()),
+	      &p5tuple->kv_16_8, &kv_result) == 0);
       *pvalue_sess = kv_result.value;
     }
   return res;
@@ -617,18 +782,22 @@ acl_fa_prefetch_session_bucket_for_hash (acl_main_t * am, int is_ip6,
 					 u64 hash)
 {
   if (is_ip6)
-    clib_bihash_prefetch_bucket_40_8 (&am->fa_ip6_sessions_hash, hash);
+    clib_bihash_prefetch_bucket_40_8
+      (acl_fa_ip6_sessions_hash (am, os_get_thread_index ()), hash);
   else
-    clib_bihash_prefetch_bucket_16_8 (&am->fa_ip4_sessions_hash, hash);
+    clib_bihash_prefetch_bucket_16_8
+      (acl_fa_ip4_sessions_hash (am, os_get_thread_index ()), hash);
 }
 
 always_inline void
 acl_fa_prefetch_session_data_for_hash (acl_main_t * am, int is_ip6, u64 hash)
 {
   if (is_ip6)
-    clib_bihash_prefetch_data_40_8 (&am->fa_ip6_sessions_hash, hash);
+    clib_bihash_prefetch_data_40_8
+      (acl_fa_ip6_sessions_hash (am, os_get_thread_index ()), hash);
   else
-    clib_bihash_prefetch_data_16_8 (&am->fa_ip4_sessions_hash, hash);
+    clib_bihash_prefetch_data_16_8
+      (acl_fa_ip4_sessions_hash (am, os_get_thread_index ()), hash);
 }
 
 always_inline int
@@ -642,8 +811,8 @@ acl_fa_find_session_with_hash (acl_main_t * am, int is_ip6, u32 sw_if_index0,
       clib_bihash_kv_40_8_t kv_result;
       kv_result.value = ~0ULL;
       res = (clib_bihash_search_inline_2_with_hash_40_8
-	     (&am->fa_ip6_sessions_hash, hash, &p5tuple->kv_40_8,
-	      &kv_result) == 0);
+	     (acl_fa_ip6_sessions_hash (am, os_get_thread_index ()), hash,
+	      &p5tuple->kv_40_8, &kv_result) == 0);
       *pvalue_sess = kv_result.value;
     }
   else
@@ -651,8 +820,8 @@ acl_fa_find_session_with_hash (acl_main_t * am, int is_ip6, u32 sw_if_index0,
       clib_bihash_kv_16_8_t kv_result;
       kv_result.value = ~0ULL;
       res = (clib_bihash_search_inline_2_with_hash_16_8
-	     (&am->fa_ip4_sessions_hash, hash, &p5tuple->kv_16_8,
-	      &kv_result) == 0);
+	     (acl_fa_ip4_sessions_hash (am, os_get_thread_index ()), hash,
+	      &p5tuple->kv_16_8, &kv_result) == 0);
       *pvalue_sess = kv_result.value;
     }
   return res;
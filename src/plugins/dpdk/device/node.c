@@ -38,7 +38,8 @@ static char *dpdk_error_strings[] = {
 
 /* make sure all flags we need are stored in lower 32 bits */
 STATIC_ASSERT ((u64) (RTE_MBUF_F_RX_IP_CKSUM_BAD | RTE_MBUF_F_RX_L4_CKSUM_BAD |
-		      RTE_MBUF_F_RX_FDIR | RTE_MBUF_F_RX_LRO) < (1ULL << 32),
+		      RTE_MBUF_F_RX_FDIR | RTE_MBUF_F_RX_LRO |
+		      RTE_MBUF_F_RX_RSS_HASH) < (1ULL << 32),
 	       "dpdk flags not in lower word, fix needed");
 
 STATIC_ASSERT (RTE_MBUF_F_RX_L4_CKSUM_BAD == (1ULL << 3),
@@ -339,6 +340,22 @@ dpdk_process_lro_offload (dpdk_device_t *xd, dpdk_per_thread_data_t *ptd,
     }
 }
 
+static_always_inline void
+dpdk_process_rss_hash (dpdk_per_thread_data_t *ptd, uword n_rx_packets)
+{
+  uword n;
+  vlib_buffer_t *b0;
+  for (n = 0; n < n_rx_packets; n++)
+    {
+      if (ptd->flags[n] & RTE_MBUF_F_RX_RSS_HASH)
+	{
+	  b0 = vlib_buffer_from_rte_mbuf (ptd->mbufs[n]);
+	  b0->flags |= VNET_BUFFER_F_RX_FLOW_HASH;
+	  vnet_buffer2 (b0)->rx_flow_hash = ptd->mbufs[n]->hash.rss;
+	}
+    }
+}
+
 static_always_inline u32
 dpdk_device_input (vlib_main_t * vm, dpdk_main_t * dm, dpdk_device_t * xd,
 		   vlib_node_runtime_t * node, u32 thread_index, u16 queue_id)
@@ -406,6 +423,10 @@ dpdk_device_input (vlib_main_t * vm, dpdk_main_t * dm, dpdk_device_t * xd,
   if (PREDICT_FALSE ((or_flags & RTE_MBUF_F_RX_LRO)))
     dpdk_process_lro_offload (xd, ptd, n_rx_packets);
 
+  /* keep the RSS hash, it may be used as the flow hash for ECMP */
+  if (PREDICT_FALSE ((or_flags & RTE_MBUF_F_RX_RSS_HASH)))
+    dpdk_process_rss_hash (ptd, n_rx_packets);
+
   if (PREDICT_FALSE ((or_flags & RTE_MBUF_F_RX_L4_CKSUM_BAD) &&
 		     (xd->buffer_flags & VNET_BUFFER_F_L4_CHECKSUM_CORRECT)))
     {
@@ -277,6 +277,7 @@ gre_input (vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame,
 	    vm->thread_index, tun_sw_if_index[0], 1 /* packets */,
 	    len[0] /* bytes */);
 	  vnet_buffer (b[0])->sw_if_index[VLIB_RX] = tun_sw_if_index[0];
+	  vnet_buffer_rx_flow_hash_clear (b[0]);
 	}
       if (PREDICT_TRUE (next[1] > GRE_INPUT_NEXT_DROP))
 	{
@@ -286,6 +287,7 @@ gre_input (vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame,
 	    vm->thread_index, tun_sw_if_index[1], 1 /* packets */,
 	    len[1] /* bytes */);
 	  vnet_buffer (b[1])->sw_if_index[VLIB_RX] = tun_sw_if_index[1];
+	  vnet_buffer_rx_flow_hash_clear (b[1]);
 	}
 
       vnet_buffer (b[0])->sw_if_index[VLIB_TX] = (u32) ~0;
@@ -394,6 +396,7 @@ gre_input (vlib_main_t *vm, vlib_node_runtime_t *node, vlib_frame_t *frame,
 	    vm->thread_index, tun_sw_if_index[0], 1 /* packets */,
 	    len[0] /* bytes */);
 	  vnet_buffer (b[0])->sw_if_index[VLIB_RX] = tun_sw_if_index[0];
+	  vnet_buffer_rx_flow_hash_clear (b[0]);
 	}
 
       vnet_buffer (b[0])->sw_if_index[VLIB_TX] = (u32) ~0;
@@ -178,6 +178,8 @@ last_stage (vlib_main_t * vm, vlib_node_runtime_t * node, vlib_buffer_t * b)
 
   vnet_buffer (b)->sw_if_index[VLIB_RX] = session->sw_if_index;
 
+  vnet_buffer_rx_flow_hash_clear (b);
+
   if (PREDICT_FALSE (!(session->admin_up)))
     {
       b->error = node->errors[L2T_DECAP_ERROR_ADMIN_DOWN];
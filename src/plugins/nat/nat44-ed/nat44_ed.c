@@ -2124,6 +2124,10 @@ snat_set_workers (uword * bitmap)
   if (clib_bitmap_last_set (bitmap) >= sm->num_workers)
     return VNET_API_ERROR_INVALID_WORKER;
 
+  /* the port blocks are sized by the port range of a worker */
+  if (sm->enabled && sm->port_block_size)
+    return VNET_API_ERROR_FEATURE_ALREADY_ENABLED;
+
   vec_free (sm->workers);
   clib_bitmap_foreach (i, bitmap)
     {
@@ -2432,6 +2436,12 @@ nat44_plugin_enable (nat44_config_t c)
 
   fail_if_enabled ();
 
+  if (c.port_block_size > sm->port_per_thread)
+    {
+      nat_log_err ("port block size larger than the ports of a thread");
+      return VNET_API_ERROR_INVALID_VALUE;
+    }
+
   sm->forwarding_enabled = 0;
   sm->mss_clamping = 0;
 
@@ -2442,6 +2452,9 @@ nat44_plugin_enable (nat44_config_t c)
   vlib_stats_set_gauge (sm->max_cfg_sessions_gauge,
 			sm->max_translations_per_thread);
   sm->translation_buckets = nat_calc_bihash_buckets (c.sessions);
+  sm->per_thread_flow_hash = c.per_thread_flow_hash;
+  sm->port_block_size = c.port_block_size;
+  sm->expiry_timer_wheel = c.expiry_timer_wheel;
 
   vec_add1 (sm->max_translations_per_fib, sm->max_translations_per_thread);
 
@@ -2495,6 +2508,10 @@ nat44_plugin_enable (nat44_config_t c)
   sm->enabled = 1;
   sm->rconfig = c;
 
+  if (sm->expiry_timer_wheel)
+    vlib_process_signal_event (vlib_get_main (),
+			       nat44_ed_expire_process_node.index, 0, 0);
+
   return 0;
 }
 
@@ -2696,6 +2713,9 @@ nat44_plugin_disable ()
   sm->max_translations_per_fib = 0;
 
   nat44_ed_db_free ();
+  sm->per_thread_flow_hash = 0;
+  sm->port_block_size = 0;
+  sm->expiry_timer_wheel = 0;
 
   clib_memset (&sm->rconfig, 0, sizeof (sm->rconfig));
 
@@ -2949,13 +2969,27 @@ nat44_ed_get_in2out_worker_index (vlib_buffer_t *b, ip4_header_t *ip,
 {
   snat_main_t *sm = &snat_main;
   u32 next_worker_index = sm->first_worker_index;
+  u32 hash_worker_index = sm->first_worker_index;
   u32 hash;
 
   clib_bihash_kv_16_8_t kv16, value16;
 
   u32 fib_index = rx_fib_index;
+
+  hash = ip->src_address.as_u32 + (ip->src_address.as_u32 >> 8) +
+	 (ip->src_address.as_u32 >> 16) + (ip->src_address.as_u32 >> 24) +
+	 rx_fib_index + (rx_fib_index >> 8) + (rx_fib_index >> 16) +
+	 (rx_fib_index >> 24);
+
+  if (PREDICT_TRUE (is_pow2 (_vec_len (sm->workers))))
+    hash_worker_index += sm->workers[hash & (_vec_len (sm->workers) - 1)];
+  else
+    hash_worker_index += sm->workers[hash % _vec_len (sm->workers)];
+
   if (b)
     {
+      int search_all = nat44_ed_flow_owner_may_differ (sm);
+
       if (PREDICT_FALSE (is_output))
 	{
 	  fib_index = sm->outside_fib_index;
@@ -3000,6 +3034,12 @@ nat44_ed_get_in2out_worker_index (vlib_buffer_t *b, ip4_header_t *ip,
 	  u16 lookup_sport, lookup_dport;
 	  u8 lookup_protocol;
 
+	  /* the sender of an ICMP error says nothing about the owner of the
+	   * session of the embedded packet */
+	  if (icmp_type_is_error_message (
+		vnet_buffer (b)->ip.reass.icmp_type_or_tcp_flags))
+	    search_all = 1;
+
 	  if (!nat_get_icmp_session_lookup_values (
 		b, ip, &lookup_saddr, &lookup_sport, &lookup_daddr,
 		&lookup_dport, &lookup_protocol))
@@ -3007,7 +3047,8 @@ nat44_ed_get_in2out_worker_index (vlib_buffer_t *b, ip4_header_t *ip,
 	      init_ed_k (&kv16, lookup_saddr.as_u32, lookup_sport,
 			 lookup_daddr.as_u32, lookup_dport, rx_fib_index,
 			 lookup_protocol);
-	      if (!clib_bihash_search_16_8 (&sm->flow_hash, &kv16, &value16))
+	      if (!nat44_ed_flow_hash_search (sm, hash_worker_index,
+					      search_all, &kv16, &value16))
 		{
 		  next_worker_index = ed_value_get_thread_index (&value16);
 		  vnet_buffer2 (b)->nat.cached_session_index =
@@ -3022,7 +3063,8 @@ nat44_ed_get_in2out_worker_index (vlib_buffer_t *b, ip4_header_t *ip,
 		 vnet_buffer (b)->ip.reass.l4_dst_port, fib_index,
 		 ip->protocol);
 
-      if (!clib_bihash_search_16_8 (&sm->flow_hash, &kv16, &value16))
+      if (!nat44_ed_flow_hash_search (sm, hash_worker_index, search_all,
+				      &kv16, &value16))
 	{
 	  next_worker_index = ed_value_get_thread_index (&value16);
 	  vnet_buffer2 (b)->nat.cached_session_index =
@@ -3035,7 +3077,8 @@ nat44_ed_get_in2out_worker_index (vlib_buffer_t *b, ip4_header_t *ip,
 		 vnet_buffer (b)->ip.reass.l4_dst_port, ip->src_address.as_u32,
 		 vnet_buffer (b)->ip.reass.l4_src_port, rx_fib_index,
 		 ip->protocol);
-      if (!clib_bihash_search_16_8 (&sm->flow_hash, &kv16, &value16))
+      if (!nat44_ed_flow_hash_search (sm, hash_worker_index, search_all,
+				      &kv16, &value16))
 	{
 	  next_worker_index = ed_value_get_thread_index (&value16);
 	  vnet_buffer2 (b)->nat.cached_dst_nat_session_index =
@@ -3044,15 +3087,7 @@ nat44_ed_get_in2out_worker_index (vlib_buffer_t *b, ip4_header_t *ip,
 	}
     }
 
-  hash = ip->src_address.as_u32 + (ip->src_address.as_u32 >> 8) +
-	 (ip->src_address.as_u32 >> 16) + (ip->src_address.as_u32 >> 24) +
-	 rx_fib_index + (rx_fib_index >> 8) + (rx_fib_index >> 16) +
-	 (rx_fib_index >> 24);
-
-  if (PREDICT_TRUE (is_pow2 (_vec_len (sm->workers))))
-    next_worker_index += sm->workers[hash & (_vec_len (sm->workers) - 1)];
-  else
-    next_worker_index += sm->workers[hash % _vec_len (sm->workers)];
+  next_worker_index = hash_worker_index;
 
 out:
   if (PREDICT_TRUE (!is_output))
@@ -3073,6 +3108,17 @@ out:
   return next_worker_index;
 }
 
+/* thread expected to own the session with the outside port */
+static_always_inline u32
+nat44_ed_get_o2i_port_owner (u16 port)
+{
+  u16 host_port = clib_net_to_host_u16 (port);
+
+  if (host_port < ED_USER_PORT_OFFSET)
+    return vlib_get_thread_index ();
+  return get_thread_idx_by_port (host_port);
+}
+
 u32
 nat44_ed_get_out2in_worker_index (vlib_buffer_t *b, ip4_header_t *ip,
 				  u32 rx_fib_index, u8 is_output)
@@ -3084,14 +3130,24 @@ nat44_ed_get_out2in_worker_index (vlib_buffer_t *b, ip4_header_t *ip,
   u16 port;
   snat_static_mapping_t *m;
   u32 hash;
+  int search_all;
 
   proto = ip->protocol;
+  search_all = nat44_ed_flow_owner_may_differ (sm) ||
+	       nat44_ed_is_unk_proto (proto);
 
   if (PREDICT_FALSE (IP_PROTOCOL_ICMP == proto))
     {
       ip4_address_t lookup_saddr, lookup_daddr;
       u16 lookup_sport, lookup_dport;
       u8 lookup_protocol;
+
+      /* the embedded packet of an ICMP error may have been translated by
+       * another worker than the one of its outside port, search them all */
+      if (icmp_type_is_error_message (
+	    vnet_buffer (b)->ip.reass.icmp_type_or_tcp_flags))
+	search_all = 1;
+
       if (!nat_get_icmp_session_lookup_values (
 	    b, ip, &lookup_saddr, &lookup_sport, &lookup_daddr, &lookup_dport,
 	    &lookup_protocol))
@@ -3099,8 +3155,9 @@ nat44_ed_get_out2in_worker_index (vlib_buffer_t *b, ip4_header_t *ip,
 	  init_ed_k (&kv16, lookup_saddr.as_u32, lookup_sport,
 		     lookup_daddr.as_u32, lookup_dport, rx_fib_index,
 		     lookup_protocol);
-	  if (PREDICT_TRUE (
-		!clib_bihash_search_16_8 (&sm->flow_hash, &kv16, &value16)))
+	  if (PREDICT_TRUE (!nat44_ed_flow_hash_search (
+		sm, nat44_ed_get_o2i_port_owner (lookup_dport), search_all,
+		&kv16, &value16)))
 	    {
 	      next_worker_index = ed_value_get_thread_index (&value16);
 	      nat_elog_debug_handoff (
@@ -3117,8 +3174,10 @@ nat44_ed_get_out2in_worker_index (vlib_buffer_t *b, ip4_header_t *ip,
 	     vnet_buffer (b)->ip.reass.l4_dst_port, rx_fib_index,
 	     ip->protocol);
 
-  if (PREDICT_TRUE (
-	!clib_bihash_search_16_8 (&sm->flow_hash, &kv16, &value16)))
+  if (PREDICT_TRUE (!nat44_ed_flow_hash_search (
+	sm,
+	nat44_ed_get_o2i_port_owner (vnet_buffer (b)->ip.reass.l4_dst_port),
+	search_all, &kv16, &value16)))
     {
       vnet_buffer2 (b)->nat.cached_session_index =
 	ed_value_get_session_index (&value16);
@@ -3272,8 +3331,23 @@ nat44_update_session_limit (u32 session_limit, u32 vrf_id)
 static void
 nat44_ed_worker_db_init (snat_main_per_thread_data_t *tsm, u32 translations)
 {
+  snat_main_t *sm = &snat_main;
   dlist_elt_t *head;
 
+  if (sm->per_thread_flow_hash)
+    {
+      // we expect 2 flows per session
+      clib_bihash_init_16_8 (&tsm->flow_hash, "ed-flow-hash",
+			     2 * sm->translation_buckets, 0);
+      clib_bihash_set_kvp_format_fn_16_8 (&tsm->flow_hash,
+					  format_ed_session_kvp);
+    }
+
+  if (sm->expiry_timer_wheel)
+    tw_timer_wheel_init_1t_3w_1024sl_ov (&tsm->expiry_timer_wheel, 0,
+					 NAT44_ED_EXPIRY_TICK,
+					 NAT44_ED_EXPIRY_MAX_PER_TICK);
+
   pool_alloc (tsm->per_vrf_sessions_pool, translations);
   pool_alloc (tsm->sessions, translations);
   pool_alloc (tsm->lru_pool, translations);
@@ -3303,10 +3377,14 @@ static void
 nat44_ed_flow_hash_init ()
 {
   snat_main_t *sm = &snat_main;
+  u32 nbuckets;
+
   // we expect 2 flows per session, so multiply translation_buckets by 2
-  clib_bihash_init_16_8 (
-    &sm->flow_hash, "ed-flow-hash",
-    clib_max (1, sm->num_workers) * 2 * sm->translation_buckets, 0);
+  if (sm->per_thread_flow_hash)
+    nbuckets = sm->translation_buckets; // static mappings only
+  else
+    nbuckets = clib_max (1, sm->num_workers) * 2 * sm->translation_buckets;
+  clib_bihash_init_16_8 (&sm->flow_hash, "ed-flow-hash", nbuckets, 0);
   clib_bihash_set_kvp_format_fn_16_8 (&sm->flow_hash, format_ed_session_kvp);
 }
 
@@ -3327,6 +3405,31 @@ nat44_ed_db_init ()
 static void
 nat44_ed_worker_db_free (snat_main_per_thread_data_t *tsm)
 {
+  snat_main_t *sm = &snat_main;
+  nat44_ed_port_blocks_t *pb;
+  u32 subscriber, *blocks;
+
+  if (sm->per_thread_flow_hash)
+    clib_bihash_free_16_8 (&tsm->flow_hash);
+  pool_foreach (pb, tsm->port_blocks)
+    {
+      clib_bitmap_free (pb->used_ports);
+      clib_bitmap_free (pb->assigned_blocks);
+      clib_bitmap_free (pb->full_blocks);
+      vec_free (pb->port_sessions);
+      vec_free (pb->block_used_ports);
+      vec_free (pb->block_subscriber);
+      hash_foreach (subscriber, blocks, pb->blocks_by_subscriber,
+		    ({ vec_free (blocks); }));
+      hash_free (pb->blocks_by_subscriber);
+    }
+  pool_free (tsm->port_blocks);
+  hash_free (tsm->port_blocks_by_addr);
+  if (sm->expiry_timer_wheel)
+    {
+      tw_timer_wheel_free_1t_3w_1024sl_ov (&tsm->expiry_timer_wheel);
+      vec_free (tsm->expired_sessions);
+    }
   pool_free (tsm->lru_pool);
   pool_free (tsm->sessions);
   pool_free (tsm->per_vrf_sessions_pool);
@@ -3632,10 +3735,13 @@ nat44_ed_del_session (snat_main_t *sm, ip4_address_t *addr, u16 port,
 
   init_ed_k (&kv, addr->as_u32, port, eh_addr->as_u32, eh_port, fib_index,
 	     proto);
-  if (clib_bihash_search_16_8 (&sm->flow_hash, &kv, &value))
+  if (nat44_ed_flow_hash_search (sm, tsm - sm->per_thread_data, 1, &kv,
+				 &value))
     {
       return VNET_API_ERROR_NO_SUCH_ENTRY;
     }
+  tsm = vec_elt_at_index (sm->per_thread_data,
+			  ed_value_get_thread_index (&value));
 
   if (pool_is_free_index (tsm->sessions, ed_value_get_session_index (&value)))
     return VNET_API_ERROR_UNSPECIFIED;
@@ -3673,6 +3779,111 @@ VLIB_REGISTER_NODE (nat_default_node) = {
   },
 };
 
+/* per thread expiry of the sessions whose timers have fired */
+static uword
+nat44_ed_expire_worker_fn (vlib_main_t *vm, vlib_node_runtime_t *rt,
+			   vlib_frame_t *f)
+{
+  snat_main_t *sm = &snat_main;
+  snat_main_per_thread_data_t *tsm;
+  u32 thread_index = vm->thread_index;
+  f64 now = vlib_time_now (vm);
+  snat_session_t *s;
+  u32 *si;
+
+  if (!sm->enabled || !sm->expiry_timer_wheel ||
+      thread_index >= vec_len (sm->per_thread_data))
+    return 0;
+
+  tsm = vec_elt_at_index (sm->per_thread_data, thread_index);
+  /* at most NAT44_ED_EXPIRY_MAX_PER_TICK timers per run */
+  vec_reset_length (tsm->expired_sessions);
+  tsm->expired_sessions = tw_timer_expire_timers_vec_1t_3w_1024sl_ov (
+    &tsm->expiry_timer_wheel, now, tsm->expired_sessions);
+
+  vec_foreach (si, tsm->expired_sessions)
+    {
+      if (pool_is_free_index (tsm->sessions, *si))
+	continue;
+      s = pool_elt_at_index (tsm->sessions, *si);
+      s->timer_handle = ~0;
+      if (now < s->last_heard + (f64) nat44_session_get_timeout (sm, s))
+	{
+	  /* refreshed by traffic since the timer was armed */
+	  nat44_ed_session_timer_start (sm, tsm, s, now);
+	  continue;
+	}
+      nat44_ed_free_session_data (sm, s, thread_index, 0);
+      nat_ed_session_delete (sm, s, thread_index, 1);
+    }
+
+  /* more timers are due, run again at once rather than on the next tick */
+  if (vec_len (tsm->expired_sessions) >= NAT44_ED_EXPIRY_MAX_PER_TICK)
+    vlib_node_set_interrupt_pending (vm, rt->node_index);
+  return 0;
+}
+
+VLIB_REGISTER_NODE (nat44_ed_expire_worker_node) = {
+  .function = nat44_ed_expire_worker_fn,
+  .type = VLIB_NODE_TYPE_INPUT,
+  .state = VLIB_NODE_STATE_INTERRUPT,
+  .name = "nat44-ed-expire-worker",
+};
+
+/* periodically interrupt each thread to run its session expiry timers */
+static uword
+nat44_ed_expire_process (vlib_main_t *vm, vlib_node_runtime_t *rt,
+			 vlib_frame_t *f)
+{
+  snat_main_t *sm = &snat_main;
+  u32 ti;
+
+  while (1)
+    {
+      if (sm->enabled && sm->expiry_timer_wheel)
+	vlib_process_wait_for_event_or_clock (vm, NAT44_ED_EXPIRY_TICK);
+      else
+	vlib_process_wait_for_event (vm);
+      vlib_process_get_events (vm, 0);
+
+      if (!sm->enabled || !sm->expiry_timer_wheel)
+	continue;
+
+      for (ti = 0; ti < vec_len (sm->per_thread_data); ti++)
+	vlib_node_set_interrupt_pending (vlib_get_main_by_index (ti),
+					 nat44_ed_expire_worker_node.index);
+    }
+
+  return 0;
+}
+
+VLIB_REGISTER_NODE (nat44_ed_expire_process_node) = {
+  .function = nat44_ed_expire_process,
+  .type = VLIB_NODE_TYPE_PROCESS,
+  .name = "nat44-ed-expire-process",
+};
+
+void
+nat44_ed_expiry_timers_restart (void)
+{
+  snat_main_t *sm = &snat_main;
+  snat_main_per_thread_data_t *tsm;
+  snat_session_t *s;
+  f64 now = vlib_time_now (vlib_get_main ());
+
+  if (!sm->enabled || !sm->expiry_timer_wheel)
+    return;
+
+  vec_foreach (tsm, sm->per_thread_data)
+    {
+      pool_foreach (s, tsm->sessions)
+	{
+	  nat44_ed_session_timer_stop (tsm, s);
+	  nat44_ed_session_timer_start (sm, tsm, s, now);
+	}
+    }
+}
+
 void
 nat_6t_l3_l4_csum_calc (nat_6t_flow_t *f)
 {
@@ -3984,6 +4195,17 @@ nat_6t_flow_buf_translate (vlib_main_t *vm, snat_main_t *sm, vlib_buffer_t *b,
 
   if (IP_PROTOCOL_ICMP == proto)
     {
+      if (is_i2o && ip->src_address.as_u32 != f->match.saddr.as_u32)
+	{
+	  // error returned from an inside router, the checksum delta of the
+	  // flow is for the address of the session host
+	  ip_csum_t sum = ip->checksum;
+	  sum = ip_csum_update (sum, ip->src_address.as_u32,
+				f->match.saddr.as_u32, ip4_header_t,
+				src_address);
+	  ip->checksum = ip_csum_fold (sum);
+	  ip->src_address = f->match.saddr;
+	}
       if (ip->src_address.as_u32 != f->rewrite.saddr.as_u32)
 	{
 	  // packet is returned from a router, not from destination
@@ -4101,6 +4323,172 @@ nat_syslog_nat44_sdel (u32 ssubix, u32 sfibix, ip4_address_t *isaddr,
 			 idaddr, idport, xdaddr, xdport, proto, 0,
 			 is_twicenat);
 }
+
+static void
+nat_syslog_nat44_port_block (ip4_address_t *isaddr, ip4_address_t *xsaddr,
+			     u16 xsport, u16 xeport, u8 is_add)
+{
+  syslog_msg_t syslog_msg;
+
+  if (!syslog_is_enabled ())
+    return;
+
+  if (syslog_severity_filter_block (PBADD_PBDEL_SEVERITY))
+    return;
+
+  syslog_msg_init (&syslog_msg, NAT_FACILITY, PBADD_PBDEL_SEVERITY,
+		   NAT_APPNAME, is_add ? PBADD_MSGID : PBDEL_MSGID);
+
+  syslog_msg_sd_init (&syslog_msg, NPBLK_SDID);
+  syslog_msg_add_sd_param (&syslog_msg, SSUBIX_SDPARAM_NAME, "%d", 0);
+  syslog_msg_add_sd_param (&syslog_msg, IATYP_SDPARAM_NAME, IATYP_IPV4);
+  syslog_msg_add_sd_param (&syslog_msg, ISADDR_SDPARAM_NAME, "%U",
+			   format_ip4_address, isaddr);
+  syslog_msg_add_sd_param (&syslog_msg, XATYP_SDPARAM_NAME, IATYP_IPV4);
+  syslog_msg_add_sd_param (&syslog_msg, XSADDR_SDPARAM_NAME, "%U",
+			   format_ip4_address, xsaddr);
+  syslog_msg_add_sd_param (&syslog_msg, XSPORT_SDPARAM_NAME, "%d", xsport);
+  syslog_msg_add_sd_param (&syslog_msg, XEPORT_SDPARAM_NAME, "%d", xeport);
+
+  syslog_msg_send (&syslog_msg);
+}
+
+static void
+nat44_ed_port_block_log (snat_main_t *sm, u32 thread_index,
+			 nat44_ed_port_blocks_t *pb, u32 block, u8 is_add)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, thread_index);
+  u16 first_port = sm->port_per_thread * tsm->snat_thread_index +
+		   ED_USER_PORT_OFFSET + block * sm->port_block_size;
+
+  nat_syslog_nat44_port_block (
+    &pb->block_subscriber[block], &pb->addr, first_port,
+    first_port + nat44_ed_port_block_n_ports (sm, block) - 1, is_add);
+}
+
+nat44_ed_port_blocks_t *
+nat44_ed_port_blocks_get (snat_main_t *sm, u32 thread_index,
+			  ip4_address_t addr)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, thread_index);
+  nat44_ed_port_blocks_t *pb;
+  u32 n_blocks;
+  uword *p;
+
+  p = hash_get (tsm->port_blocks_by_addr, addr.as_u32);
+  if (p)
+    return pool_elt_at_index (tsm->port_blocks, p[0]);
+
+  n_blocks = (sm->port_per_thread + sm->port_block_size - 1) /
+	     sm->port_block_size;
+
+  pool_get_zero (tsm->port_blocks, pb);
+  pb->addr = addr;
+  clib_bitmap_validate (pb->used_ports, sm->port_per_thread);
+  clib_bitmap_validate (pb->assigned_blocks, n_blocks);
+  clib_bitmap_validate (pb->full_blocks, n_blocks);
+  vec_validate (pb->port_sessions, sm->port_per_thread - 1);
+  vec_validate (pb->block_used_ports, n_blocks - 1);
+  vec_validate (pb->block_subscriber, n_blocks - 1);
+  hash_set (tsm->port_blocks_by_addr, addr.as_u32, pb - tsm->port_blocks);
+
+  return pb;
+}
+
+/* give the first unassigned block to a subscriber, ~0 if none is left */
+u32
+nat44_ed_port_blocks_assign (nat44_ed_port_blocks_t *pb,
+			     ip4_address_t subscriber)
+{
+  uword block = clib_bitmap_first_clear (pb->assigned_blocks);
+  u32 *blocks;
+
+  if (block >= vec_len (pb->block_used_ports))
+    return ~0;
+
+  pb->assigned_blocks = clib_bitmap_set (pb->assigned_blocks, block, 1);
+  pb->block_subscriber[block] = subscriber;
+  blocks = nat44_ed_port_blocks_of (pb, subscriber);
+  vec_add1 (blocks, block);
+  hash_set (pb->blocks_by_subscriber, subscriber.as_u32, blocks);
+
+  return block;
+}
+
+void
+nat44_ed_port_blocks_unassign (nat44_ed_port_blocks_t *pb, u32 block)
+{
+  ip4_address_t subscriber = pb->block_subscriber[block];
+  u32 *blocks = nat44_ed_port_blocks_of (pb, subscriber);
+  u32 i = vec_search (blocks, block);
+
+  ASSERT (pb->block_used_ports[block] == 0);
+  ASSERT (i != ~0);
+  vec_del1 (blocks, i);
+  if (vec_len (blocks))
+    hash_set (pb->blocks_by_subscriber, subscriber.as_u32, blocks);
+  else
+    {
+      vec_free (blocks);
+      hash_unset (pb->blocks_by_subscriber, subscriber.as_u32);
+    }
+  pb->assigned_blocks = clib_bitmap_set (pb->assigned_blocks, block, 0);
+  pb->block_subscriber[block].as_u32 = 0;
+}
+
+void
+nat44_ed_port_blocks_ref (snat_main_t *sm, u32 thread_index,
+			  nat44_ed_port_blocks_t *pb, u16 port_offset)
+{
+  u32 block = port_offset / sm->port_block_size;
+
+  if (pb->port_sessions[port_offset]++)
+    return;
+
+  pb->used_ports = clib_bitmap_set (pb->used_ports, port_offset, 1);
+  if (0 == pb->block_used_ports[block]++)
+    nat44_ed_port_block_log (sm, thread_index, pb, block, 1);
+  if (pb->block_used_ports[block] == nat44_ed_port_block_n_ports (sm, block))
+    pb->full_blocks = clib_bitmap_set (pb->full_blocks, block, 1);
+}
+
+void
+nat44_ed_port_blocks_release (snat_main_t *sm, u32 thread_index,
+			      snat_session_t *s)
+{
+  snat_main_per_thread_data_t *tsm =
+    vec_elt_at_index (sm->per_thread_data, thread_index);
+  nat44_ed_port_blocks_t *pb;
+  u16 port_offset;
+  u32 block;
+  uword *p;
+
+  p = hash_get (tsm->port_blocks_by_addr, s->out2in.addr.as_u32);
+  if (!p)
+    return;
+  pb = pool_elt_at_index (tsm->port_blocks, p[0]);
+
+  port_offset = clib_net_to_host_u16 (s->out2in.port) -
+		(sm->port_per_thread * tsm->snat_thread_index +
+		 ED_USER_PORT_OFFSET);
+  ASSERT (port_offset < sm->port_per_thread);
+  ASSERT (pb->port_sessions[port_offset]);
+
+  if (--pb->port_sessions[port_offset])
+    return;
+
+  block = port_offset / sm->port_block_size;
+  pb->used_ports = clib_bitmap_set (pb->used_ports, port_offset, 0);
+  pb->full_blocks = clib_bitmap_set (pb->full_blocks, block, 0);
+  if (0 == --pb->block_used_ports[block])
+    {
+      nat44_ed_port_block_log (sm, thread_index, pb, block, 0);
+      nat44_ed_port_blocks_unassign (pb, block);
+    }
+}
+
 __clib_export void
 nat44_original_dst_lookup (ip4_address_t *i2o_src, u16 i2o_src_port,
 			   ip4_address_t *i2o_dst, u16 i2o_dst_port,
@@ -4132,10 +4520,13 @@ nat44_original_dst_lookup (ip4_address_t *i2o_src, u16 i2o_src_port,
   init_ed_k (&kv, i2o_src->as_u32, i2o_src_port, i2o_dst->as_u32, i2o_dst_port,
 	     fib_index, proto);
   if (tsm->sessions == NULL ||
-      clib_bihash_search_16_8 (&sm->flow_hash, &kv, &value))
+      nat44_ed_flow_hash_search (sm, tsm - sm->per_thread_data, 1, &kv,
+				 &value))
     {
       return;
     }
+  tsm = vec_elt_at_index (sm->per_thread_data,
+			  ed_value_get_thread_index (&value));
   s = pool_elt_at_index (tsm->sessions, ed_value_get_session_index (&value));
   if (s)
     {
@@ -28,6 +28,7 @@
 #include <vppinfra/hash.h>
 #include <vppinfra/dlist.h>
 #include <vppinfra/error.h>
+#include <vppinfra/tw_timer_1t_3w_1024sl_ov.h>
 #include <vlibapi/api.h>
 
 #include <nat/lib/lib.h>
@@ -46,6 +47,12 @@
  */
 #define ED_USER_PORT_OFFSET 1024
 
+/* session expiry timer wheel tick, in seconds */
+#define NAT44_ED_EXPIRY_TICK 0.1
+
+/* number of session timers handled per thread before yielding */
+#define NAT44_ED_EXPIRY_MAX_PER_TICK 1024
+
 /* NAT buffer flags */
 #define SNAT_FLAG_HAIRPINNING (1 << 0)
 
@@ -54,7 +61,8 @@
   _ (0x00, IS_ENDPOINT_INDEPENDENT)                                           \
   _ (0x01, IS_ENDPOINT_DEPENDENT)                                             \
   _ (0x02, IS_STATIC_MAPPING_ONLY)                                            \
-  _ (0x04, IS_CONNECTION_TRACKING)
+  _ (0x04, IS_CONNECTION_TRACKING)                                            \
+  _ (0x10, IS_PER_THREAD_FLOW_HASH)
 
 typedef enum nat44_config_flags_t_
 {
@@ -68,6 +76,12 @@ typedef struct
   u32 inside_vrf;
   u32 outside_vrf;
   u32 sessions;
+  /* keep the sessions in per-thread flow hashes */
+  u8 per_thread_flow_hash;
+  /* allocate the outside ports from blocks of this size, 0 if random */
+  u16 port_block_size;
+  /* expire the sessions with per-thread timer wheels */
+  u8 expiry_timer_wheel;
 } nat44_config_t;
 
 typedef enum
@@ -169,6 +183,7 @@ format_function_t format_nat44_ed_tcp_state;
 #define SNAT_SESSION_FLAG_AFFINITY	     (1 << 6)
 #define SNAT_SESSION_FLAG_EXACT_ADDRESS	     (1 << 7)
 #define SNAT_SESSION_FLAG_HAIRPINNING	     (1 << 8)
+#define SNAT_SESSION_FLAG_PORT_BLOCK	     (1 << 9)
 
 /* NAT interface flags */
 #define NAT_INTERFACE_FLAG_IS_INSIDE 1
@@ -311,6 +326,9 @@ typedef CLIB_PACKED(struct
   u32 lru_index;
   f64 last_lru_update;
 
+  /* expiry timer handle, if expiry timer wheel */
+  u32 timer_handle;
+
   /* Last heard timer */
   f64 last_heard;
 
@@ -447,6 +465,27 @@ typedef struct
   ip4_address_t addr;
 } snat_fib_entry_reg_t;
 
+/* Port blocks of an outside address, within the port range of a thread.
+ * Each block in use belongs to a single subscriber (inside address). */
+typedef struct
+{
+  ip4_address_t addr;
+  /* ports used by at least one session */
+  uword *used_ports;
+  /* blocks given to a subscriber */
+  uword *assigned_blocks;
+  /* blocks without a free port */
+  uword *full_blocks;
+  /* number of sessions using each port */
+  u16 *port_sessions;
+  /* number of used ports in each block */
+  u16 *block_used_ports;
+  /* subscriber of each assigned block */
+  ip4_address_t *block_subscriber;
+  /* vector of the assigned blocks of a subscriber, by inside address */
+  uword *blocks_by_subscriber;
+} nat44_ed_port_blocks_t;
+
 typedef struct
 {
   /* Session pool */
@@ -471,6 +510,17 @@ typedef struct
 
   per_vrf_sessions_t *per_vrf_sessions_pool;
 
+  /* Flow hash of the sessions of this thread, if per-thread flow hash */
+  clib_bihash_16_8_t flow_hash;
+
+  /* Port blocks of the outside addresses used by this thread */
+  nat44_ed_port_blocks_t *port_blocks;
+  uword *port_blocks_by_addr;
+
+  /* Session expiry timers, if expiry timer wheel */
+  tw_timer_wheel_1t_3w_1024sl_ov_t expiry_timer_wheel;
+  u32 *expired_sessions;
+
 } snat_main_per_thread_data_t;
 
 struct snat_main_s;
@@ -520,6 +570,17 @@ typedef struct snat_main_s
   /* Endpoint dependent lookup table */
   clib_bihash_16_8_t flow_hash;
 
+  /* Sessions are kept in the per-thread flow hashes and the flow hash
+   * above holds only the static mappings */
+  u8 per_thread_flow_hash;
+
+  /* Outside ports are allocated from blocks of this size, 0 if random */
+  u16 port_block_size;
+
+  /* Sessions are expired by per-thread timer wheels instead of being
+   * reclaimed from the LRU lists on demand */
+  u8 expiry_timer_wheel;
+
   // vector of fibs
   nat_fib_t *fibs;
 
@@ -682,6 +743,8 @@ extern vlib_node_registration_t snat_in2out_worker_handoff_node;
 extern vlib_node_registration_t snat_in2out_output_worker_handoff_node;
 extern vlib_node_registration_t snat_out2in_worker_handoff_node;
 
+extern vlib_node_registration_t nat44_ed_expire_process_node;
+
 /** \brief Check if SNAT session is created from static mapping.
     @param s SNAT session
     @return true if SNAT session is created from static mapping otherwise 0
@@ -941,6 +1004,19 @@ snat_static_mapping_t *nat44_ed_sm_o2i_lookup (snat_main_t *sm,
 					       ip4_address_t addr, u16 port,
 					       u32 fib_index, u8 proto);
 
+nat44_ed_port_blocks_t *nat44_ed_port_blocks_get (snat_main_t *sm,
+						  u32 thread_index,
+						  ip4_address_t addr);
+u32 nat44_ed_port_blocks_assign (nat44_ed_port_blocks_t *pb,
+				 ip4_address_t subscriber);
+void nat44_ed_port_blocks_unassign (nat44_ed_port_blocks_t *pb, u32 block);
+void nat44_ed_port_blocks_ref (snat_main_t *sm, u32 thread_index,
+			       nat44_ed_port_blocks_t *pb, u16 port_offset);
+void nat44_ed_port_blocks_release (snat_main_t *sm, u32 thread_index,
+				   snat_session_t *s);
+
+void nat44_ed_expiry_timers_restart (void);
+
 void nat_syslog_nat44_sadd (u32 ssubix, u32 sfibix, ip4_address_t *isaddr,
 			    u16 isport, ip4_address_t *idaddr, u16 idport,
 			    ip4_address_t *xsaddr, u16 xsport,
@@ -59,6 +59,8 @@ vl_api_nat44_ed_plugin_enable_disable_t_handler (
 	  c.sessions = ntohl (mp->sessions);
 	  c.inside_vrf = ntohl (mp->inside_vrf);
 	  c.outside_vrf = ntohl (mp->outside_vrf);
+	  c.per_thread_flow_hash =
+	    !!(mp->flags & NAT44_API_IS_PER_THREAD_FLOW_HASH);
 
 	  rv = nat44_plugin_enable (c);
 	}
@@ -71,6 +73,42 @@ vl_api_nat44_ed_plugin_enable_disable_t_handler (
   REPLY_MACRO (VL_API_NAT44_ED_PLUGIN_ENABLE_DISABLE_REPLY);
 }
 
+static void
+vl_api_nat44_ed_plugin_enable_disable_v2_t_handler (
+  vl_api_nat44_ed_plugin_enable_disable_v2_t *mp)
+{
+  snat_main_t *sm = &snat_main;
+  nat44_config_t c = { 0 };
+  vl_api_nat44_ed_plugin_enable_disable_v2_reply_t *rmp;
+  int rv = 0;
+
+  if (mp->enable)
+    {
+      if ((mp->flags & NAT44_API_IS_STATIC_MAPPING_ONLY) ||
+	  (mp->flags & NAT44_API_IS_CONNECTION_TRACKING))
+	{
+	  rv = VNET_API_ERROR_UNSUPPORTED;
+	}
+      else
+	{
+	  c.sessions = ntohl (mp->sessions);
+	  c.inside_vrf = ntohl (mp->inside_vrf);
+	  c.outside_vrf = ntohl (mp->outside_vrf);
+	  c.per_thread_flow_hash =
+	    !!(mp->flags & NAT44_API_IS_PER_THREAD_FLOW_HASH);
+	  c.port_block_size = ntohs (mp->port_block_size);
+
+	  rv = nat44_plugin_enable (c);
+	}
+    }
+  else
+    {
+      rv = nat44_plugin_disable ();
+    }
+
+  REPLY_MACRO (VL_API_NAT44_ED_PLUGIN_ENABLE_DISABLE_V2_REPLY);
+}
+
 static void
 vl_api_nat44_ed_set_fq_options_t_handler (vl_api_nat44_ed_set_fq_options_t *mp)
 {
@@ -203,6 +241,7 @@ vl_api_nat_set_timeouts_t_handler (vl_api_nat_set_timeouts_t * mp)
   sm->timeouts.tcp.established = ntohl (mp->tcp_established);
   sm->timeouts.tcp.transitory = ntohl (mp->tcp_transitory);
   sm->timeouts.icmp = ntohl (mp->icmp);
+  nat44_ed_expiry_timers_restart ();
 
   REPLY_MACRO (VL_API_NAT_SET_TIMEOUTS_REPLY);
 }
@@ -1191,6 +1230,8 @@ vl_api_nat44_show_running_config_t_handler (
       // consider how to split functionality between subplugins
       rmp->ipfix_logging_enabled = nat_ipfix_logging_enabled ();
       rmp->flags |= NAT44_IS_ENDPOINT_DEPENDENT;
+      if (rc->per_thread_flow_hash)
+	rmp->flags |= NAT44_IS_PER_THREAD_FLOW_HASH;
     }));
 }
 
@@ -39,6 +39,7 @@ nat44_ed_enable_disable_command_fn (vlib_main_t *vm, unformat_input_t *input,
 
   nat44_config_t c = { 0 };
   u8 enable_set = 0, enable = 0;
+  u32 port_block_size;
 
   if (!unformat_user (input, unformat_line_input, line_input))
     return clib_error_return (0, NAT44_ED_EXPECTED_ARGUMENT);
@@ -49,6 +50,19 @@ nat44_ed_enable_disable_command_fn (vlib_main_t *vm, unformat_input_t *input,
 	;
       else if (unformat (line_input, "outside-vrf %u", &c.outside_vrf));
       else if (unformat (line_input, "sessions %u", &c.sessions));
+      else if (unformat (line_input, "per-thread-flow-hash"))
+	c.per_thread_flow_hash = 1;
+      else if (unformat (line_input, "expiry-timer-wheel"))
+	c.expiry_timer_wheel = 1;
+      else if (unformat (line_input, "port-block-size %u", &port_block_size))
+	{
+	  if (!port_block_size || port_block_size > 0xffff)
+	    {
+	      error = clib_error_return (0, "invalid port block size");
+	      goto done;
+	    }
+	  c.port_block_size = port_block_size;
+	}
       else if (!enable_set)
 	{
 	  enable_set = 1;
@@ -278,7 +292,8 @@ nat44_show_hash_command_fn (vlib_main_t * vm, unformat_input_t * input,
   {
     vlib_cli_output (vm, "-------- thread %d %s --------\n",
 		     i, vlib_worker_threads[i].name);
-    vlib_cli_output (vm, "%U", format_bihash_16_8, &sm->flow_hash, verbose);
+    vlib_cli_output (vm, "%U", format_bihash_16_8,
+		     nat44_ed_flow_hash (sm, i), verbose);
   }
 
   vlib_cli_output (vm, "%U", format_bihash_16_8, &nam->affinity_hash, verbose);
@@ -611,7 +626,10 @@ nat44_show_addresses_command_fn (vlib_main_t * vm, unformat_input_t * input,
 				 vlib_cli_command_t * cmd)
 {
   snat_main_t *sm = &snat_main;
+  snat_main_per_thread_data_t *tsm;
+  nat44_ed_port_blocks_t *pb;
   snat_address_t *ap;
+  uword *p;
 
   vlib_cli_output (vm, "NAT44 pool addresses:");
   vec_foreach (ap, sm->addresses)
@@ -626,6 +644,20 @@ nat44_show_addresses_command_fn (vlib_main_t * vm, unformat_input_t * input,
 
       if (ap->addr_len != ~0)
 	vlib_cli_output (vm, "  synced with interface address");
+
+      vec_foreach (tsm, sm->per_thread_data)
+	{
+	  p = hash_get (tsm->port_blocks_by_addr, ap->addr.as_u32);
+	  if (!p)
+	    continue;
+	  pb = pool_elt_at_index (tsm->port_blocks, p[0]);
+	  vlib_cli_output (
+	    vm, "  thread %u: %u ports in use in %u blocks of %u subscribers",
+	    (u32) (tsm - sm->per_thread_data),
+	    (u32) clib_bitmap_count_set_bits (pb->used_ports),
+	    (u32) clib_bitmap_count_set_bits (pb->assigned_blocks),
+	    hash_elts (pb->blocks_by_subscriber));
+	}
     }
   vlib_cli_output (vm, "NAT44 twice-nat pool addresses:");
   vec_foreach (ap, sm->twice_nat_addresses)
@@ -1783,6 +1815,7 @@ set_timeout_command_fn (vlib_main_t * vm,
 	  goto done;
 	}
     }
+  nat44_ed_expiry_timers_restart ();
 done:
   unformat_free (line_input);
   return error;
@@ -1852,6 +1885,12 @@ done:
  *  vpp# nat44 plugin disable
  * To set inside-vrf outside-vrf, use:
  *  vpp# nat44 plugin enable inside-vrf <id> outside-vrf <id>
+ * To keep the sessions of each worker in its own flow hash, use:
+ *  vpp# nat44 plugin enable per-thread-flow-hash
+ * To allocate the outside ports from blocks of 64 ports, use:
+ *  vpp# nat44 plugin enable port-block-size 64
+ * To expire the sessions with per-thread timer wheels, use:
+ *  vpp# nat44 plugin enable expiry-timer-wheel
  * @cliexend
 ?*/
 VLIB_CLI_COMMAND (nat44_ed_enable_disable_command, static) = {
@@ -1859,7 +1898,8 @@ VLIB_CLI_COMMAND (nat44_ed_enable_disable_command, static) = {
   .function = nat44_ed_enable_disable_command_fn,
   .short_help =
     "nat44 plugin <enable [sessions <max-number>] [inside-vrf <vrf-id>] "
-    "[outside-vrf <vrf-id>]>|disable",
+    "[outside-vrf <vrf-id>] [per-thread-flow-hash] "
+    "[port-block-size <n>] [expiry-timer-wheel]>|disable",
 };
 
 /*?
@@ -96,6 +96,102 @@ format_nat_in2out_ed_trace (u8 * s, va_list * args)
   return s;
 }
 
+static_always_inline int
+nat_ed_alloc_port_try (snat_main_t *sm, u8 proto, u32 thread_index,
+		       snat_session_t *s, u16 port)
+{
+  if (IP_PROTOCOL_ICMP == proto)
+    {
+      s->o2i.match.sport = clib_host_to_net_u16 (port);
+    }
+  s->o2i.match.dport = clib_host_to_net_u16 (port);
+  return nat_ed_ses_o2i_flow_hash_add_del (sm, thread_index, s, 2);
+}
+
+/* try the free ports of a block of the subscriber */
+static_always_inline int
+nat_ed_port_block_alloc_port (snat_main_t *sm, u8 proto, u32 thread_index,
+			      snat_session_t *s, nat44_ed_port_blocks_t *pb,
+			      u32 block, u16 port_thread_offset,
+			      u16 *attempts, u16 *port_offset)
+{
+  u32 offset = block * sm->port_block_size;
+  u32 end = offset + nat44_ed_port_block_n_ports (sm, block);
+
+  if (clib_bitmap_get (pb->full_blocks, block))
+    return 1;
+  offset = clib_bitmap_next_clear (pb->used_ports, offset);
+  while (offset < end && *attempts > 0)
+    {
+      if (0 == nat_ed_alloc_port_try (sm, proto, thread_index, s,
+				      port_thread_offset + offset))
+	{
+	  *port_offset = offset;
+	  return 0;
+	}
+      offset = clib_bitmap_next_clear (pb->used_ports, offset + 1);
+      --*attempts;
+    }
+  return 1;
+}
+
+/* take a port from the blocks of the subscriber (inside address) of the
+ * session, giving it a new block once all of its ports are in use */
+static int
+nat_ed_alloc_port_with_port_blocks (snat_main_t *sm, u8 proto,
+				    u32 thread_index,
+				    nat44_ed_port_blocks_t *pb,
+				    u16 port_thread_offset, snat_session_t *s,
+				    u16 *port_offset)
+{
+  u16 attempts = ED_PORT_ALLOC_ATTEMPTS;
+  u32 *blocks, *block, new_block;
+  u16 offset;
+
+  blocks = nat44_ed_port_blocks_of (pb, s->in2out.addr);
+  vec_foreach (block, blocks)
+    if (0 == nat_ed_port_block_alloc_port (sm, proto, thread_index, s, pb,
+					   *block, port_thread_offset,
+					   &attempts, port_offset))
+      return 0;
+
+  new_block = nat44_ed_port_blocks_assign (pb, s->in2out.addr);
+  if (~0 != new_block)
+    {
+      attempts = ED_PORT_ALLOC_ATTEMPTS;
+      if (0 == nat_ed_port_block_alloc_port (sm, proto, thread_index, s, pb,
+					     new_block, port_thread_offset,
+					     &attempts, port_offset))
+	return 0;
+      nat44_ed_port_blocks_unassign (pb, new_block);
+    }
+
+  /* no free port and no free block left, share a port of the subscriber
+   * with sessions to other destinations */
+  blocks = nat44_ed_port_blocks_of (pb, s->in2out.addr);
+  if (!vec_len (blocks))
+    return 1;
+  attempts = ED_PORT_ALLOC_ATTEMPTS;
+  do
+    {
+      new_block = blocks[snat_random_port (0, vec_len (blocks) - 1)];
+      offset = new_block * sm->port_block_size +
+	       snat_random_port (
+		 0, nat44_ed_port_block_n_ports (sm, new_block) - 1);
+      if (pb->port_sessions[offset] != 0xffff &&
+	  0 == nat_ed_alloc_port_try (sm, proto, thread_index, s,
+				      port_thread_offset + offset))
+	{
+	  *port_offset = offset;
+	  return 0;
+	}
+      --attempts;
+    }
+  while (attempts > 0);
+
+  return 1;
+}
+
 static int
 nat_ed_alloc_addr_and_port_with_snat_address (
   snat_main_t *sm, u8 proto, u32 thread_index, snat_address_t *a,
@@ -104,54 +200,62 @@ nat_ed_alloc_addr_and_port_with_snat_address (
 {
   const u16 port_thread_offset =
     (port_per_thread * snat_thread_index) + ED_USER_PORT_OFFSET;
+  nat44_ed_port_blocks_t *pb;
+  u16 attempts = ED_PORT_ALLOC_ATTEMPTS;
+  u16 port_offset;
 
   /* Backup original match in case of failure */
   const nat_6t_t match = s->o2i.match;
 
   s->o2i.match.daddr = a->addr;
+  if (sm->port_block_size)
+    {
+      pb = nat44_ed_port_blocks_get (sm, thread_index, a->addr);
+      if (nat_ed_alloc_port_with_port_blocks (sm, proto, thread_index, pb,
+					      port_thread_offset, s,
+					      &port_offset))
+	goto fail;
+      nat44_ed_port_blocks_ref (sm, thread_index, pb, port_offset);
+      s->flags |= SNAT_SESSION_FLAG_PORT_BLOCK;
+      goto done;
+    }
+
   /* first try port suggested by caller */
   u16 port = clib_net_to_host_u16 (*outside_port);
-  u16 port_offset = port - port_thread_offset;
+  port_offset = port - port_thread_offset;
   if (port < port_thread_offset ||
       port >= port_thread_offset + port_per_thread)
     {
       /* need to pick a different port, suggested port doesn't fit in
        * this thread's port range */
       port_offset = snat_random_port (0, port_per_thread - 1);
-      port = port_thread_offset + port_offset;
     }
-  u16 attempts = ED_PORT_ALLOC_ATTEMPTS;
   do
     {
-      if (IP_PROTOCOL_ICMP == proto)
-	{
-	  s->o2i.match.sport = clib_host_to_net_u16 (port);
-	}
-      s->o2i.match.dport = clib_host_to_net_u16 (port);
-      if (0 == nat_ed_ses_o2i_flow_hash_add_del (sm, thread_index, s, 2))
-	{
-	  *outside_addr = a->addr;
-	  *outside_port = clib_host_to_net_u16 (port);
-	  return 0;
-	}
+      if (0 == nat_ed_alloc_port_try (sm, proto, thread_index, s,
+				      port_thread_offset + port_offset))
+	goto done;
       port_offset = snat_random_port (0, port_per_thread - 1);
-      port = port_thread_offset + port_offset;
       --attempts;
     }
   while (attempts > 0);
 
+fail:
   /* Revert match */
   s->o2i.match = match;
   return 1;
+
+done:
+  *outside_addr = a->addr;
+  *outside_port = clib_host_to_net_u16 (port_thread_offset + port_offset);
+  return 0;
 }
 
-static int
-nat_ed_alloc_addr_and_port (snat_main_t *sm, u32 rx_fib_index,
-			    u32 tx_sw_if_index, u32 nat_proto,
-			    u32 thread_index, ip4_address_t s_addr,
-			    ip4_address_t d_addr, u32 snat_thread_index,
-			    snat_session_t *s, ip4_address_t *outside_addr,
-			    u16 *outside_port)
+/* pick the pool address the sessions of a flow are translated to */
+static_always_inline snat_address_t *
+nat_ed_alloc_addr_select (snat_main_t *sm, u32 rx_fib_index,
+			  u32 tx_sw_if_index, ip4_address_t s_addr,
+			  ip4_address_t d_addr)
 {
   if (vec_len (sm->addresses) > 0)
     {
@@ -176,10 +280,7 @@ nat_ed_alloc_addr_and_port (snat_main_t *sm, u32 rx_fib_index,
 			   (d_addr.as_u32 & ip4_main.fib_masks[a->addr_len])))
 
 			{
-			  return nat_ed_alloc_addr_and_port_with_snat_address (
-			    sm, nat_proto, thread_index, a,
-			    sm->port_per_thread, snat_thread_index, s,
-			    outside_addr, outside_port);
+			  return a;
 			}
 		      ra = a;
 		    }
@@ -202,10 +303,7 @@ nat_ed_alloc_addr_and_port (snat_main_t *sm, u32 rx_fib_index,
 			   (d_addr.as_u32 & ip4_main.fib_masks[a->addr_len])))
 
 			{
-			  return nat_ed_alloc_addr_and_port_with_snat_address (
-			    sm, nat_proto, thread_index, a,
-			    sm->port_per_thread, snat_thread_index, s,
-			    outside_addr, outside_port);
+			  return a;
 			}
 		      ra = a;
 		    }
@@ -218,9 +316,7 @@ nat_ed_alloc_addr_and_port (snat_main_t *sm, u32 rx_fib_index,
 	    }
 	  if (ra)
 	    {
-	      return nat_ed_alloc_addr_and_port_with_snat_address (
-		sm, nat_proto, thread_index, ra, sm->port_per_thread,
-		snat_thread_index, s, outside_addr, outside_port);
+	      return ra;
 	    }
 	}
       else
@@ -235,9 +331,7 @@ nat_ed_alloc_addr_and_port (snat_main_t *sm, u32 rx_fib_index,
 		      (a->net.as_u32 ==
 		       (d_addr.as_u32 & ip4_main.fib_masks[a->addr_len])))
 		    {
-		      return nat_ed_alloc_addr_and_port_with_snat_address (
-			sm, nat_proto, thread_index, a, sm->port_per_thread,
-			snat_thread_index, s, outside_addr, outside_port);
+		      return a;
 		    }
 		  ja = a;
 		}
@@ -255,9 +349,7 @@ nat_ed_alloc_addr_and_port (snat_main_t *sm, u32 rx_fib_index,
 		      (a->net.as_u32 ==
 		       (d_addr.as_u32 & ip4_main.fib_masks[a->addr_len])))
 		    {
-		      return nat_ed_alloc_addr_and_port_with_snat_address (
-			sm, nat_proto, thread_index, a, sm->port_per_thread,
-			snat_thread_index, s, outside_addr, outside_port);
+		      return a;
 		    }
 		  ja = a;
 		}
@@ -270,12 +362,27 @@ nat_ed_alloc_addr_and_port (snat_main_t *sm, u32 rx_fib_index,
 
       if (ja || ba)
 	{
-	  a = ja ? ja : ba;
-	  return nat_ed_alloc_addr_and_port_with_snat_address (
-	    sm, nat_proto, thread_index, a, sm->port_per_thread,
-	    snat_thread_index, s, outside_addr, outside_port);
+	  return ja ? ja : ba;
 	}
     }
+  return 0;
+}
+
+static int
+nat_ed_alloc_addr_and_port (snat_main_t *sm, u32 rx_fib_index,
+			    u32 tx_sw_if_index, u32 nat_proto,
+			    u32 thread_index, ip4_address_t s_addr,
+			    ip4_address_t d_addr, u32 snat_thread_index,
+			    snat_session_t *s, ip4_address_t *outside_addr,
+			    u16 *outside_port)
+{
+  snat_address_t *a =
+    nat_ed_alloc_addr_select (sm, rx_fib_index, tx_sw_if_index, s_addr, d_addr);
+
+  if (a)
+    return nat_ed_alloc_addr_and_port_with_snat_address (
+      sm, nat_proto, thread_index, a, sm->port_per_thread, snat_thread_index,
+      s, outside_addr, outside_port);
   /* Totally out of translations to use... */
   nat_ipfix_logging_addresses_exhausted (thread_index, 0);
   return 1;
@@ -429,17 +536,20 @@ is_destination_resolvable (u32 rx_fib_index, ip4_address_t addr)
   return 0;
 }
 
+/*
+ * tx_fib_index is the FIB the remote address is reached through, ~0 if the
+ * caller did not look it up yet. The outside port is tried first, when it
+ * is in the port range of the thread.
+ */
 static u32
 slow_path_ed (vlib_main_t *vm, snat_main_t *sm, vlib_buffer_t *b,
 	      ip4_address_t l_addr, ip4_address_t r_addr, u16 l_port,
 	      u16 r_port, u8 proto, u32 rx_fib_index, u32 tx_sw_if_index,
-	      snat_session_t **sessionp, vlib_node_runtime_t *node, u32 next,
-	      u32 thread_index, f64 now)
+	      u32 tx_fib_index, u16 outside_port, snat_session_t **sessionp,
+	      vlib_node_runtime_t *node, u32 next, u32 thread_index, f64 now)
 {
   snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
   ip4_address_t outside_addr;
-  u16 outside_port;
-  u32 tx_fib_index;
   u8 is_identity_nat = 0;
 
   snat_session_t *s = NULL;
@@ -490,7 +600,8 @@ slow_path_ed (vlib_main_t *vm, snat_main_t *sm, vlib_buffer_t *b,
   s = nat_ed_session_alloc (sm, thread_index, now, proto);
   ASSERT (s);
 
-  tx_fib_index = get_tx_fib_index (rx_fib_index, r_addr);
+  if (~0 == tx_fib_index)
+    tx_fib_index = get_tx_fib_index (rx_fib_index, r_addr);
 
   if (!is_sm)
     {
@@ -500,9 +611,6 @@ slow_path_ed (vlib_main_t *vm, snat_main_t *sm, vlib_buffer_t *b,
       s->in2out.fib_index = rx_fib_index;
       s->out2in.fib_index = tx_fib_index;
 
-      // suggest using local port to allocation function
-      outside_port = l_port;
-
       if (PREDICT_FALSE (nat44_ed_external_sm_lookup (sm, r_addr, r_port,
 						      proto, &daddr, &dport)))
 	{
@@ -642,7 +750,9 @@ nat44_ed_not_translate (vlib_main_t *vm, vlib_node_runtime_t *node,
 	     ip->protocol);
 
   // do nat if active session or is static mapping
-  if (!clib_bihash_search_16_8 (&sm->flow_hash, &kv, &value) ||
+  if (!nat44_ed_flow_hash_search (sm, vm->thread_index,
+				  nat44_ed_flow_owner_may_differ (sm), &kv,
+				  &value) ||
       !snat_static_mapping_match (
 	vm, ip->dst_address, vnet_buffer (b)->ip.reass.l4_dst_port,
 	sm->outside_fib_index, proto, &placeholder_addr, &placeholder_port,
@@ -712,7 +822,8 @@ nat_not_translate_output_feature_fwd (snat_main_t * sm, ip4_header_t * ip,
 		 ip->protocol);
     }
 
-  if (!clib_bihash_search_16_8 (&sm->flow_hash, &kv, &value))
+  if (!clib_bihash_search_16_8 (nat44_ed_flow_hash (sm, thread_index), &kv,
+				&value))
     {
       ASSERT (thread_index == ed_value_get_thread_index (&value));
       s =
@@ -759,7 +870,8 @@ nat44_ed_not_translate_output_feature (snat_main_t *sm, vlib_buffer_t *b,
   /* src NAT check */
   init_ed_k (&kv, ip->src_address.as_u32, src_port, ip->dst_address.as_u32,
 	     dst_port, tx_fib_index, ip->protocol);
-  if (!clib_bihash_search_16_8 (&sm->flow_hash, &kv, &value))
+  if (!clib_bihash_search_16_8 (nat44_ed_flow_hash (sm, thread_index), &kv,
+				&value))
     {
       ASSERT (thread_index == ed_value_get_thread_index (&value));
       s =
@@ -791,7 +903,8 @@ nat44_ed_not_translate_output_feature (snat_main_t *sm, vlib_buffer_t *b,
 
   init_ed_k (&kv, ip->dst_address.as_u32, dst_port, ip->src_address.as_u32,
 	     src_port, rx_fib_index, ip->protocol);
-  if (!clib_bihash_search_16_8 (&sm->flow_hash, &kv, &value))
+  if (!clib_bihash_search_16_8 (nat44_ed_flow_hash (sm, thread_index), &kv,
+				&value))
     {
       ASSERT (thread_index == ed_value_get_thread_index (&value));
       s =
@@ -867,8 +980,9 @@ icmp_in2out_ed_slow_path (snat_main_t *sm, vlib_buffer_t *b, ip4_header_t *ip,
 
   next =
     slow_path_ed (vm, sm, b, ip->src_address, ip->dst_address, lookup_sport,
-		  lookup_dport, ip->protocol, rx_fib_index, tx_sw_if_index, &s,
-		  node, next, thread_index, vlib_time_now (vm));
+		  lookup_dport, ip->protocol, rx_fib_index, tx_sw_if_index, ~0,
+		  lookup_sport, &s, node, next, thread_index,
+		  vlib_time_now (vm));
 
   if (NAT_NEXT_DROP == next)
     goto out;
@@ -943,7 +1057,8 @@ nat44_ed_in2out_slowpath_unknown_proto (snat_main_t *sm, vlib_buffer_t *b,
 	      init_ed_k (&s_kv, s->out2in.addr.as_u32, 0,
 			 ip->dst_address.as_u32, 0, tx_fib_index,
 			 ip->protocol);
-	      if (clib_bihash_search_16_8 (&sm->flow_hash, &s_kv, &s_value))
+	      if (nat44_ed_flow_hash_search (sm, thread_index, 1, &s_kv,
+					     &s_value))
 		{
 		  new_src_addr = s->out2in.addr;
 		}
@@ -958,7 +1073,8 @@ nat44_ed_in2out_slowpath_unknown_proto (snat_main_t *sm, vlib_buffer_t *b,
 	      init_ed_k (&s_kv, sm->addresses[i].addr.as_u32, 0,
 			 ip->dst_address.as_u32, 0, tx_fib_index,
 			 ip->protocol);
-	      if (clib_bihash_search_16_8 (&sm->flow_hash, &s_kv, &s_value))
+	      if (nat44_ed_flow_hash_search (sm, thread_index, 1, &s_kv,
+					     &s_value))
 		{
 		  new_src_addr = sm->addresses[i].addr;
 		}
@@ -1181,7 +1297,8 @@ nat44_ed_in2out_fast_path_node_fn_inline (vlib_main_t *vm,
 		 lookup.dport, lookup.fib_index, lookup.proto);
 
       // lookup flow
-      if (clib_bihash_search_16_8 (&sm->flow_hash, &kv0, &value0))
+      if (clib_bihash_search_16_8 (nat44_ed_flow_hash (sm, thread_index),
+				   &kv0, &value0))
 	{
 	  // flow does not exist go slow path
 	  next[0] = def_slow;
@@ -1328,6 +1445,268 @@ nat44_ed_in2out_fast_path_node_fn_inline (vlib_main_t *vm,
   return frame->n_vectors;
 }
 
+static_always_inline u32
+nat44_ed_in2out_slow_path_search (clib_bihash_16_8_t *h, u32 thread_index,
+				  u64 hash, clib_bihash_kv_16_8_t *kv)
+{
+  clib_bihash_kv_16_8_t value;
+
+  if (clib_bihash_search_inline_2_with_hash_16_8 (h, hash, kv, &value))
+    return ~0;
+  ASSERT (thread_index == ed_value_get_thread_index (&value));
+  return ed_value_get_session_index (&value);
+}
+
+/*
+ * Flows added to the flow hash while the frame is processed, as a bitmap of
+ * the low bits of their hashes. A packet the frame lookup found no session
+ * for is only searched again if its bit is set.
+ */
+#define NAT44_ED_NEW_FLOWS_BITS 512
+
+static_always_inline void
+nat44_ed_new_flows_set (u64 *new_flows, u64 hash)
+{
+  hash &= NAT44_ED_NEW_FLOWS_BITS - 1;
+  new_flows[hash / 64] |= 1ULL << (hash % 64);
+}
+
+static_always_inline void
+nat44_ed_new_flows_add (u64 *new_flows, snat_session_t *s)
+{
+  clib_bihash_kv_16_8_t kv;
+
+  nat_6t_flow_to_ed_k (&kv, &s->i2o);
+  nat44_ed_new_flows_set (new_flows, clib_bihash_hash_16_8 (&kv));
+  nat_6t_flow_to_ed_k (&kv, &s->o2i);
+  nat44_ed_new_flows_set (new_flows, clib_bihash_hash_16_8 (&kv));
+}
+
+static_always_inline int
+nat44_ed_new_flows_may_match (u64 *new_flows, u64 hash)
+{
+  hash &= NAT44_ED_NEW_FLOWS_BITS - 1;
+  return (new_flows[hash / 64] >> (hash % 64)) & 1;
+}
+
+/*
+ * A session found by the frame lookup may have been deleted by an earlier
+ * packet of the frame, and its index reused by a new session. It is still
+ * the session of the packet if it holds the flow of the packet.
+ */
+static_always_inline int
+nat44_ed_session_has_flow (snat_main_per_thread_data_t *tsm, u32 ses_index,
+			   clib_bihash_kv_16_8_t *kv)
+{
+  clib_bihash_kv_16_8_t skv;
+  snat_session_t *s;
+
+  if (pool_is_free_index (tsm->sessions, ses_index))
+    return 0;
+  s = pool_elt_at_index (tsm->sessions, ses_index);
+  nat_6t_flow_to_ed_k (&skv, &s->i2o);
+  if (skv.key[0] == kv->key[0] && skv.key[1] == kv->key[1])
+    return 1;
+  nat_6t_flow_to_ed_k (&skv, &s->o2i);
+  return skv.key[0] == kv->key[0] && skv.key[1] == kv->key[1];
+}
+
+/* port last planned for a new flow of the frame, see
+ * nat44_ed_in2out_slow_path_plan */
+typedef struct
+{
+  nat44_ed_port_blocks_t *pb;
+  ip4_address_t subscriber;
+  u32 port_offset;
+} nat44_ed_port_plan_t;
+
+/*
+ * Pick the port a new flow gets from the port blocks of its subscriber:
+ * the allocation takes the first free port of the blocks, so the next new
+ * flow of the same subscriber in the frame gets the one after. Returns 1 if
+ * a new block is needed, which is left to the allocation.
+ */
+static_always_inline int
+nat44_ed_port_blocks_plan_port (snat_main_t *sm, nat44_ed_port_blocks_t *pb,
+				ip4_address_t subscriber,
+				nat44_ed_port_plan_t *plan, u32 *port_offset)
+{
+  u32 *blocks, *block, offset, end;
+
+  blocks = nat44_ed_port_blocks_of (pb, subscriber);
+  vec_foreach (block, blocks)
+    {
+      if (clib_bitmap_get (pb->full_blocks, *block))
+	continue;
+      offset = *block * sm->port_block_size;
+      end = offset + nat44_ed_port_block_n_ports (sm, *block);
+      if (plan->pb == pb && plan->subscriber.as_u32 == subscriber.as_u32 &&
+	  plan->port_offset >= offset && plan->port_offset < end)
+	offset = plan->port_offset + 1;
+      offset = clib_bitmap_next_clear (pb->used_ports, offset);
+      if (offset < end)
+	{
+	  plan->pb = pb;
+	  plan->subscriber = subscriber;
+	  plan->port_offset = *port_offset = offset;
+	  return 0;
+	}
+    }
+  return 1;
+}
+
+/*
+ * Prepare the session of a TCP or UDP packet the frame lookup found no flow
+ * for: look up the outside FIB and pick the outside address and port the
+ * same way the allocation does, then prefetch the bucket the outside key
+ * goes into. The port is only claimed by the insert of that key when the
+ * session is created, which fails and moves on to another port if it is
+ * taken in the meantime.
+ */
+static_always_inline void
+nat44_ed_in2out_slow_path_plan (snat_main_t *sm, clib_bihash_16_8_t *h,
+				u32 thread_index, vlib_buffer_t *b,
+				ip4_header_t *ip, u32 rx_fib_index,
+				nat44_ed_port_plan_t *plan, u32 *tx_fib_index,
+				u16 *outside_port)
+{
+  snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+  const u16 port_thread_offset =
+    (sm->port_per_thread * tsm->snat_thread_index) + ED_USER_PORT_OFFSET;
+  clib_bihash_kv_16_8_t kv;
+  snat_address_t *a;
+  u32 port_offset;
+  u16 port;
+
+  if (ip->protocol == IP_PROTOCOL_TCP &&
+      !tcp_flags_is_init (vnet_buffer (b)->ip.reass.icmp_type_or_tcp_flags))
+    return;
+
+  *tx_fib_index = get_tx_fib_index (rx_fib_index, ip->dst_address);
+  a = nat_ed_alloc_addr_select (sm, rx_fib_index,
+				vnet_buffer (b)->sw_if_index[VLIB_TX],
+				ip->src_address, ip->dst_address);
+  if (!a)
+    return;
+
+  if (sm->port_block_size)
+    {
+      if (nat44_ed_port_blocks_plan_port (
+	    sm, nat44_ed_port_blocks_get (sm, thread_index, a->addr),
+	    ip->src_address, plan, &port_offset))
+	return;
+      port = port_thread_offset + port_offset;
+    }
+  else
+    {
+      port = clib_net_to_host_u16 (*outside_port);
+      if (port < port_thread_offset ||
+	  port >= port_thread_offset + sm->port_per_thread)
+	port = port_thread_offset +
+	       snat_random_port (0, sm->port_per_thread - 1);
+    }
+  *outside_port = clib_host_to_net_u16 (port);
+
+  init_ed_k (&kv, ip->dst_address.as_u32,
+	     vnet_buffer (b)->ip.reass.l4_dst_port, a->addr.as_u32,
+	     *outside_port, *tx_fib_index, ip->protocol);
+  clib_bihash_prefetch_bucket_16_8 (h, clib_bihash_hash_16_8 (&kv));
+}
+
+/*
+ * Look up the flows of all the TCP and UDP packets of a slow path frame up
+ * front. The keys are hashed and their buckets prefetched for the whole
+ * frame first, so the bucket misses of a burst of new flows overlap instead
+ * of stalling each packet in turn, and the buckets the new i2o keys go into
+ * are then in the cache. ses_indices[i] is the session of packet i, or ~0.
+ *
+ * The sessions of the new flows are then prepared for the whole frame, once
+ * per flow: tx_fib_indices[i] and outside_ports[i] are the outside FIB and
+ * the port to try first for the session of packet i, and the buckets of
+ * their outside keys are prefetched before any session is created.
+ */
+static_always_inline void
+nat44_ed_in2out_slow_path_lookup (snat_main_t *sm, clib_bihash_16_8_t *h,
+				  u32 thread_index, vlib_buffer_t **b,
+				  u32 n_left, int is_output_feature,
+				  clib_bihash_kv_16_8_t *kvs, u64 *hashes,
+				  u32 *ses_indices, u32 *tx_fib_indices,
+				  u16 *outside_ports)
+{
+  u64 planned[NAT44_ED_NEW_FLOWS_BITS / 64] = {};
+  nat44_ed_port_plan_t plan = {};
+  u16 lookups[VLIB_FRAME_SIZE], new_flows[VLIB_FRAME_SIZE];
+  u32 i, j, n_lookups = 0, n_new_flows = 0;
+  ip4_header_t *ips[VLIB_FRAME_SIZE];
+  u32 rx_fib_indices[VLIB_FRAME_SIZE];
+
+  for (i = 0; i < n_left; i++)
+    {
+      u32 iph_offset = 0;
+      ip4_header_t *ip;
+
+      ses_indices[i] = ~0;
+      tx_fib_indices[i] = ~0;
+
+      if (is_output_feature)
+	iph_offset = vnet_buffer (b[i])->ip.reass.save_rewrite_length;
+      ip = (ip4_header_t *) ((u8 *) vlib_buffer_get_current (b[i]) +
+			     iph_offset);
+
+      /* same checks as the packet loop does before its lookup */
+      if ((!is_output_feature && ip->ttl == 1) ||
+	  nat44_ed_is_unk_proto (ip->protocol) ||
+	  ip->protocol == IP_PROTOCOL_ICMP)
+	continue;
+
+      outside_ports[i] = vnet_buffer (b[i])->ip.reass.l4_src_port;
+      ips[i] = ip;
+      rx_fib_indices[i] = fib_table_get_index_for_sw_if_index (
+	FIB_PROTOCOL_IP4, vnet_buffer (b[i])->sw_if_index[VLIB_RX]);
+      init_ed_k (&kvs[i], ip->src_address.as_u32,
+		 vnet_buffer (b[i])->ip.reass.l4_src_port,
+		 ip->dst_address.as_u32,
+		 vnet_buffer (b[i])->ip.reass.l4_dst_port, rx_fib_indices[i],
+		 ip->protocol);
+      hashes[i] = clib_bihash_hash_16_8 (&kvs[i]);
+      clib_bihash_prefetch_bucket_16_8 (h, hashes[i]);
+      lookups[n_lookups++] = i;
+    }
+
+  for (i = 0; i < n_lookups; i++)
+    {
+      if (i + 4 < n_lookups)
+	clib_bihash_prefetch_data_16_8 (h, hashes[lookups[i + 4]]);
+      ses_indices[lookups[i]] = nat44_ed_in2out_slow_path_search (
+	h, thread_index, hashes[lookups[i]], &kvs[lookups[i]]);
+    }
+
+  for (i = 0; i < n_lookups; i++)
+    {
+      u32 k = lookups[i];
+
+      if (~0 != ses_indices[k])
+	continue;
+
+      /* later packets of a new flow use the session of the first one */
+      if (nat44_ed_new_flows_may_match (planned, hashes[k]))
+	{
+	  for (j = 0; j < n_new_flows; j++)
+	    if (kvs[new_flows[j]].key[0] == kvs[k].key[0] &&
+		kvs[new_flows[j]].key[1] == kvs[k].key[1])
+	      break;
+	  if (j < n_new_flows)
+	    continue;
+	}
+      nat44_ed_new_flows_set (planned, hashes[k]);
+      new_flows[n_new_flows++] = k;
+
+      nat44_ed_in2out_slow_path_plan (sm, h, thread_index, b[k], ips[k],
+				      rx_fib_indices[k], &plan,
+				      &tx_fib_indices[k], &outside_ports[k]);
+    }
+}
+
 static inline uword
 nat44_ed_in2out_slow_path_node_fn_inline (vlib_main_t *vm,
 					  vlib_node_runtime_t *node,
@@ -1340,6 +1719,13 @@ nat44_ed_in2out_slow_path_node_fn_inline (vlib_main_t *vm,
   f64 now = vlib_time_now (vm);
   u32 thread_index = vm->thread_index;
   snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
+  clib_bihash_16_8_t *flow_hash = nat44_ed_flow_hash (sm, thread_index);
+  clib_bihash_kv_16_8_t kvs[VLIB_FRAME_SIZE];
+  u64 hashes[VLIB_FRAME_SIZE];
+  u32 ses_indices[VLIB_FRAME_SIZE];
+  u32 tx_fib_indices[VLIB_FRAME_SIZE];
+  u16 outside_ports[VLIB_FRAME_SIZE];
+  u64 new_flows[NAT44_ED_NEW_FLOWS_BITS / 64] = {};
 
   from = vlib_frame_vector_args (frame);
   n_left_from = frame->n_vectors;
@@ -1348,6 +1734,11 @@ nat44_ed_in2out_slow_path_node_fn_inline (vlib_main_t *vm,
   u16 nexts[VLIB_FRAME_SIZE], *next = nexts;
   vlib_get_buffers (vm, from, b, n_left_from);
 
+  nat44_ed_in2out_slow_path_lookup (sm, flow_hash, thread_index, bufs,
+				    n_left_from, is_output_feature, kvs,
+				    hashes, ses_indices, tx_fib_indices,
+				    outside_ports);
+
   while (n_left_from > 0)
     {
       vlib_buffer_t *b0;
@@ -1359,8 +1750,9 @@ nat44_ed_in2out_slow_path_node_fn_inline (vlib_main_t *vm,
       udp_header_t *udp0;
       icmp46_header_t *icmp0;
       snat_session_t *s0 = 0;
-      clib_bihash_kv_16_8_t kv0 = { 0 }, value0;
+      clib_bihash_kv_16_8_t kv0 = { 0 };
       int translation_error = NAT_ED_TRNSL_ERR_SUCCESS;
+      u32 i0 = b - bufs;
 
       b0 = *b;
 
@@ -1446,17 +1838,20 @@ nat44_ed_in2out_slow_path_node_fn_inline (vlib_main_t *vm,
 	  goto trace0;
 	}
 
-      init_ed_k (
-	&kv0, ip0->src_address.as_u32, vnet_buffer (b0)->ip.reass.l4_src_port,
-	ip0->dst_address.as_u32, vnet_buffer (b0)->ip.reass.l4_dst_port,
-	rx_fib_index0, ip0->protocol);
-      if (!clib_bihash_search_16_8 (&sm->flow_hash, &kv0, &value0))
-	{
-	  ASSERT (thread_index == ed_value_get_thread_index (&value0));
-	  s0 =
-	    pool_elt_at_index (tsm->sessions,
-			       ed_value_get_session_index (&value0));
-	}
+      /*
+       * An earlier packet of the frame may have deleted the session found by
+       * the frame lookup, or created the flow it missed. Search again only
+       * then, the bucket is in the cache by now. The sessions of ICMP and
+       * of unknown protocols never hold the flow of a TCP or UDP packet.
+       */
+      kv0 = kvs[i0];
+      if (~0 != ses_indices[i0] ?
+	    !nat44_ed_session_has_flow (tsm, ses_indices[i0], &kv0) :
+	    nat44_ed_new_flows_may_match (new_flows, hashes[i0]))
+	ses_indices[i0] = nat44_ed_in2out_slow_path_search (
+	  flow_hash, thread_index, hashes[i0], &kv0);
+      if (~0 != ses_indices[i0])
+	s0 = pool_elt_at_index (tsm->sessions, ses_indices[i0]);
 
       if (!s0)
 	{
@@ -1491,8 +1886,9 @@ nat44_ed_in2out_slow_path_node_fn_inline (vlib_main_t *vm,
 	    slow_path_ed (vm, sm, b0, ip0->src_address, ip0->dst_address,
 			  vnet_buffer (b0)->ip.reass.l4_src_port,
 			  vnet_buffer (b0)->ip.reass.l4_dst_port,
-			  ip0->protocol, rx_fib_index0, tx_sw_if_index0, &s0,
-			  node, next[0], thread_index, now);
+			  ip0->protocol, rx_fib_index0, tx_sw_if_index0,
+			  tx_fib_indices[i0], outside_ports[i0], &s0, node,
+			  next[0], thread_index, now);
 
 	  if (PREDICT_FALSE (next[0] == NAT_NEXT_DROP))
 	    goto trace0;
@@ -1500,6 +1896,7 @@ nat44_ed_in2out_slow_path_node_fn_inline (vlib_main_t *vm,
 	  if (PREDICT_FALSE (!s0))
 	    goto trace0;
 
+	  nat44_ed_new_flows_add (new_flows, s0);
 	}
 
       b0->flags |= VNET_BUFFER_F_IS_NATED;
@@ -259,6 +259,56 @@ nat_6t_flow_to_ed_kv (clib_bihash_kv_16_8_t *kv, nat_6t_flow_t *f,
 	      session_idx);
 }
 
+/* flow hash holding the sessions owned by the thread */
+static_always_inline clib_bihash_16_8_t *
+nat44_ed_flow_hash (snat_main_t *sm, u32 thread_idx)
+{
+  if (sm->per_thread_flow_hash)
+    return &vec_elt_at_index (sm->per_thread_data, thread_idx)->flow_hash;
+  return &sm->flow_hash;
+}
+
+/*
+ * With the per-thread flow hash, a session is owned by the thread its
+ * inside address hashes to and its outside port belongs to, unless it was
+ * created by a static mapping or the forwarding bypass.
+ */
+static_always_inline int
+nat44_ed_flow_owner_may_differ (snat_main_t *sm)
+{
+  return pool_elts (sm->static_mappings) || sm->forwarding_enabled;
+}
+
+/*
+ * Find a flow owned by any thread. The table of thread_idx, the expected
+ * owner, is searched first, and the other threads' tables only if
+ * search_all is set. The owner is in the thread index of the value.
+ */
+static_always_inline int
+nat44_ed_flow_hash_search (snat_main_t *sm, u32 thread_idx, int search_all,
+			   clib_bihash_kv_16_8_t *kv,
+			   clib_bihash_kv_16_8_t *value)
+{
+  snat_main_per_thread_data_t *tsm;
+
+  if (!sm->per_thread_flow_hash)
+    return clib_bihash_search_16_8 (&sm->flow_hash, kv, value);
+
+  if (!clib_bihash_search_16_8 (nat44_ed_flow_hash (sm, thread_idx), kv,
+				value))
+    return 0;
+
+  if (search_all)
+    vec_foreach (tsm, sm->per_thread_data)
+      {
+	if (tsm - sm->per_thread_data == thread_idx)
+	  continue;
+	if (!clib_bihash_search_16_8 (&tsm->flow_hash, kv, value))
+	  return 0;
+      }
+  return -1;
+}
+
 static_always_inline int
 nat_ed_ses_i2o_flow_hash_add_del (snat_main_t *sm, u32 thread_idx,
 				  snat_session_t *s, int is_add)
@@ -277,7 +327,8 @@ nat_ed_ses_i2o_flow_hash_add_del (snat_main_t *sm, u32 thread_idx,
     }
 
   ASSERT (thread_idx == s->thread_index);
-  return clib_bihash_add_del_16_8 (&sm->flow_hash, &kv, is_add);
+  return clib_bihash_add_del_16_8 (nat44_ed_flow_hash (sm, thread_idx), &kv,
+				   is_add);
 }
 
 static_always_inline int
@@ -306,7 +357,35 @@ nat_ed_ses_o2i_flow_hash_add_del (snat_main_t *sm, u32 thread_idx,
       nat_6t_l3_l4_csum_calc (&s->o2i);
     }
   ASSERT (thread_idx == s->thread_index);
-  return clib_bihash_add_del_16_8 (&sm->flow_hash, &kv, is_add);
+  return clib_bihash_add_del_16_8 (nat44_ed_flow_hash (sm, thread_idx), &kv,
+				   is_add);
+}
+
+/* arm the expiry timer of the session for its remaining lifetime */
+always_inline void
+nat44_ed_session_timer_start (snat_main_t *sm,
+			      snat_main_per_thread_data_t *tsm,
+			      snat_session_t *s, f64 now)
+{
+  f64 expiry = s->last_heard + (f64) nat44_session_get_timeout (sm, s);
+  u32 ticks = 1;
+
+  if (expiry > now)
+    ticks += (u32) ((expiry - now) / NAT44_ED_EXPIRY_TICK);
+  s->timer_handle = tw_timer_start_1t_3w_1024sl_ov (
+    &tsm->expiry_timer_wheel, s - tsm->sessions, 0, ticks);
+}
+
+always_inline void
+nat44_ed_session_timer_stop (snat_main_per_thread_data_t *tsm,
+			     snat_session_t *s)
+{
+  if (s->timer_handle != ~0)
+    {
+      tw_timer_stop_1t_3w_1024sl_ov (&tsm->expiry_timer_wheel,
+				     s->timer_handle);
+      s->timer_handle = ~0;
+    }
 }
 
 always_inline void
@@ -326,6 +405,10 @@ nat_ed_session_delete (snat_main_t *sm, snat_session_t *ses, u32 thread_index,
     nat_elog_warn (sm, "flow hash del failed");
   if (nat_ed_ses_o2i_flow_hash_add_del (sm, thread_index, ses, 0))
     nat_elog_warn (sm, "flow hash del failed");
+  if (ses->flags & SNAT_SESSION_FLAG_PORT_BLOCK)
+    nat44_ed_port_blocks_release (sm, thread_index, ses);
+  if (sm->expiry_timer_wheel)
+    nat44_ed_session_timer_stop (tsm, ses);
   pool_put (tsm->sessions, ses);
   vlib_set_simple_counter (&sm->total_sessions, thread_index, 0,
 			   pool_elts (tsm->sessions));
@@ -388,13 +471,23 @@ nat_ed_session_alloc (snat_main_t *sm, u32 thread_index, f64 now, u8 proto)
   snat_session_t *s;
   snat_main_per_thread_data_t *tsm = &sm->per_thread_data[thread_index];
 
-  nat_lru_free_one (sm, thread_index, now);
+  /* expired sessions are already gone if the timer wheel is used */
+  if (!sm->expiry_timer_wheel)
+    nat_lru_free_one (sm, thread_index, now);
 
   pool_get (tsm->sessions, s);
   clib_memset (s, 0, sizeof (*s));
+  s->timer_handle = ~0;
 
   nat_ed_lru_insert (tsm, s, now, proto);
 
+  if (sm->expiry_timer_wheel)
+    {
+      s->proto = proto;
+      s->last_heard = now;
+      nat44_ed_session_timer_start (sm, tsm, s, now);
+    }
+
   s->ha_last_refreshed = now;
   vlib_set_simple_counter (&sm->total_sessions, thread_index, 0,
 			   pool_elts (tsm->sessions));
@@ -665,6 +758,23 @@ snat_random_port (u16 min, u16 max)
   return min + (rwide % (max - min + 1));
 }
 
+/* number of ports of a port block, the last one of a thread may be short */
+static_always_inline u32
+nat44_ed_port_block_n_ports (snat_main_t *sm, u32 block)
+{
+  return clib_min (sm->port_block_size,
+		   sm->port_per_thread - block * sm->port_block_size);
+}
+
+/* vector of the port blocks assigned to a subscriber */
+static_always_inline u32 *
+nat44_ed_port_blocks_of (nat44_ed_port_blocks_t *pb, ip4_address_t subscriber)
+{
+  uword *p = hash_get (pb->blocks_by_subscriber, subscriber.as_u32);
+
+  return p ? (u32 *) p[0] : 0;
+}
+
 always_inline u8
 is_interface_addr (snat_main_t *sm, vlib_node_runtime_t *node,
 		   u32 sw_if_index0, u32 ip4_addr)
@@ -791,6 +901,12 @@ nat44_set_tcp_session_state (snat_main_t *sm, f64 now, snat_session_t *ses,
   ses->last_lru_update = now;
   clib_dlist_remove (tsm->lru_pool, ses->lru_index);
   clib_dlist_addtail (tsm->lru_pool, ses->lru_head_index, ses->lru_index);
+  /* the timeout depends on the state, re-arm the expiry timer */
+  if (sm->expiry_timer_wheel)
+    {
+      nat44_ed_session_timer_stop (tsm, ses);
+      nat44_ed_session_timer_start (sm, tsm, ses, now);
+    }
 }
 
 always_inline void
@@ -129,6 +129,56 @@ dump_name_vector (stat_segment_data_t *res, u8 *s, u8 used_only)
   return s;
 }
 
+static u8 *
+dump_histogram (stat_segment_data_t *res, u8 *s, u8 used_only)
+{
+  u8 need_header = 1;
+  int j, k;
+  u8 *name;
+
+  name = make_stat_name (res->name);
+
+  for (k = 0; k < vec_len (res->histogram_vec); k++)
+    for (j = 0; j < vec_len (res->histogram_vec[k]); j++)
+      {
+	u64 *h = res->histogram_vec[k][j];
+	u32 b, n_buckets = vec_len (h) - 1;
+	u64 count = 0;
+
+	for (b = 0; b < n_buckets; b++)
+	  count += h[1 + b];
+
+	if (used_only && !count)
+	  continue;
+	if (need_header)
+	  {
+	    s = format (s, "# TYPE %v histogram\n", name);
+	    need_header = 0;
+	  }
+
+	count = 0;
+	for (b = 0; b + 1 < n_buckets; b++)
+	  {
+	    count += h[1 + b];
+	    s = format (s,
+			"%v_bucket{thread=\"%d\",index=\"%d\",le=\"%llu\"} "
+			"%llu\n",
+			name, k, j,
+			stat_histogram_bucket_lower_bound (b + 1) - 1, count);
+	  }
+	count += h[n_buckets];
+	s = format (s,
+		    "%v_bucket{thread=\"%d\",index=\"%d\",le=\"+Inf\"} %llu\n",
+		    name, k, j, count);
+	s = format (s, "%v_sum{thread=\"%d\",index=\"%d\"} %llu\n", name, k,
+		    j, h[0]);
+	s = format (s, "%v_count{thread=\"%d\",index=\"%d\"} %llu\n", name,
+		    k, j, count);
+      }
+
+  return s;
+}
+
 static u8 *
 scrape_stats_segment (u8 *s, u8 **patterns, u8 used_only)
 {
@@ -168,6 +218,10 @@ retry:
 	  s = dump_name_vector (&res[i], s, used_only);
 	  break;
 
+	case STAT_DIR_TYPE_HISTOGRAM:
+	  s = dump_histogram (&res[i], s, used_only);
+	  break;
+
 	case STAT_DIR_TYPE_EMPTY:
 	  break;
 
@@ -2213,8 +2213,30 @@ fib_test_v4 (void)
     FIB_TEST(!fib_urpf_check(urpfi, 99),
              "uRPF check for 68.68.68.68/32 on 99 not-OK",
              99);
+    FIB_TEST(!fib_urpf_check(urpfi, tm->hw[0]->sw_if_index + 64),
+             "uRPF check for 68.68.68.68/32 on %d not-OK",
+             tm->hw[0]->sw_if_index + 64);
     dpo_reset(&dpo_44);
 
+    /*
+     * a list with an interface whose index is beyond the interface bits
+     */
+    urpfi = fib_urpf_list_alloc_and_lock();
+    fib_urpf_list_append(urpfi, 3);
+    fib_urpf_list_append(urpfi, 67);
+    fib_urpf_list_bake(urpfi);
+
+    FIB_TEST(!(fib_urpf_list_get(urpfi)->furpf_flags &
+               FIB_URPF_LIST_BITS_EXACT),
+             "uRPF list [3, 67] bits are not exact");
+    FIB_TEST((fib_urpf_check(urpfi, 3) &&
+              fib_urpf_check(urpfi, 67)),
+             "uRPF check for [3, 67] on 3 and 67 OK");
+    FIB_TEST((!fib_urpf_check(urpfi, 4) &&
+              !fib_urpf_check(urpfi, 131)),
+             "uRPF check for [3, 67] on 4 and 131 not-OK");
+    fib_urpf_list_unlock(urpfi);
+
     fib_table_entry_delete(fib_index,
                            &bgp_44_s_32,
                            FIB_SOURCE_API);
@@ -10809,6 +10831,888 @@ fib_test_sticky (void)
     return 0;
 }
 
+/*
+ * Drain the async walk queues, as the fib-walk process would.
+ */
+static void
+fib_test_walk_drain (vlib_main_t *vm)
+{
+    fib_walk_priority_t prio;
+
+    FOR_EACH_FIB_WALK_PRIORITY(prio)
+    {
+        while (0 != fib_walk_queue_get_size(prio))
+        {
+            fib_walk_process_queues(vm, 1);
+        }
+    }
+}
+
+/*
+ * Is every bucket the data-plane could choose for the prefix the adj
+ */
+static int
+fib_test_pic_fwd_via (u32 fib_index,
+                      const fib_prefix_t *pfx,
+                      adj_index_t ai)
+{
+    const load_balance_t *lb;
+    const dpo_id_t *dpo;
+    u32 bucket;
+
+    dpo = fib_entry_contribute_ip_forwarding(
+        fib_table_lookup_exact_match(fib_index, pfx));
+    lb = load_balance_get(dpo->dpoi_index);
+
+    for (bucket = 0; bucket < lb->lb_n_buckets; bucket++)
+    {
+        dpo = load_balance_get_fwd_bucket(lb, bucket);
+
+        if (DPO_ADJACENCY != dpo->dpoi_type || ai != dpo->dpoi_index)
+        {
+            return (0);
+        }
+    }
+    return (1);
+}
+
+/*
+ * Fail one of the two attached next-hops that N prefixes share and
+ * measure the time until the data-plane avoids it, and until every
+ * entry has been updated by the FIB walk.
+ */
+static int
+fib_test_pic_one (u32 n_prefixes, int pic)
+{
+    const u32 fib_index = 0;
+    vlib_main_t *vm = vlib_get_main();
+    fib_route_path_t *rpaths = NULL, *r_paths = NULL;
+    test_main_t *tm = &test_main;
+    fib_prefix_t pfx = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+    };
+    u8 eth_addr[] = {
+        0xde, 0xde, 0xde, 0xba, 0xba, 0xba,
+    };
+    const load_balance_t *lb;
+    adj_index_t ai_01, ai_02;
+    u32 ii, n_feis, n_converged;
+    ip46_address_t nh_01 = {
+        .ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a01),
+    };
+    ip46_address_t nh_02 = {
+        .ip4.as_u32 = clib_host_to_net_u32(0x0a0a0b01),
+    };
+    clib_error_t *error;
+    f64 t[3];
+    int res;
+
+    res = 0;
+    n_feis = fib_entry_pool_size();
+
+    ai_01 = adj_nbr_add_or_lock(FIB_PROTOCOL_IP4, VNET_LINK_IP4,
+                                &nh_01, tm->hw[0]->sw_if_index);
+    adj_nbr_update_rewrite(ai_01, ADJ_NBR_REWRITE_FLAG_COMPLETE,
+                           fib_test_build_rewrite(eth_addr));
+    ai_02 = adj_nbr_add_or_lock(FIB_PROTOCOL_IP4, VNET_LINK_IP4,
+                                &nh_02, tm->hw[1]->sw_if_index);
+    adj_nbr_update_rewrite(ai_02, ADJ_NBR_REWRITE_FLAG_COMPLETE,
+                           fib_test_build_rewrite(eth_addr));
+
+    fib_route_path_t r_path_01 = {
+        .frp_proto = DPO_PROTO_IP4,
+        .frp_addr = nh_01,
+        .frp_sw_if_index = tm->hw[0]->sw_if_index,
+        .frp_fib_index = ~0,
+        .frp_weight = 1,
+    };
+    fib_route_path_t r_path_02 = {
+        .frp_proto = DPO_PROTO_IP4,
+        .frp_addr = nh_02,
+        .frp_sw_if_index = tm->hw[1]->sw_if_index,
+        .frp_fib_index = ~0,
+        .frp_weight = 1,
+    };
+    vec_add1(r_paths, r_path_01);
+    vec_add1(r_paths, r_path_02);
+
+    fib_path_list_pic_enable_disable(pic);
+
+    /*
+     * 1.0.0.0/32 and up, all via both next-hops
+     */
+    fib_table_batch_begin();
+    for (ii = 0; ii < n_prefixes; ii++)
+    {
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x01000000 + ii);
+
+        vec_reset_length(rpaths);
+        vec_append(rpaths, r_paths);
+        fib_table_entry_path_add2(fib_index, &pfx, FIB_SOURCE_API,
+                                  FIB_ENTRY_FLAG_NONE, rpaths);
+    }
+    fib_table_batch_end();
+    fib_test_walk_drain(vm);
+
+    pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x01000000);
+    lb = load_balance_get(fib_entry_contribute_ip_forwarding(
+                              fib_table_lookup_exact_match(fib_index,
+                                                           &pfx))->dpoi_index);
+    FIB_TEST((2 == lb->lb_n_buckets), "%U has 2 buckets",
+             format_fib_prefix, &pfx);
+    FIB_TEST((pic == (INDEX_INVALID != lb->lb_map)),
+             "%U uses a map:%d", format_fib_prefix, &pfx, pic);
+
+    /*
+     * a resilient entry shares the popular path-list but not a map
+     */
+    fib_prefix_t pfx_res = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x02000000),
+    };
+    vec_reset_length(rpaths);
+    vec_append(rpaths, r_paths);
+    fib_table_entry_path_add2(fib_index, &pfx_res, FIB_SOURCE_API,
+                              FIB_ENTRY_FLAG_RESILIENT, rpaths);
+    FIB_TEST((fib_entry_get_path_list(
+                  fib_table_lookup_exact_match(fib_index, &pfx)) ==
+              fib_entry_get_path_list(
+                  fib_table_lookup_exact_match(fib_index, &pfx_res))),
+             "%U shares the path-list", format_fib_prefix, &pfx_res);
+    FIB_TEST(!fib_entry_uses_lb_map(
+                 fib_table_lookup_exact_match(fib_index, &pfx_res)),
+             "%U does not use a map", format_fib_prefix, &pfx_res);
+
+    /*
+     * fail the first next-hop. the async walk to the entries of the
+     * popular path-list is run after
+     */
+    t[0] = vlib_time_now(vm);
+    error = vnet_sw_interface_set_flags(vnet_get_main(),
+                                        tm->hw[0]->sw_if_index,
+                                        ~VNET_SW_INTERFACE_FLAG_ADMIN_UP);
+    FIB_TEST((NULL == error), "Interface shutdown OK");
+    t[1] = vlib_time_now(vm);
+
+    n_converged = 0;
+    for (ii = 0; ii < n_prefixes; ii++)
+    {
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x01000000 + ii);
+        n_converged += fib_test_pic_fwd_via(fib_index, &pfx, ai_02);
+    }
+    if (pic)
+    {
+        FIB_TEST((n_prefixes == n_converged),
+                 "PIC: %d of %d converged before the walk",
+                 n_converged, n_prefixes);
+    }
+
+    /*
+     * without a map to repair it the resilient entry still gets its
+     * synchronous walk, PIC or not
+     */
+    FIB_TEST(fib_test_pic_fwd_via(fib_index, &pfx_res, ai_02),
+             "%U converged before the walk", format_fib_prefix, &pfx_res);
+
+    fib_test_walk_drain(vm);
+    t[2] = vlib_time_now(vm);
+
+    for (ii = 0; ii < n_prefixes; ii++)
+    {
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x01000000 + ii);
+        FIB_TEST(fib_test_pic_fwd_via(fib_index, &pfx, ai_02),
+                 "%U via second next-hop", format_fib_prefix, &pfx);
+    }
+
+    vlib_cli_output(vm, "pic:%s %8d prefixes: %8d converged in %.6fs, "
+                    "walk done in %.6fs",
+                    (pic ? "on " : "off"), n_prefixes, n_converged,
+                    t[1] - t[0], t[2] - t[0]);
+
+    /*
+     * restore the interface, and clean up
+     */
+    error = vnet_sw_interface_set_flags(vnet_get_main(),
+                                        tm->hw[0]->sw_if_index,
+                                        VNET_SW_INTERFACE_FLAG_ADMIN_UP);
+    FIB_TEST((NULL == error), "Interface bring-up OK");
+    fib_test_walk_drain(vm);
+
+    for (ii = 0; ii < n_prefixes; ii++)
+    {
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x01000000 + ii);
+        fib_table_entry_delete(fib_index, &pfx, FIB_SOURCE_API);
+    }
+    fib_table_entry_delete(fib_index, &pfx_res, FIB_SOURCE_API);
+    fib_test_walk_drain(vm);
+    fib_path_list_pic_enable_disable(0);
+
+    adj_unlock(ai_01);
+    adj_unlock(ai_02);
+    vec_free(rpaths);
+    vec_free(r_paths);
+
+    FIB_TEST((n_feis == fib_entry_pool_size()), "Entries gone");
+
+    return (res);
+}
+
+/*
+ * With background mtrie updates the table and the data-plane's view of
+ * it differ until the pending updates are applied.
+ */
+static int
+fib_test_mtrie_update (void)
+{
+    const u32 fib_index = 0;
+    test_main_t *tm = &test_main;
+    fib_prefix_t pfx = {
+        .fp_len = 24,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x0b0b0b00),
+    };
+    fib_route_path_t *rpaths = NULL;
+    fib_route_path_t rpath = {
+        .frp_proto = DPO_PROTO_IP4,
+        .frp_addr.ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a01),
+        .frp_sw_if_index = tm->hw[0]->sw_if_index,
+        .frp_fib_index = ~0,
+        .frp_weight = 1,
+    };
+    index_t lbi_before, lbi;
+    fib_node_index_t fei;
+    u32 n_feis;
+    int res;
+
+    res = 0;
+    n_feis = fib_entry_pool_size();
+    vec_add1(rpaths, rpath);
+
+    lbi_before = ip4_fib_forwarding_lookup(fib_index, &pfx.fp_addr.ip4);
+    ip4_fib_mtrie_update_set_background(1);
+
+    /*
+     * the table has the route, the data-plane not until the flush
+     */
+    fib_table_batch_begin();
+    fei = fib_table_entry_path_add2(fib_index, &pfx, FIB_SOURCE_API,
+                                    FIB_ENTRY_FLAG_NONE, rpaths);
+    fib_table_batch_end();
+
+    lbi = fib_entry_contribute_ip_forwarding(fei)->dpoi_index;
+    FIB_TEST((fei == fib_table_lookup(fib_index, &pfx)),
+             "%U in the table", format_fib_prefix, &pfx);
+    FIB_TEST((lbi_before ==
+              ip4_fib_forwarding_lookup(fib_index, &pfx.fp_addr.ip4)),
+             "%U not yet forwarded", format_fib_prefix, &pfx);
+
+    ip4_fib_mtrie_update_flush();
+    FIB_TEST((lbi == ip4_fib_forwarding_lookup(fib_index, &pfx.fp_addr.ip4)),
+             "%U forwarded after the flush", format_fib_prefix, &pfx);
+
+    /*
+     * and the same for a removal
+     */
+    fib_table_batch_begin();
+    fib_table_entry_delete(fib_index, &pfx, FIB_SOURCE_API);
+    fib_table_batch_end();
+
+    FIB_TEST((fei != fib_table_lookup(fib_index, &pfx)),
+             "%U gone from the table", format_fib_prefix, &pfx);
+    FIB_TEST((lbi == ip4_fib_forwarding_lookup(fib_index, &pfx.fp_addr.ip4)),
+             "%U still forwarded", format_fib_prefix, &pfx);
+
+    ip4_fib_mtrie_update_set_background(0);
+    FIB_TEST((lbi_before ==
+              ip4_fib_forwarding_lookup(fib_index, &pfx.fp_addr.ip4)),
+             "%U not forwarded once inline", format_fib_prefix, &pfx);
+
+    vec_free(rpaths);
+    FIB_TEST((n_feis == fib_entry_pool_size()), "Entries gone");
+
+    return (res);
+}
+
+/*
+ * Add or remove one of the DIR-24-8 test prefixes
+ */
+static void
+fib_test_mtrie_24_route (u32 fib_index, u32 addr, u8 len, int is_add)
+{
+    fib_prefix_t pfx = {
+        .fp_len = len,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr.ip4.as_u32 = clib_host_to_net_u32(addr),
+    };
+
+    if (is_add)
+        fib_table_entry_special_add(fib_index, &pfx, FIB_SOURCE_SPECIAL,
+                                    FIB_ENTRY_FLAG_DROP);
+    else
+        fib_table_entry_special_remove(fib_index, &pfx, FIB_SOURCE_SPECIAL);
+}
+
+/*
+ * Add prefixes of all lengths from /8 to /32 packed into 48.0.0.0/14 so
+ * they nest, with a few /24s holding longer prefixes. the addresses to
+ * look up are the first and last of each prefix and their neighbours.
+ */
+static void
+fib_test_mtrie_24_add (u32 fib_index,
+                       u32 *seed,
+                       u32 n_prefixes,
+                       u32 **pfx_addrs,
+                       u8 **pfx_lens,
+                       ip4_address_t **addrs)
+{
+    ip4_address_t addr;
+    u32 h, ii;
+    u8 len;
+
+    for (ii = 0; ii < n_prefixes; ii++)
+    {
+        fib_prefix_t pfx = {
+            .fp_proto = FIB_PROTOCOL_IP4,
+        };
+
+        len = 8 + random_u32(seed) % 25;
+        h = 0x30000000 | (random_u32(seed) & 0x000307ff);
+        h &= ~0U << (32 - len);
+        pfx.fp_len = len;
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(h);
+
+        if (FIB_NODE_INDEX_INVALID !=
+            fib_table_lookup_exact_match(fib_index, &pfx))
+            continue;
+
+        fib_test_mtrie_24_route(fib_index, h, len, 1);
+        vec_add1(*pfx_addrs, h);
+        vec_add1(*pfx_lens, len);
+
+        addr.as_u32 = clib_host_to_net_u32(h);
+        vec_add1(*addrs, addr);
+        addr.as_u32 = clib_host_to_net_u32(h - 1);
+        vec_add1(*addrs, addr);
+        addr.as_u32 = clib_host_to_net_u32(h | ~(~0U << (32 - len)));
+        vec_add1(*addrs, addr);
+        addr.as_u32 = clib_host_to_net_u32((h | ~(~0U << (32 - len))) + 1);
+        vec_add1(*addrs, addr);
+    }
+}
+
+/*
+ * The data-plane lookups of each address, one at a time and four at a
+ * time.
+ */
+static int
+fib_test_mtrie_24_lookup (u32 fib_index,
+                          const ip4_address_t *addrs,
+                          index_t **lbis)
+{
+    index_t lbi[4];
+    int res = 0;
+    u32 ii;
+
+    vec_reset_length(*lbis);
+
+    for (ii = 0; ii < vec_len(addrs); ii++)
+    {
+        vec_add1(*lbis, ip4_fib_forwarding_lookup(fib_index, &addrs[ii]));
+    }
+    for (ii = 0; ii + 4 <= vec_len(addrs); ii += 4)
+    {
+        ip4_fib_forwarding_lookup_x4(fib_index, fib_index,
+                                     fib_index, fib_index,
+                                     &addrs[ii], &addrs[ii + 1],
+                                     &addrs[ii + 2], &addrs[ii + 3],
+                                     &lbi[0], &lbi[1], &lbi[2], &lbi[3]);
+        FIB_TEST(((*lbis)[ii] == lbi[0] && (*lbis)[ii + 1] == lbi[1] &&
+                  (*lbis)[ii + 2] == lbi[2] && (*lbis)[ii + 3] == lbi[3]),
+                 "x4 lookup of %U as x1", format_ip4_address, &addrs[ii]);
+    }
+
+    return (res);
+}
+
+static int
+fib_test_mtrie_24_cmp (const ip4_address_t *addrs,
+                       const index_t *expected,
+                       const index_t *lbis,
+                       const char *what)
+{
+    int res = 0;
+    u32 ii;
+
+    for (ii = 0; ii < vec_len(addrs); ii++)
+    {
+        FIB_TEST((expected[ii] == lbis[ii]),
+                 "%s: %U via LB %d, expected %d", what,
+                 format_ip4_address, &addrs[ii], lbis[ii], expected[ii]);
+    }
+
+    return (res);
+}
+
+/*
+ * The plies the DIR-24-8 mtrie needs for the test prefixes, one per /24
+ * with a longer prefix.
+ */
+static uword
+fib_test_mtrie_24_n_plies (const u32 *addrs, const u8 *lens)
+{
+    uword *h = NULL, n;
+    u32 ii;
+
+    for (ii = 0; ii < vec_len(addrs); ii++)
+    {
+        if (lens[ii] > 24)
+            hash_set(h, addrs[ii] >> 8, 1);
+    }
+    n = hash_elts(h);
+    hash_free(h);
+
+    return (n);
+}
+
+/*
+ * The DIR-24-8 mtrie forwards as the table's default mtrie does, when
+ * built from the table and when updated with it.
+ */
+static int
+fib_test_mtrie_24 (void)
+{
+    const u32 fib_index = 0;
+    index_t *expected = NULL, *lbis = NULL;
+    ip4_address_t *addrs = NULL, addr;
+    u32 *pfx_addrs = NULL, seed, ii, n_feis, other;
+    uword base_usage;
+    u8 *pfx_lens = NULL;
+    int res = 0;
+
+    n_feis = fib_entry_pool_size();
+    seed = 0xdeadbeef;
+
+#define FIB_TEST_MTRIE_24_USAGE(_n_plies)                               \
+    FIB_TEST((base_usage + (_n_plies) * sizeof(ip4_mtrie_8_ply_t) ==    \
+              ip4_mtrie_24_memory_usage(ip4_fib_get(fib_index)->mtrie_24)), \
+             "DIR-24-8 usage for %d plies", (int) (_n_plies))
+
+    /*
+     * the table's own prefixes
+     */
+    ip4_fib_table_mtrie_24_enable(fib_index);
+    FIB_TEST((NULL != ip4_fib_mtrie_24_get(fib_index)), "DIR-24-8 enabled");
+    base_usage = ip4_mtrie_24_memory_usage(ip4_fib_get(fib_index)->mtrie_24);
+    ip4_fib_table_mtrie_24_disable(fib_index);
+    FIB_TEST((NULL == ip4_fib_mtrie_24_get(fib_index)), "DIR-24-8 disabled");
+
+    /*
+     * nested prefixes, and some addresses at random
+     */
+    fib_test_mtrie_24_add(fib_index, &seed, 256,
+                          &pfx_addrs, &pfx_lens, &addrs);
+    for (ii = 0; ii < 256; ii++)
+    {
+        addr.as_u32 = clib_host_to_net_u32(0x30000000 |
+                                           (random_u32(&seed) & 0x0007ffff));
+        vec_add1(addrs, addr);
+    }
+
+    /*
+     * the mtrie built from the table forwards as the default
+     */
+    if (fib_test_mtrie_24_lookup(fib_index, addrs, &expected))
+        return (1);
+    ip4_fib_table_mtrie_24_enable(fib_index);
+    if (fib_test_mtrie_24_lookup(fib_index, addrs, &lbis) ||
+        fib_test_mtrie_24_cmp(addrs, expected, lbis, "built"))
+        return (1);
+    FIB_TEST_MTRIE_24_USAGE(fib_test_mtrie_24_n_plies(pfx_addrs, pfx_lens));
+
+    /*
+     * and when updated with the table; remove every other prefix and
+     * add some more. the default mtrie is always kept up to date so
+     * compare against it once the DIR-24-8 is gone.
+     */
+    for (ii = vec_len(pfx_addrs); ii-- > 0; )
+    {
+        if (ii & 1)
+        {
+            fib_test_mtrie_24_route(fib_index, pfx_addrs[ii],
+                                    pfx_lens[ii], 0);
+            vec_del1(pfx_addrs, ii);
+            vec_del1(pfx_lens, ii);
+        }
+    }
+    fib_test_mtrie_24_add(fib_index, &seed, 64,
+                          &pfx_addrs, &pfx_lens, &addrs);
+    if (fib_test_mtrie_24_lookup(fib_index, addrs, &lbis))
+        return (1);
+    FIB_TEST_MTRIE_24_USAGE(fib_test_mtrie_24_n_plies(pfx_addrs, pfx_lens));
+
+    ip4_fib_table_mtrie_24_disable(fib_index);
+    if (fib_test_mtrie_24_lookup(fib_index, addrs, &expected) ||
+        fib_test_mtrie_24_cmp(addrs, expected, lbis, "updated"))
+        return (1);
+
+    /*
+     * rebuilt after it was disabled
+     */
+    ip4_fib_table_mtrie_24_enable(fib_index);
+    if (fib_test_mtrie_24_lookup(fib_index, addrs, &lbis) ||
+        fib_test_mtrie_24_cmp(addrs, expected, lbis, "rebuilt"))
+        return (1);
+
+    /*
+     * a batch can mix tables with and without one; all the combinations
+     * of the two tables in turn
+     */
+    other = fib_table_find_or_create_and_lock(FIB_PROTOCOL_IP4, 11,
+                                              FIB_SOURCE_API);
+    fib_test_mtrie_24_route(other, 0x30000000, 16, 1);
+    fib_test_mtrie_24_route(other, 0x30040000, 24, 1);
+    for (ii = 0; ii + 4 <= vec_len(addrs); ii += 4)
+    {
+        u32 fis[4], jj;
+        index_t lbi[4];
+
+        for (jj = 0; jj < 4; jj++)
+            fis[jj] = ((ii / 4) & (1 << jj)) ? other : fib_index;
+
+        ip4_fib_forwarding_lookup_x4(fis[0], fis[1], fis[2], fis[3],
+                                     &addrs[ii], &addrs[ii + 1],
+                                     &addrs[ii + 2], &addrs[ii + 3],
+                                     &lbi[0], &lbi[1], &lbi[2], &lbi[3]);
+        for (jj = 0; jj < 4; jj++)
+            FIB_TEST((lbi[jj] ==
+                      ip4_fib_forwarding_lookup(fis[jj], &addrs[ii + jj])),
+                     "mixed x4 lookup of %U in %d as x1",
+                     format_ip4_address, &addrs[ii + jj], fis[jj]);
+    }
+    fib_test_mtrie_24_route(other, 0x30000000, 16, 0);
+    fib_test_mtrie_24_route(other, 0x30040000, 24, 0);
+    fib_table_unlock(other, FIB_PROTOCOL_IP4, FIB_SOURCE_API);
+
+    /*
+     * the plies go with the prefixes
+     */
+    for (ii = 0; ii < vec_len(pfx_addrs); ii++)
+    {
+        fib_test_mtrie_24_route(fib_index, pfx_addrs[ii], pfx_lens[ii], 0);
+    }
+    FIB_TEST_MTRIE_24_USAGE(0);
+    ip4_fib_table_mtrie_24_disable(fib_index);
+
+#undef FIB_TEST_MTRIE_24_USAGE
+
+    vec_free(expected);
+    vec_free(lbis);
+    vec_free(addrs);
+    vec_free(pfx_addrs);
+    vec_free(pfx_lens);
+    FIB_TEST((n_feis == fib_entry_pool_size()), "Entries gone");
+
+    return (res);
+}
+
+/*
+ * Convergence time vs. number of prefixes, with and without PIC
+ */
+static int
+fib_test_pic (u32 max_prefixes)
+{
+    u32 n_prefixes;
+    int res = 0;
+
+    for (n_prefixes = 100; n_prefixes <= max_prefixes; n_prefixes *= 10)
+    {
+        res += fib_test_pic_one(n_prefixes, 0);
+        res += fib_test_pic_one(n_prefixes, 1);
+    }
+
+    return (res);
+}
+
+/*
+ * Snapshot the adjacency each bucket of a route's load-balance uses
+ */
+static adj_index_t *
+fib_test_resilient_buckets (u32 fib_index,
+                            const fib_prefix_t *pfx)
+{
+    const load_balance_t *lb;
+    adj_index_t *ais = NULL;
+    const dpo_id_t *dpo;
+    u32 bucket;
+
+    dpo = fib_entry_contribute_ip_forwarding(
+        fib_table_lookup_exact_match(fib_index, pfx));
+    lb = load_balance_get(dpo->dpoi_index);
+
+    for (bucket = 0; bucket < lb->lb_n_buckets; bucket++)
+    {
+        vec_add1(ais, load_balance_get_bucket_i(lb, bucket)->dpoi_index);
+    }
+    return (ais);
+}
+
+static u32
+fib_test_resilient_n_moved (const adj_index_t *old,
+                            const adj_index_t *new)
+{
+    u32 ii, n_moved = 0;
+
+    for (ii = 0; ii < vec_len(new); ii++)
+    {
+        n_moved += (ii >= vec_len(old) || old[ii] != new[ii]);
+    }
+    return (n_moved);
+}
+
+/*
+ * Add and remove paths from a resilient route and check only the flows
+ * that must move do.
+ */
+static int
+fib_test_resilient (void)
+{
+#define N_RES_PATHS 4
+    const u32 fib_index = 0;
+    fib_route_path_t r_paths[N_RES_PATHS], *rpaths = NULL;
+    adj_index_t ais[N_RES_PATHS], *old, *new;
+    test_main_t *tm = &test_main;
+    fib_prefix_t pfx = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+        .fp_addr = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x01010101),
+        },
+    };
+    const load_balance_t *lb;
+    u32 ii, jj, lb_count, n_buckets[N_RES_PATHS];
+    fib_node_index_t fei;
+    int res;
+
+    res = 0;
+    lb_count = pool_elts(load_balance_pool);
+
+    for (ii = 0; ii < N_RES_PATHS; ii++)
+    {
+        ip46_address_t nh = {
+            .ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a02 + ii),
+        };
+
+        ais[ii] = adj_nbr_add_or_lock(FIB_PROTOCOL_IP4, VNET_LINK_IP4,
+                                      &nh, tm->hw[0]->sw_if_index);
+
+        r_paths[ii] = (fib_route_path_t) {
+            .frp_proto = DPO_PROTO_IP4,
+            .frp_addr = nh,
+            .frp_sw_if_index = tm->hw[0]->sw_if_index,
+            .frp_fib_index = ~0,
+            .frp_weight = 1,
+        };
+    }
+
+    /*
+     * 1.1.1.1/32 via the first three
+     */
+    vec_add(rpaths, r_paths, 3);
+    fei = fib_table_entry_path_add2(fib_index, &pfx, FIB_SOURCE_API,
+                                    FIB_ENTRY_FLAG_RESILIENT, rpaths);
+    lb = load_balance_get(fib_entry_contribute_ip_forwarding(fei)->dpoi_index);
+    FIB_TEST((LB_RESILIENT_N_BUCKETS == lb->lb_n_buckets),
+             "%U has %d buckets", format_fib_prefix, &pfx,
+             lb->lb_n_buckets);
+    FIB_TEST((LOAD_BALANCE_FLAG_RESILIENT == lb->lb_flags),
+             "%U LB is resilient", format_fib_prefix, &pfx);
+    old = fib_test_resilient_buckets(fib_index, &pfx);
+
+    /*
+     * adding the fourth moves only the quarter of the buckets it is given
+     */
+    vec_reset_length(rpaths);
+    vec_add1(rpaths, r_paths[3]);
+    fib_table_entry_path_add2(fib_index, &pfx, FIB_SOURCE_API,
+                              FIB_ENTRY_FLAG_RESILIENT, rpaths);
+    new = fib_test_resilient_buckets(fib_index, &pfx);
+
+    FIB_TEST((LB_RESILIENT_N_BUCKETS / 4 ==
+              fib_test_resilient_n_moved(old, new)),
+             "add path: %d buckets moved",
+             fib_test_resilient_n_moved(old, new));
+
+    clib_memset(n_buckets, 0, sizeof(n_buckets));
+    for (ii = 0; ii < N_RES_PATHS; ii++)
+    {
+        for (jj = 0; jj < vec_len(new); jj++)
+        {
+            n_buckets[ii] += (ais[ii] == new[jj]);
+        }
+        FIB_TEST((LB_RESILIENT_N_BUCKETS / 4 == n_buckets[ii]),
+                 "path %d has %d buckets", ii, n_buckets[ii]);
+    }
+
+    /*
+     * removing the second moves only its buckets
+     */
+    vec_free(old);
+    old = new;
+    vec_reset_length(rpaths);
+    vec_add1(rpaths, r_paths[1]);
+    fib_table_entry_path_remove2(fib_index, &pfx, FIB_SOURCE_API, rpaths);
+    vec_free(rpaths);
+    new = fib_test_resilient_buckets(fib_index, &pfx);
+
+    FIB_TEST((LB_RESILIENT_N_BUCKETS / 4 ==
+              fib_test_resilient_n_moved(old, new)),
+             "remove path: %d buckets moved",
+             fib_test_resilient_n_moved(old, new));
+    for (ii = 0; ii < vec_len(new); ii++)
+    {
+        if (old[ii] != ais[1])
+            FIB_TEST((old[ii] == new[ii]), "bucket %d kept", ii);
+        FIB_TEST((new[ii] != ais[1]), "bucket %d moved", ii);
+    }
+
+    vec_free(old);
+    vec_free(new);
+
+    fib_table_entry_delete(fib_index, &pfx, FIB_SOURCE_API);
+
+    for (ii = 0; ii < N_RES_PATHS; ii++)
+    {
+        adj_unlock(ais[ii]);
+    }
+
+    FIB_TEST((lb_count == pool_elts(load_balance_pool)),
+             "LB pool size is %d", pool_elts(load_balance_pool));
+
+    return (res);
+}
+
+/*
+ * Add and delete many routes and check that the compaction releases the
+ * free tail of the entry and load-balance pools without changing the
+ * forwarding of the routes that remain
+ */
+static int
+fib_test_memory_compact (void)
+{
+#define N_COMPACT_ROUTES 4096
+#define COMPACT_KEEP(_ii) ((_ii) < 16 || 0 == (_ii) % 512)
+    const u32 fib_index = 0;
+    test_main_t *tm = &test_main;
+    fib_route_path_t *rpaths = NULL;
+    fib_route_path_t rpath = {
+        .frp_proto = DPO_PROTO_IP4,
+        .frp_addr.ip4.as_u32 = clib_host_to_net_u32(0x0a0a0a01),
+        .frp_sw_if_index = tm->hw[0]->sw_if_index,
+        .frp_fib_index = ~0,
+        .frp_weight = 1,
+    };
+    fib_prefix_t pfx = {
+        .fp_len = 32,
+        .fp_proto = FIB_PROTOCOL_IP4,
+    };
+    u32 ii, n_feis, n_lbs, n_kept, fe_len, lb_len;
+    fib_node_index_t *feis = NULL;
+    dpo_id_t *buckets = NULL;
+    index_t *lbis = NULL;
+    int res;
+
+    res = 0;
+    n_feis = fib_entry_pool_size();
+    n_lbs = pool_elts(load_balance_pool);
+    vec_add1(rpaths, rpath);
+    vec_validate(feis, N_COMPACT_ROUTES - 1);
+    vec_validate(lbis, N_COMPACT_ROUTES - 1);
+    vec_validate(buckets, N_COMPACT_ROUTES - 1);
+
+    /*
+     * 12.0.0.0/32 onwards, each route has its own entry and load-balance
+     */
+    for (ii = 0; ii < N_COMPACT_ROUTES; ii++)
+    {
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x0c000000 + ii);
+        feis[ii] = fib_table_entry_path_add2(fib_index, &pfx, FIB_SOURCE_API,
+                                             FIB_ENTRY_FLAG_NONE, rpaths);
+    }
+    FIB_TEST((n_feis + N_COMPACT_ROUTES == fib_entry_pool_size()),
+             "entry pool size is %d", fib_entry_pool_size());
+
+    /*
+     * keep the first few and a sparse few after them, the routes added
+     * last are then at the tail of the pools
+     */
+    n_kept = 0;
+    for (ii = 0; ii < N_COMPACT_ROUTES; ii++)
+    {
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x0c000000 + ii);
+        if (COMPACT_KEEP(ii))
+        {
+            n_kept++;
+            lbis[ii] = ip4_fib_forwarding_lookup(fib_index, &pfx.fp_addr.ip4);
+            FIB_TEST((lbis[ii] ==
+                      fib_entry_contribute_ip_forwarding(feis[ii])->dpoi_index),
+                     "%U forwarded", format_fib_prefix, &pfx);
+            buckets[ii] = *load_balance_get_bucket(lbis[ii], 0);
+        }
+        else
+            fib_table_entry_delete(fib_index, &pfx, FIB_SOURCE_API);
+    }
+    FIB_TEST((n_feis + n_kept == fib_entry_pool_size()),
+             "entry pool size is %d", fib_entry_pool_size());
+    FIB_TEST((n_lbs + n_kept == pool_elts(load_balance_pool)),
+             "LB pool size is %d", pool_elts(load_balance_pool));
+
+    fe_len = fib_entry_pool_len();
+    lb_len = pool_len(load_balance_pool);
+    fib_memory_compact();
+
+    FIB_TEST((fib_entry_pool_len() < fe_len),
+             "entry pool length %d from %d",
+             fib_entry_pool_len(), fe_len);
+    FIB_TEST((pool_len(load_balance_pool) < lb_len),
+             "LB pool length %d from %d",
+             pool_len(load_balance_pool), lb_len);
+    FIB_TEST((n_feis + n_kept == fib_entry_pool_size()),
+             "entry pool size is %d", fib_entry_pool_size());
+    FIB_TEST((n_lbs + n_kept == pool_elts(load_balance_pool)),
+             "LB pool size is %d", pool_elts(load_balance_pool));
+
+    /*
+     * the remaining routes keep their entries and forwarding
+     */
+    for (ii = 0; ii < N_COMPACT_ROUTES; ii++)
+    {
+        if (!COMPACT_KEEP(ii))
+            continue;
+        pfx.fp_addr.ip4.as_u32 = clib_host_to_net_u32(0x0c000000 + ii);
+        FIB_TEST((feis[ii] == fib_table_lookup_exact_match(fib_index, &pfx)),
+                 "%U entry kept", format_fib_prefix, &pfx);
+        FIB_TEST((lbis[ii] ==
+                  ip4_fib_forwarding_lookup(fib_index, &pfx.fp_addr.ip4)),
+                 "%U LB kept", format_fib_prefix, &pfx);
+        FIB_TEST(dpo_cmp(&buckets[ii],
+                         load_balance_get_bucket(lbis[ii], 0)) == 0,
+                 "%U forwarding kept", format_fib_prefix, &pfx);
+        fib_table_entry_delete(fib_index, &pfx, FIB_SOURCE_API);
+    }
+
+    vec_free(rpaths);
+    vec_free(feis);
+    vec_free(lbis);
+    vec_free(buckets);
+    FIB_TEST((n_feis == fib_entry_pool_size()), "Entries gone");
+    FIB_TEST((n_lbs == pool_elts(load_balance_pool)),
+             "LB pool size is %d", pool_elts(load_balance_pool));
+
+    return (res);
+}
+
 static clib_error_t *
 fib_test (vlib_main_t * vm,
           unformat_input_t * input,
@@ -10870,6 +11774,29 @@ fib_test (vlib_main_t * vm,
     {
         res += fib_test_sticky();
     }
+    else if (unformat (input, "resilient"))
+    {
+        res += fib_test_resilient();
+    }
+    else if (unformat (input, "mtrie-update"))
+    {
+        res += fib_test_mtrie_update();
+    }
+    else if (unformat (input, "mtrie-24"))
+    {
+        res += fib_test_mtrie_24();
+    }
+    else if (unformat (input, "memory-compact"))
+    {
+        res += fib_test_memory_compact();
+    }
+    else if (unformat (input, "pic"))
+    {
+        u32 max_prefixes = 10000;
+
+        unformat (input, "%d", &max_prefixes);
+        res += fib_test_pic(max_prefixes);
+    }
     else
     {
         res += fib_test_v4();
@@ -10879,6 +11806,11 @@ fib_test (vlib_main_t * vm,
         res += fib_test_pref();
         res += fib_test_label();
         res += fib_test_inherit();
+        res += fib_test_pic(1000);
+        res += fib_test_resilient();
+        res += fib_test_mtrie_update();
+        res += fib_test_mtrie_24();
+        res += fib_test_memory_compact();
         res += lfib_test();
 
         /*
@@ -0,0 +1,305 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright(c) 2022 Cisco Systems, Inc.
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/stats/stats.h>
+
+#define STATS_TEST_I(_cond, _comment, _args...)                               \
+  ({                                                                          \
+    int _evald = (_cond);                                                     \
+    if (!(_evald))                                                            \
+      {                                                                       \
+	vlib_cli_output (vm, "FAIL:%d: " _comment "\n", __LINE__, ##_args);   \
+      }                                                                       \
+    _evald;                                                                   \
+  })
+
+#define STATS_TEST(_cond, _comment, _args...)                                 \
+  {                                                                           \
+    if (!STATS_TEST_I (_cond, _comment, ##_args))                             \
+      {                                                                       \
+	return 1;                                                             \
+      }                                                                       \
+  }
+
+/*
+ * Check that the replica rebuilt from the delta frames holds the values of
+ * the given stats segment entries.
+ */
+static int
+stats_test_delta_check (vlib_main_t *vm, vlib_stats_delta_entry_t *replica,
+			u32 *entries)
+{
+  vlib_stats_segment_t *sm = vlib_stats_get_segment ();
+  vlib_stats_delta_entry_t *de;
+  vlib_stats_entry_t *e;
+  u32 *ei;
+
+  vec_foreach (ei, entries)
+    {
+      e = sm->directory_vector + ei[0];
+
+      if (e->type == STAT_DIR_TYPE_EMPTY)
+	{
+	  STATS_TEST (ei[0] >= vec_len (replica) || replica[ei[0]].type == 0,
+		      "entry %u removed", ei[0]);
+	  continue;
+	}
+
+      STATS_TEST (ei[0] < vec_len (replica), "entry %u replicated", ei[0]);
+      de = replica + ei[0];
+      STATS_TEST (de->type == e->type, "entry %u type %u, expected %u",
+		  ei[0], de->type, e->type);
+      STATS_TEST (de->name && !strcmp ((char *) de->name, e->name),
+		  "entry %u name %s, expected %s", ei[0], de->name, e->name);
+
+      if (e->type == STAT_DIR_TYPE_SCALAR_INDEX)
+	{
+	  STATS_TEST (de->value == e->value, "%s value %llu, expected %llu",
+		      e->name, de->value, e->value);
+	}
+      else if (e->type == STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE)
+	{
+	  counter_t **c = e->data;
+
+	  for (u32 t = 0; t < vec_len (c); t++)
+	    for (u32 j = 0; j < vec_len (c[t]); j++)
+	      {
+		counter_t v = 0;
+
+		if (t < vec_len (de->simple) && j < vec_len (de->simple[t]))
+		  v = de->simple[t][j];
+		STATS_TEST (v == c[t][j], "%s [%u][%u] %llu, expected %llu",
+			    e->name, t, j, v, c[t][j]);
+	      }
+	}
+      else
+	{
+	  vlib_counter_t **c = e->data;
+
+	  for (u32 t = 0; t < vec_len (c); t++)
+	    for (u32 j = 0; j < vec_len (c[t]); j++)
+	      {
+		vlib_counter_t v = {};
+
+		if (t < vec_len (de->combined) &&
+		    j < vec_len (de->combined[t]))
+		  v = de->combined[t][j];
+		STATS_TEST (v.packets == c[t][j].packets &&
+			      v.bytes == c[t][j].bytes,
+			    "%s [%u][%u] %llu/%llu, expected %llu/%llu",
+			    e->name, t, j, v.packets, v.bytes,
+			    c[t][j].packets, c[t][j].bytes);
+	      }
+	}
+    }
+
+  return 0;
+}
+
+/* Encode a frame against the snapshot and apply it to the replica */
+static int
+stats_test_delta_round_trip (vlib_main_t *vm,
+			     vlib_stats_delta_entry_t **snapshot,
+			     vlib_stats_delta_entry_t **replica, int is_full,
+			     u32 *entries)
+{
+  clib_error_t *error;
+  f64 timestamp;
+  u64 sequence;
+  u8 *frame;
+
+  frame = vlib_stats_delta_encode (snapshot, is_full);
+  error = vlib_stats_delta_decode (replica, frame, &sequence, &timestamp);
+  vec_free (frame);
+
+  STATS_TEST (!error, "decode: %U", format_clib_error, error);
+  STATS_TEST (timestamp > unix_time_now () - 10.0, "timestamp %.6f",
+	      timestamp);
+  return stats_test_delta_check (vm, *replica, entries);
+}
+
+static int
+stats_test_delta_stream (vlib_main_t *vm)
+{
+  vlib_stats_delta_entry_t *snapshot = 0, *replica = 0, *full = 0;
+  vlib_simple_counter_main_t simple = {
+    .name = "test-delta-simple",
+    .stat_segment_name = "/test/delta/simple",
+  };
+  vlib_combined_counter_main_t combined = {
+    .name = "test-delta-combined",
+    .stat_segment_name = "/test/delta/combined",
+  };
+  clib_error_t *error;
+  u32 *entries = 0;
+  u32 gauge, i;
+  f64 timestamp;
+  u64 sequence;
+  u8 *frame;
+  int res;
+
+  gauge = vlib_stats_add_gauge ("/test/delta/gauge");
+  vlib_validate_simple_counter (&simple, 99);
+  vlib_validate_combined_counter (&combined, 99);
+  vec_add1 (entries, gauge);
+  vec_add1 (entries, simple.stats_entry_index);
+  vec_add1 (entries, combined.stats_entry_index);
+
+  /* everything is new to an empty snapshot */
+  vlib_stats_set_gauge (gauge, 42);
+  vlib_increment_simple_counter (&simple, 0, 7, 3);
+  vlib_increment_combined_counter (&combined, 0, 99, 1, 1500);
+  if ((res = stats_test_delta_round_trip (vm, &snapshot, &replica, 0,
+					  entries)))
+    goto done;
+
+  /* nothing changed */
+  if ((res = stats_test_delta_round_trip (vm, &snapshot, &replica, 0,
+					  entries)))
+    goto done;
+
+  /* negative deltas, and values which do not fit in 32 or 63 bits */
+  vlib_stats_set_gauge (gauge, 1ULL << 63 | 5);
+  for (i = 0; i < 100; i += 9)
+    vlib_increment_simple_counter (&simple, 0, i, (u64) i << 40);
+  vlib_increment_combined_counter (&combined, 0, 0, 1, 1ULL << 40);
+  if ((res = stats_test_delta_round_trip (vm, &snapshot, &replica, 0,
+					  entries)))
+    goto done;
+
+  vlib_stats_set_gauge (gauge, 1);
+  vlib_zero_simple_counter (&simple, 7);
+  vlib_zero_combined_counter (&combined, 99);
+  if ((res = stats_test_delta_round_trip (vm, &snapshot, &replica, 0,
+					  entries)))
+    goto done;
+
+  /* a full frame rebuilds the same values from scratch */
+  if ((res = stats_test_delta_round_trip (vm, &snapshot, &full, 1, entries)))
+    goto done;
+
+  /* removed entries are reported */
+  vlib_stats_remove_entry (gauge);
+  if ((res = stats_test_delta_round_trip (vm, &snapshot, &replica, 0,
+					  entries)))
+    goto done;
+
+  /* a truncated frame is an error, not a crash */
+  vlib_increment_simple_counter (&simple, 0, 3, 1);
+  frame = vlib_stats_delta_encode (&snapshot, 0);
+  vec_set_len (frame, vec_len (frame) - 2);
+  clib_mem_unaligned (frame, u32) =
+    clib_host_to_net_u32 (vec_len (frame) - sizeof (u32));
+  error = vlib_stats_delta_decode (&replica, frame, &sequence, &timestamp);
+  vec_free (frame);
+  res = !STATS_TEST_I (error != 0, "truncated frame decoded");
+  clib_error_free (error);
+
+done:
+  vlib_free_simple_counter (&simple);
+  vlib_free_combined_counter (&combined);
+  vlib_stats_delta_entries_free (&snapshot);
+  vlib_stats_delta_entries_free (&replica);
+  vlib_stats_delta_entries_free (&full);
+  vec_free (entries);
+  return res;
+}
+
+static int
+stats_test_histogram (vlib_main_t *vm)
+{
+  u64 values[] = { 0, 1, 7, 8, 9, 15, 16, 17, 100, 1000, 12345, 1ULL << 40 };
+  u32 n_buckets = stat_histogram_n_buckets (1000), b, i, index;
+  u64 lb, prev = 0, sum = 0, *h, n;
+  int res = 0;
+
+  /* values below 2^STAT_HISTOGRAM_SUB_BUCKET_BITS get a bucket each */
+  for (i = 0; i < (1 << STAT_HISTOGRAM_SUB_BUCKET_BITS); i++)
+    STATS_TEST (stat_histogram_bucket_index (i) == i, "bucket of %u is %u",
+		i, stat_histogram_bucket_index (i));
+
+  /* lower bounds grow and map back to their own bucket */
+  for (b = 0; b < stat_histogram_n_buckets (CLIB_U64_MAX); b++)
+    {
+      lb = stat_histogram_bucket_lower_bound (b);
+      STATS_TEST (b == 0 || lb > prev, "bucket %u lower bound %llu <= %llu",
+		  b, lb, prev);
+      STATS_TEST (stat_histogram_bucket_index (lb) == b,
+		  "lower bound %llu of bucket %u is in bucket %u", lb, b,
+		  stat_histogram_bucket_index (lb));
+      STATS_TEST (b == 0 || stat_histogram_bucket_index (lb - 1) == b - 1,
+		  "%llu is in bucket %u, expected %u", lb - 1,
+		  stat_histogram_bucket_index (lb - 1), b - 1);
+      prev = lb;
+    }
+  STATS_TEST (stat_histogram_bucket_index (CLIB_U64_MAX) == b - 1,
+	      "max value in bucket %u, expected %u",
+	      stat_histogram_bucket_index (CLIB_U64_MAX), b - 1);
+
+  /* every value up to the maximum has a bucket of its own range */
+  STATS_TEST (stat_histogram_bucket_lower_bound (n_buckets - 1) <= 1000 &&
+		stat_histogram_bucket_lower_bound (n_buckets) > 1000,
+	      "%u buckets for 1000", n_buckets);
+
+  /* recorded values land in their bucket, larger ones in the last one */
+  index = vlib_stats_add_histogram_vector (n_buckets, "/test/histogram");
+  vlib_stats_validate (index, 0, 1);
+  h = vlib_stats_get_histogram (index, 0, 1);
+  STATS_TEST (vec_len (h) == n_buckets + 1, "histogram length %u",
+	      vec_len (h));
+
+  for (i = 0; i < ARRAY_LEN (values); i++)
+    {
+      vlib_stats_histogram_record (h, values[i]);
+      sum += values[i];
+    }
+
+  if (!STATS_TEST_I (h[0] == sum, "sum %llu, expected %llu", h[0], sum))
+    res = 1;
+
+  for (b = 0; b < n_buckets; b++)
+    {
+      n = 0;
+      for (i = 0; i < ARRAY_LEN (values); i++)
+	if (clib_min (stat_histogram_bucket_index (values[i]),
+		      n_buckets - 1) == b)
+	  n++;
+      if (!STATS_TEST_I (h[1 + b] == n, "bucket %u count %llu, expected %llu",
+			 b, h[1 + b], n))
+	res = 1;
+    }
+
+  vlib_stats_remove_entry (index);
+  return res;
+}
+
+static clib_error_t *
+test_stats_command_fn (vlib_main_t *vm, unformat_input_t *input,
+		       vlib_cli_command_t *cmd)
+{
+  int res = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "delta-stream"))
+	res = stats_test_delta_stream (vm);
+      else if (unformat (input, "histogram"))
+	res = stats_test_histogram (vm);
+      else
+	return clib_error_return (0, "unknown input '%U'",
+				  format_unformat_error, input);
+    }
+
+  if (res)
+    return clib_error_return (0, "Stats unit test failed");
+  vlib_cli_output (vm, "Stats unit test OK");
+  return 0;
+}
+
+VLIB_CLI_COMMAND (test_stats_command, static) = {
+  .path = "test stats",
+  .short_help = "test stats [delta-stream] [histogram]",
+  .function = test_stats_command_fn,
+};
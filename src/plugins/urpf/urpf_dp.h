@@ -87,6 +87,86 @@ typedef enum
   URPF_N_NEXT,
 } urpf_next_t;
 
+/**
+ * Check one packet, given the result of the lookup of its source, and
+ * set the next node it is sent to.
+ */
+static_always_inline void
+urpf_check_one (vlib_main_t *vm, vlib_node_runtime_t *node, vlib_buffer_t *b,
+		u32 lb_index, u32 pass, u16 *next, vlib_dir_t dir,
+		urpf_mode_t mode)
+{
+  const load_balance_t *lb;
+
+  lb = load_balance_get (lb_index);
+
+  if (URPF_MODE_STRICT == mode)
+    {
+      /* for RX the check is: would this source adddress be forwarded
+       * out of the interface on which it was recieved, if yes allow.
+       * For TX it's; would this source address be forwarded out of the
+       * interface through which it is being sent, if yes drop.
+       */
+      int res;
+
+      res = fib_urpf_check (lb->lb_urpf, vnet_buffer (b)->sw_if_index[dir]);
+      if (VLIB_RX == dir)
+	pass |= res;
+      else
+	{
+	  pass |= !res && fib_urpf_check_size (lb->lb_urpf);
+
+	  /* allow locally generated */
+	  pass |= b->flags & VNET_BUFFER_F_LOCALLY_ORIGINATED;
+	}
+    }
+  else
+    pass |= fib_urpf_check_size (lb->lb_urpf);
+
+  if (PREDICT_TRUE (pass))
+    vnet_feature_next_u16 (next, b);
+  else
+    {
+      *next = URPF_NEXT_DROP;
+      b->error = node->errors[URPF_ERROR_DROP];
+    }
+
+  if (b->flags & VLIB_BUFFER_IS_TRACED)
+    {
+      urpf_trace_t *t;
+
+      t = vlib_add_trace (vm, node, b, sizeof (*t));
+      t->urpf = lb->lb_urpf;
+    }
+}
+
+static_always_inline const u8 *
+urpf_get_header (vlib_buffer_t *b, vlib_dir_t dir)
+{
+  const u8 *h;
+
+  h = (u8 *) vlib_buffer_get_current (b);
+
+  if (VLIB_TX == dir)
+    h += vnet_buffer (b)->ip.save_rewrite_length;
+
+  return (h);
+}
+
+static_always_inline u32
+urpf_get_fib_index (vlib_buffer_t *b, ip_address_family_t af, vlib_dir_t dir)
+{
+  return (urpf_cfgs[af][dir][vnet_buffer (b)->sw_if_index[dir]].fib_index);
+}
+
+static_always_inline u32
+urpf_ip4_pass (const ip4_header_t *ip)
+{
+  /* Pass multicast. */
+  return (ip4_address_is_multicast (&ip->src_address) ||
+	  ip4_address_is_global_broadcast (&ip->src_address));
+}
+
 static_always_inline uword
 urpf_inline (vlib_main_t * vm,
 	     vlib_node_runtime_t * node,
@@ -107,151 +187,92 @@ urpf_inline (vlib_main_t * vm,
   while (n_left >= 4)
     {
       u32 pass0, lb_index0, pass1, lb_index1;
-      const load_balance_t *lb0, *lb1;
-      u32 fib_index0, fib_index1;
-      const u8 *h0, *h1;
+      u32 pass2, lb_index2, pass3, lb_index3;
+      u32 fib_index0, fib_index1, fib_index2, fib_index3;
+      const u8 *h0, *h1, *h2, *h3;
 
       /* Prefetch next iteration. */
-      {
-	vlib_prefetch_buffer_header (b[2], LOAD);
-	vlib_prefetch_buffer_header (b[3], LOAD);
-	vlib_prefetch_buffer_data (b[2], LOAD);
-	vlib_prefetch_buffer_data (b[3], LOAD);
-      }
-
-      h0 = (u8 *) vlib_buffer_get_current (b[0]);
-      h1 = (u8 *) vlib_buffer_get_current (b[1]);
-
-      if (VLIB_TX == dir)
+      if (n_left >= 8)
 	{
-	  h0 += vnet_buffer (b[0])->ip.save_rewrite_length;
-	  h1 += vnet_buffer (b[1])->ip.save_rewrite_length;
+	  vlib_prefetch_buffer_header (b[4], LOAD);
+	  vlib_prefetch_buffer_header (b[5], LOAD);
+	  vlib_prefetch_buffer_header (b[6], LOAD);
+	  vlib_prefetch_buffer_header (b[7], LOAD);
+	  vlib_prefetch_buffer_data (b[4], LOAD);
+	  vlib_prefetch_buffer_data (b[5], LOAD);
+	  vlib_prefetch_buffer_data (b[6], LOAD);
+	  vlib_prefetch_buffer_data (b[7], LOAD);
 	}
 
-      fib_index0 =
-	urpf_cfgs[af][dir][vnet_buffer (b[0])->sw_if_index[dir]].fib_index;
-      fib_index1 =
-	urpf_cfgs[af][dir][vnet_buffer (b[1])->sw_if_index[dir]].fib_index;
+      h0 = urpf_get_header (b[0], dir);
+      h1 = urpf_get_header (b[1], dir);
+      h2 = urpf_get_header (b[2], dir);
+      h3 = urpf_get_header (b[3], dir);
+
+      fib_index0 = urpf_get_fib_index (b[0], af, dir);
+      fib_index1 = urpf_get_fib_index (b[1], af, dir);
+      fib_index2 = urpf_get_fib_index (b[2], af, dir);
+      fib_index3 = urpf_get_fib_index (b[3], af, dir);
 
       if (AF_IP4 == af)
 	{
-	  const ip4_header_t *ip0, *ip1;
+	  const ip4_header_t *ip0, *ip1, *ip2, *ip3;
 
 	  ip0 = (ip4_header_t *) h0;
 	  ip1 = (ip4_header_t *) h1;
-
-	  ip4_fib_forwarding_lookup_x2 (fib_index0,
-					fib_index1,
-					&ip0->src_address,
-					&ip1->src_address,
-					&lb_index0, &lb_index1);
-	  /* Pass multicast. */
-	  pass0 = (ip4_address_is_multicast (&ip0->src_address) ||
-		   ip4_address_is_global_broadcast (&ip0->src_address));
-	  pass1 = (ip4_address_is_multicast (&ip1->src_address) ||
-		   ip4_address_is_global_broadcast (&ip1->src_address));
+	  ip2 = (ip4_header_t *) h2;
+	  ip3 = (ip4_header_t *) h3;
+
+	  ip4_fib_forwarding_lookup_x4 (
+	    fib_index0, fib_index1, fib_index2, fib_index3, &ip0->src_address,
+	    &ip1->src_address, &ip2->src_address, &ip3->src_address,
+	    &lb_index0, &lb_index1, &lb_index2, &lb_index3);
+
+	  pass0 = urpf_ip4_pass (ip0);
+	  pass1 = urpf_ip4_pass (ip1);
+	  pass2 = urpf_ip4_pass (ip2);
+	  pass3 = urpf_ip4_pass (ip3);
 	}
       else
 	{
-	  const ip6_header_t *ip0, *ip1;
+	  const ip6_header_t *ip0, *ip1, *ip2, *ip3;
 
 	  ip0 = (ip6_header_t *) h0;
 	  ip1 = (ip6_header_t *) h1;
+	  ip2 = (ip6_header_t *) h2;
+	  ip3 = (ip6_header_t *) h3;
 
 	  lb_index0 = ip6_fib_table_fwding_lookup (fib_index0,
 						   &ip0->src_address);
 	  lb_index1 = ip6_fib_table_fwding_lookup (fib_index1,
 						   &ip1->src_address);
+	  lb_index2 = ip6_fib_table_fwding_lookup (fib_index2,
+						   &ip2->src_address);
+	  lb_index3 = ip6_fib_table_fwding_lookup (fib_index3,
+						   &ip3->src_address);
 	  pass0 = ip6_address_is_multicast (&ip0->src_address);
 	  pass1 = ip6_address_is_multicast (&ip1->src_address);
+	  pass2 = ip6_address_is_multicast (&ip2->src_address);
+	  pass3 = ip6_address_is_multicast (&ip3->src_address);
 	}
 
-      lb0 = load_balance_get (lb_index0);
-      lb1 = load_balance_get (lb_index1);
-
-      if (URPF_MODE_STRICT == mode)
-	{
-	  /* for RX the check is: would this source adddress be forwarded
-	   * out of the interface on which it was recieved, if yes allow.
-	   * For TX it's; would this source address be forwarded out of the
-	   * interface through which it is being sent, if yes drop.
-	   */
-	  int res0, res1;
-
-	  res0 = fib_urpf_check (lb0->lb_urpf,
-				 vnet_buffer (b[0])->sw_if_index[dir]);
-	  res1 = fib_urpf_check (lb1->lb_urpf,
-				 vnet_buffer (b[1])->sw_if_index[dir]);
-
-	  if (VLIB_RX == dir)
-	    {
-	      pass0 |= res0;
-	      pass1 |= res1;
-	    }
-	  else
-	    {
-	      pass0 |= !res0 && fib_urpf_check_size (lb0->lb_urpf);
-	      pass1 |= !res1 && fib_urpf_check_size (lb1->lb_urpf);
-
-	      /* allow locally generated */
-	      pass0 |= b[0]->flags & VNET_BUFFER_F_LOCALLY_ORIGINATED;
-	      pass1 |= b[1]->flags & VNET_BUFFER_F_LOCALLY_ORIGINATED;
-	    }
-	}
-      else
-	{
-	  pass0 |= fib_urpf_check_size (lb0->lb_urpf);
-	  pass1 |= fib_urpf_check_size (lb1->lb_urpf);
-	}
-
-      if (PREDICT_TRUE (pass0))
-	vnet_feature_next_u16 (&next[0], b[0]);
-      else
-	{
-	  next[0] = URPF_NEXT_DROP;
-	  b[0]->error = node->errors[URPF_ERROR_DROP];
-	}
-      if (PREDICT_TRUE (pass1))
-	vnet_feature_next_u16 (&next[1], b[1]);
-      else
-	{
-	  next[1] = URPF_NEXT_DROP;
-	  b[1]->error = node->errors[URPF_ERROR_DROP];
-	}
-
-      if (b[0]->flags & VLIB_BUFFER_IS_TRACED)
-	{
-	  urpf_trace_t *t;
+      urpf_check_one (vm, node, b[0], lb_index0, pass0, &next[0], dir, mode);
+      urpf_check_one (vm, node, b[1], lb_index1, pass1, &next[1], dir, mode);
+      urpf_check_one (vm, node, b[2], lb_index2, pass2, &next[2], dir, mode);
+      urpf_check_one (vm, node, b[3], lb_index3, pass3, &next[3], dir, mode);
 
-	  t = vlib_add_trace (vm, node, b[0], sizeof (*t));
-	  t->urpf = lb0->lb_urpf;
-	}
-      if (b[1]->flags & VLIB_BUFFER_IS_TRACED)
-	{
-	  urpf_trace_t *t;
-
-	  t = vlib_add_trace (vm, node, b[1], sizeof (*t));
-	  t->urpf = lb1->lb_urpf;
-	}
-
-      b += 2;
-      next += 2;
-      n_left -= 2;
+      b += 4;
+      next += 4;
+      n_left -= 4;
     }
 
   while (n_left)
     {
       u32 pass0, lb_index0, fib_index0;
-      const load_balance_t *lb0;
       const u8 *h0;
 
-      h0 = (u8 *) vlib_buffer_get_current (b[0]);
-
-      if (VLIB_TX == dir)
-	h0 += vnet_buffer (b[0])->ip.save_rewrite_length;
-
-      fib_index0 =
-	urpf_cfgs[af][dir][vnet_buffer (b[0])->sw_if_index[dir]].fib_index;
+      h0 = urpf_get_header (b[0], dir);
+      fib_index0 = urpf_get_fib_index (b[0], af, dir);
 
       if (AF_IP4 == af)
 	{
@@ -261,10 +282,7 @@ urpf_inline (vlib_main_t * vm,
 
 	  lb_index0 = ip4_fib_forwarding_lookup (fib_index0,
 						 &ip0->src_address);
-
-	  /* Pass multicast. */
-	  pass0 = (ip4_address_is_multicast (&ip0->src_address) ||
-		   ip4_address_is_global_broadcast (&ip0->src_address));
+	  pass0 = urpf_ip4_pass (ip0);
 	}
       else
 	{
@@ -277,40 +295,8 @@ urpf_inline (vlib_main_t * vm,
 	  pass0 = ip6_address_is_multicast (&ip0->src_address);
 	}
 
-      lb0 = load_balance_get (lb_index0);
+      urpf_check_one (vm, node, b[0], lb_index0, pass0, &next[0], dir, mode);
 
-      if (URPF_MODE_STRICT == mode)
-	{
-	  int res0;
-
-	  res0 = fib_urpf_check (lb0->lb_urpf,
-				 vnet_buffer (b[0])->sw_if_index[dir]);
-	  if (VLIB_RX == dir)
-	    pass0 |= res0;
-	  else
-	    {
-	      pass0 |= !res0 && fib_urpf_check_size (lb0->lb_urpf);
-	      pass0 |= b[0]->flags & VNET_BUFFER_F_LOCALLY_ORIGINATED;
-	    }
-	}
-      else
-	pass0 |= fib_urpf_check_size (lb0->lb_urpf);
-
-      if (PREDICT_TRUE (pass0))
-	vnet_feature_next_u16 (&next[0], b[0]);
-      else
-	{
-	  next[0] = URPF_NEXT_DROP;
-	  b[0]->error = node->errors[URPF_ERROR_DROP];
-	}
-
-      if (b[0]->flags & VLIB_BUFFER_IS_TRACED)
-	{
-	  urpf_trace_t *t;
-
-	  t = vlib_add_trace (vm, node, b[0], sizeof (*t));
-	  t->urpf = lb0->lb_urpf;
-	}
       b++;
       next++;
       n_left--;
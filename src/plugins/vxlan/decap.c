@@ -266,7 +266,9 @@ vxlan_input (vlib_main_t * vm,
 	  vnet_update_l2_len (b[1]);
 	  /* Set packet input sw_if_index to unicast VXLAN tunnel for learning */
 	  vnet_buffer (b[0])->sw_if_index[VLIB_RX] = di0.sw_if_index;
+	  vnet_buffer_rx_flow_hash_clear (b[0]);
 	  vnet_buffer (b[1])->sw_if_index[VLIB_RX] = di1.sw_if_index;
+	  vnet_buffer_rx_flow_hash_clear (b[1]);
 	  vlib_increment_combined_counter (rx_counter, thread_index,
 					   stats_if0, 1, len0);
 	  vlib_increment_combined_counter (rx_counter, thread_index,
@@ -278,6 +280,7 @@ vxlan_input (vlib_main_t * vm,
 	    {
 	      vnet_update_l2_len (b[0]);
 	      vnet_buffer (b[0])->sw_if_index[VLIB_RX] = di0.sw_if_index;
+	      vnet_buffer_rx_flow_hash_clear (b[0]);
 	      vlib_increment_combined_counter (rx_counter, thread_index,
 					       stats_if0, 1, len0);
 	    }
@@ -291,6 +294,7 @@ vxlan_input (vlib_main_t * vm,
 	    {
 	      vnet_update_l2_len (b[1]);
 	      vnet_buffer (b[1])->sw_if_index[VLIB_RX] = di1.sw_if_index;
+	      vnet_buffer_rx_flow_hash_clear (b[1]);
 	      vlib_increment_combined_counter (rx_counter, thread_index,
 					       stats_if1, 1, len1);
 	    }
@@ -359,6 +363,7 @@ vxlan_input (vlib_main_t * vm,
 
 	  /* Set packet input sw_if_index to unicast VXLAN tunnel for learning */
 	  vnet_buffer (b[0])->sw_if_index[VLIB_RX] = di0.sw_if_index;
+	  vnet_buffer_rx_flow_hash_clear (b[0]);
 
 	  vlib_increment_combined_counter (rx_counter, thread_index,
 					   stats_if0, 1, len0);
@@ -1171,6 +1176,10 @@ VLIB_NODE_FN (vxlan4_flow_input_node) (vlib_main_t * vm,
 	  b1->flow_id = 0;
 	  b2->flow_id = 0;
 	  b3->flow_id = 0;
+	  vnet_buffer_rx_flow_hash_clear (b0);
+	  vnet_buffer_rx_flow_hash_clear (b1);
+	  vnet_buffer_rx_flow_hash_clear (b2);
+	  vnet_buffer_rx_flow_hash_clear (b3);
 
 	  u32 sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX] =
 	    t0->sw_if_index;
@@ -1272,6 +1281,7 @@ VLIB_NODE_FN (vxlan4_flow_input_node) (vlib_main_t * vm,
 	  u32 t_index0 = b0->flow_id - vxm->flow_id_start;
 	  vxlan_tunnel_t *t0 = &vxm->tunnels[t_index0];
 	  b0->flow_id = 0;
+	  vnet_buffer_rx_flow_hash_clear (b0);
 
 	  u32 sw_if_index0 = vnet_buffer (b0)->sw_if_index[VLIB_RX] =
 	    t0->sw_if_index;
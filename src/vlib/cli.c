@@ -641,7 +641,12 @@ vlib_cli_dispatch_sub_commands (vlib_main_t * vm,
 		}
 
 	      if (!c->is_mp_safe)
-		vlib_worker_thread_barrier_sync (vm);
+		{
+		  /* Attribute the barrier hold to this command */
+		  vlib_worker_threads[0].barrier_context = c->path;
+		  vlib_worker_threads[0].barrier_context_is_vec = 1;
+		  vlib_worker_thread_barrier_sync (vm);
+		}
 	      if (PREDICT_FALSE (vec_len (cm->perf_counter_cbs) != 0))
 		clib_call_callbacks (cm->perf_counter_cbs, cm,
 				     c - cm->commands, 0 /* before */ );
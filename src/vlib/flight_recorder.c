@@ -0,0 +1,263 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright(c) 2022 Cisco Systems, Inc.
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/threads.h>
+
+vlib_flight_recorder_main_t vlib_flight_recorder_main = {
+  .log2_n_entries = 14,
+  .min_idle_clocks = 5000,
+};
+
+#define FR_TIME_MASK ((1ULL << 48) - 1)
+
+static void
+flight_recorder_apply_config (vlib_main_t *vm)
+{
+  vlib_flight_recorder_main_t *frm = &vlib_flight_recorder_main;
+  vlib_flight_recorder_t *fr = &vm->flight_recorder;
+
+  fr->min_idle_clocks = frm->min_idle_clocks;
+  fr->trigger_clocks =
+    frm->trigger_loop_time * vm->clib_time.clocks_per_second;
+}
+
+/* Called by every thread before entering its main loop */
+void
+vlib_flight_recorder_thread_init (vlib_main_t *vm)
+{
+  vlib_flight_recorder_main_t *frm = &vlib_flight_recorder_main;
+  vlib_flight_recorder_t *fr = &vm->flight_recorder;
+  u32 n_entries = 1 << frm->log2_n_entries;
+
+  /* worker mains start as a copy of the main thread one */
+  clib_memset (fr, 0, sizeof (*fr));
+
+  flight_recorder_apply_config (vm);
+
+  if (frm->disabled)
+    return;
+
+  fr->ring = clib_mem_alloc_aligned (n_entries * sizeof (fr->ring[0]),
+				     CLIB_CACHE_LINE_BYTES);
+  clib_memset (fr->ring, 0, n_entries * sizeof (fr->ring[0]));
+  fr->mask = n_entries - 1;
+}
+
+void
+vlib_flight_recorder_trigger (vlib_main_t *vm, u64 loop_clocks)
+{
+  vlib_flight_recorder_t *fr = &vm->flight_recorder;
+  uword n_bytes = (fr->mask + 1) * sizeof (fr->ring[0]);
+
+  fr->n_triggers++;
+
+  /* Keep the first stall until somebody looks at it */
+  if (fr->ring == 0 || fr->snapshot_time)
+    return;
+
+  if (fr->snapshot == 0)
+    fr->snapshot = clib_mem_alloc_aligned (n_bytes, CLIB_CACHE_LINE_BYTES);
+
+  clib_memcpy_fast (fr->snapshot, fr->ring, n_bytes);
+  fr->snapshot_head = fr->head;
+  fr->snapshot_time = clib_cpu_time_now ();
+  fr->snapshot_loop_clocks = loop_clocks;
+}
+
+static clib_error_t *
+flight_recorder_config (vlib_main_t *vm, unformat_input_t *input)
+{
+  vlib_flight_recorder_main_t *frm = &vlib_flight_recorder_main;
+  u32 n_entries;
+  f64 usec;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "entries %u", &n_entries))
+	frm->log2_n_entries = max_log2 (clib_max (n_entries, 2));
+      else if (unformat (input, "min-idle-clocks %u", &frm->min_idle_clocks))
+	;
+      else if (unformat (input, "trigger-loop-time %f", &usec))
+	frm->trigger_loop_time = usec * 1e-6;
+      else if (unformat (input, "disable"))
+	frm->disabled = 1;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  return 0;
+}
+
+VLIB_CONFIG_FUNCTION (flight_recorder_config, "flight-recorder");
+
+static u8 *
+format_flight_recorder_entry (u8 *s, va_list *args)
+{
+  vlib_main_t *vm = va_arg (*args, vlib_main_t *);
+  vlib_flight_recorder_entry_t *e =
+    va_arg (*args, vlib_flight_recorder_entry_t *);
+  u64 ref = va_arg (*args, u64);
+  f64 spc = vm->clib_time.seconds_per_clock;
+  u64 ago = ((ref & FR_TIME_MASK) - e->time) & FR_TIME_MASK;
+
+  return format (s, "%12.3f %-32U %8u %12u %10.3f", -1e6 * ago * spc,
+		 format_vlib_node_name, vm, e->node_index, e->n_vectors,
+		 e->clocks, 1e6 * e->clocks * spc);
+}
+
+static clib_error_t *
+show_flight_recorder_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				 vlib_cli_command_t *cmd)
+{
+  vlib_flight_recorder_entry_t *e, *copy = 0;
+  u32 thread_index = vm->thread_index, count = 50, min_clocks = 0;
+  u32 n_triggers;
+  vlib_flight_recorder_t *fr;
+  vlib_main_t *tvm;
+  int snapshot = 0;
+  u64 head, ref, loop_clocks = 0, n, i;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "thread %u", &thread_index))
+	;
+      else if (unformat (input, "snapshot"))
+	snapshot = 1;
+      else if (unformat (input, "count %u", &count))
+	;
+      else if (unformat (input, "min-clocks %u", &min_clocks))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (thread_index >= vlib_get_n_threads ())
+    return clib_error_return (0, "no such thread %u", thread_index);
+
+  tvm = vlib_get_main_by_index (thread_index);
+  fr = &tvm->flight_recorder;
+
+  if (fr->ring == 0)
+    return clib_error_return (0, "flight recorder disabled");
+
+  /*
+   * The owning thread writes the ring and the snapshot from its main loop,
+   * copy them while it is parked at the barrier. The barrier is only held
+   * for the copy, not while formatting.
+   */
+  vec_validate (copy, fr->mask);
+  vlib_worker_thread_barrier_sync (vm);
+  if (snapshot)
+    {
+      ref = fr->snapshot_time;
+      head = fr->snapshot_head;
+      loop_clocks = fr->snapshot_loop_clocks;
+      if (ref)
+	clib_memcpy_fast (copy, fr->snapshot, vec_bytes (copy));
+    }
+  else
+    {
+      head = fr->head;
+      clib_memcpy_fast (copy, fr->ring, vec_bytes (copy));
+      ref = clib_cpu_time_now ();
+    }
+  n_triggers = fr->n_triggers;
+  vlib_worker_thread_barrier_release (vm);
+
+  if (snapshot)
+    {
+      if (ref == 0)
+	{
+	  vlib_cli_output (vm, "no snapshot, %u triggers", n_triggers);
+	  goto done;
+	}
+      vlib_cli_output (vm, "snapshot: loop took %.3f us, %u triggers",
+		       1e6 * loop_clocks * tvm->clib_time.seconds_per_clock,
+		       n_triggers);
+    }
+
+  n = clib_min (head, (u64) fr->mask + 1);
+  vlib_cli_output (vm, "%12s %-32s %8s %12s %10s", "Time (us)", "Node",
+		   "Vectors", "Clocks", "Time (us)");
+
+  /* Oldest first, newest last */
+  for (i = head - n; i < head; i++)
+    {
+      e = copy + (i & fr->mask);
+      if (head - i > count && !min_clocks)
+	continue;
+      if (e->clocks < min_clocks)
+	continue;
+      vlib_cli_output (vm, "%U", format_flight_recorder_entry, tvm, e, ref);
+    }
+
+done:
+  vec_free (copy);
+  return 0;
+}
+
+VLIB_CLI_COMMAND (show_flight_recorder_command, static) = {
+  .path = "show flight-recorder",
+  .short_help = "show flight-recorder [thread <n>] [snapshot] [count <n>] "
+		"[min-clocks <n>]",
+  .function = show_flight_recorder_command_fn,
+  .is_mp_safe = 1,
+};
+
+static clib_error_t *
+set_flight_recorder_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				vlib_cli_command_t *cmd)
+{
+  vlib_flight_recorder_main_t *frm = &vlib_flight_recorder_main;
+  f64 usec;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "trigger-loop-time %f", &usec))
+	frm->trigger_loop_time = usec * 1e-6;
+      else if (unformat (input, "min-idle-clocks %u", &frm->min_idle_clocks))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  foreach_vlib_main ()
+    flight_recorder_apply_config (this_vlib_main);
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (set_flight_recorder_command, static) = {
+  .path = "set flight-recorder",
+  .short_help = "set flight-recorder [trigger-loop-time <usec>] "
+		"[min-idle-clocks <n>]",
+  .function = set_flight_recorder_command_fn,
+};
+
+static clib_error_t *
+clear_flight_recorder_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				  vlib_cli_command_t *cmd)
+{
+  /* Re-arm the triggers, workers set them from their main loop */
+  vlib_worker_thread_barrier_sync (vm);
+  foreach_vlib_main ()
+    {
+      this_vlib_main->flight_recorder.snapshot_time = 0;
+      this_vlib_main->flight_recorder.n_triggers = 0;
+    }
+  vlib_worker_thread_barrier_release (vm);
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (clear_flight_recorder_command, static) = {
+  .path = "clear flight-recorder",
+  .short_help = "clear flight-recorder",
+  .function = clear_flight_recorder_command_fn,
+  .is_mp_safe = 1,
+};
@@ -0,0 +1,92 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright(c) 2022 Cisco Systems, Inc.
+ */
+
+/*
+ * Dispatch flight recorder: a per-thread ring of the most recent node
+ * dispatches, cheap enough to leave on, so micro-stalls can be examined
+ * after the fact. Optionally the ring is frozen into a snapshot when a
+ * main loop iteration takes longer than a threshold.
+ */
+
+#ifndef included_vlib_flight_recorder_h
+#define included_vlib_flight_recorder_h
+
+#include <vppinfra/clib.h>
+#include <vppinfra/time.h>
+
+typedef struct
+{
+  /* cpu time at dispatch start, low 48 bits */
+  u64 time : 48;
+  u64 n_vectors : 16;
+  u32 node_index;
+  u32 clocks;
+} vlib_flight_recorder_entry_t;
+
+STATIC_ASSERT_SIZEOF (vlib_flight_recorder_entry_t, 16);
+
+typedef struct
+{
+  /* ring, zero when disabled */
+  vlib_flight_recorder_entry_t *ring;
+  u32 mask;
+  u32 min_idle_clocks;
+  u64 head;
+
+  /* loop time trigger, zero when disabled */
+  u64 trigger_clocks;
+  u64 loop_start;
+
+  /* ring frozen by the last trigger, until cleared */
+  vlib_flight_recorder_entry_t *snapshot;
+  u64 snapshot_head;
+  u64 snapshot_time;
+  u64 snapshot_loop_clocks;
+  u32 n_triggers;
+} vlib_flight_recorder_t;
+
+typedef struct
+{
+  /* configuration, applied to every thread */
+  u32 log2_n_entries;
+  u32 min_idle_clocks;
+  f64 trigger_loop_time;
+  u8 disabled;
+} vlib_flight_recorder_main_t;
+
+extern vlib_flight_recorder_main_t vlib_flight_recorder_main;
+
+static_always_inline void
+vlib_flight_recorder_add (vlib_flight_recorder_t *fr, u32 node_index,
+			  uword n_vectors, u64 t0, u64 t1)
+{
+  vlib_flight_recorder_entry_t *e;
+  u64 clocks = t1 - t0;
+
+  if (PREDICT_FALSE (fr->ring == 0))
+    return;
+
+  /* Cheap empty polls would push everything else out of the ring */
+  if (n_vectors == 0 && clocks < fr->min_idle_clocks)
+    return;
+
+  e = fr->ring + (fr->head++ & fr->mask);
+  e->time = t0;
+  e->n_vectors = n_vectors;
+  e->node_index = node_index;
+  e->clocks = clocks > CLIB_U32_MAX ? CLIB_U32_MAX : clocks;
+}
+
+/* Sleeping in epoll is not a stall, time the loop from the wakeup */
+static_always_inline void
+vlib_flight_recorder_sleep_done (vlib_flight_recorder_t *fr)
+{
+  fr->loop_start = clib_cpu_time_now ();
+}
+
+struct vlib_main_t;
+void vlib_flight_recorder_thread_init (struct vlib_main_t *vm);
+void vlib_flight_recorder_trigger (struct vlib_main_t *vm, u64 loop_clocks);
+
+#endif /* included_vlib_flight_recorder_h */
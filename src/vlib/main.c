@@ -977,6 +977,15 @@ dispatch_node (vlib_main_t * vm,
 				      /* n_vectors */ n,
 				      /* n_clocks */ t - last_time_stamp);
 
+  /* Empty polls would swamp the distribution, only record real work */
+  if (PREDICT_FALSE (vm->node_clocks_histograms != 0) && n)
+    vlib_stats_node_histograms_record (vm->node_clocks_histograms,
+				       vm->node_vectors_histograms,
+				       node->node_index, n, t - last_time_stamp);
+
+  vlib_flight_recorder_add (&vm->flight_recorder, node->node_index, n,
+			    last_time_stamp, t);
+
   /* When in adaptive mode and vector rate crosses threshold switch to
      polling mode and vice versa. */
   if (PREDICT_FALSE (node->flags & VLIB_NODE_FLAG_ADAPTIVE_MODE))
@@ -1346,6 +1355,11 @@ dispatch_process (vlib_main_t * vm,
 			     /* n_vectors */ n_vectors,
 			     /* n_clocks */ t - last_time_stamp);
 
+  /* vlib_start_process passes no time stamp */
+  if (last_time_stamp)
+    vlib_flight_recorder_add (&vm->flight_recorder, node_runtime->node_index,
+			      n_vectors, last_time_stamp, t);
+
   return t;
 }
 
@@ -1435,6 +1449,9 @@ dispatch_suspended_process (vlib_main_t * vm,
 			     /* n_vectors */ n_vectors,
 			     /* n_clocks */ t - last_time_stamp);
 
+  vlib_flight_recorder_add (&vm->flight_recorder, node_runtime->node_index,
+			    n_vectors, last_time_stamp, t);
+
   return t;
 }
 
@@ -1483,6 +1500,8 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
   vm->numa_node = clib_get_current_numa_node ();
   os_set_numa_index (vm->numa_node);
 
+  vlib_flight_recorder_thread_init (vm);
+
   /* Start all processes. */
   if (is_main)
     {
@@ -1501,6 +1520,8 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
 					 cpu_time_now);
     }
 
+  vm->flight_recorder.loop_start = cpu_time_now;
+
   while (1)
     {
       vlib_node_runtime_t *n;
@@ -1699,6 +1720,15 @@ vlib_main_or_worker_loop (vlib_main_t * vm, int is_main)
       /* Record time stamp in case there are no enabled nodes and above
          calls do not update time stamp. */
       cpu_time_now = clib_cpu_time_now ();
+
+      /* Freeze the flight recorder when this iteration ran long */
+      if (PREDICT_FALSE (vm->flight_recorder.trigger_clocks &&
+			 cpu_time_now - vm->flight_recorder.loop_start >
+			   vm->flight_recorder.trigger_clocks))
+	vlib_flight_recorder_trigger (vm, cpu_time_now -
+					    vm->flight_recorder.loop_start);
+      vm->flight_recorder.loop_start = cpu_time_now;
+
       vm->loops_this_reporting_interval++;
       now = clib_time_now_internal (&vm->clib_time, cpu_time_now);
       /* Time to update loops_per_second? */
@@ -50,6 +50,7 @@
 #include <vppinfra/time.h>
 
 #include <pthread.h>
+#include <vlib/flight_recorder.h>
 
 
 /* By default turn off node/error event logging.
@@ -258,6 +259,14 @@ typedef struct vlib_main_t
   u32 buffer_alloc_success_seed;
   f64 buffer_alloc_success_rate;
 
+  /* dispatch flight recorder */
+  vlib_flight_recorder_t flight_recorder;
+
+  /* this thread's per-node dispatch histograms, zero when disabled.
+     Only changed while the thread is parked at the barrier. */
+  u64 **node_clocks_histograms;
+  u64 **node_vectors_histograms;
+
 #ifdef CLIB_SANITIZE_ADDR
   /* address sanitizer stack save */
   void *asan_stack_save;
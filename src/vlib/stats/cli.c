@@ -46,6 +46,10 @@ format_stat_dir_entry (u8 *s, va_list *args)
       type_name = "Symlink";
       break;
 
+    case STAT_DIR_TYPE_HISTOGRAM:
+      type_name = "Histogram";
+      break;
+
     default:
       type_name = "illegal!";
       break;
@@ -108,6 +112,84 @@ show_stat_segment_hash_command_fn (vlib_main_t *vm, unformat_input_t *input,
   return 0;
 }
 
+static clib_error_t *
+show_stat_histogram_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				vlib_cli_command_t *cmd)
+{
+  vlib_stats_segment_t *sm = vlib_stats_get_segment ();
+  clib_error_t *error = 0;
+  vlib_stats_entry_t *e;
+  u32 entry_index, index = ~0, i, j;
+  u64 ***data, *sum = 0;
+  int verbose = 0;
+  u8 *name = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "index %u", &index))
+	;
+      else if (unformat (input, "verbose"))
+	verbose = 1;
+      else if (unformat (input, "%s", &name))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (name == 0)
+    return clib_error_return (0, "histogram name required");
+
+  entry_index = vlib_stats_find_entry_index ("%v", name);
+  if (entry_index == STAT_SEGMENT_INDEX_INVALID)
+    {
+      error = clib_error_return (0, "unknown statistic `%v'", name);
+      goto done;
+    }
+
+  e = vlib_stats_get_entry (sm, entry_index);
+  if (e->type == STAT_DIR_TYPE_SYMLINK)
+    {
+      index = e->index2;
+      e = vlib_stats_get_entry (sm, e->index1);
+    }
+  if (e->type != STAT_DIR_TYPE_HISTOGRAM)
+    {
+      error = clib_error_return (0, "`%v' is not a histogram", name);
+      goto done;
+    }
+
+  /* Sum across threads */
+  data = e->data;
+  for (i = 0; i < vec_len (data); i++)
+    for (j = 0; j < vec_len (data[i]); j++)
+      {
+	u64 *h = data[i][j];
+	if (index != ~0 && j != index)
+	  continue;
+	vec_validate (sum, vec_len (h) - 1);
+	for (u32 k = 0; k < vec_len (h); k++)
+	  sum[k] += h[k];
+      }
+
+  if (sum == 0)
+    vlib_cli_output (vm, "%v: no data", name);
+  else
+    vlib_cli_output (vm, "%v: %U", name, format_vlib_stats_histogram, sum,
+		     verbose);
+
+done:
+  vec_free (sum);
+  vec_free (name);
+  return error;
+}
+
+VLIB_CLI_COMMAND (show_stat_histogram_command, static) = {
+  .path = "show statistics histogram",
+  .short_help = "show statistics histogram <name> [index <n>] [verbose]",
+  .function = show_stat_histogram_command_fn,
+};
+
 VLIB_CLI_COMMAND (show_stat_segment_hash_command, static) = {
   .path = "show statistics hash",
   .short_help = "show statistics hash",
@@ -34,6 +34,9 @@ static struct
 
 static vlib_stats_string_vector_t node_names = 0;
 
+/* Calls taking longer than this land in the last clocks bucket */
+#define NODE_HISTOGRAM_MAX_CLOCKS (1ULL << 26)
+
 static inline void
 update_node_counters (vlib_stats_segment_t *sm)
 {
@@ -128,12 +131,98 @@ update_node_counters (vlib_stats_segment_t *sm)
   vec_free (stat_vms);
 }
 
+/*
+ * Point every thread at its own histogram rows, or at nothing when
+ * disabled. Threads record through these cached pointers without taking
+ * the stats segment lock or looking at the directory vector, so both the
+ * pointers and the vectors behind them may only change while the workers
+ * are parked at the barrier.
+ */
+static void
+node_histograms_publish (vlib_stats_segment_t *sm, int is_enable)
+{
+  u64 ***clocks = 0, ***vectors = 0;
+
+  if (is_enable)
+    {
+      clocks = vlib_stats_get_entry_data_pointer (
+	sm->node_clocks_histogram_index);
+      vectors = vlib_stats_get_entry_data_pointer (
+	sm->node_vectors_histogram_index);
+    }
+
+  foreach_vlib_main ()
+    {
+      u32 ti = this_vlib_main->thread_index;
+
+      this_vlib_main->node_clocks_histograms = is_enable ? clocks[ti] : 0;
+      this_vlib_main->node_vectors_histograms = is_enable ? vectors[ti] : 0;
+    }
+}
+
+/* Make room for nodes registered since the last run */
+static void
+update_node_histograms (vlib_main_t *vm, vlib_stats_segment_t *sm,
+			int force)
+{
+  u32 n_nodes = vec_len (vm->node_main.nodes);
+  u32 last_thread = vlib_get_n_threads () - 1;
+
+  if (!force &&
+      !vlib_stats_validate_will_expand (sm->node_clocks_histogram_index,
+					last_thread, n_nodes - 1) &&
+      !vlib_stats_validate_will_expand (sm->node_vectors_histogram_index,
+					last_thread, n_nodes - 1))
+    return;
+
+  vlib_worker_thread_barrier_sync (vm);
+  vlib_stats_validate (sm->node_clocks_histogram_index, last_thread,
+		       n_nodes - 1);
+  vlib_stats_validate (sm->node_vectors_histogram_index, last_thread,
+		       n_nodes - 1);
+  node_histograms_publish (sm, 1);
+  vlib_worker_thread_barrier_release (vm);
+}
+
+static void
+node_histograms_enable_disable (vlib_main_t *vm, int is_enable)
+{
+  vlib_stats_segment_t *sm = vlib_stats_get_segment ();
+
+  /* Index 0 is a scalar /sys counter, never one of ours */
+  if (is_enable && sm->node_clocks_histogram_index == 0)
+    {
+      sm->node_clocks_histogram_index = vlib_stats_add_histogram_vector (
+	stat_histogram_n_buckets (NODE_HISTOGRAM_MAX_CLOCKS),
+	"/sys/node/clocks-per-call");
+      sm->node_vectors_histogram_index = vlib_stats_add_histogram_vector (
+	stat_histogram_n_buckets (VLIB_FRAME_SIZE),
+	"/sys/node/vectors-per-call");
+      ASSERT (sm->node_clocks_histogram_index != CLIB_U32_MAX);
+      ASSERT (sm->node_vectors_histogram_index != CLIB_U32_MAX);
+    }
+
+  if (is_enable)
+    update_node_histograms (vm, sm, 1 /* force */);
+  else if (sm->node_histograms_enabled)
+    {
+      vlib_worker_thread_barrier_sync (vm);
+      node_histograms_publish (sm, 0);
+      vlib_worker_thread_barrier_release (vm);
+    }
+
+  sm->node_histograms_enabled = is_enable;
+}
+
 static void
 do_stat_segment_updates (vlib_main_t *vm, vlib_stats_segment_t *sm)
 {
   if (sm->node_counters_enabled)
     update_node_counters (sm);
 
+  if (sm->node_histograms_enabled)
+    update_node_histograms (vm, sm, 0 /* force */);
+
   vlib_stats_collector_t *c;
   pool_foreach (c, sm->collectors)
     {
@@ -148,6 +237,8 @@ do_stat_segment_updates (vlib_main_t *vm, vlib_stats_segment_t *sm)
 
   /* Heartbeat, so clients detect we're still here */
   sm->directory_vector[STAT_COUNTER_HEARTBEAT].value++;
+
+  vlib_stats_delta_stream_update (sm);
 }
 
 static uword
@@ -169,6 +260,9 @@ stat_segment_collector_process (vlib_main_t *vm, vlib_node_runtime_t *rt,
 	}
     }
 
+  if (sm->node_histograms_config)
+    node_histograms_enable_disable (vm, 1);
+
   sm->directory_vector[STAT_COUNTER_BOOTTIME].value = unix_time_now ();
 
   while (1)
@@ -184,3 +278,101 @@ VLIB_REGISTER_NODE (stat_segment_collector, static) = {
   .name = "statseg-collector-process",
   .type = VLIB_NODE_TYPE_PROCESS,
 };
+
+static clib_error_t *
+set_node_histograms_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				vlib_cli_command_t *cmd)
+{
+  int is_enable;
+
+  if (unformat (input, "on"))
+    is_enable = 1;
+  else if (unformat (input, "off"))
+    is_enable = 0;
+  else
+    return clib_error_return (0, "expected on | off");
+
+  node_histograms_enable_disable (vm, is_enable);
+  return 0;
+}
+
+VLIB_CLI_COMMAND (set_node_histograms_command, static) = {
+  .path = "set statistics node-histograms",
+  .short_help = "set statistics node-histograms on | off",
+  .function = set_node_histograms_command_fn,
+};
+
+static clib_error_t *
+show_node_histograms_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				 vlib_cli_command_t *cmd)
+{
+  vlib_stats_segment_t *sm = vlib_stats_get_segment ();
+  u32 node_index = ~0, i, j, k;
+  u64 ***clocks, ***vectors;
+  u64 *csum = 0, *vsum = 0;
+  int verbose = 0;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "verbose"))
+	verbose = 1;
+      else if (unformat (input, "%U", unformat_vlib_node, vm, &node_index))
+	;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (sm->node_clocks_histogram_index == 0)
+    return clib_error_return (0, "node histograms not enabled");
+
+  clocks = vlib_stats_get_entry_data_pointer (sm->node_clocks_histogram_index);
+  vectors =
+    vlib_stats_get_entry_data_pointer (sm->node_vectors_histogram_index);
+
+  for (j = 0; j < vec_len (vm->node_main.nodes); j++)
+    {
+      u64 n_calls = 0;
+
+      if (node_index != ~0 && j != node_index)
+	continue;
+
+      vec_reset_length (csum);
+      vec_reset_length (vsum);
+
+      /* Sum across threads */
+      for (i = 0; i < vec_len (clocks); i++)
+	{
+	  if (j >= vec_len (clocks[i]) || j >= vec_len (vectors[i]))
+	    continue;
+	  vec_validate (csum, vec_len (clocks[i][j]) - 1);
+	  vec_validate (vsum, vec_len (vectors[i][j]) - 1);
+	  for (k = 0; k < vec_len (clocks[i][j]); k++)
+	    csum[k] += clocks[i][j][k];
+	  for (k = 0; k < vec_len (vectors[i][j]); k++)
+	    vsum[k] += vectors[i][j][k];
+	}
+
+      for (k = 1; k < vec_len (vsum); k++)
+	n_calls += vsum[k];
+
+      if (n_calls == 0 && node_index == ~0)
+	continue;
+
+      vlib_cli_output (vm, "%U:", format_vlib_node_name, vm, j);
+      vlib_cli_output (vm, "  clocks:  %U", format_vlib_stats_histogram,
+		       csum, verbose);
+      vlib_cli_output (vm, "  vectors: %U", format_vlib_stats_histogram,
+		       vsum, verbose);
+    }
+
+  vec_free (csum);
+  vec_free (vsum);
+  return 0;
+}
+
+VLIB_CLI_COMMAND (show_node_histograms_command, static) = {
+  .path = "show statistics node-histograms",
+  .short_help = "show statistics node-histograms [<node-name>] [verbose]",
+  .function = show_node_histograms_command_fn,
+};
@@ -0,0 +1,784 @@
+/* SPDX-License-Identifier: Apache-2.0
+ * Copyright(c) 2022 Cisco Systems, Inc.
+ */
+
+/*
+ * Stats delta stream
+ *
+ * Clients connected to the delta socket receive, once per collector
+ * interval, a frame holding only the counters which changed since the
+ * previous interval. The first frame a client receives is a full snapshot
+ * of every non-zero counter, after which it can rebuild the segment by
+ * accumulating deltas.
+ *
+ * Each frame is a 4 byte length (network order) followed by a payload
+ * encoded with the vppinfra serializer. "v" below is
+ * serialize_likely_small_unsigned_integer, "s" is
+ * serialize_likely_small_signed_integer:
+ *
+ *   v version, u8 is_full, v sequence, f64 timestamp (serialize_f64,
+ *   low then high 32 bits of the IEEE 754 value), v epoch
+ *   entries, each:
+ *     v (entry_index - previous entry_index), u8 type [| NAME flag]
+ *     [cstring name]
+ *     items, each:
+ *       v (thread_index - previous thread_index + 1)
+ *       v (index - previous index in this thread)
+ *       s value delta [s bytes delta, for combined counters]
+ *     v 0 terminates the items
+ *   v 0, u8 STAT_DIR_TYPE_ILLEGAL terminates the entries
+ *
+ * Deltas are computed modulo 2^64, so gauges holding f64 bit patterns are
+ * reconstructed exactly. An entry of type STAT_DIR_TYPE_EMPTY has been
+ * removed. Symlinks, name vectors and histograms are not streamed.
+ *
+ * vlib_stats_delta_decode applies a frame to a replica of the counters,
+ * the way a client rebuilds them.
+ */
+
+#include <vlib/vlib.h>
+#include <vlib/unix/unix.h>
+#include <vlib/stats/stats.h>
+#include <vppinfra/serialize.h>
+
+/* Drop clients which fall this far behind */
+#define STATS_DELTA_MAX_BACKLOG (64 << 20)
+
+typedef struct
+{
+  u32 clib_file_index;
+  u8 is_synced;
+  u8 *tx_buffer;
+  u64 n_frames;
+  u64 n_bytes;
+} stats_delta_client_t;
+
+typedef struct
+{
+  serialize_main_t *m;
+  u32 last_entry_index;
+  u32 entry_index;
+  u8 type;
+  u8 *name;
+  u8 header_done;
+  u32 last_thread_index;
+  u32 last_index;
+  u32 n_items;
+} stats_delta_encoder_t;
+
+typedef struct
+{
+  clib_socket_t *socket;
+  stats_delta_client_t *clients;
+  vlib_stats_delta_entry_t *entries;
+  u64 sequence;
+
+  /* last interval */
+  u32 n_changed;
+  u32 n_delta_bytes;
+  f64 encode_time;
+} stats_delta_main_t;
+
+static stats_delta_main_t stats_delta_main;
+
+static void
+stats_delta_encode_header (stats_delta_encoder_t *enc)
+{
+  serialize_main_t *m = enc->m;
+  u8 t = enc->type;
+
+  if (enc->header_done)
+    return;
+
+  if (enc->name)
+    t |= STAT_DELTA_STREAM_F_NAME;
+
+  serialize_likely_small_unsigned_integer (
+    m, enc->entry_index - enc->last_entry_index);
+  serialize_integer (m, t, sizeof (u8));
+  if (enc->name)
+    serialize_cstring (m, (char *) enc->name);
+
+  enc->last_entry_index = enc->entry_index;
+  enc->last_thread_index = 0;
+  enc->last_index = 0;
+  enc->header_done = 1;
+}
+
+static_always_inline void
+stats_delta_encode_item (stats_delta_encoder_t *enc, u32 thread_index,
+			 u32 index, u64 d0, u64 d1)
+{
+  serialize_main_t *m = enc->m;
+
+  stats_delta_encode_header (enc);
+
+  if (thread_index != enc->last_thread_index)
+    enc->last_index = 0;
+
+  serialize_likely_small_unsigned_integer (
+    m, thread_index - enc->last_thread_index + 1);
+  serialize_likely_small_unsigned_integer (m, index - enc->last_index);
+  serialize_likely_small_signed_integer (m, (i64) d0);
+  if (enc->type == STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED)
+    serialize_likely_small_signed_integer (m, (i64) d1);
+
+  enc->last_thread_index = thread_index;
+  enc->last_index = index;
+  enc->n_items++;
+}
+
+static void
+stats_delta_encode_entry_end (stats_delta_encoder_t *enc)
+{
+  if (enc->header_done)
+    serialize_likely_small_unsigned_integer (enc->m, 0);
+}
+
+static void
+stats_delta_encode_entry_start (stats_delta_encoder_t *enc, u32 entry_index,
+				u8 type, u8 *name)
+{
+  enc->entry_index = entry_index;
+  enc->type = type;
+  enc->name = name;
+  enc->header_done = 0;
+}
+
+static void
+stats_delta_diff_simple (stats_delta_encoder_t *enc,
+			 vlib_stats_delta_entry_t *de, counter_t **cur)
+{
+  for (u32 i = 0; i < vec_len (cur); i++)
+    {
+      counter_t *c = cur[i], *s;
+
+      vec_validate (de->simple, i);
+      vec_validate (de->simple[i], vec_len (c) ? vec_len (c) - 1 : 0);
+      s = de->simple[i];
+
+      for (u32 j = 0; j < vec_len (c); j++)
+	if (PREDICT_FALSE (c[j] != s[j]))
+	  {
+	    stats_delta_encode_item (enc, i, j, c[j] - s[j], 0);
+	    s[j] = c[j];
+	  }
+    }
+}
+
+static void
+stats_delta_diff_combined (stats_delta_encoder_t *enc,
+			   vlib_stats_delta_entry_t *de, vlib_counter_t **cur)
+{
+  for (u32 i = 0; i < vec_len (cur); i++)
+    {
+      vlib_counter_t *c = cur[i], *s;
+
+      vec_validate (de->combined, i);
+      vec_validate (de->combined[i], vec_len (c) ? vec_len (c) - 1 : 0);
+      s = de->combined[i];
+
+      for (u32 j = 0; j < vec_len (c); j++)
+	if (PREDICT_FALSE (c[j].packets != s[j].packets ||
+			   c[j].bytes != s[j].bytes))
+	  {
+	    stats_delta_encode_item (enc, i, j, c[j].packets - s[j].packets,
+				     c[j].bytes - s[j].bytes);
+	    s[j] = c[j];
+	  }
+    }
+}
+
+static void
+stats_delta_entry_free (vlib_stats_delta_entry_t *de)
+{
+  vec_free (de->name);
+  for (u32 i = 0; i < vec_len (de->simple); i++)
+    vec_free (de->simple[i]);
+  vec_free (de->simple);
+  for (u32 i = 0; i < vec_len (de->combined); i++)
+    vec_free (de->combined[i]);
+  vec_free (de->combined);
+  clib_memset (de, 0, sizeof (*de));
+}
+
+static void
+stats_delta_encode_frame_start (serialize_main_t *m, int is_full)
+{
+  stats_delta_main_t *dm = &stats_delta_main;
+  vlib_stats_segment_t *sm = vlib_stats_get_segment ();
+
+  serialize_open_vector (m, 0);
+  /* length, patched once the frame is complete */
+  serialize_integer (m, 0, sizeof (u32));
+  serialize_likely_small_unsigned_integer (m, STAT_DELTA_STREAM_VERSION);
+  serialize_integer (m, is_full, sizeof (u8));
+  serialize_likely_small_unsigned_integer (m, dm->sequence);
+  serialize (m, serialize_f64, unix_time_now ());
+  serialize_likely_small_unsigned_integer (m, sm->shared_header->epoch);
+}
+
+static u8 *
+stats_delta_encode_frame_end (serialize_main_t *m)
+{
+  u8 *frame;
+
+  serialize_likely_small_unsigned_integer (m, 0);
+  serialize_integer (m, STAT_DIR_TYPE_ILLEGAL, sizeof (u8));
+  frame = serialize_close_vector (m);
+
+  clib_mem_unaligned (frame, u32) =
+    clib_host_to_net_u32 (vec_len (frame) - sizeof (u32));
+  return frame;
+}
+
+/*
+ * Walk the directory, emit every counter which differs from the snapshot
+ * and bring the snapshot up to date.
+ */
+static u8 *
+stats_delta_encode_delta (vlib_stats_segment_t *sm,
+			  vlib_stats_delta_entry_t **snapshot, u32 *n_changed)
+{
+  serialize_main_t _m, *m = &_m;
+  stats_delta_encoder_t enc = { .m = m };
+  u32 n_entries = vec_len (sm->directory_vector);
+  vlib_stats_delta_entry_t *entries;
+
+  stats_delta_encode_frame_start (m, 0 /* is_full */);
+
+  vec_validate (*snapshot, n_entries ? n_entries - 1 : 0);
+  entries = *snapshot;
+
+  for (u32 i = 0; i < vec_len (entries); i++)
+    {
+      vlib_stats_delta_entry_t *de = entries + i;
+      vlib_stats_entry_t *e = 0;
+      u8 type = STAT_DIR_TYPE_EMPTY;
+
+      if (i < n_entries)
+	{
+	  e = sm->directory_vector + i;
+	  type = e->type;
+	}
+
+      if (type != STAT_DIR_TYPE_SCALAR_INDEX &&
+	  type != STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE &&
+	  type != STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED)
+	{
+	  /* Streamed entry went away */
+	  if (de->type)
+	    {
+	      stats_delta_encode_entry_start (&enc, i, STAT_DIR_TYPE_EMPTY, 0);
+	      stats_delta_encode_header (&enc);
+	      stats_delta_encode_entry_end (&enc);
+	      stats_delta_entry_free (de);
+	    }
+	  continue;
+	}
+
+      /* Index reused by a different type of counter */
+      if (de->type && de->type != type)
+	stats_delta_entry_free (de);
+
+      if (de->type == 0)
+	{
+	  de->type = type;
+	  de->is_new = 1;
+	}
+
+      stats_delta_encode_entry_start (&enc, i, type,
+				      de->is_new ? (u8 *) e->name : 0);
+
+      /* Announce new entries even if they are all zero */
+      if (de->is_new)
+	stats_delta_encode_header (&enc);
+
+      if (type == STAT_DIR_TYPE_SCALAR_INDEX)
+	{
+	  if (e->value != de->value)
+	    {
+	      stats_delta_encode_item (&enc, 0, 0, e->value - de->value, 0);
+	      de->value = e->value;
+	    }
+	}
+      else if (type == STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE)
+	stats_delta_diff_simple (&enc, de, e->data);
+      else
+	stats_delta_diff_combined (&enc, de, e->data);
+
+      stats_delta_encode_entry_end (&enc);
+      de->is_new = 0;
+    }
+
+  *n_changed = enc.n_items;
+  return stats_delta_encode_frame_end (m);
+}
+
+/*
+ * Emit the snapshot as deltas against zero, for newly connected clients.
+ */
+static u8 *
+stats_delta_encode_full (vlib_stats_segment_t *sm,
+			 vlib_stats_delta_entry_t *entries)
+{
+  serialize_main_t _m, *m = &_m;
+  stats_delta_encoder_t enc = { .m = m };
+
+  stats_delta_encode_frame_start (m, 1 /* is_full */);
+
+  for (u32 i = 0; i < vec_len (entries); i++)
+    {
+      vlib_stats_delta_entry_t *de = entries + i;
+
+      if (de->type == 0)
+	continue;
+
+      stats_delta_encode_entry_start (&enc, i, de->type,
+				      (u8 *) sm->directory_vector[i].name);
+      stats_delta_encode_header (&enc);
+
+      if (de->type == STAT_DIR_TYPE_SCALAR_INDEX)
+	{
+	  if (de->value)
+	    stats_delta_encode_item (&enc, 0, 0, de->value, 0);
+	}
+      else if (de->type == STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE)
+	{
+	  for (u32 t = 0; t < vec_len (de->simple); t++)
+	    for (u32 j = 0; j < vec_len (de->simple[t]); j++)
+	      if (de->simple[t][j])
+		stats_delta_encode_item (&enc, t, j, de->simple[t][j], 0);
+	}
+      else
+	{
+	  for (u32 t = 0; t < vec_len (de->combined); t++)
+	    for (u32 j = 0; j < vec_len (de->combined[t]); j++)
+	      if (de->combined[t][j].packets || de->combined[t][j].bytes)
+		stats_delta_encode_item (&enc, t, j,
+					 de->combined[t][j].packets,
+					 de->combined[t][j].bytes);
+	}
+
+      stats_delta_encode_entry_end (&enc);
+    }
+
+  return stats_delta_encode_frame_end (m);
+}
+
+__clib_export u8 *
+vlib_stats_delta_encode (vlib_stats_delta_entry_t **snapshot, int is_full)
+{
+  vlib_stats_segment_t *sm = vlib_stats_get_segment ();
+  u32 n_changed;
+
+  if (is_full)
+    return stats_delta_encode_full (sm, *snapshot);
+  return stats_delta_encode_delta (sm, snapshot, &n_changed);
+}
+
+/*
+ * The decoder reads from a copy of the frame followed by this many zero
+ * bytes. Zeros terminate every list, so a truncated frame stops in the
+ * padding and is caught by stats_delta_check_length instead of reading
+ * past the end of the data.
+ */
+#define STATS_DELTA_DECODE_PAD 64
+
+static void
+stats_delta_check_length (serialize_main_t *m, u32 len)
+{
+  if (m->stream.current_buffer_index > len)
+    serialize_error_return (m, "truncated frame");
+}
+
+static void
+stats_delta_unserialize_items (serialize_main_t *m,
+			       vlib_stats_delta_entry_t *de, u32 len)
+{
+  u32 thread_index = 0, index = 0, t;
+  u64 d0, d1 = 0;
+
+  while ((t = unserialize_likely_small_unsigned_integer (m)))
+    {
+      stats_delta_check_length (m, len);
+      if (t != 1)
+	{
+	  thread_index += t - 1;
+	  index = 0;
+	}
+      index += unserialize_likely_small_unsigned_integer (m);
+      d0 = unserialize_likely_small_signed_integer (m);
+      if (de->type == STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED)
+	d1 = unserialize_likely_small_signed_integer (m);
+
+      if (de->type == STAT_DIR_TYPE_SCALAR_INDEX)
+	de->value += d0;
+      else if (de->type == STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE)
+	{
+	  vec_validate (de->simple, thread_index);
+	  vec_validate (de->simple[thread_index], index);
+	  de->simple[thread_index][index] += d0;
+	}
+      else
+	{
+	  vec_validate (de->combined, thread_index);
+	  vec_validate (de->combined[thread_index], index);
+	  de->combined[thread_index][index].packets += d0;
+	  de->combined[thread_index][index].bytes += d1;
+	}
+    }
+  stats_delta_check_length (m, len);
+}
+
+static void
+stats_delta_unserialize_frame (serialize_main_t *m, va_list *va)
+{
+  vlib_stats_delta_entry_t **replica =
+    va_arg (*va, vlib_stats_delta_entry_t **);
+  u64 *sequence = va_arg (*va, u64 *);
+  f64 *timestamp = va_arg (*va, f64 *);
+  u32 len = va_arg (*va, u32);
+  vlib_stats_delta_entry_t *de;
+  u32 entry_index = 0, n;
+  u8 is_full, type;
+
+  if (unserialize_likely_small_unsigned_integer (m) !=
+      STAT_DELTA_STREAM_VERSION)
+    serialize_error_return (m, "unknown delta stream version");
+  unserialize_integer (m, &is_full, sizeof (u8));
+  *sequence = unserialize_likely_small_unsigned_integer (m);
+  unserialize (m, unserialize_f64, timestamp);
+  unserialize_likely_small_unsigned_integer (m); /* epoch */
+  stats_delta_check_length (m, len);
+
+  if (is_full)
+    vlib_stats_delta_entries_free (replica);
+
+  while (1)
+    {
+      n = unserialize_likely_small_unsigned_integer (m);
+      unserialize_integer (m, &type, sizeof (u8));
+      stats_delta_check_length (m, len);
+      if (n == 0 && type == STAT_DIR_TYPE_ILLEGAL)
+	break;
+
+      entry_index += n;
+      vec_validate (*replica, entry_index);
+      de = *replica + entry_index;
+
+      if (type & STAT_DELTA_STREAM_F_NAME)
+	{
+	  n = unserialize_likely_small_unsigned_integer (m);
+	  stats_delta_check_length (m, len);
+	  if (n > len - m->stream.current_buffer_index)
+	    serialize_error_return (m, "truncated frame");
+	  vec_free (de->name);
+	  vec_validate (de->name, n);
+	  clib_memcpy_fast (de->name, unserialize_get (m, n), n);
+	  type &= ~STAT_DELTA_STREAM_F_NAME;
+	}
+
+      if (type == STAT_DIR_TYPE_EMPTY)
+	{
+	  stats_delta_entry_free (de);
+	  if (unserialize_likely_small_unsigned_integer (m))
+	    serialize_error_return (m, "items for removed entry %u",
+				    entry_index);
+	  continue;
+	}
+      if (type != STAT_DIR_TYPE_SCALAR_INDEX &&
+	  type != STAT_DIR_TYPE_COUNTER_VECTOR_SIMPLE &&
+	  type != STAT_DIR_TYPE_COUNTER_VECTOR_COMBINED)
+	serialize_error_return (m, "unexpected entry type %u", type);
+
+      de->type = type;
+      stats_delta_unserialize_items (m, de, len);
+    }
+}
+
+__clib_export clib_error_t *
+vlib_stats_delta_decode (vlib_stats_delta_entry_t **replica, u8 *frame,
+			 u64 *sequence, f64 *timestamp)
+{
+  serialize_main_t _m, *m = &_m;
+  clib_error_t *error;
+  u8 *data = 0;
+  u32 len;
+
+  if (vec_len (frame) < sizeof (u32))
+    return clib_error_return (0, "short frame");
+  len = clib_net_to_host_u32 (clib_mem_unaligned (frame, u32));
+  if (len != vec_len (frame) - sizeof (u32))
+    return clib_error_return (0, "frame length %u, expected %u", len,
+			      vec_len (frame) - sizeof (u32));
+
+  vec_validate (data, len + STATS_DELTA_DECODE_PAD - 1);
+  clib_memcpy_fast (data, frame + sizeof (u32), len);
+
+  unserialize_open_data (m, data, vec_len (data));
+  error = unserialize (m, stats_delta_unserialize_frame, replica, sequence,
+		       timestamp, len);
+  vec_free (m->stream.overflow_buffer);
+  vec_free (data);
+  return error;
+}
+
+__clib_export void
+vlib_stats_delta_entries_free (vlib_stats_delta_entry_t **entries)
+{
+  vlib_stats_delta_entry_t *de;
+
+  vec_foreach (de, *entries)
+    stats_delta_entry_free (de);
+  vec_free (*entries);
+}
+
+static void
+stats_delta_client_close (stats_delta_client_t *c)
+{
+  stats_delta_main_t *dm = &stats_delta_main;
+
+  clib_file_del_by_index (&file_main, c->clib_file_index);
+  vec_free (c->tx_buffer);
+  pool_put (dm->clients, c);
+}
+
+/* Returns non-zero if the client has to be closed */
+static int
+stats_delta_client_flush (stats_delta_client_t *c)
+{
+  clib_file_t *f = clib_file_get (&file_main, c->clib_file_index);
+  int n;
+
+  if (vec_len (c->tx_buffer) == 0)
+    return 0;
+
+  n = send (f->file_descriptor, c->tx_buffer, vec_len (c->tx_buffer),
+	    MSG_NOSIGNAL);
+
+  if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    return 1;
+
+  if (n > 0)
+    {
+      c->n_bytes += n;
+      if (n == vec_len (c->tx_buffer))
+	vec_set_len (c->tx_buffer, 0);
+      else
+	vec_delete (c->tx_buffer, n, 0);
+    }
+
+  clib_file_set_data_available_to_write (&file_main, c->clib_file_index,
+					 vec_len (c->tx_buffer) != 0);
+  return 0;
+}
+
+static void
+stats_delta_client_send (stats_delta_client_t *c, u8 *frame)
+{
+  vec_append (c->tx_buffer, frame);
+  c->n_frames++;
+}
+
+void
+vlib_stats_delta_stream_update (vlib_stats_segment_t *sm)
+{
+  stats_delta_main_t *dm = &stats_delta_main;
+  stats_delta_client_t *c;
+  u32 *to_close = 0, *ci;
+  u8 *frame, *full = 0;
+  f64 t0;
+
+  if (pool_elts (dm->clients) == 0)
+    return;
+
+  t0 = vlib_time_now (vlib_get_main ());
+
+  frame = stats_delta_encode_delta (sm, &dm->entries, &dm->n_changed);
+  dm->n_delta_bytes = vec_len (frame);
+
+  pool_foreach (c, dm->clients)
+    {
+      if (c->is_synced)
+	stats_delta_client_send (c, frame);
+      else
+	{
+	  if (full == 0)
+	    full = stats_delta_encode_full (sm, dm->entries);
+	  stats_delta_client_send (c, full);
+	  c->is_synced = 1;
+	}
+
+      if (vec_len (c->tx_buffer) > STATS_DELTA_MAX_BACKLOG ||
+	  stats_delta_client_flush (c))
+	vec_add1 (to_close, c - dm->clients);
+    }
+
+  vec_foreach (ci, to_close)
+    stats_delta_client_close (pool_elt_at_index (dm->clients, ci[0]));
+
+  dm->sequence++;
+  dm->encode_time = vlib_time_now (vlib_get_main ()) - t0;
+
+  vec_free (to_close);
+  vec_free (frame);
+  vec_free (full);
+}
+
+static clib_error_t *
+stats_delta_client_read_ready (clib_file_t *uf)
+{
+  stats_delta_main_t *dm = &stats_delta_main;
+  stats_delta_client_t *c;
+  u8 buf[128];
+  int n;
+
+  c = pool_elt_at_index (dm->clients, uf->private_data);
+
+  /* Clients are not expected to send anything, drain until EOF */
+  n = read (uf->file_descriptor, buf, sizeof (buf));
+  if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+    stats_delta_client_close (c);
+
+  return 0;
+}
+
+static clib_error_t *
+stats_delta_client_write_ready (clib_file_t *uf)
+{
+  stats_delta_main_t *dm = &stats_delta_main;
+  stats_delta_client_t *c;
+
+  c = pool_elt_at_index (dm->clients, uf->private_data);
+  if (stats_delta_client_flush (c))
+    stats_delta_client_close (c);
+
+  return 0;
+}
+
+static clib_error_t *
+stats_delta_client_error (clib_file_t *uf)
+{
+  stats_delta_main_t *dm = &stats_delta_main;
+
+  stats_delta_client_close (pool_elt_at_index (dm->clients, uf->private_data));
+  return 0;
+}
+
+static clib_error_t *
+stats_delta_accept_ready (clib_file_t *uf)
+{
+  stats_delta_main_t *dm = &stats_delta_main;
+  clib_file_t template = { 0 };
+  clib_socket_t client;
+  stats_delta_client_t *c;
+  clib_error_t *err;
+
+  err = clib_socket_accept (dm->socket, &client);
+  if (err)
+    {
+      clib_error_report (err);
+      return err;
+    }
+
+  pool_get_zero (dm->clients, c);
+
+  template.read_function = stats_delta_client_read_ready;
+  template.write_function = stats_delta_client_write_ready;
+  template.error_function = stats_delta_client_error;
+  template.file_descriptor = client.fd;
+  template.private_data = c - dm->clients;
+  template.description = format (0, "stats delta stream client");
+  c->clib_file_index = clib_file_add (&file_main, &template);
+
+  return 0;
+}
+
+static clib_error_t *
+stats_delta_socket_exit (vlib_main_t *vm)
+{
+  vlib_stats_segment_t *sm = vlib_stats_get_segment ();
+
+  if (vec_len (sm->delta_socket_name))
+    unlink ((char *) sm->delta_socket_name);
+  return 0;
+}
+
+VLIB_MAIN_LOOP_EXIT_FUNCTION (stats_delta_socket_exit);
+
+static clib_error_t *
+stats_delta_init (vlib_main_t *vm)
+{
+  stats_delta_main_t *dm = &stats_delta_main;
+  vlib_stats_segment_t *sm = vlib_stats_get_segment ();
+  clib_file_t template = { 0 };
+  clib_error_t *error;
+  clib_socket_t *s;
+
+  /* Opt-in, only when a socket name is configured */
+  if (!vec_len (sm->delta_socket_name))
+    return 0;
+
+  s = clib_mem_alloc (sizeof (clib_socket_t));
+  clib_memset (s, 0, sizeof (clib_socket_t));
+  s->config = (char *) sm->delta_socket_name;
+  s->flags = CLIB_SOCKET_F_IS_SERVER | CLIB_SOCKET_F_ALLOW_GROUP_WRITE;
+
+  if ((error = clib_socket_init (s)))
+    {
+      clib_mem_free (s);
+      return error;
+    }
+
+  template.read_function = stats_delta_accept_ready;
+  template.file_descriptor = s->fd;
+  template.description =
+    format (0, "stats delta stream listener %s", s->config);
+  clib_file_add (&file_main, &template);
+
+  dm->socket = s;
+
+  return 0;
+}
+
+VLIB_INIT_FUNCTION (stats_delta_init) = {
+  .runs_after = VLIB_INITS ("statseg_init"),
+};
+
+static clib_error_t *
+show_stat_delta_stream_command_fn (vlib_main_t *vm, unformat_input_t *input,
+				   vlib_cli_command_t *cmd)
+{
+  stats_delta_main_t *dm = &stats_delta_main;
+  vlib_stats_segment_t *sm = vlib_stats_get_segment ();
+  stats_delta_client_t *c;
+
+  if (dm->socket == 0)
+    {
+      vlib_cli_output (vm, "delta stream disabled");
+      return 0;
+    }
+
+  vlib_cli_output (vm, "socket %s, %u clients, sequence %llu",
+		   sm->delta_socket_name, pool_elts (dm->clients),
+		   dm->sequence);
+  vlib_cli_output (vm,
+		   "last interval: %u changed counters, %u bytes, "
+		   "%.3f ms to encode",
+		   dm->n_changed, dm->n_delta_bytes, dm->encode_time * 1e3);
+
+  pool_foreach (c, dm->clients)
+    vlib_cli_output (vm,
+		     "  [%u] frames %llu bytes sent %llu backlog %u%s",
+		     c - dm->clients, c->n_frames, c->n_bytes,
+		     vec_len (c->tx_buffer), c->is_synced ? "" : " (syncing)");
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (show_stat_delta_stream_command, static) = {
+  .path = "show statistics delta-stream",
+  .short_help = "show statistics delta-stream",
+  .function = show_stat_delta_stream_command_fn,
+};
@@ -19,3 +19,62 @@ format_vlib_stats_symlink (u8 *s, va_list *args)
 
   return s;
 }
+
+static u64
+histogram_percentile (u64 *h, u64 count, f64 pct)
+{
+  u64 rank = count * pct / 100.0, seen = 0;
+  u32 n_buckets = vec_len (h) - 1;
+
+  for (u32 b = 0; b < n_buckets; b++)
+    {
+      seen += h[1 + b];
+      if (seen > rank)
+	return stat_histogram_bucket_lower_bound (b);
+    }
+  return stat_histogram_bucket_lower_bound (n_buckets - 1);
+}
+
+/*
+ * Format a single histogram (sum followed by buckets), e.g. one already
+ * summed across threads.
+ */
+u8 *
+format_vlib_stats_histogram (u8 *s, va_list *args)
+{
+  u64 *h = va_arg (*args, u64 *);
+  int verbose = va_arg (*args, int);
+  u32 indent = format_get_indent (s);
+  u32 n_buckets = vec_len (h) - 1;
+  u64 count = 0;
+
+  for (u32 b = 0; b < n_buckets; b++)
+    count += h[1 + b];
+
+  if (count == 0)
+    return format (s, "no samples");
+
+  s = format (s, "count %llu mean %.2f p50 %llu p90 %llu p99 %llu p99.9 %llu",
+	      count, (f64) h[0] / count, histogram_percentile (h, count, 50),
+	      histogram_percentile (h, count, 90),
+	      histogram_percentile (h, count, 99),
+	      histogram_percentile (h, count, 99.9));
+
+  if (!verbose)
+    return s;
+
+  for (u32 b = 0; b < n_buckets; b++)
+    {
+      if (h[1 + b] == 0)
+	continue;
+      if (b == n_buckets - 1)
+	s = format (s, "\n%U[%llu, inf) %llu", format_white_space, indent,
+		    stat_histogram_bucket_lower_bound (b), h[1 + b]);
+      else
+	s = format (s, "\n%U[%llu, %llu) %llu", format_white_space, indent,
+		    stat_histogram_bucket_lower_bound (b),
+		    stat_histogram_bucket_lower_bound (b + 1), h[1 + b]);
+    }
+
+  return s;
+}
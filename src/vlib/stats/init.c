@@ -143,6 +143,9 @@ statseg_config (vlib_main_t *vm, unformat_input_t *input)
     {
       if (unformat (input, "socket-name %s", &sm->socket_name))
 	;
+      else if (unformat (input, "delta-socket-name %s",
+			 &sm->delta_socket_name))
+	;
       /* DEPRECATE: default (does nothing) */
       else if (unformat (input, "default"))
 	;
@@ -156,6 +159,10 @@ statseg_config (vlib_main_t *vm, unformat_input_t *input)
 	sm->node_counters_enabled = 1;
       else if (unformat (input, "per-node-counters off"))
 	sm->node_counters_enabled = 0;
+      else if (unformat (input, "per-node-histograms on"))
+	sm->node_histograms_config = 1;
+      else if (unformat (input, "per-node-histograms off"))
+	sm->node_histograms_config = 0;
       else if (unformat (input, "update-interval %f", &sm->update_interval))
 	;
       else
@@ -169,6 +176,8 @@ statseg_config (vlib_main_t *vm, unformat_input_t *input)
    */
   if (vec_len (sm->socket_name))
     vec_terminate_c_string (sm->socket_name);
+  if (vec_len (sm->delta_socket_name))
+    vec_terminate_c_string (sm->delta_socket_name);
 
   return 0;
 }
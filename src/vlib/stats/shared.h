@@ -14,8 +14,50 @@ typedef enum
   STAT_DIR_TYPE_NAME_VECTOR,
   STAT_DIR_TYPE_EMPTY,
   STAT_DIR_TYPE_SYMLINK,
+  STAT_DIR_TYPE_HISTOGRAM,
 } stat_directory_type_t;
 
+/*
+ * Histogram counters are a per-thread vector of per-index vectors of
+ * uint64_t. Element 0 of each histogram holds the sum of the recorded
+ * values, the remaining elements are log-linear bucket counts: values
+ * below 2^STAT_HISTOGRAM_SUB_BUCKET_BITS get a bucket each, every higher
+ * power of two is split into 2^STAT_HISTOGRAM_SUB_BUCKET_BITS buckets.
+ * The last bucket also counts every value beyond its lower bound.
+ */
+#define STAT_HISTOGRAM_SUB_BUCKET_BITS 3
+
+static inline uint32_t
+stat_histogram_bucket_index (uint64_t v)
+{
+  uint32_t s = STAT_HISTOGRAM_SUB_BUCKET_BITS, e;
+
+  if (v < (1ULL << s))
+    return v;
+
+  e = 63 - __builtin_clzll (v);
+  return ((e - s + 1) << s) + ((v >> (e - s)) & ((1ULL << s) - 1));
+}
+
+static inline uint64_t
+stat_histogram_bucket_lower_bound (uint32_t b)
+{
+  uint32_t s = STAT_HISTOGRAM_SUB_BUCKET_BITS, e;
+
+  if (b < (1U << s))
+    return b;
+
+  e = (b >> s) + s - 1;
+  return (1ULL << e) + ((uint64_t) (b & ((1U << s) - 1)) << (e - s));
+}
+
+/* Number of buckets needed to tell apart all values up to max_value */
+static inline uint32_t
+stat_histogram_n_buckets (uint64_t max_value)
+{
+  return stat_histogram_bucket_index (max_value) + 1;
+}
+
 typedef struct
 {
   stat_directory_type_t type;
@@ -35,6 +77,12 @@ typedef struct
   char name[VLIB_STATS_MAX_NAME_SZ];
 } vlib_stats_entry_t;
 
+/*
+ * Delta stream wire format, see vlib/stats/delta.c
+ */
+#define STAT_DELTA_STREAM_VERSION 1
+#define STAT_DELTA_STREAM_F_NAME  0x80
+
 /*
  * Shared header first in the shared memory segment.
  */
@@ -132,8 +132,9 @@ vlib_stats_remove_entry (u32 entry_index)
   vlib_stats_entry_t *e = vlib_stats_get_entry (sm, entry_index);
   counter_t **c;
   vlib_counter_t **vc;
+  u64 ***hc;
   void *oldheap;
-  u32 i;
+  u32 i, j;
 
   if (entry_index >= vec_len (sm->directory_vector))
     return;
@@ -168,6 +169,20 @@ vlib_stats_remove_entry (u32 entry_index)
       clib_mem_set_heap (oldheap);
       break;
 
+    case STAT_DIR_TYPE_HISTOGRAM:
+      hc = e->data;
+      e->data = 0;
+      oldheap = clib_mem_set_heap (sm->heap);
+      for (i = 0; i < vec_len (hc); i++)
+	{
+	  for (j = 0; j < vec_len (hc[i]); j++)
+	    vec_free (hc[i][j]);
+	  vec_free (hc[i]);
+	}
+      vec_free (hc);
+      clib_mem_set_heap (oldheap);
+      break;
+
     case STAT_DIR_TYPE_SCALAR_INDEX:
     case STAT_DIR_TYPE_SYMLINK:
       break;
@@ -381,6 +396,39 @@ vlib_stats_add_counter_pair_vector (char *fmt, ...)
 					name);
 }
 
+u32
+vlib_stats_add_histogram_vector (u32 n_buckets, char *fmt, ...)
+{
+  vlib_stats_segment_t *sm = vlib_stats_get_segment ();
+  vlib_stats_histogram_header_t *hh;
+  va_list va;
+  u64 ***data;
+  u32 index;
+  u8 *name;
+
+  ASSERT (n_buckets > 0);
+
+  va_start (va, fmt);
+  name = va_format (0, fmt, &va);
+  va_end (va);
+
+  index = vlib_stats_new_entry_internal (STAT_DIR_TYPE_HISTOGRAM, name);
+  if (index == CLIB_U32_MAX)
+    return index;
+
+  data = vec_new_generic (u64 **, 0, sizeof (vlib_stats_histogram_header_t),
+			  CLIB_CACHE_LINE_BYTES, sm->heap);
+  hh = vec_header (data);
+  hh->entry_index = index;
+  hh->n_buckets = n_buckets;
+
+  vlib_stats_segment_lock ();
+  sm->directory_vector[index].data = data;
+  vlib_stats_segment_unlock ();
+
+  return index;
+}
+
 static int
 vlib_stats_validate_will_expand_internal (u32 entry_index, va_list *va)
 {
@@ -418,6 +466,20 @@ vlib_stats_validate_will_expand_internal (u32 entry_index, va_list *va)
 	if (idx1 >= vec_max_len (data[i]))
 	  goto done;
     }
+  else if (e->type == STAT_DIR_TYPE_HISTOGRAM)
+    {
+      u32 idx0 = va_arg (*va, u32);
+      u32 idx1 = va_arg (*va, u32);
+      u64 ***data = e->data;
+
+      /* every newly added index needs its buckets allocated */
+      if (idx0 >= vec_len (data))
+	goto done;
+
+      for (u32 i = 0; i <= idx0; i++)
+	if (idx1 >= vec_len (data[i]))
+	  goto done;
+    }
   else
     ASSERT (0);
 
@@ -483,6 +545,26 @@ vlib_stats_validate (u32 entry_index, ...)
 	vec_validate_aligned (data[i], idx1, CLIB_CACHE_LINE_BYTES);
       e->data = data;
     }
+  else if (e->type == STAT_DIR_TYPE_HISTOGRAM)
+    {
+      u32 idx0 = va_arg (va, u32);
+      u32 idx1 = va_arg (va, u32);
+      u64 ***data = e->data;
+      vlib_stats_histogram_header_t *hh = vec_header (data);
+
+      vec_validate_aligned (data, idx0, CLIB_CACHE_LINE_BYTES);
+
+      for (u32 i = 0; i <= idx0; i++)
+	{
+	  vec_validate_aligned (data[i], idx1, CLIB_CACHE_LINE_BYTES);
+	  /* sum followed by the buckets */
+	  for (u32 j = 0; j <= idx1; j++)
+	    if (data[i][j] == 0)
+	      vec_validate_aligned (data[i][j], hh->n_buckets,
+				    CLIB_CACHE_LINE_BYTES);
+	}
+      e->data = data;
+    }
   else
     ASSERT (0);
 
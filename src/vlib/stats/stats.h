@@ -74,9 +74,14 @@ typedef struct
   u32 n_locks;
   clib_socket_t *socket;
   u8 *socket_name;
+  u8 *delta_socket_name;
   ssize_t memory_size;
   clib_mem_page_sz_t log2_page_sz;
   u8 node_counters_enabled;
+  u8 node_histograms_enabled;
+  u8 node_histograms_config;
+  u32 node_clocks_histogram_index;
+  u32 node_vectors_histogram_index;
   void *heap;
   vlib_stats_shared_header_t
     *shared_header; /* pointer to shared memory segment */
@@ -89,6 +94,12 @@ typedef struct
   u32 entry_index;
 } vlib_stats_header_t;
 
+typedef struct
+{
+  u32 entry_index;
+  u32 n_buckets;
+} vlib_stats_histogram_header_t;
+
 typedef struct
 {
   vlib_stats_segment_t segment;
@@ -148,6 +159,41 @@ void vlib_stats_set_string_vector (vlib_stats_string_vector_t *sv, u32 index,
 				   char *fmt, ...);
 void vlib_stats_free_string_vector (vlib_stats_string_vector_t *sv);
 
+/* histogram vector */
+u32 vlib_stats_add_histogram_vector (u32 n_buckets, char *fmt, ...);
+
+static_always_inline u64 *
+vlib_stats_get_histogram (u32 entry_index, u32 thread_index, u32 index)
+{
+  u64 ***data = vlib_stats_get_entry_data_pointer (entry_index);
+  return data[thread_index][index];
+}
+
+/* Lock-free as long as each thread only records into its own histograms */
+static_always_inline void
+vlib_stats_histogram_record (u64 *h, u64 value)
+{
+  u32 bucket = stat_histogram_bucket_index (value);
+  u32 last = vec_len (h) - 2;
+
+  h[0] += value;
+  h[1 + clib_min (bucket, last)]++;
+}
+
+/* per-node dispatch histograms, indexed by node index */
+static_always_inline void
+vlib_stats_node_histograms_record (u64 **clocks, u64 **vectors,
+				   u32 node_index, uword n_vectors,
+				   uword n_clocks)
+{
+  /* nodes registered since the last collector run are not validated yet */
+  if (PREDICT_FALSE (node_index >= vec_len (clocks)))
+    return;
+
+  vlib_stats_histogram_record (clocks[node_index], n_clocks);
+  vlib_stats_histogram_record (vectors[node_index], n_vectors);
+}
+
 /* symlink */
 u32 vlib_stats_add_symlink (u32 entry_index, u32 vector_index, char *fmt, ...);
 void vlib_stats_rename_symlink (u64 entry_index, char *fmt, ...);
@@ -159,6 +205,26 @@ void vlib_stats_remove_entry (u32 entry_index);
 u32 vlib_stats_find_entry_index (char *fmt, ...);
 void vlib_stats_register_collector_fn (vlib_stats_collector_reg_t *r);
 
+/* delta stream */
+typedef struct
+{
+  u8 type;
+  u8 is_new;
+  u8 *name;
+  u64 value;
+  counter_t **simple;
+  vlib_counter_t **combined;
+} vlib_stats_delta_entry_t;
+
+void vlib_stats_delta_stream_update (vlib_stats_segment_t *sm);
+u8 *vlib_stats_delta_encode (vlib_stats_delta_entry_t **snapshot,
+			     int is_full);
+clib_error_t *vlib_stats_delta_decode (vlib_stats_delta_entry_t **replica,
+				       u8 *frame, u64 *sequence,
+				       f64 *timestamp);
+void vlib_stats_delta_entries_free (vlib_stats_delta_entry_t **entries);
+
 format_function_t format_vlib_stats_symlink;
+format_function_t format_vlib_stats_histogram;
 
 #endif
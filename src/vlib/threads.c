@@ -130,9 +130,71 @@ barrier_trace_release (f64 t_entry, f64 t_closed_total, f64 t_update_main)
   ed->t_update_main = (int) (1000000.0 * t_update_main);
   ed->t_closed_total = (int) (1000000.0 * t_closed_total);
   ed->count = (int) vlib_worker_threads[0].barrier_sync_count;
+}
 
-  /* Reset context for next trace */
-  vlib_worker_threads[0].barrier_context = NULL;
+VLIB_REGISTER_LOG_CLASS (barrier_log, static) = {
+  .class_name = "barrier",
+};
+
+#define BARRIER_HOLD_HISTOGRAM_MAX_USEC 1000000
+
+/*
+ * Attribute a barrier hold to the caller and context (API message or CLI
+ * path) of the outermost sync. Sites are never removed so their indices
+ * stay valid in /sys/barrier/names and /sys/barrier/hold-usec.
+ */
+static void
+barrier_stats_record (f64 t_hold)
+{
+  vlib_thread_main_t *tm = &vlib_thread_main;
+  vlib_worker_thread_t *w = vlib_worker_threads;
+  vlib_barrier_site_t *s;
+  uword key[2], *p;
+  u32 site_index;
+  u64 *h;
+
+  key[0] = pointer_to_uword (w->barrier_hold_caller);
+  key[1] = pointer_to_uword (w->barrier_hold_context);
+
+  p = mhash_get (&tm->barrier_site_index_by_key, key);
+  if (p)
+    site_index = p[0];
+  else
+    {
+      site_index = vec_len (tm->barrier_sites);
+      vec_add2 (tm->barrier_sites, s, 1);
+      if (w->barrier_hold_context == 0)
+	s->name = format (0, "%s", w->barrier_hold_caller);
+      else if (w->barrier_hold_context_is_vec)
+	s->name = format (0, "%v (%s)", w->barrier_hold_context,
+			  w->barrier_hold_caller);
+      else
+	s->name = format (0, "%s (%s)", w->barrier_hold_context,
+			  w->barrier_hold_caller);
+      mhash_set (&tm->barrier_site_index_by_key, key, site_index, 0);
+
+      vlib_stats_set_string_vector (&tm->barrier_site_names, site_index,
+				    "%v", s->name);
+      vlib_stats_validate (tm->barrier_hold_histogram_index, 0, site_index);
+    }
+
+  s = vec_elt_at_index (tm->barrier_sites, site_index);
+  s->count++;
+  s->total_time += t_hold;
+  s->max_time = clib_max (s->max_time, t_hold);
+  tm->barrier_hold_total_time += t_hold;
+
+  h = vlib_stats_get_histogram (tm->barrier_hold_histogram_index, 0,
+				site_index);
+  vlib_stats_histogram_record (h, t_hold * 1e6);
+
+  if (tm->barrier_stall_threshold != 0 &&
+      t_hold > tm->barrier_stall_threshold)
+    {
+      s->n_stalls++;
+      vlib_log_warn (barrier_log.class, "workers stalled for %.3f ms by %v",
+		     t_hold * 1e3, s->name);
+    }
 }
 
 uword
@@ -185,6 +247,13 @@ vlib_thread_init (vlib_main_t * vm)
     vlib_stats_add_gauge ("/sys/num_worker_threads");
   ASSERT (stats_num_worker_threads_dir_index != ~0);
 
+  mhash_init (&tm->barrier_site_index_by_key, sizeof (uword),
+	      2 * sizeof (uword));
+  tm->barrier_site_names = vlib_stats_add_string_vector ("/sys/barrier/names");
+  tm->barrier_hold_histogram_index = vlib_stats_add_histogram_vector (
+    stat_histogram_n_buckets (BARRIER_HOLD_HISTOGRAM_MAX_USEC),
+    "/sys/barrier/hold-usec");
+
   /* get bitmaps of active cpu cores and sockets */
   tm->cpu_core_bitmap =
     clib_sysfs_list_to_bitmap ("/sys/devices/system/cpu/online");
@@ -1125,6 +1194,7 @@ cpu_config (vlib_main_t * vm, unformat_input_t * input)
   tm->sched_policy = ~0;
   tm->sched_priority = ~0;
   tm->main_lcore = ~0;
+  tm->barrier_stall_threshold = 1e-3;
 
   tr = tm->next;
 
@@ -1177,6 +1247,11 @@ cpu_config (vlib_main_t * vm, unformat_input_t * input)
 	;
       else if (unformat (input, "scheduler-priority %u", &tm->sched_priority))
 	;
+      else if (unformat (input, "barrier-stats"))
+	tm->barrier_stats_enabled = 1;
+      else if (unformat (input, "barrier-stall-threshold %f",
+			 &tm->barrier_stall_threshold))
+	tm->barrier_stall_threshold *= 1e-6;
       else if (unformat (input, "%s %u", &name, &count))
 	{
 	  p = hash_get_mem (tm->thread_registrations_by_name, name);
@@ -1322,6 +1397,12 @@ vlib_worker_thread_barrier_sync_int (vlib_main_t * vm, const char *func_name)
     clib_call_callbacks (vm->barrier_perf_callbacks, vm,
 			 vm->clib_time.last_cpu_time, 0 /* enter */ );
 
+  vlib_worker_threads[0].barrier_hold_caller = func_name;
+  vlib_worker_threads[0].barrier_hold_context =
+    vlib_worker_threads[0].barrier_context;
+  vlib_worker_threads[0].barrier_hold_context_is_vec =
+    vlib_worker_threads[0].barrier_context_is_vec;
+
   /*
    * Need data to decide if we're working hard enough to honor
    * the barrier hold-down timer.
@@ -1488,6 +1569,13 @@ vlib_worker_thread_barrier_release (vlib_main_t * vm)
 
   barrier_trace_release (t_entry, t_closed_total, t_update_main);
 
+  if (PREDICT_FALSE (vlib_thread_main.barrier_stats_enabled))
+    barrier_stats_record (t_closed_total);
+
+  /* Reset context for next sync */
+  vlib_worker_threads[0].barrier_context = NULL;
+  vlib_worker_threads[0].barrier_context_is_vec = 0;
+
   if (PREDICT_FALSE (vec_len (vm->barrier_perf_callbacks) != 0))
     clib_call_callbacks (vm->barrier_perf_callbacks, vm,
 			 vm->clib_time.last_cpu_time, 1 /* leave */ );
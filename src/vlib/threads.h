@@ -17,6 +17,7 @@
 
 #include <vlib/main.h>
 #include <vppinfra/callback.h>
+#include <vppinfra/mhash.h>
 #include <linux/sched.h>
 
 void vlib_set_thread_name (char *name);
@@ -101,6 +102,12 @@ typedef struct
   u8 barrier_elog_enabled;
   const char *barrier_caller;
   const char *barrier_context;
+  /* barrier_context is a vector (e.g. a CLI path), not a C string */
+  u8 barrier_context_is_vec;
+  /* caller and context of the outermost sync, for hold attribution */
+  const char *barrier_hold_caller;
+  const char *barrier_hold_context;
+  u8 barrier_hold_context_is_vec;
   volatile u32 *node_reforks_required;
   volatile u32 wait_before_barrier;
   volatile u32 workers_before_barrier;
@@ -226,6 +233,16 @@ __foreach_vlib_main_helper (vlib_main_t *ii, vlib_main_t **p)
        __foreach_vlib_main_helper (ii, &this_vlib_main); ii++)                \
     if (this_vlib_main)
 
+/* Barrier holds attributed to one caller / context pair */
+typedef struct
+{
+  u8 *name;
+  u64 count;
+  u64 n_stalls;
+  f64 total_time;
+  f64 max_time;
+} vlib_barrier_site_t;
+
 #define foreach_sched_policy \
   _(SCHED_OTHER, OTHER, "other") \
   _(SCHED_BATCH, BATCH, "batch") \
@@ -297,6 +314,15 @@ typedef struct
   /* NUMA-bound heap size */
   uword numa_heap_size;
 
+  /* barrier hold attribution, see "show barrier-stats" */
+  u8 barrier_stats_enabled;
+  vlib_barrier_site_t *barrier_sites;
+  mhash_t barrier_site_index_by_key;
+  u8 **barrier_site_names;
+  u32 barrier_hold_histogram_index;
+  f64 barrier_stall_threshold;
+  f64 barrier_hold_total_time;
+
 } vlib_thread_main_t;
 
 extern vlib_thread_main_t vlib_thread_main;
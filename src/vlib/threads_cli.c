@@ -19,6 +19,7 @@
 
 #include <vlib/threads.h>
 #include <vlib/unix/unix.h>
+#include <vlib/stats/stats.h>
 
 static u8 *
 format_sched_policy_and_priority (u8 * s, va_list * args)
@@ -533,6 +534,156 @@ VLIB_CLI_COMMAND (cmd_test_frame_queue_threshold,static) = {
 };
 /* *INDENT-ON* */
 
+static int
+barrier_site_cmp_total_time (void *a1, void *a2)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_barrier_site_t *s1 = vec_elt_at_index (tm->barrier_sites, *(u32 *) a1);
+  vlib_barrier_site_t *s2 = vec_elt_at_index (tm->barrier_sites, *(u32 *) a2);
+
+  if (s1->total_time == s2->total_time)
+    return 0;
+  return s1->total_time < s2->total_time ? 1 : -1;
+}
+
+static clib_error_t *
+show_barrier_stats_fn (vlib_main_t *vm, unformat_input_t *input,
+		       vlib_cli_command_t *cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_barrier_site_t *s;
+  u32 count = 20, *indices = 0, i;
+  int verbose = 0;
+  u64 *h;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "count %u", &count))
+	;
+      else if (unformat (input, "verbose"))
+	verbose = 1;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  if (!tm->barrier_stats_enabled)
+    vlib_cli_output (vm, "barrier stats disabled, "
+		     "enable with 'set barrier-stats on'");
+
+  vlib_cli_output (vm, "%lu syncs, held %.3f ms in total, stall threshold "
+		   "%.1f us",
+		   vlib_worker_threads[0].barrier_sync_count,
+		   tm->barrier_hold_total_time * 1e3,
+		   tm->barrier_stall_threshold * 1e6);
+
+  if (vec_len (tm->barrier_sites) == 0)
+    return 0;
+
+  for (i = 0; i < vec_len (tm->barrier_sites); i++)
+    vec_add1 (indices, i);
+  vec_sort_with_function (indices, barrier_site_cmp_total_time);
+
+  vlib_cli_output (vm, "%-50s%10s%12s%10s%10s%8s", "Site", "Calls",
+		   "Total (ms)", "Avg (us)", "Max (us)", "Stalls");
+
+  for (i = 0; i < clib_min (count, vec_len (indices)); i++)
+    {
+      s = vec_elt_at_index (tm->barrier_sites, indices[i]);
+      if (s->count == 0)
+	continue;
+      vlib_cli_output (vm, "%-50v%10lu%12.3f%10.1f%10.1f%8lu", s->name,
+		       s->count, s->total_time * 1e3,
+		       s->total_time * 1e6 / s->count, s->max_time * 1e6,
+		       s->n_stalls);
+      if (verbose)
+	{
+	  h = vlib_stats_get_histogram (tm->barrier_hold_histogram_index, 0,
+					indices[i]);
+	  vlib_cli_output (vm, "  hold (us): %U", format_vlib_stats_histogram,
+			   h, 0);
+	}
+    }
+
+  vec_free (indices);
+  return 0;
+}
+
+/*?
+ * Show which callers held the worker barrier, and for how long, most
+ * expensive first. Holds taken on behalf of a binary API message or a CLI
+ * command are attributed to that message or command. The same data is
+ * exported in the stats segment as /sys/barrier/names and
+ * /sys/barrier/hold-usec.
+ *
+ * @cliexcmd{show barrier-stats [count <n>] [verbose]}
+?*/
+VLIB_CLI_COMMAND (show_barrier_stats_command, static) = {
+  .path = "show barrier-stats",
+  .short_help = "show barrier-stats [count <n>] [verbose]",
+  .function = show_barrier_stats_fn,
+  .is_mp_safe = 1,
+};
+
+static clib_error_t *
+set_barrier_stats_fn (vlib_main_t *vm, unformat_input_t *input,
+		      vlib_cli_command_t *cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  int enable = tm->barrier_stats_enabled;
+  f64 usec;
+
+  while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+      if (unformat (input, "on"))
+	enable = 1;
+      else if (unformat (input, "off"))
+	enable = 0;
+      else if (unformat (input, "stall-threshold %f", &usec))
+	tm->barrier_stall_threshold = usec * 1e-6;
+      else
+	return clib_error_return (0, "unknown input `%U'",
+				  format_unformat_error, input);
+    }
+
+  tm->barrier_stats_enabled = enable;
+  return 0;
+}
+
+VLIB_CLI_COMMAND (set_barrier_stats_command, static) = {
+  .path = "set barrier-stats",
+  .short_help = "set barrier-stats [on | off] [stall-threshold <usec>]",
+  .function = set_barrier_stats_fn,
+};
+
+static clib_error_t *
+clear_barrier_stats_fn (vlib_main_t *vm, unformat_input_t *input,
+			vlib_cli_command_t *cmd)
+{
+  vlib_thread_main_t *tm = vlib_get_thread_main ();
+  vlib_barrier_site_t *s;
+  u64 *h;
+
+  /* Sites stay, their indices are exported in the stats segment */
+  vec_foreach (s, tm->barrier_sites)
+    {
+      s->count = s->n_stalls = 0;
+      s->total_time = s->max_time = 0;
+      h = vlib_stats_get_histogram (tm->barrier_hold_histogram_index, 0,
+				    s - tm->barrier_sites);
+      clib_memset (h, 0, vec_bytes (h));
+    }
+  tm->barrier_hold_total_time = 0;
+
+  return 0;
+}
+
+VLIB_CLI_COMMAND (clear_barrier_stats_command, static) = {
+  .path = "clear barrier-stats",
+  .short_help = "clear barrier-stats",
+  .function = clear_barrier_stats_fn,
+};
+
 /*
  * fd.io coding-style-patch-verification: ON
  *
@@ -169,6 +169,7 @@ linux_epoll_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 	  {
 	    ts = tsrem;
 	  }
+	vlib_flight_recorder_sleep_done (&vm->flight_recorder);
       }
     /* If we're not working very hard, decide how long to sleep */
     else if (is_main && vector_rate < 2 && vm->api_queue_nonempty == 0
@@ -229,6 +230,8 @@ linux_epoll_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 				      vec_len (em->epoll_events), timeout_ms);
 	  }
 
+	if (timeout_ms)
+	  vlib_flight_recorder_sleep_done (&vm->flight_recorder);
       }
     else
       {
@@ -251,8 +254,9 @@ linux_epoll_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 		  ts = tsrem;
 		if (*vlib_worker_threads->wait_at_barrier ||
 		    nm->pending_interrupts)
-		  goto done;
+		  break;
 	      }
+	    vlib_flight_recorder_sleep_done (&vm->flight_recorder);
 	  }
 	goto done;
       }
@@ -496,6 +496,11 @@ vl_msg_api_barrier_release (void)
 {
 }
 
+void
+vl_msg_api_barrier_trace_context (const char *context)
+{
+}
+
 always_inline void
 msg_handler_internal (api_main_t *am, void *the_msg, uword msg_len,
 		      int trace_it, int do_it, int free_it)
@@ -562,7 +567,7 @@ msg_handler_internal (api_main_t *am, void *the_msg, uword msg_len,
 
 	  if (!m->is_mp_safe)
 	    {
-	      vl_msg_api_barrier_trace_context (am->msg_names[id]);
+	      vl_msg_api_barrier_trace_context (m->name);
 	      vl_msg_api_barrier_sync ();
 	    }
 
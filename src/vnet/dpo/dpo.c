@@ -620,6 +620,18 @@ VLIB_INIT_FUNCTION(dpo_module_init) =
 };
 /* *INDENT-ON* */
 
+void
+dpo_memory_compact (void)
+{
+    dpo_vft_t *vft;
+
+    vec_foreach(vft, dpo_vfts)
+    {
+	if (NULL != vft->dv_mem_compact)
+	    vft->dv_mem_compact();
+    }
+}
+
 static clib_error_t *
 dpo_memory_show (vlib_main_t * vm,
 		 unformat_input_t * input,
@@ -628,8 +640,8 @@ dpo_memory_show (vlib_main_t * vm,
     dpo_vft_t *vft;
 
     vlib_cli_output (vm, "DPO memory");
-    vlib_cli_output (vm, "%=30s %=5s %=8s/%=9s   totals",
-		     "Name","Size", "in-use", "allocated");
+    vlib_cli_output (vm, "%=30s %=5s %=8s/%=9s   totals %=8s %=8s",
+		     "Name","Size", "in-use", "allocated", "holes", "tail");
 
     vec_foreach(vft, dpo_vfts)
     {
@@ -388,6 +388,11 @@ typedef void (*dpo_unlock_fn_t)(dpo_id_t *dpo);
  */
 typedef void (*dpo_mem_show_t)(void);
 
+/**
+ * @brief A function to release the memory a type no longer uses
+ */
+typedef void (*dpo_mem_compact_t)(void);
+
 /**
  * @brief Given a DPO instance return a vector of node indices that
  * the type/instance will use.
@@ -457,6 +462,10 @@ typedef struct dpo_vft_t_
      * Signal on an interposed child that the parent has changed
      */
     dpo_mk_interpose_t dv_mk_interpose;
+    /**
+     * A function to release unused memory
+     */
+    dpo_mem_compact_t dv_mem_compact;
 } dpo_vft_t;
 
 
@@ -498,6 +507,14 @@ extern void dpo_register(dpo_type_t type,
 extern dpo_type_t dpo_register_new_type(const dpo_vft_t *vft,
 					const char * const * const * nodes);
 
+/**
+ * @brief Release the memory each DPO type no longer uses
+ *
+ * The data-plane reads the DPO pools, so this must be called with the
+ * workers held at the barrier.
+ */
+extern void dpo_memory_compact(void);
+
 /**
  * @brief Return already stacked up next node index for a given
  *        child_type/child_proto and parent_type/patent_proto.
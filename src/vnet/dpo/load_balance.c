@@ -614,6 +614,108 @@ load_balance_fill_buckets_sticky (load_balance_t *lb,
     vec_free(fwding_paths);
 }
 
+/*
+ * The key of a next-hop in the resilient fill; a bucket holds a copy of
+ * the next-hop's DPO stacked on the load-balance, so compare only
+ * what it refers to.
+ */
+static u64
+load_balance_resilient_key (const dpo_id_t *dpo)
+{
+    return (((u64) dpo->dpoi_type << 32) | dpo->dpoi_index);
+}
+
+/*
+ * Fill the buckets so that each bucket that already uses one of the
+ * next-hops keeps it, as long as that next-hop is not given more buckets
+ * than its weight. Only the buckets of removed next-hops, or of those
+ * whose share has shrunk, are moved to the next-hops with buckets
+ * to spare.
+ */
+static void
+load_balance_fill_buckets_resilient (load_balance_t *lb,
+                                     load_balance_path_t *nhs,
+                                     dpo_id_t *buckets,
+                                     u32 n_buckets)
+{
+    u32 *quota = NULL, *moved = NULL, *bucket, nhi;
+    uword *db, *p;
+
+    db = hash_create(0, sizeof(uword));
+    vec_validate(quota, vec_len(nhs) - 1);
+
+    for (nhi = 0; nhi < vec_len(nhs); nhi++)
+    {
+        u64 key = load_balance_resilient_key(&nhs[nhi].path_dpo);
+
+        p = hash_get(db, key);
+
+        if (NULL == p)
+        {
+            hash_set(db, key, nhi);
+            quota[nhi] = nhs[nhi].path_weight;
+        }
+        else
+        {
+            /* two paths via the same object share its buckets */
+            quota[p[0]] += nhs[nhi].path_weight;
+        }
+    }
+
+    for (nhi = 0; nhi < n_buckets; nhi++)
+    {
+        p = NULL;
+
+        if (dpo_id_is_valid(&buckets[nhi]))
+            p = hash_get(db, load_balance_resilient_key(&buckets[nhi]));
+
+        if (NULL != p && quota[p[0]])
+            quota[p[0]]--;
+        else
+            vec_add1(moved, nhi);
+    }
+
+    nhi = 0;
+    vec_foreach(bucket, moved)
+    {
+        while (0 == quota[nhi])
+            nhi++;
+
+        ASSERT(nhi < vec_len(nhs));
+        load_balance_set_bucket_i(lb, *bucket, buckets, &nhs[nhi].path_dpo);
+        quota[nhi]--;
+    }
+
+    hash_free(db);
+    vec_free(quota);
+    vec_free(moved);
+}
+
+/*
+ * A resilient load-balance has a large, fixed, number of buckets, the
+ * next-hops' normalised weights are scaled up to fill it.
+ */
+static u32
+load_balance_resilient_n_buckets (load_balance_path_t *nhs,
+                                  u32 n_buckets)
+{
+    load_balance_path_t *nh;
+    u32 scale;
+
+    if (n_buckets >= LB_RESILIENT_N_BUCKETS)
+        return (n_buckets);
+
+    /* both are powers of 2 */
+    scale = LB_RESILIENT_N_BUCKETS / n_buckets;
+
+    vec_foreach (nh, nhs)
+    {
+        nh->path_weight *= scale;
+    }
+
+    return (LB_RESILIENT_N_BUCKETS);
+}
+
 static void
 load_balance_fill_buckets (load_balance_t *lb,
                            load_balance_path_t *nhs,
@@ -621,7 +723,11 @@ load_balance_fill_buckets (load_balance_t *lb,
                            u32 n_buckets,
                            load_balance_flags_t flags)
 {
-    if (flags & LOAD_BALANCE_FLAG_STICKY)
+    if (flags & LOAD_BALANCE_FLAG_RESILIENT)
+    {
+        load_balance_fill_buckets_resilient(lb, nhs, buckets, n_buckets);
+    }
+    else if (flags & LOAD_BALANCE_FLAG_STICKY)
     {
         load_balance_fill_buckets_sticky(lb, nhs, buckets, n_buckets);
     }
@@ -665,6 +771,16 @@ load_balance_multipath_update (const dpo_id_t *dpo,
                                          &sum_of_weights,
                                          multipath_next_hop_error_tolerance);
 
+    if (flags & LOAD_BALANCE_FLAG_RESILIENT)
+    {
+        /*
+         * the map would translate the buckets of the down paths, undoing
+         * the placement the resilient fill chose
+         */
+        ASSERT(!(flags & LOAD_BALANCE_FLAG_USES_MAP));
+        n_buckets = load_balance_resilient_n_buckets(nhs, n_buckets);
+    }
+
     /*
      * Save the old load-balance map used, and get a new one if required.
      */
@@ -926,13 +1042,25 @@ load_balance_unlock (dpo_id_t *dpo)
 static void
 load_balance_mem_show (void)
 {
-    fib_show_memory_usage("load-balance",
-			  pool_elts(load_balance_pool),
-			  pool_len(load_balance_pool),
-			  sizeof(load_balance_t));
+    fib_show_memory_pool_usage("load-balance",
+                               load_balance_pool,
+                               sizeof(load_balance_t));
     load_balance_map_show_mem();
 }
 
+static void
+load_balance_mem_compact (void)
+{
+    vlib_main_t *vm = vlib_get_main();
+
+    /*
+     * the workers read the pool, so it can only move while they are held
+     */
+    vlib_worker_thread_barrier_sync (vm);
+    pool_shrink(load_balance_pool);
+    vlib_worker_thread_barrier_release (vm);
+}
+
 static u16
 load_balance_dpo_get_mtu (const dpo_id_t *dpo)
 {
@@ -956,6 +1084,7 @@ const static dpo_vft_t lb_vft = {
     .dv_unlock = load_balance_unlock,
     .dv_format = format_load_balance_dpo,
     .dv_mem_show = load_balance_mem_show,
+    .dv_mem_compact = load_balance_mem_compact,
     .dv_get_mtu = load_balance_dpo_get_mtu,
 };
 
@@ -61,6 +61,13 @@ extern load_balance_main_t load_balance_main;
  */
 #define LB_NUM_INLINE_BUCKETS 4
 
+/**
+ * The minimum number of buckets in a resilient load-balance. A change in
+ * the set of paths moves only the buckets of the paths that lose share,
+ * so the more buckets the finer the share each path can be given.
+ */
+#define LB_RESILIENT_N_BUCKETS 1024
+
 /**
  * @brief One path from an [EU]CMP set that the client wants to add to a
  * load-balance object
@@ -88,20 +95,27 @@ typedef struct load_balance_path_t_ {
 typedef enum load_balance_attr_t_ {
     LOAD_BALANCE_ATTR_USES_MAP = 0,
     LOAD_BALANCE_ATTR_STICKY = 1,
+    /**
+     * The buckets are fixed and a change in paths moves as few flows as
+     * possible
+     */
+    LOAD_BALANCE_ATTR_RESILIENT = 2,
 } load_balance_attr_t;
 
 #define LOAD_BALANCE_ATTR_NAMES  {                  \
     [LOAD_BALANCE_ATTR_USES_MAP] = "uses-map",      \
     [LOAD_BALANCE_ATTR_STICKY] = "sticky",          \
+    [LOAD_BALANCE_ATTR_RESILIENT] = "resilient",    \
 }
 
 #define FOR_EACH_LOAD_BALANCE_ATTR(_attr)                       \
-    for (_attr = 0; _attr <= LOAD_BALANCE_ATTR_STICKY; _attr++)
+    for (_attr = 0; _attr <= LOAD_BALANCE_ATTR_RESILIENT; _attr++)
 
 typedef enum load_balance_flags_t_ {
     LOAD_BALANCE_FLAG_NONE = 0,
     LOAD_BALANCE_FLAG_USES_MAP = (1 << 0),
     LOAD_BALANCE_FLAG_STICKY = (1 << 1),
+    LOAD_BALANCE_FLAG_RESILIENT = (1 << 2),
 } __attribute__((packed)) load_balance_flags_t;
 
 /**
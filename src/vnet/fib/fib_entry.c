@@ -300,10 +300,9 @@ fib_entry_show_memory (void)
     fib_entry_src_t *esrc;
     fib_entry_t *entry;
 
-    fib_show_memory_usage("Entry",
-			  pool_elts(fib_entry_pool),
-			  pool_len(fib_entry_pool),
-			  sizeof(fib_entry_t));
+    fib_show_memory_pool_usage("Entry",
+                               fib_entry_pool,
+                               sizeof(fib_entry_t));
 
     pool_foreach (entry, fib_entry_pool)
      {
@@ -321,6 +320,12 @@ fib_entry_show_memory (void)
 			  sizeof(fib_path_ext_t));
 }
 
+static void
+fib_entry_memory_compact (void)
+{
+    pool_shrink(fib_entry_pool);
+}
+
 /**
  * @brief Contribute the set of Adjacencies that this entry forwards with
  * to build the uRPF list of its children
@@ -1546,6 +1551,7 @@ static const fib_node_vft_t fib_entry_vft = {
     .fnv_last_lock = fib_entry_last_lock_gone,
     .fnv_back_walk = fib_entry_back_walk_notify,
     .fnv_mem_show = fib_entry_show_memory,
+    .fnv_mem_compact = fib_entry_memory_compact,
 };
 
 u32
@@ -1600,6 +1606,25 @@ fib_entry_is_host (fib_node_index_t fib_entry_index)
     return (fib_prefix_is_host(fib_entry_get_prefix(fib_entry_index)));
 }
 
+/**
+ * Return !0 if the entry forwards through a load-balance map, so the map
+ * steers its traffic off a failed path before the entry is walked.
+ * Resilient load-balances never use a map.
+ */
+int
+fib_entry_uses_lb_map (fib_node_index_t fib_entry_index)
+{
+    fib_entry_t *fib_entry;
+
+    fib_entry = fib_entry_get(fib_entry_index);
+
+    if (DPO_LOAD_BALANCE != fib_entry->fe_lb.dpoi_type)
+        return (0);
+
+    return (INDEX_INVALID !=
+            load_balance_get(fib_entry->fe_lb.dpoi_index)->lb_map);
+}
+
 /**
  * Return !0 is the entry is resolved, i.e. will return a valid forwarding
  * chain
@@ -1828,6 +1853,12 @@ fib_entry_pool_size (void)
     return (pool_elts(fib_entry_pool));
 }
 
+u32
+fib_entry_pool_len (void)
+{
+    return (pool_len(fib_entry_pool));
+}
+
 #if CLIB_DEBUG > 0
 void
 fib_table_assert_empty (const fib_table_t *fib_table)
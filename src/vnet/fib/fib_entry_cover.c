@@ -17,6 +17,7 @@
 #include <vnet/fib/fib_entry_src.h>
 #include <vnet/fib/fib_node_list.h>
 #include <vnet/fib/fib_entry_delegate.h>
+#include <vnet/fib/fib_table.h>
 
 u32
 fib_entry_cover_track (fib_entry_t* cover,
@@ -159,6 +160,41 @@ fib_entry_cover_change_notify (fib_node_index_t cover_index,
 			 uword_to_pointer(covered, void*));
 }
 
+static walk_rc_t
+fib_entry_cover_check_one (fib_entry_t *cover,
+			   fib_node_index_t covered,
+			   void *args)
+{
+    fib_entry_t *fib_entry;
+
+    /*
+     * the covered entry's cover is whatever is now the less specific
+     * of its prefix. if that is no longer this entry then something
+     * was inserted in between.
+     */
+    fib_entry = fib_entry_get(covered);
+
+    if (fib_table_get_less_specific(fib_entry->fe_fib_index,
+                                    &fib_entry->fe_prefix) !=
+        fib_entry_get_index(cover))
+    {
+	fib_entry_cover_changed(covered);
+    }
+    return (WALK_CONTINUE);
+}
+
+void
+fib_entry_cover_change_check (fib_node_index_t cover_index)
+{
+    fib_entry_t *cover;
+
+    cover = fib_entry_get(cover_index);
+
+    fib_entry_cover_walk(cover,
+			 fib_entry_cover_check_one,
+			 NULL);
+}
+
 static walk_rc_t
 fib_entry_cover_update_one (fib_entry_t *cover,
 			    fib_node_index_t covered,
@@ -37,6 +37,11 @@ extern void fib_entry_cover_walk(fib_entry_t *cover,
 
 extern void fib_entry_cover_change_notify(fib_node_index_t cover_index,
 					  fib_node_index_t covered_index);
+/**
+ * Re-evaluate the cover of all the entries tracking this one, after
+ * any number of more specifics have been inserted beneath it.
+ */
+extern void fib_entry_cover_change_check(fib_node_index_t cover_index);
 extern void fib_entry_cover_update_notify(fib_entry_t *cover);
 
 #endif
@@ -269,12 +269,23 @@ static load_balance_flags_t
 fib_entry_calc_lb_flags (fib_entry_src_collect_forwarding_ctx_t *ctx,
                          const fib_entry_src_t *esrc)
 {
+    /**
+     * A resilient LB chooses where each path's flows go, which a map
+     * would undo when paths go down.
+     */
+    if (esrc->fes_entry_flags & FIB_ENTRY_FLAG_RESILIENT)
+    {
+        return (LOAD_BALANCE_FLAG_RESILIENT);
+    }
+
     /**
      * We'll use a LB map if the path-list has multiple recursive paths.
      * recursive paths implies BGP, and hence scale.
+     * In PIC mode any multi-path popular path-list will do.
      */
-    if (ctx->n_recursive_constrained > 1 &&
-        fib_path_list_is_popular(esrc->fes_pl))
+    if (fib_path_list_is_popular(esrc->fes_pl) &&
+        (ctx->n_recursive_constrained > 1 ||
+         (fib_path_list_pic_is_enabled() && vec_len(ctx->next_hops) > 1)))
     {
         return (LOAD_BALANCE_FLAG_USES_MAP);
     }
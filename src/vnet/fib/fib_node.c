@@ -241,6 +241,31 @@ fib_show_memory_usage (const char *name,
 		     in_use_elts*size_elt, allocd_elts*size_elt);
 }
 
+void
+fib_show_memory_pool_usage (const char *name,
+                            void *pool,
+                            size_t size_elt)
+{
+    uword n_bytes = 0, n_tail = 0, n_holes = 0;
+    pool_header_t *ph;
+
+    if (NULL != pool)
+    {
+        ph = pool_header(pool);
+        n_bytes = (vec_mem_size(pool) +
+                   vec_mem_size(ph->free_bitmap) +
+                   vec_mem_size(ph->free_indices));
+        n_tail = pool_free_tail_elts(pool);
+        n_holes = vec_len(ph->free_indices) - n_tail;
+    }
+
+    vlib_cli_output (vlib_get_main(), "%=30s %=5d %=8d/%=9d   %d/%d %=8d %=8d",
+		     name, size_elt,
+		     pool_elts(pool), pool_len(pool),
+		     pool_elts(pool)*size_elt, n_bytes,
+                     n_holes, n_tail);
+}
+
 static clib_error_t *
 fib_memory_show (vlib_main_t * vm,
 		 unformat_input_t * input,
@@ -254,8 +279,8 @@ fib_memory_show (vlib_main_t * vm,
     vlib_cli_output (vm, "%U", format_fib_table_memory);
     vlib_cli_output (vm, "%U", format_mfib_table_memory);
     vlib_cli_output (vm, "  Nodes:");
-    vlib_cli_output (vm, "%=30s %=5s %=8s/%=9s   totals",
-		     "Name","Size", "in-use", "allocated");
+    vlib_cli_output (vm, "%=30s %=5s %=8s/%=9s   totals %=8s %=8s",
+		     "Name","Size", "in-use", "allocated", "holes", "tail");
 
     vec_foreach(vft, fn_vfts)
     {
@@ -284,17 +309,21 @@ fib_memory_show (vlib_main_t * vm,
  *       IPv4 multicast            2     2322
  *       IPv6 multicast            2      ???
  * Nodes:
- *            Name               Size  in-use /allocated   totals
- *            Entry               96     20   /    20      1920/1920
+ *            Name               Size  in-use /allocated   totals  holes    tail
+ *            Entry               96     20   /    24      1920/2472   4       0
  *        Entry Source            32      0   /    0       0/0
  *    Entry Path-Extensions       60      0   /    0       0/0
  *       multicast-Entry         192     12   /    12      2304/2304
- *          Path-list             40     28   /    28      1120/1120
+ *          Path-list             40     28   /    28      1120/1304   0       0
  *          uRPF-list             16     20   /    20      320/320
- *            Path                72     28   /    28      2016/2016
+ *            Path                72     28   /    28      2016/2200   0       0
  *     Node-list elements         20     28   /    28      560/560
  *       Node-list heads          8      30   /    30      240/240
  * @cliexend
+ *
+ * For the types that report them, the second total is every byte the type's
+ * pool holds, the holes are free elements between those in use and the tail
+ * is the free elements after the last one in use.
 ?*/
 VLIB_CLI_COMMAND (show_fib_memory, static) = {
     .path = "show fib memory",
@@ -302,3 +331,57 @@ VLIB_CLI_COMMAND (show_fib_memory, static) = {
     .short_help = "show fib memory",
 };
 /* *INDENT-ON* */
+
+void
+fib_memory_compact (void)
+{
+    fib_node_vft_t *vft;
+
+    vec_foreach(vft, fn_vfts)
+    {
+	if (NULL != vft->fnv_mem_compact)
+	    vft->fnv_mem_compact();
+    }
+    dpo_memory_compact();
+}
+
+static clib_error_t *
+fib_memory_clear (vlib_main_t * vm,
+                  unformat_input_t * input,
+                  vlib_cli_command_t * cmd)
+{
+    clib_mem_usage_t before, after;
+
+    clib_mem_get_heap_usage(clib_mem_get_heap(), &before);
+    fib_memory_compact();
+    clib_mem_get_heap_usage(clib_mem_get_heap(), &after);
+
+    vlib_cli_output (vm, "released %U",
+                     format_memory_size,
+                     (before.bytes_used > after.bytes_used ?
+                      before.bytes_used - after.bytes_used : 0));
+
+    return (NULL);
+}
+
+/* *INDENT-OFF* */
+/*?
+ * The '<em>clear fib memory</em>' command returns to the heap the memory
+ * that the FIB and DPO object pools no longer use, for example after a large
+ * number of routes has been removed. Objects keep their indices, so only the
+ * free elements at the end of each pool (the 'tail' in
+ * '<em>show fib memory</em>') are released; the pools' free lists are then
+ * ordered so that later allocations fill the lowest holes first and the tail
+ * has a chance to drain.
+ *
+ * @cliexpar
+ * @cliexstart{clear fib memory}
+ * released 118.27m
+ * @cliexend
+?*/
+VLIB_CLI_COMMAND (clear_fib_memory, static) = {
+    .path = "clear fib memory",
+    .function = fib_memory_clear,
+    .short_help = "clear fib memory",
+};
+/* *INDENT-ON* */
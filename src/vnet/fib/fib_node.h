@@ -298,6 +298,12 @@ typedef void (*fib_node_last_lock_gone_t)(struct fib_node_t_ *node);
  */
 typedef void (*fib_node_memory_show_t)(void);
 
+/**
+ * Function definition to release the memory a type no longer uses.
+ * Implementations should call pool_shrink() on their pools.
+ */
+typedef void (*fib_node_memory_compact_t)(void);
+
 /**
  * A FIB graph nodes virtual function table
  */
@@ -306,6 +312,7 @@ typedef struct fib_node_vft_t_ {
     fib_node_last_lock_gone_t fnv_last_lock;
     fib_node_back_walk_t fnv_back_walk;
     fib_node_memory_show_t fnv_mem_show;
+    fib_node_memory_compact_t fnv_mem_compact;
 } fib_node_vft_t;
 
 /**
@@ -379,6 +386,30 @@ extern void fib_show_memory_usage(const char *name,
 				  u32 allocd_elts,
 				  size_t size_elt);
 
+/**
+ * @brief Show the memory usage for a type allocated from a pool
+ *
+ * As fib_show_memory_usage() but the allocated bytes include the pool's
+ * spare capacity and free lists, and the free elements are split into
+ * the holes between in-use elements and the free tail that compaction
+ * would release.
+ *
+ * @param name the name of the type
+ * @param pool The type's pool
+ * @param size_elt The size of one element
+ */
+extern void fib_show_memory_pool_usage(const char *name,
+                                       void *pool,
+                                       size_t size_elt);
+
+/**
+ * @brief Release the memory the FIB and DPO types no longer use
+ *
+ * Calls the fnv_mem_compact function of each FIB node type and then
+ * dpo_memory_compact().
+ */
+extern void fib_memory_compact(void);
+
 extern void fib_node_init(fib_node_t *node,
 			  fib_node_type_t ft);
 extern void fib_node_deinit(fib_node_t *node);
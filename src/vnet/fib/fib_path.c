@@ -971,6 +971,17 @@ fib_path_to_chain_type (const fib_path_t *path)
     }
 }
 
+/*
+ * PIC edge trigger for attached next-hop paths. Only PIC mode gives
+ * their path-lists load-balance maps, don't search them otherwise.
+ */
+static void
+fib_path_attached_next_hop_state_change (fib_path_t *path)
+{
+    if (fib_path_list_pic_is_enabled())
+        load_balance_map_path_state_change(fib_path_get_index(path));
+}
+
 /*
  * fib_path_back_walk_notify
  *
@@ -1065,6 +1076,7 @@ FIXME comment
                 return (FIB_NODE_BACK_WALK_CONTINUE);
             }
 	    path->fp_oper_flags |= FIB_PATH_OPER_FLAG_RESOLVED;
+            fib_path_attached_next_hop_state_change(path);
 	}
 	if (FIB_NODE_BW_REASON_FLAG_INTERFACE_DOWN & ctx->fnbw_reason)
 	{
@@ -1076,6 +1088,11 @@ FIXME comment
                 return (FIB_NODE_BACK_WALK_CONTINUE);
             }
 	    path->fp_oper_flags &= ~FIB_PATH_OPER_FLAG_RESOLVED;
+
+            /*
+             * PIC edge trigger. let the load-balance maps know
+             */
+            fib_path_attached_next_hop_state_change(path);
 	}
 	if (FIB_NODE_BW_REASON_FLAG_INTERFACE_DELETE & ctx->fnbw_reason)
 	{
@@ -1087,6 +1104,7 @@ FIXME comment
 	     */
 	    fib_path_unresolve(path);
 	    path->fp_oper_flags |= FIB_PATH_OPER_FLAG_DROP;
+            fib_path_attached_next_hop_state_change(path);
 	}
         if (FIB_NODE_BW_REASON_FLAG_ADJ_UPDATE & ctx->fnbw_reason)
 	{
@@ -1113,6 +1131,7 @@ FIXME comment
             {
                 path->fp_oper_flags |= FIB_PATH_OPER_FLAG_RESOLVED;
             }
+            fib_path_attached_next_hop_state_change(path);
 
             if (!if_is_up)
             {
@@ -1139,6 +1158,7 @@ FIXME comment
              * the adj has gone down. the path is no longer resolved.
              */
 	    path->fp_oper_flags &= ~FIB_PATH_OPER_FLAG_RESOLVED;
+            fib_path_attached_next_hop_state_change(path);
         }
 	break;
     case FIB_PATH_TYPE_ATTACHED:
@@ -1224,10 +1244,15 @@ FIXME comment
 static void
 fib_path_memory_show (void)
 {
-    fib_show_memory_usage("Path",
-			  pool_elts(fib_path_pool),
-			  pool_len(fib_path_pool),
-			  sizeof(fib_path_t));
+    fib_show_memory_pool_usage("Path",
+                               fib_path_pool,
+                               sizeof(fib_path_t));
+}
+
+static void
+fib_path_memory_compact (void)
+{
+    pool_shrink(fib_path_pool);
 }
 
 /*
@@ -1238,6 +1263,7 @@ static const fib_node_vft_t fib_path_vft = {
     .fnv_last_lock = fib_path_last_lock_gone,
     .fnv_back_walk = fib_path_back_walk_notify,
     .fnv_mem_show = fib_path_memory_show,
+    .fnv_mem_compact = fib_path_memory_compact,
 };
 
 static fib_path_cfg_flags_t
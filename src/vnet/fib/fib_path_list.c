@@ -20,6 +20,7 @@
 #include <vnet/dpo/load_balance_map.h>
 
 #include <vnet/fib/fib_path_list.h>
+#include <vnet/fib/fib_entry.h>
 #include <vnet/fib/fib_internal.h>
 #include <vnet/fib/fib_node_list.h>
 #include <vnet/fib/fib_walk.h>
@@ -37,6 +38,15 @@
  */
 #define FIB_PATH_LIST_POPULAR 64
 
+/**
+ * PIC mode. By default only popular path-lists with more than one
+ * recursive path generate load-balance maps - recursive paths imply BGP,
+ * and hence scale. In PIC mode any popular multi-path path-list does,
+ * so the failure of an attached next-hop is also repaired by the maps,
+ * i.e. in time proportional to the number of path-lists, not prefixes.
+ */
+static int fib_path_list_pic;
+
 /**
  * FIB path-list
  * A representation of the list/set of path trough which a prefix is reachable
@@ -457,6 +467,61 @@ fib_path_list_get_urpf (fib_node_index_t path_list_index)
     return (path_list->fpl_urpf);
 }
 
+/**
+ * Have the load-balance maps of the path-list's children repaired the
+ * loss of any of its paths. That's so in PIC mode when there are paths
+ * left to share the load, and none in reserve (of a lesser preference)
+ * that only a walk to the children would bring into use.
+ */
+static int
+fib_path_list_pic_repaired (const fib_path_list_t *path_list)
+{
+    fib_node_index_t *path_index;
+    u32 n_resolved;
+    u16 pref;
+
+    if (!fib_path_list_pic || vec_len(path_list->fpl_paths) < 2)
+        return (0);
+
+    n_resolved = 0;
+    pref = fib_path_get_preference(path_list->fpl_paths[0]);
+
+    vec_foreach (path_index, path_list->fpl_paths)
+    {
+        if (pref != fib_path_get_preference(*path_index))
+            return (0);
+        n_resolved += fib_path_is_resolved(*path_index);
+    }
+
+    return (n_resolved > 0);
+}
+
+/*
+ * Collect the children of a repaired path-list that the load-balance maps
+ * do not cover: entries that don't forward through a map (e.g. resilient
+ * load-balances), tracked entries, midchain adjacencies and tunnels.
+ */
+static walk_rc_t
+fib_path_list_pic_collect_child (fib_node_ptr_t *ptr,
+                                 void *arg)
+{
+    fib_node_ptr_t **children = arg;
+
+    /*
+     * walks in progress hang off the child list, they are not children
+     */
+    if (FIB_NODE_TYPE_WALK == ptr->fnp_type)
+        return (WALK_CONTINUE);
+
+    if (FIB_NODE_TYPE_ENTRY == ptr->fnp_type &&
+        fib_entry_uses_lb_map(ptr->fnp_index))
+        return (WALK_CONTINUE);
+
+    vec_add1(*children, *ptr);
+
+    return (WALK_CONTINUE);
+}
+
 /*
  * fib_path_list_back_walk
  *
@@ -482,8 +547,36 @@ fib_path_list_back_walk (fib_node_index_t path_list_index,
     if (path_list->fpl_flags & FIB_PATH_LIST_FLAG_POPULAR)
     {
         /*
-         * many children. schedule a async walk
+         * many children. schedule a async walk.
+         * if the children's maps have already been repaired to avoid
+         * a failed path then, for the children using those maps, even a
+         * walk that wants to be synchronous can wait.
          */
+        if ((ctx->fnbw_flags & FIB_NODE_BW_FLAG_FORCE_SYNC) &&
+            fib_path_list_pic_repaired(path_list))
+        {
+            fib_node_back_walk_ctx_t sync_ctx;
+            fib_node_ptr_t *children = NULL, *child;
+
+            /*
+             * the children not covered by a map still get their
+             * synchronous walk, the async walk then visits them again
+             */
+            fib_node_list_walk(path_list->fpl_node.fn_children,
+                               fib_path_list_pic_collect_child,
+                               &children);
+
+            vec_foreach (child, children)
+            {
+                sync_ctx = *ctx;
+                if (FIB_NODE_GRAPH_MAX_DEPTH < ++sync_ctx.fnbw_depth)
+                    break;
+                fib_node_back_walk_one(child, &sync_ctx);
+            }
+            vec_free(children);
+
+            ctx->fnbw_flags &= ~FIB_NODE_BW_FLAG_FORCE_SYNC;
+        }
         fib_walk_async(FIB_NODE_TYPE_PATH_LIST,
                        path_list_index,
                        FIB_WALK_PRIORITY_LOW,
@@ -523,13 +616,21 @@ fib_path_list_back_walk_notify (fib_node_t *node,
 static void
 fib_path_list_memory_show (void)
 {
-    fib_show_memory_usage("Path-list",
-			  pool_elts(fib_path_list_pool),
-			  pool_len(fib_path_list_pool),
-			  sizeof(fib_path_list_t));
+    fib_show_memory_pool_usage("Path-list",
+                               fib_path_list_pool,
+                               sizeof(fib_path_list_t));
     fib_urpf_list_show_mem();
 }
 
+/*
+ * Release the path-lists' unused memory
+ */
+static void
+fib_path_list_memory_compact (void)
+{
+    pool_shrink(fib_path_list_pool);
+}
+
 /*
  * The FIB path-list's graph node virtual function table
  */
@@ -538,6 +639,7 @@ static const fib_node_vft_t fib_path_list_vft = {
     .fnv_last_lock = fib_path_list_last_lock_gone,
     .fnv_back_walk = fib_path_list_back_walk_notify,
     .fnv_mem_show = fib_path_list_memory_show,
+    .fnv_mem_compact = fib_path_list_memory_compact,
 };
 
 static inline fib_path_list_t *
@@ -665,6 +767,40 @@ fib_path_list_is_popular (fib_node_index_t path_list_index)
     return (path_list->fpl_flags & FIB_PATH_LIST_FLAG_POPULAR);
 }
 
+int
+fib_path_list_pic_is_enabled (void)
+{
+    return (fib_path_list_pic);
+}
+
+void
+fib_path_list_pic_enable_disable (int is_enable)
+{
+    fib_node_back_walk_ctx_t ctx = {
+        .fnbw_reason = FIB_NODE_BW_REASON_FLAG_EVALUATE,
+    };
+    fib_path_list_t *path_list;
+
+    if (fib_path_list_pic == !!is_enable)
+        return;
+
+    fib_path_list_pic = !!is_enable;
+
+    /*
+     * the entries using popular path-lists add or drop their maps
+     */
+    pool_foreach (path_list, fib_path_list_pool)
+    {
+        if (path_list->fpl_flags & FIB_PATH_LIST_FLAG_POPULAR)
+        {
+            fib_walk_async(FIB_NODE_TYPE_PATH_LIST,
+                           fib_path_list_get_index(path_list),
+                           FIB_WALK_PRIORITY_LOW,
+                           &ctx);
+        }
+    }
+}
+
 static fib_path_list_flags_t
 fib_path_list_flags_fixup (fib_path_list_flags_t flags)
 {
@@ -1479,3 +1615,33 @@ VLIB_CLI_COMMAND (show_fib_path_list, static) = {
   .function = show_fib_path_list_command,
   .short_help = "show fib path-lists",
 };
+
+static clib_error_t *
+set_fib_pic_command (vlib_main_t * vm,
+                     unformat_input_t * input,
+                     vlib_cli_command_t * cmd)
+{
+    if (unformat (input, "on"))
+        fib_path_list_pic_enable_disable(1);
+    else if (unformat (input, "off"))
+        fib_path_list_pic_enable_disable(0);
+    else
+        return (clib_error_return(0, "unknown input '%U'",
+                                  format_unformat_error, input));
+    return (NULL);
+}
+
+/*?
+ * Enable or disable prefix independent convergence for all popular,
+ * i.e. widely shared, multi-path path-lists. When on, the prefixes that
+ * share such a path-list forward through a shared load-balance map, so
+ * the failure of one of the paths is repaired for all of them at once.
+ *
+ * @cliexpar
+ * @cliexcmd{set fib pic on}
+ ?*/
+VLIB_CLI_COMMAND (set_fib_pic, static) = {
+  .path = "set fib pic",
+  .function = set_fib_pic_command,
+  .short_help = "set fib pic [on|off]",
+};
@@ -0,0 +1,434 @@
+/*
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <vnet/fib/fib_route_queue.h>
+#include <vnet/fib/fib_table.h>
+#include <vnet/fib/fib_api.h>
+
+/**
+ * A queued route update
+ */
+typedef struct fib_route_queue_update_t_
+{
+    fib_prefix_t frqu_prefix;
+    fib_route_path_t *frqu_rpaths;
+    fib_entry_flag_t frqu_flags;
+    fib_source_t frqu_src;
+    u8 frqu_is_add;
+    u8 frqu_is_multipath;
+    u32 frqu_request;
+} fib_route_queue_update_t;
+
+/**
+ * A client's request, whose updates may be spread over several tables'
+ * queues
+ */
+typedef struct fib_route_queue_request_t_
+{
+    fib_route_queue_done_t frqr_done;
+    u32 frqr_client_index;
+    u32 frqr_context;
+    u32 frqr_fib_index;
+    fib_protocol_t frqr_proto;
+
+    /**
+     * The request's updates queued and not yet applied or discarded
+     */
+    u32 frqr_n_pending;
+    u32 frqr_n_applied;
+    u32 frqr_n_failed;
+
+    /**
+     * The error of the first update that failed
+     */
+    int frqr_rv;
+
+    /**
+     * No more updates are added once the request has ended
+     */
+    u8 frqr_ended;
+} fib_route_queue_request_t;
+
+/**
+ * The updates queued for one table
+ */
+typedef struct fib_route_queue_t_
+{
+    u32 frq_fib_index;
+    fib_protocol_t frq_proto;
+
+    /**
+     * The updates not yet applied, in order, from frq_head
+     */
+    fib_route_queue_update_t *frq_updates;
+    u32 frq_head;
+} fib_route_queue_t;
+
+/**
+ * The number of a table's updates applied before moving to the next table
+ */
+#define FIB_ROUTE_QUEUE_QUOTA 256
+
+static fib_route_queue_t *fib_route_queue_pool;
+static fib_route_queue_request_t *fib_route_queue_request_pool;
+
+/**
+ * DB of queues, per-protocol, keyed by fib index
+ */
+static uword *fib_route_queue_db[FIB_PROTOCOL_MAX];
+
+/**
+ * Stats
+ */
+static u64 fib_route_queue_n_applied;
+static u64 fib_route_queue_n_errors;
+static u64 fib_route_queue_n_slices;
+
+vlib_node_registration_t fib_route_queue_node;
+
+u32
+fib_route_queue_request_begin (fib_route_queue_done_t done,
+                               u32 client_index,
+                               u32 context)
+{
+    fib_route_queue_request_t *frqr;
+
+    pool_get_zero(fib_route_queue_request_pool, frqr);
+    frqr->frqr_done = done;
+    frqr->frqr_client_index = client_index;
+    frqr->frqr_context = context;
+
+    return (frqr - fib_route_queue_request_pool);
+}
+
+static void
+fib_route_queue_request_check_done (fib_route_queue_request_t *frqr)
+{
+    if (!frqr->frqr_ended || frqr->frqr_n_pending)
+        return;
+
+    /*
+     * a request with nothing queued has nothing to report
+     */
+    if (frqr->frqr_n_applied || frqr->frqr_n_failed)
+        frqr->frqr_done(frqr->frqr_client_index,
+                        frqr->frqr_context,
+                        frqr->frqr_fib_index,
+                        frqr->frqr_proto,
+                        frqr->frqr_n_applied,
+                        frqr->frqr_n_failed,
+                        frqr->frqr_rv);
+
+    pool_put(fib_route_queue_request_pool, frqr);
+}
+
+void
+fib_route_queue_request_end (u32 request)
+{
+    fib_route_queue_request_t *frqr;
+
+    frqr = pool_elt_at_index(fib_route_queue_request_pool, request);
+    frqr->frqr_ended = 1;
+
+    fib_route_queue_request_check_done(frqr);
+}
+
+/**
+ * Account for an update of a request that was applied, or discarded
+ */
+static void
+fib_route_queue_request_update_done (u32 request,
+                                     int rv)
+{
+    fib_route_queue_request_t *frqr;
+
+    frqr = pool_elt_at_index(fib_route_queue_request_pool, request);
+    frqr->frqr_n_pending--;
+
+    if (0 == rv)
+        frqr->frqr_n_applied++;
+    else
+    {
+        if (0 == frqr->frqr_n_failed++)
+            frqr->frqr_rv = rv;
+    }
+
+    fib_route_queue_request_check_done(frqr);
+}
+
+static void
+fib_route_queue_destroy (fib_route_queue_t *frq)
+{
+    fib_route_queue_update_t *frqu;
+    u32 ii;
+
+    /*
+     * the updates not applied are reported to their requests as failed
+     */
+    for (ii = frq->frq_head; ii < vec_len(frq->frq_updates); ii++)
+    {
+        frqu = &frq->frq_updates[ii];
+
+        vec_free(frqu->frqu_rpaths);
+        fib_route_queue_request_update_done(frqu->frqu_request,
+                                            VNET_API_ERROR_NO_SUCH_FIB);
+    }
+    vec_free(frq->frq_updates);
+
+    hash_unset(fib_route_queue_db[frq->frq_proto], frq->frq_fib_index);
+    pool_put(fib_route_queue_pool, frq);
+}
+
+void
+fib_route_queue_add (u32 fib_index,
+                     const fib_prefix_t *prefix,
+                     u8 is_add,
+                     u8 is_multipath,
+                     fib_source_t src,
+                     fib_entry_flag_t entry_flags,
+                     const fib_route_path_t *rpaths,
+                     u32 request)
+{
+    fib_route_queue_request_t *frqr;
+    fib_route_queue_update_t *frqu;
+    fib_route_queue_t *frq;
+    uword *p;
+
+    frqr = pool_elt_at_index(fib_route_queue_request_pool, request);
+    ASSERT(!frqr->frqr_ended);
+    frqr->frqr_fib_index = fib_index;
+    frqr->frqr_proto = prefix->fp_proto;
+    frqr->frqr_n_pending++;
+
+    p = hash_get(fib_route_queue_db[prefix->fp_proto], fib_index);
+
+    if (NULL == p)
+    {
+        pool_get_zero(fib_route_queue_pool, frq);
+        frq->frq_fib_index = fib_index;
+        frq->frq_proto = prefix->fp_proto;
+        hash_set(fib_route_queue_db[prefix->fp_proto], fib_index,
+                 frq - fib_route_queue_pool);
+
+        if (1 == pool_elts(fib_route_queue_pool))
+            vlib_process_signal_event(vlib_get_main(),
+                                      fib_route_queue_node.index, 0, 0);
+    }
+    else
+    {
+        frq = pool_elt_at_index(fib_route_queue_pool, p[0]);
+    }
+
+    vec_add2(frq->frq_updates, frqu, 1);
+
+    frqu->frqu_prefix = *prefix;
+    /* the FIB fixes up the paths it is given, so the update has a copy */
+    frqu->frqu_rpaths = vec_dup((fib_route_path_t*) rpaths);
+    frqu->frqu_flags = entry_flags;
+    frqu->frqu_src = src;
+    frqu->frqu_is_add = is_add;
+    frqu->frqu_is_multipath = is_multipath;
+    frqu->frqu_request = request;
+}
+
+void
+fib_route_queue_flush (u32 fib_index,
+                       fib_protocol_t proto)
+{
+    uword *p;
+
+    p = hash_get(fib_route_queue_db[proto], fib_index);
+
+    if (NULL != p)
+        fib_route_queue_destroy(pool_elt_at_index(fib_route_queue_pool,
+                                                  p[0]));
+}
+
+static u32
+fib_route_queue_get_n_pending (const fib_route_queue_t *frq)
+{
+    return (vec_len(frq->frq_updates) - frq->frq_head);
+}
+
+u32
+fib_route_queue_n_pending (void)
+{
+    fib_route_queue_t *frq;
+    u32 n_pending = 0;
+
+    pool_foreach (frq, fib_route_queue_pool)
+    {
+        n_pending += fib_route_queue_get_n_pending(frq);
+    }
+
+    return (n_pending);
+}
+
+/**
+ * Apply a slice of a table's updates, as one route batch with the
+ * workers held
+ */
+static void
+fib_route_queue_apply (vlib_main_t *vm,
+                       fib_route_queue_t *frq,
+                       u32 max)
+{
+    fib_route_queue_update_t *frqu;
+    u32 ii, n;
+    int rv;
+
+    n = clib_min(max, fib_route_queue_get_n_pending(frq));
+
+    vlib_worker_thread_barrier_sync(vm);
+    fib_table_batch_begin();
+
+    for (ii = frq->frq_head; ii < frq->frq_head + n; ii++)
+    {
+        frqu = &frq->frq_updates[ii];
+
+        rv = fib_api_route_add_del(frqu->frqu_is_add,
+                                   frqu->frqu_is_multipath,
+                                   frq->frq_fib_index,
+                                   &frqu->frqu_prefix,
+                                   frqu->frqu_src,
+                                   frqu->frqu_flags,
+                                   frqu->frqu_rpaths);
+        if (0 != rv)
+            fib_route_queue_n_errors++;
+
+        vec_free(frqu->frqu_rpaths);
+        fib_route_queue_request_update_done(frqu->frqu_request, rv);
+    }
+
+    fib_table_batch_end();
+    vlib_worker_thread_barrier_release(vm);
+
+    frq->frq_head += n;
+    fib_route_queue_n_applied += n;
+    fib_route_queue_n_slices++;
+
+    if (0 == fib_route_queue_get_n_pending(frq))
+        fib_route_queue_destroy(frq);
+}
+
+void
+fib_route_queue_drain (u32 fib_index,
+                       fib_protocol_t proto)
+{
+    uword *p;
+
+    p = hash_get(fib_route_queue_db[proto], fib_index);
+
+    if (NULL != p)
+        fib_route_queue_apply(vlib_get_main(),
+                              pool_elt_at_index(fib_route_queue_pool, p[0]),
+                              ~0);
+}
+
+static uword
+fib_route_queue_process (vlib_main_t * vm,
+                         vlib_node_runtime_t * node,
+                         vlib_frame_t * f)
+{
+    u32 *indices = NULL, *frqi;
+    fib_route_queue_t *frq;
+
+    while (1)
+    {
+        vlib_process_wait_for_event(vm);
+        vlib_process_get_events(vm, NULL);
+
+        while (pool_elts(fib_route_queue_pool))
+        {
+            /*
+             * one slice from each table with updates, then round again
+             */
+            vec_reset_length(indices);
+            pool_foreach (frq, fib_route_queue_pool)
+            {
+                vec_add1(indices, frq - fib_route_queue_pool);
+            }
+
+            vec_foreach(frqi, indices)
+            {
+                /* flushed while we were suspended */
+                if (pool_is_free_index(fib_route_queue_pool, *frqi))
+                    continue;
+
+                fib_route_queue_apply(vm,
+                                      pool_elt_at_index(fib_route_queue_pool,
+                                                        *frqi),
+                                      FIB_ROUTE_QUEUE_QUOTA);
+                vlib_process_suspend(vm, 10e-6);
+            }
+        }
+    }
+
+    /*
+     * Unreached
+     */
+    return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (fib_route_queue_node) = {
+    .function = fib_route_queue_process,
+    .type = VLIB_NODE_TYPE_PROCESS,
+    .name = "fib-route-queue",
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+fib_route_queue_show (vlib_main_t * vm,
+                      unformat_input_t * input,
+                      vlib_cli_command_t * cmd)
+{
+    fib_route_queue_t *frq;
+
+    vlib_cli_output(vm, "%d pending, %lld applied in %lld slices, %lld errors",
+                    fib_route_queue_n_pending(),
+                    fib_route_queue_n_applied,
+                    fib_route_queue_n_slices,
+                    fib_route_queue_n_errors);
+
+    pool_foreach (frq, fib_route_queue_pool)
+    {
+        vlib_cli_output(vm, "  %U: %d pending",
+                        format_fib_table_name, frq->frq_fib_index,
+                        frq->frq_proto,
+                        fib_route_queue_get_n_pending(frq));
+    }
+
+    return (NULL);
+}
+
+/*?
+ * This command displays the route updates queued per-table, e.g. by the
+ * asynchronous bulk route API, and not yet applied.
+ *
+ * @cliexpar
+ * @cliexstart{show fib route-queue}
+ * 5120 pending, 3072 applied in 12 slices, 0 errors
+ *   ipv4-VRF:1: 2048 pending
+ *   ipv4-VRF:2: 3072 pending
+ * @cliexend
+ ?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (fib_route_queue_show_command, static) = {
+    .path = "show fib route-queue",
+    .short_help = "show fib route-queue",
+    .function = fib_route_queue_show,
+};
+/* *INDENT-ON* */
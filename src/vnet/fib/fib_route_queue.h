@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FIB_ROUTE_QUEUE_H__
+#define __FIB_ROUTE_QUEUE_H__
+
+#include <vnet/fib/fib_types.h>
+#include <vnet/fib/fib_entry.h>
+
+/**
+ * @brief Route updates queued for the fib-route-queue process.
+ *
+ * Loading many tables at once, e.g. thousands of VRFs each with thousands
+ * of routes, would otherwise hold the main thread, and the workers at the
+ * barrier, until the last route is programmed. Queued updates are kept
+ * per-table and the process applies them a slice of one table at a time,
+ * round-robin across the tables, holding the barrier only for each slice.
+ * The updates for a table are applied in the order they were queued.
+ */
+extern void fib_route_queue_add(u32 fib_index,
+                                const fib_prefix_t *prefix,
+                                u8 is_add,
+                                u8 is_multipath,
+                                fib_source_t src,
+                                fib_entry_flag_t entry_flags,
+                                const fib_route_path_t *rpaths,
+                                u32 request);
+
+/**
+ * @brief Called once all the updates queued for a request have been
+ * applied, or discarded with their table's queue. n_failed counts both
+ * the updates that failed and those discarded, rv is the error of the
+ * first of them.
+ */
+typedef void (*fib_route_queue_done_t)(u32 client_index,
+                                       u32 context,
+                                       u32 fib_index,
+                                       fib_protocol_t proto,
+                                       u32 n_applied,
+                                       u32 n_failed,
+                                       int rv);
+
+/**
+ * @brief Start a request, which the updates the client queues with
+ * fib_route_queue_add() belong to. The done callback is invoked once they
+ * have all been applied, and not at all if none were queued.
+ */
+extern u32 fib_route_queue_request_begin(fib_route_queue_done_t done,
+                                         u32 client_index,
+                                         u32 context);
+
+/**
+ * @brief No more updates are queued for the request
+ */
+extern void fib_route_queue_request_end(u32 request);
+
+/**
+ * @brief Discard the updates queued for a table
+ */
+extern void fib_route_queue_flush(u32 fib_index,
+                                  fib_protocol_t proto);
+
+/**
+ * @brief Apply now all the updates queued for a table, so that they do not
+ * later override an update the client makes to the table directly
+ */
+extern void fib_route_queue_drain(u32 fib_index,
+                                  fib_protocol_t proto);
+
+/**
+ * @brief The number of updates queued for all tables
+ */
+extern u32 fib_route_queue_n_pending(void);
+
+#endif
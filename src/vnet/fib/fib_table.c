@@ -22,9 +22,17 @@
 #include <vnet/fib/ip4_fib.h>
 #include <vnet/fib/ip6_fib.h>
 #include <vnet/fib/mpls_fib.h>
+#include <vnet/fib/fib_route_queue.h>
 
 const static char * fib_table_flags_strings[] = FIB_TABLE_ATTRIBUTES;
 
+/**
+ * Nesting depth of the current route batch and the covers, by entry
+ * index, whose covered entries must be re-evaluated when it ends.
+ */
+static u32 fib_table_batch_depth;
+static uword *fib_table_batch_covers;
+
 fib_table_t *
 fib_table_get (fib_node_index_t index,
 	       fib_protocol_t proto)
@@ -138,6 +146,44 @@ fib_table_get_less_specific (u32 fib_index,
 					  prefix));
 }
 
+void
+fib_table_batch_begin (void)
+{
+    vlib_smp_unsafe_warning();
+
+    fib_table_batch_depth++;
+}
+
+int
+fib_table_batch_is_active (void)
+{
+    return (0 != fib_table_batch_depth);
+}
+
+void
+fib_table_batch_end (void)
+{
+    fib_node_index_t fib_entry_index;
+
+    ASSERT(fib_table_batch_depth);
+
+    if (--fib_table_batch_depth)
+        return;
+
+    /*
+     * the walks below can remove entries, and so clear their bits,
+     * hence the bitmap is consumed one bit at a time
+     */
+    while (!clib_bitmap_is_zero(fib_table_batch_covers))
+    {
+        fib_entry_index = clib_bitmap_first_set(fib_table_batch_covers);
+        fib_table_batch_covers = clib_bitmap_set(fib_table_batch_covers,
+                                                 fib_entry_index, 0);
+
+        fib_entry_cover_change_check(fib_entry_index);
+    }
+}
+
 static void
 fib_table_entry_remove (fib_table_t *fib_table,
 			const fib_prefix_t *prefix,
@@ -147,6 +193,13 @@ fib_table_entry_remove (fib_table_t *fib_table,
 
     fib_table->ft_total_route_counts--;
 
+    /*
+     * the removal walks the entries this one covers, so there's
+     * nothing left to defer
+     */
+    fib_table_batch_covers = clib_bitmap_set(fib_table_batch_covers,
+                                             fib_entry_index, 0);
+
     switch (prefix->fp_proto)
     {
     case FIB_PROTOCOL_IP4:
@@ -206,7 +259,16 @@ fib_table_post_insert_actions (fib_table_t *fib_table,
          * beneficial since there are often many host entries sharing the
          * same cover (i.e. ADJ or RR sourced entries).
          */
-        if (!fib_entry_is_host(fib_entry_index))
+        if (fib_entry_is_host(fib_entry_index))
+            return;
+
+        if (fib_table_batch_depth)
+        {
+            fib_table_batch_covers =
+                clib_bitmap_set(fib_table_batch_covers,
+                                fib_entry_cover_index, 1);
+        }
+        else
         {
             fib_entry_cover_change_notify(fib_entry_cover_index,
                                           fib_entry_index);
@@ -259,10 +321,10 @@ fib_table_fwding_dpo_update (u32 fib_index,
     switch (prefix->fp_proto)
     {
     case FIB_PROTOCOL_IP4:
-	return (ip4_fib_table_fwding_dpo_update(ip4_fib_get(fib_index),
-						&prefix->fp_addr.ip4,
-						prefix->fp_len,
-						dpo));
+	return (ip4_fib_table_fwding_update(fib_index,
+					    &prefix->fp_addr.ip4,
+					    prefix->fp_len,
+					    dpo));
     case FIB_PROTOCOL_IP6:
 	return (ip6_fib_table_fwding_dpo_update(fib_index,
 						&prefix->fp_addr.ip6,
@@ -286,12 +348,12 @@ fib_table_fwding_dpo_remove (u32 fib_index,
     switch (prefix->fp_proto)
     {
     case FIB_PROTOCOL_IP4:
-	return (ip4_fib_table_fwding_dpo_remove(ip4_fib_get(fib_index),
-						&prefix->fp_addr.ip4,
-						prefix->fp_len,
-						dpo,
-                                                fib_table_get_less_specific(fib_index,
-                                                                            prefix)));
+	return (ip4_fib_table_fwding_remove(fib_index,
+					    &prefix->fp_addr.ip4,
+					    prefix->fp_len,
+					    dpo,
+					    fib_table_get_less_specific(fib_index,
+									prefix)));
     case FIB_PROTOCOL_IP6:
 	return (ip6_fib_table_fwding_dpo_remove(fib_index,
 						&prefix->fp_addr.ip6,
@@ -1378,7 +1440,13 @@ fib_table_unlock (u32 fib_index,
     fib_table = fib_table_get(fib_index, proto);
 
     if (source == FIB_SOURCE_API || source == FIB_SOURCE_CLI)
+    {
+        /*
+         * the client is done with the table, so too with its queued routes
+         */
+        fib_route_queue_flush(fib_index, proto);
         fib_table_lock_clear(fib_table, source);
+    }
     else
         fib_table_lock_dec(fib_table, source);
 
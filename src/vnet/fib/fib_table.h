@@ -177,6 +177,29 @@ extern fib_node_index_t fib_table_lookup_exact_match(u32 fib_index,
 extern fib_node_index_t fib_table_get_less_specific(u32 fib_index,
 						    const fib_prefix_t *prefix);
 
+/**
+ * @brief
+ *  Begin a batch of route updates.
+ *  Until the matching fib_table_batch_end() the re-evaluation of the
+ *  cover of entries that track the cover of a newly inserted prefix is
+ *  deferred, so that each such cover is walked once per batch, rather
+ *  than once per insert. Batches nest.
+ */
+extern void fib_table_batch_begin(void);
+
+/**
+ * @brief
+ *  End a batch of route updates, running the deferred cover walks
+ *  once the outermost batch ends.
+ */
+extern void fib_table_batch_end(void);
+
+/**
+ * @brief
+ *  Is a batch of route updates in progress
+ */
+extern int fib_table_batch_is_active(void);
+
 /**
  * @brief
  *  Add a 'special' entry to the FIB.
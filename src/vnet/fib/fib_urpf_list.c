@@ -154,6 +154,7 @@ void
 fib_urpf_list_bake (index_t ui)
 {
     fib_urpf_list_t *urpf;
+    u32 *swi;
 
     urpf = fib_urpf_list_get(ui);
 
@@ -176,6 +177,19 @@ fib_urpf_list_bake (index_t ui)
         vec_set_len (urpf->furpf_itfs, i+1);
       }
 
+    /*
+     * compile the interface bits the data-plane checks first
+     */
+    urpf->furpf_flags |= FIB_URPF_LIST_BITS_EXACT;
+
+    vec_foreach(swi, urpf->furpf_itfs)
+    {
+        urpf->furpf_itf_bits |= FIB_URPF_ITF_BIT(*swi);
+
+        if (*swi >= 64)
+            urpf->furpf_flags &= ~FIB_URPF_LIST_BITS_EXACT;
+    }
+
     urpf->furpf_flags |= FIB_URPF_LIST_BAKED;
 }
 
@@ -53,10 +53,27 @@ typedef enum fib_urpf_list_flag_t_
      * are not chunky fries - once is enough.
      */
     FIB_URPF_LIST_BAKED = (1 << 0),
+    /**
+     * @brief Set when all the interfaces in the list have an index less
+     * than 64, so the interface bits are an exact representation of it.
+     */
+    FIB_URPF_LIST_BITS_EXACT = (1 << 1),
 } fib_urpf_list_flag_t;
 
+/**
+ * @brief The bit for an interface in a uRPF list's interface bits
+ */
+#define FIB_URPF_ITF_BIT(_sw_if_index) (1ULL << ((_sw_if_index) & 63))
+
 typedef struct fib_urpf_list_t_
 {
+    /**
+     * The bits, FIB_URPF_ITF_BIT, of the interfaces in the list; set
+     * when the list is baked. An interface whose bit is clear is not in
+     * the list, so the data-plane need not walk it.
+     */
+    u64 furpf_itf_bits;
+
     /**
      * The list of interfaces that comprise the allowed accepting interfaces
      */
@@ -115,6 +132,14 @@ fib_urpf_check (index_t ui, u32 sw_if_index)
 
     urpf = fib_urpf_list_get(ui);
 
+    if (PREDICT_TRUE(urpf->furpf_flags & FIB_URPF_LIST_BAKED))
+    {
+        if (!(urpf->furpf_itf_bits & FIB_URPF_ITF_BIT(sw_if_index)))
+            return (0);
+        if (urpf->furpf_flags & FIB_URPF_LIST_BITS_EXACT)
+            return (sw_if_index < 64);
+    }
+
     vec_foreach(swi, urpf->furpf_itfs)
     {
 	if (*swi == sw_if_index)
@@ -143,6 +143,352 @@ ip4_fib_hash_flush_specials (u32 fib_index)
     }
 }
 
+/**
+ * An update to a table's mtrie that has been deferred to the background
+ * process. The LBs are locked until the workers can no longer see them.
+ */
+typedef struct ip4_fib_mtrie_update_t_ {
+    u32 imu_fib_index;
+    ip4_address_t imu_addr;
+    u8 imu_len;
+    u8 imu_is_add;
+    u8 imu_cover_len;
+    dpo_id_t imu_dpo;
+    dpo_id_t imu_cover_dpo;
+} ip4_fib_mtrie_update_t;
+
+/**
+ * The number of updates applied before the process yields
+ */
+#define IP4_FIB_MTRIE_UPDATE_QUOTA 1024
+
+typedef struct ip4_fib_mtrie_update_main_t_ {
+    /**
+     * Updates not yet applied, in order, from imum_head
+     */
+    ip4_fib_mtrie_update_t *imum_updates;
+    u32 imum_head;
+
+    /**
+     * Apply the updates made during a route batch from the process
+     */
+    int imum_background;
+
+    /**
+     * Stats
+     */
+    u64 imum_n_inline;
+    u64 imum_n_deferred;
+    f64 imum_drain_start;
+    u32 imum_drain_n;
+    u32 imum_last_n;
+    f64 imum_last_time;
+} ip4_fib_mtrie_update_main_t;
+
+static ip4_fib_mtrie_update_main_t ip4_fib_mtrie_update_main;
+
+ip4_mtrie_24_t **ip4_fib_mtrie_24s;
+
+vlib_node_registration_t ip4_fib_mtrie_update_node;
+
+static u32
+ip4_fib_mtrie_update_n_pending (void)
+{
+    ip4_fib_mtrie_update_main_t *imum = &ip4_fib_mtrie_update_main;
+
+    return (vec_len(imum->imum_updates) - imum->imum_head);
+}
+
+static void
+ip4_fib_mtrie_update_apply (const ip4_fib_mtrie_update_t *imu)
+{
+    ip4_fib_t *fib = ip4_fib_get(imu->imu_fib_index);
+
+    if (imu->imu_is_add)
+    {
+	ip4_mtrie_route_add(&fib->mtrie, &imu->imu_addr, imu->imu_len,
+			    imu->imu_dpo.dpoi_index);
+	if (NULL != fib->mtrie_24)
+	    ip4_mtrie_24_route_add(fib->mtrie_24, &imu->imu_addr,
+				   imu->imu_len, imu->imu_dpo.dpoi_index);
+    }
+    else
+    {
+	ip4_mtrie_route_del(&fib->mtrie, &imu->imu_addr, imu->imu_len,
+			    imu->imu_dpo.dpoi_index,
+			    imu->imu_cover_len,
+			    imu->imu_cover_dpo.dpoi_index);
+	if (NULL != fib->mtrie_24)
+	    ip4_mtrie_24_route_del(fib->mtrie_24, &imu->imu_addr,
+				   imu->imu_len, imu->imu_dpo.dpoi_index,
+				   imu->imu_cover_len,
+				   imu->imu_cover_dpo.dpoi_index);
+    }
+}
+
+/**
+ * Apply up to max of the pending updates. The workers forward on the
+ * mtrie throughout, so the plies and LBs the updates release are only
+ * freed once each worker has started a new loop.
+ */
+static void
+ip4_fib_mtrie_update_drain (vlib_main_t *vm, u32 max)
+{
+    ip4_fib_mtrie_update_main_t *imum = &ip4_fib_mtrie_update_main;
+    ip4_fib_mtrie_update_t *imu;
+    u32 ii, n;
+
+    n = clib_min(max, ip4_fib_mtrie_update_n_pending());
+
+    ip4_mtrie_ply_free_defer(1);
+    for (ii = imum->imum_head; ii < imum->imum_head + n; ii++)
+    {
+	ip4_fib_mtrie_update_apply(&imum->imum_updates[ii]);
+    }
+    ip4_mtrie_ply_free_defer(0);
+
+    vlib_worker_wait_one_loop();
+    ip4_mtrie_ply_free_flush();
+
+    /*
+     * releasing the LBs can release the adjacencies; do that as the
+     * rest of the control plane would, with the workers held
+     */
+    vlib_worker_thread_barrier_sync(vm);
+    for (ii = imum->imum_head; ii < imum->imum_head + n; ii++)
+    {
+	imu = &imum->imum_updates[ii];
+	dpo_reset(&imu->imu_dpo);
+	dpo_reset(&imu->imu_cover_dpo);
+    }
+    vlib_worker_thread_barrier_release(vm);
+
+    imum->imum_head += n;
+    imum->imum_drain_n += n;
+
+    if (0 == ip4_fib_mtrie_update_n_pending())
+    {
+	vec_reset_length(imum->imum_updates);
+	imum->imum_head = 0;
+	imum->imum_last_n = imum->imum_drain_n;
+	imum->imum_last_time = vlib_time_now(vm) - imum->imum_drain_start;
+	imum->imum_drain_n = 0;
+    }
+}
+
+void
+ip4_fib_mtrie_update_flush (void)
+{
+    vlib_main_t *vm = vlib_get_main();
+
+    while (ip4_fib_mtrie_update_n_pending())
+	ip4_fib_mtrie_update_drain(vm, ~0);
+}
+
+void
+ip4_fib_mtrie_update_set_background (int is_background)
+{
+    ip4_fib_mtrie_update_main_t *imum = &ip4_fib_mtrie_update_main;
+
+    imum->imum_background = is_background;
+
+    if (!is_background)
+	ip4_fib_mtrie_update_flush();
+}
+
+static ip4_fib_mtrie_update_t *
+ip4_fib_mtrie_update_enqueue (u32 fib_index,
+			      const ip4_address_t *addr,
+			      u32 len,
+			      const dpo_id_t *dpo)
+{
+    ip4_fib_mtrie_update_main_t *imum = &ip4_fib_mtrie_update_main;
+    vlib_main_t *vm = vlib_get_main();
+    ip4_fib_mtrie_update_t *imu;
+
+    if (0 == ip4_fib_mtrie_update_n_pending())
+    {
+	imum->imum_drain_start = vlib_time_now(vm);
+	vlib_process_signal_event(vm, ip4_fib_mtrie_update_node.index, 0, 0);
+    }
+
+    vec_add2(imum->imum_updates, imu, 1);
+    clib_memset(imu, 0, sizeof(*imu));
+
+    imu->imu_fib_index = fib_index;
+    imu->imu_addr = *addr;
+    imu->imu_len = len;
+    dpo_copy(&imu->imu_dpo, dpo);
+    imum->imum_n_deferred++;
+
+    return (imu);
+}
+
+/**
+ * Once deferred, all subsequent updates are too, so they apply in order
+ */
+static int
+ip4_fib_mtrie_update_defer (void)
+{
+    ip4_fib_mtrie_update_main_t *imum = &ip4_fib_mtrie_update_main;
+
+    return (imum->imum_background &&
+	    (fib_table_batch_is_active() ||
+	     ip4_fib_mtrie_update_n_pending()));
+}
+
+void
+ip4_fib_table_fwding_update (u32 fib_index,
+			     const ip4_address_t *addr,
+			     u32 len,
+			     const dpo_id_t *dpo)
+{
+    ip4_fib_mtrie_update_t *imu;
+
+    if (ip4_fib_mtrie_update_defer())
+    {
+	imu = ip4_fib_mtrie_update_enqueue(fib_index, addr, len, dpo);
+	imu->imu_is_add = 1;
+    }
+    else
+    {
+	ip4_fib_mtrie_update_main.imum_n_inline++;
+	ip4_fib_table_fwding_dpo_update(ip4_fib_get(fib_index),
+					addr, len, dpo);
+    }
+}
+
+void
+ip4_fib_table_fwding_remove (u32 fib_index,
+			     const ip4_address_t *addr,
+			     u32 len,
+			     const dpo_id_t *dpo,
+			     u32 cover_index)
+{
+    ip4_fib_mtrie_update_t *imu;
+
+    if (ip4_fib_mtrie_update_defer())
+    {
+	/*
+	 * the cover's forwarding is captured now, it may itself change
+	 * before the update is applied, but then that change is queued too
+	 */
+	imu = ip4_fib_mtrie_update_enqueue(fib_index, addr, len, dpo);
+	imu->imu_cover_len = fib_entry_get_prefix(cover_index)->fp_len;
+	dpo_copy(&imu->imu_cover_dpo,
+		 fib_entry_contribute_ip_forwarding(cover_index));
+    }
+    else
+    {
+	ip4_fib_mtrie_update_main.imum_n_inline++;
+	ip4_fib_table_fwding_dpo_remove(ip4_fib_get(fib_index),
+					addr, len, dpo, cover_index);
+    }
+}
+
+static uword
+ip4_fib_mtrie_update_process (vlib_main_t * vm,
+			      vlib_node_runtime_t * node,
+			      vlib_frame_t * f)
+{
+    while (1)
+    {
+	vlib_process_wait_for_event(vm);
+	vlib_process_get_events(vm, NULL);
+
+	while (ip4_fib_mtrie_update_n_pending())
+	{
+	    ip4_fib_mtrie_update_drain(vm, IP4_FIB_MTRIE_UPDATE_QUOTA);
+	    vlib_process_suspend(vm, 10e-6);
+	}
+    }
+
+    /*
+     * Unreached
+     */
+    return 0;
+}
+
+/* *INDENT-OFF* */
+VLIB_REGISTER_NODE (ip4_fib_mtrie_update_node) = {
+    .function = ip4_fib_mtrie_update_process,
+    .type = VLIB_NODE_TYPE_PROCESS,
+    .name = "ip4-mtrie-update",
+};
+/* *INDENT-ON* */
+
+static fib_table_walk_rc_t
+ip4_fib_mtrie_24_build_cb (fib_node_index_t fib_entry_index,
+                           void *arg)
+{
+    ip4_mtrie_24_t *mtrie = arg;
+    const fib_prefix_t *pfx;
+    const dpo_id_t *dpo;
+
+    /*
+     * only the entries with a load-balance are in the forwarding mtrie,
+     * the others contribute a drop
+     */
+    dpo = fib_entry_contribute_ip_forwarding(fib_entry_index);
+
+    if (DPO_LOAD_BALANCE == dpo->dpoi_type)
+    {
+        pfx = fib_entry_get_prefix(fib_entry_index);
+        ip4_mtrie_24_route_add(mtrie, &pfx->fp_addr.ip4, pfx->fp_len,
+                               dpo->dpoi_index);
+    }
+
+    return (FIB_TABLE_WALK_CONTINUE);
+}
+
+void
+ip4_fib_table_mtrie_24_enable (u32 fib_index)
+{
+    ip4_mtrie_24_t *mtrie;
+    ip4_fib_t *v4_fib;
+
+    v4_fib = ip4_fib_get(fib_index);
+
+    if (NULL != v4_fib->mtrie_24)
+        return;
+
+    /*
+     * build from the table as the mtrie sees it, i.e. with no updates
+     * pending, and populate the trie before the data-plane sees it.
+     * the insertion order does not matter to the trie.
+     */
+    ip4_fib_mtrie_update_flush();
+
+    mtrie = ip4_mtrie_24_alloc();
+    ip4_fib_table_walk(v4_fib, ip4_fib_mtrie_24_build_cb, mtrie);
+
+    v4_fib->mtrie_24 = mtrie;
+    clib_atomic_store_rel_n(&ip4_fib_mtrie_24s[fib_index], mtrie);
+}
+
+void
+ip4_fib_table_mtrie_24_disable (u32 fib_index)
+{
+    ip4_mtrie_24_t *mtrie;
+    ip4_fib_t *v4_fib;
+
+    v4_fib = ip4_fib_get(fib_index);
+    mtrie = v4_fib->mtrie_24;
+
+    if (NULL == mtrie)
+        return;
+
+    /*
+     * back to the mtrie, which is always kept up to date, then wait for
+     * the workers to finish any lookup in flight before freeing
+     */
+    clib_atomic_store_rel_n(&ip4_fib_mtrie_24s[fib_index], NULL);
+    v4_fib->mtrie_24 = NULL;
+    vlib_worker_wait_one_loop();
+
+    ip4_mtrie_24_free(mtrie);
+}
+
 static u32
 ip4_create_fib_with_table_id (u32 table_id,
                               fib_source_t src)
@@ -157,6 +503,7 @@ ip4_create_fib_with_table_id (u32 table_id,
 
     fib_table->ft_proto = FIB_PROTOCOL_IP4;
     fib_table->ft_index = (v4_fib - ip4_fibs);
+    vec_validate(ip4_fib_mtrie_24s, fib_table->ft_index);
 
     /*
      * It is required that the index of the fib_table_t in its pool
@@ -218,6 +565,12 @@ ip4_fib_table_destroy (u32 fib_index)
 
     vec_free (fib_table->ft_locks);
     vec_free(fib_table->ft_src_route_counts);
+
+    /*
+     * no deferred updates may refer to the table once it's gone
+     */
+    ip4_fib_mtrie_update_flush();
+    ip4_fib_table_mtrie_24_disable(fib_table->ft_index);
     ip4_fib_table_free(v4_fib);
 
     pool_put(ip4_fibs, v4_fib);
@@ -328,6 +681,53 @@ format_ip4_fib_table_memory (u8 * s, va_list * args)
     return (s);
 }
 
+/**
+ * The memory used by each table's mtrie per route, and the rate at which
+ * the deferred mtrie updates were last applied
+ */
+static clib_error_t *
+ip4_show_fib_mtrie_stats (vlib_main_t * vm)
+{
+    ip4_fib_mtrie_update_main_t *imum = &ip4_fib_mtrie_update_main;
+    fib_table_t *fib_table;
+    uword mtrie_size;
+    ip4_fib_t *fib;
+
+    vlib_cli_output(vm, "%=10s %=10s %=12s %=12s",
+		    "Table", "Routes", "Bytes", "Bytes/Route");
+
+    pool_foreach (fib_table, ip4_main.fibs)
+    {
+	fib = pool_elt_at_index(ip4_fibs, fib_table->ft_index);
+	mtrie_size = ip4_mtrie_memory_usage(&fib->mtrie);
+	if (NULL != fib->mtrie_24)
+	    mtrie_size += ip4_mtrie_24_memory_usage(fib->mtrie_24);
+
+	vlib_cli_output(vm, "%=10d %=10d %=12d %=12.1f",
+			fib_table->ft_table_id,
+			fib_table->ft_total_route_counts,
+			mtrie_size,
+			(fib_table->ft_total_route_counts ?
+			 (f64) mtrie_size / fib_table->ft_total_route_counts :
+			 0.0));
+    }
+
+    vlib_cli_output(vm, "plies: %d in use, %d allocated",
+		    pool_elts(ip4_ply_pool), pool_len(ip4_ply_pool));
+    vlib_cli_output(vm, "updates: %s, %lld inline, %lld deferred, %d pending",
+		    (imum->imum_background ? "background" : "inline"),
+		    imum->imum_n_inline, imum->imum_n_deferred,
+		    ip4_fib_mtrie_update_n_pending());
+    if (imum->imum_last_n)
+	vlib_cli_output(vm, "last drain: %d updates in %.6fs, %.2e updates/s",
+			imum->imum_last_n, imum->imum_last_time,
+			(imum->imum_last_time ?
+			 imum->imum_last_n / imum->imum_last_time :
+			 0.0));
+
+    return (NULL);
+}
+
 static clib_error_t *
 ip4_show_fib (vlib_main_t * vm,
 	      unformat_input_t * input,
@@ -354,6 +754,9 @@ ip4_show_fib (vlib_main_t * vm,
 	else if (unformat (input, "detail") || unformat (input, "det"))
 	    detail = 1;
 
+	else if (unformat (input, "mtrie-stats"))
+	    return (ip4_show_fib_mtrie_stats(vm));
+
 	else if (unformat (input, "mtrie"))
 	    mtrie = 1;
 
@@ -394,6 +797,8 @@ ip4_show_fib (vlib_main_t * vm,
 
 
             mtrie_size = ip4_mtrie_memory_usage(&fib->mtrie);
+            if (NULL != fib->mtrie_24)
+                mtrie_size += ip4_mtrie_24_memory_usage(fib->mtrie_24);
             hash_size = 0;
 
 	    for (i = 0; i < ARRAY_LEN (fib->hash.fib_entry_by_dst_address); i++)
@@ -416,14 +821,15 @@ ip4_show_fib (vlib_main_t * vm,
             continue;
         }
 
-	s = format(s, "%U, fib_index:%d, flow hash:[%U] epoch:%d flags:%U locks:[",
+	s = format(s, "%U, fib_index:%d, flow hash:[%U] epoch:%d flags:%U lookup:%s locks:[",
                    format_fib_table_name, fib_index,
                    FIB_PROTOCOL_IP4,
                    fib_index,
                    format_ip_flow_hash_config,
                    fib_table->ft_flow_hash_config,
                    fib_table->ft_epoch,
-                   format_fib_table_flags, fib_table->ft_flags);
+                   format_fib_table_flags, fib_table->ft_flags,
+                   (NULL != fib->mtrie_24 ? "dir-24-8" : "mtrie"));
         vec_foreach_index(source, fib_table->ft_locks)
         {
             if (0 != fib_table->ft_locks[source])
@@ -441,6 +847,9 @@ ip4_show_fib (vlib_main_t * vm,
 	if (mtrie)
         {
 	    vlib_cli_output (vm, "%U", format_ip4_mtrie, &fib->mtrie, verbose);
+	    if (NULL != fib->mtrie_24)
+		vlib_cli_output (vm, "%U", format_ip4_mtrie_24,
+				 fib->mtrie_24, verbose);
             continue;
         }
 	if (! verbose)
@@ -620,11 +1029,110 @@ ip4_show_fib (vlib_main_t * vm,
  *                   24               2
  *                   32               4
  * @cliexend
+ * Example of how to display the memory the mtries use per route and the
+ * rate of the mtrie updates, see 'set ip fib mtrie-update':
+ * @cliexstart{show ip fib mtrie-stats}
+ *   Table      Routes      Bytes      Bytes/Route
+ *     0        100009     861248         8.6
+ * plies: 398 in use, 398 allocated
+ * updates: background, 9 inline, 100000 deferred, 0 pending
+ * last drain: 100000 updates in 1.027380s, 9.73e4 updates/s
+ * @cliexend
  ?*/
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (ip4_show_fib_command, static) = {
     .path = "show ip fib",
-    .short_help = "show ip fib [summary] [table <table-id>] [index <fib-id>] [<ip4-addr>[/<mask>]] [mtrie] [detail]",
+    .short_help = "show ip fib [summary] [table <table-id>] [index <fib-id>] [<ip4-addr>[/<mask>]] [mtrie] [mtrie-stats] [detail]",
     .function = ip4_show_fib,
 };
 /* *INDENT-ON* */
+
+static clib_error_t *
+ip4_fib_mtrie_update_set (vlib_main_t * vm,
+			  unformat_input_t * input,
+			  vlib_cli_command_t * cmd)
+{
+    if (unformat (input, "background"))
+	ip4_fib_mtrie_update_set_background(1);
+    else if (unformat (input, "inline"))
+	ip4_fib_mtrie_update_set_background(0);
+    else
+	return (clib_error_return (0, "unknown input `%U'",
+				   format_unformat_error, input));
+
+    return (NULL);
+}
+
+/*?
+ * This command selects how the IPv4 forwarding mtries are updated for
+ * the routes added and removed in a batch, e.g. by the bulk route API.
+ * Inline, the default, updates the mtrie as each route changes. In the
+ * background the updates are applied in order by a process, a chunk at
+ * a time, without holding the workers, who forward on the old state
+ * until each update is applied. Until then 'show ip fib' shows the
+ * routes as they are in the table, not as they are in the mtrie.
+ *
+ * @cliexpar
+ * @cliexcmd{set ip fib mtrie-update background}
+ ?*/
+/* *INDENT-OFF* */
+VLIB_CLI_COMMAND (ip4_fib_mtrie_update_set_command, static) = {
+    .path = "set ip fib mtrie-update",
+    .short_help = "set ip fib mtrie-update [background|inline]",
+    .function = ip4_fib_mtrie_update_set,
+};
+/* *INDENT-ON* */
+
+static clib_error_t *
+ip4_fib_lookup_set (vlib_main_t * vm,
+                    unformat_input_t * input,
+                    vlib_cli_command_t * cmd)
+{
+    u32 table_id = 0, fib_index;
+    int enable = -1;
+
+    while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+	if (unformat (input, "table %d", &table_id))
+	    ;
+	else if (unformat (input, "dir-24-8"))
+	    enable = 1;
+	else if (unformat (input, "mtrie"))
+	    enable = 0;
+	else
+	    return (clib_error_return (0, "unknown input '%U'",
+                                       format_unformat_error, input));
+    }
+
+    if (-1 == enable)
+        return (clib_error_return (0, "specify dir-24-8 or mtrie"));
+
+    fib_index = ip4_fib_index_from_table_id(table_id);
+
+    if (~0 == fib_index)
+        return (clib_error_return (0, "no such table %d", table_id));
+
+    if (enable)
+        ip4_fib_table_mtrie_24_enable(fib_index);
+    else
+        ip4_fib_table_mtrie_24_disable(fib_index);
+
+    return (NULL);
+}
+
+/*?
+ * Select the data-plane lookup for an IPv4 table. By default a table is
+ * looked up in its 16-8-8 stride mtrie, three memory accesses for a /32.
+ * With 'dir-24-8' the table also maintains a 24-8 stride mtrie that
+ * serves its lookups: one memory access for prefixes up to /24, two for
+ * longer ones, at the cost of 80MB per table (from hugepages when there
+ * are any) plus 1344 bytes per /24 holding longer prefixes.
+ *
+ * @cliexpar
+ * @cliexcmd{set ip fib lookup table 0 dir-24-8}
+ ?*/
+VLIB_CLI_COMMAND (ip4_fib_lookup_set_command, static) = {
+    .path = "set ip fib lookup",
+    .short_help = "set ip fib lookup [table <table-id>] dir-24-8|mtrie",
+    .function = ip4_fib_lookup_set,
+};
@@ -43,7 +43,7 @@
 /**
  * the FIB module uses the 16-8-8 stride trie
  */
-#ifdef VPP_IP_FIB_MTRIE_16
+#if defined(VPP_IP_FIB_MTRIE_16)
 typedef ip4_fib_16_t ip4_fib_t;
 
 #define ip4_fibs ip4_fib_16s
@@ -58,6 +58,8 @@ typedef ip4_fib_16_t ip4_fib_t;
 #define ip4_fib_table_sub_tree_walk ip4_fib_16_table_sub_tree_walk
 #define ip4_fib_table_init ip4_fib_16_table_init
 #define ip4_fib_table_free ip4_fib_16_table_free
+#define ip4_mtrie_route_add ip4_mtrie_16_route_add
+#define ip4_mtrie_route_del ip4_mtrie_16_route_del
 #define ip4_mtrie_memory_usage ip4_mtrie_16_memory_usage
 #define format_ip4_mtrie format_ip4_mtrie_16
 
@@ -76,6 +78,8 @@ typedef ip4_fib_8_t ip4_fib_t;
 #define ip4_fib_table_sub_tree_walk ip4_fib_8_table_sub_tree_walk
 #define ip4_fib_table_init ip4_fib_8_table_init
 #define ip4_fib_table_free ip4_fib_8_table_free
+#define ip4_mtrie_route_add ip4_mtrie_8_route_add
+#define ip4_mtrie_route_del ip4_mtrie_8_route_del
 #define ip4_mtrie_memory_usage ip4_mtrie_8_memory_usage
 #define format_ip4_mtrie format_ip4_mtrie_8
 
@@ -117,6 +121,45 @@ extern void ip4_fib_table_destroy(u32 fib_index);
 
 extern u8 *format_ip4_fib_table_memory(u8 * s, va_list * args);
 
+/**
+ * @brief Update/remove a prefix in the table's forwarding mtrie.
+ * During a route batch (see fib_table_batch_begin) the mtrie can be updated
+ * later by a background process, so the workers continue to forward on
+ * the old state meanwhile.
+ */
+extern void ip4_fib_table_fwding_update(u32 fib_index,
+                                        const ip4_address_t *addr,
+                                        u32 len,
+                                        const dpo_id_t *dpo);
+extern void ip4_fib_table_fwding_remove(u32 fib_index,
+                                        const ip4_address_t *addr,
+                                        u32 len,
+                                        const dpo_id_t *dpo,
+                                        u32 cover_index);
+
+/**
+ * @brief Give a table a DIR-24-8 mtrie, built from its forwarding, to
+ * serve its data-plane lookups; or go back to the default mtrie.
+ * The 80MB root is only paid by the tables that opt in.
+ */
+extern void ip4_fib_table_mtrie_24_enable(u32 fib_index);
+extern void ip4_fib_table_mtrie_24_disable(u32 fib_index);
+
+/**
+ * @brief Apply the mtrie updates from route batches in a background
+ * process rather than inline (see 'set ip fib mtrie-update').
+ */
+extern void ip4_fib_mtrie_update_set_background(int is_background);
+
+/**
+ * @brief Apply all pending background mtrie updates now.
+ * ip4_fib_forwarding_lookup() returns what the data-plane would, so while
+ * updates are pending it can disagree with the table. The control-plane
+ * should look up the table (ip4_fib_table_lookup, fib_table_lookup), or
+ * flush first if it needs the data-plane's answer to be current.
+ */
+extern void ip4_fib_mtrie_update_flush(void);
+
 static inline 
 u32 ip4_fib_index_from_table_id (u32 table_id)
 {
@@ -132,18 +175,78 @@ u32 ip4_fib_index_from_table_id (u32 table_id)
 
 extern u32 ip4_fib_table_get_index_for_sw_if_index(u32 sw_if_index);
 
-#ifdef VPP_IP_FIB_MTRIE_16
+/**
+ * @brief The tables' opt-in DIR-24-8 mtries, by fib index.
+ * The pointers are kept apart from the tables, whose mtrie root is 256KB
+ * for the 16-8-8 stride, so that finding out which mtrie serves a lookup
+ * costs a read of this small vector, in cache, not of the table.
+ */
+extern ip4_mtrie_24_t **ip4_fib_mtrie_24s;
+
+/**
+ * @brief A table's opt-in DIR-24-8 mtrie, or NULL.
+ * It is published and withdrawn while the workers forward, see
+ * ip4_fib_table_mtrie_24_enable/disable.
+ */
+always_inline const ip4_mtrie_24_t *
+ip4_fib_mtrie_24_get (u32 fib_index)
+{
+    return (clib_atomic_load_acq_n(&ip4_fib_mtrie_24s[fib_index]));
+}
+
+always_inline index_t
+ip4_fib_mtrie_24_forwarding_lookup (const ip4_mtrie_24_t *mtrie,
+                                    const ip4_address_t * addr)
+{
+    ip4_mtrie_leaf_t leaf;
+
+    leaf = ip4_mtrie_24_lookup_step_one (mtrie, addr);
+    leaf = ip4_mtrie_24_lookup_step (leaf, addr);
+
+    return (ip4_mtrie_leaf_get_adj_index(leaf));
+}
+
+/*
+ * The first two steps of a lookup are in the table's DIR-24-8 mtrie if it
+ * has one, else in its mtrie. The DIR-24-8 lookup is then complete and its
+ * leaf terminal, which the mtrie's remaining steps pass on as it is; so
+ * lookups in tables of either kind can be interleaved.
+ */
+#if defined(VPP_IP_FIB_MTRIE_16)
+always_inline ip4_mtrie_leaf_t
+ip4_fib_forwarding_lookup_step_one (u32 fib_index,
+                                    const ip4_mtrie_24_t *mtrie_24,
+                                    const ip4_address_t * addr)
+{
+    if (PREDICT_FALSE(NULL != mtrie_24))
+        return (ip4_mtrie_24_lookup_step_one (mtrie_24, addr));
+
+    return (ip4_mtrie_16_lookup_step_one (&ip4_fib_get(fib_index)->mtrie,
+                                          addr));
+}
+
+always_inline ip4_mtrie_leaf_t
+ip4_fib_forwarding_lookup_step_two (const ip4_mtrie_24_t *mtrie_24,
+                                    ip4_mtrie_leaf_t leaf,
+                                    const ip4_address_t * addr)
+{
+    if (PREDICT_FALSE(NULL != mtrie_24))
+        return (ip4_mtrie_24_lookup_step (leaf, addr));
+
+    return (ip4_mtrie_16_lookup_step (leaf, addr, 2));
+}
+
 always_inline index_t
 ip4_fib_forwarding_lookup (u32 fib_index,
                            const ip4_address_t * addr)
 {
+    const ip4_mtrie_24_t * mtrie_24;
     ip4_mtrie_leaf_t leaf;
-    ip4_mtrie_16_t * mtrie;
 
-    mtrie = &ip4_fib_get(fib_index)->mtrie;
+    mtrie_24 = ip4_fib_mtrie_24_get(fib_index);
 
-    leaf = ip4_mtrie_16_lookup_step_one (mtrie, addr);
-    leaf = ip4_mtrie_16_lookup_step (leaf, addr, 2);
+    leaf = ip4_fib_forwarding_lookup_step_one (fib_index, mtrie_24, addr);
+    leaf = ip4_fib_forwarding_lookup_step_two (mtrie_24, leaf, addr);
     leaf = ip4_mtrie_16_lookup_step (leaf, addr, 3);
 
     return (ip4_mtrie_leaf_get_adj_index(leaf));
@@ -157,16 +260,18 @@ ip4_fib_forwarding_lookup_x2 (u32 fib_index0,
                               index_t *lb0,
                               index_t *lb1)
 {
+    const ip4_mtrie_24_t * mtrie_24[2];
     ip4_mtrie_leaf_t leaf[2];
-    ip4_mtrie_16_t * mtrie[2];
 
-    mtrie[0] = &ip4_fib_get(fib_index0)->mtrie;
-    mtrie[1] = &ip4_fib_get(fib_index1)->mtrie;
+    mtrie_24[0] = ip4_fib_mtrie_24_get(fib_index0);
+    mtrie_24[1] = ip4_fib_mtrie_24_get(fib_index1);
 
-    leaf[0] = ip4_mtrie_16_lookup_step_one (mtrie[0], addr0);
-    leaf[1] = ip4_mtrie_16_lookup_step_one (mtrie[1], addr1);
-    leaf[0] = ip4_mtrie_16_lookup_step (leaf[0], addr0, 2);
-    leaf[1] = ip4_mtrie_16_lookup_step (leaf[1], addr1, 2);
+    leaf[0] = ip4_fib_forwarding_lookup_step_one (fib_index0, mtrie_24[0],
+                                                  addr0);
+    leaf[1] = ip4_fib_forwarding_lookup_step_one (fib_index1, mtrie_24[1],
+                                                  addr1);
+    leaf[0] = ip4_fib_forwarding_lookup_step_two (mtrie_24[0], leaf[0], addr0);
+    leaf[1] = ip4_fib_forwarding_lookup_step_two (mtrie_24[1], leaf[1], addr1);
     leaf[0] = ip4_mtrie_16_lookup_step (leaf[0], addr0, 3);
     leaf[1] = ip4_mtrie_16_lookup_step (leaf[1], addr1, 3);
 
@@ -188,23 +293,27 @@ ip4_fib_forwarding_lookup_x4 (u32 fib_index0,
                               index_t *lb2,
                               index_t *lb3)
 {
+    const ip4_mtrie_24_t * mtrie_24[4];
     ip4_mtrie_leaf_t leaf[4];
-    ip4_mtrie_16_t * mtrie[4];
-
-    mtrie[0] = &ip4_fib_get(fib_index0)->mtrie;
-    mtrie[1] = &ip4_fib_get(fib_index1)->mtrie;
-    mtrie[2] = &ip4_fib_get(fib_index2)->mtrie;
-    mtrie[3] = &ip4_fib_get(fib_index3)->mtrie;
-
-    leaf[0] = ip4_mtrie_16_lookup_step_one (mtrie[0], addr0);
-    leaf[1] = ip4_mtrie_16_lookup_step_one (mtrie[1], addr1);
-    leaf[2] = ip4_mtrie_16_lookup_step_one (mtrie[2], addr2);
-    leaf[3] = ip4_mtrie_16_lookup_step_one (mtrie[3], addr3);
 
-    leaf[0] = ip4_mtrie_16_lookup_step (leaf[0], addr0, 2);
-    leaf[1] = ip4_mtrie_16_lookup_step (leaf[1], addr1, 2);
-    leaf[2] = ip4_mtrie_16_lookup_step (leaf[2], addr2, 2);
-    leaf[3] = ip4_mtrie_16_lookup_step (leaf[3], addr3, 2);
+    mtrie_24[0] = ip4_fib_mtrie_24_get(fib_index0);
+    mtrie_24[1] = ip4_fib_mtrie_24_get(fib_index1);
+    mtrie_24[2] = ip4_fib_mtrie_24_get(fib_index2);
+    mtrie_24[3] = ip4_fib_mtrie_24_get(fib_index3);
+
+    leaf[0] = ip4_fib_forwarding_lookup_step_one (fib_index0, mtrie_24[0],
+                                                  addr0);
+    leaf[1] = ip4_fib_forwarding_lookup_step_one (fib_index1, mtrie_24[1],
+                                                  addr1);
+    leaf[2] = ip4_fib_forwarding_lookup_step_one (fib_index2, mtrie_24[2],
+                                                  addr2);
+    leaf[3] = ip4_fib_forwarding_lookup_step_one (fib_index3, mtrie_24[3],
+                                                  addr3);
+
+    leaf[0] = ip4_fib_forwarding_lookup_step_two (mtrie_24[0], leaf[0], addr0);
+    leaf[1] = ip4_fib_forwarding_lookup_step_two (mtrie_24[1], leaf[1], addr1);
+    leaf[2] = ip4_fib_forwarding_lookup_step_two (mtrie_24[2], leaf[2], addr2);
+    leaf[3] = ip4_fib_forwarding_lookup_step_two (mtrie_24[3], leaf[3], addr3);
 
     leaf[0] = ip4_mtrie_16_lookup_step (leaf[0], addr0, 3);
     leaf[1] = ip4_mtrie_16_lookup_step (leaf[1], addr1, 3);
@@ -219,17 +328,40 @@ ip4_fib_forwarding_lookup_x4 (u32 fib_index0,
 
 #else
 
+always_inline ip4_mtrie_leaf_t
+ip4_fib_forwarding_lookup_step_one (u32 fib_index,
+                                    const ip4_mtrie_24_t *mtrie_24,
+                                    const ip4_address_t * addr)
+{
+    if (PREDICT_FALSE(NULL != mtrie_24))
+        return (ip4_mtrie_24_lookup_step_one (mtrie_24, addr));
+
+    return (ip4_mtrie_8_lookup_step_one (&ip4_fib_get(fib_index)->mtrie,
+                                         addr));
+}
+
+always_inline ip4_mtrie_leaf_t
+ip4_fib_forwarding_lookup_step_two (const ip4_mtrie_24_t *mtrie_24,
+                                    ip4_mtrie_leaf_t leaf,
+                                    const ip4_address_t * addr)
+{
+    if (PREDICT_FALSE(NULL != mtrie_24))
+        return (ip4_mtrie_24_lookup_step (leaf, addr));
+
+    return (ip4_mtrie_8_lookup_step (leaf, addr, 1));
+}
+
 always_inline index_t
 ip4_fib_forwarding_lookup (u32 fib_index,
                            const ip4_address_t * addr)
 {
+    const ip4_mtrie_24_t * mtrie_24;
     ip4_mtrie_leaf_t leaf;
-    ip4_mtrie_8_t * mtrie;
 
-    mtrie = &ip4_fib_get(fib_index)->mtrie;
+    mtrie_24 = ip4_fib_mtrie_24_get(fib_index);
 
-    leaf = ip4_mtrie_8_lookup_step_one (mtrie, addr);
-    leaf = ip4_mtrie_8_lookup_step (leaf, addr, 1);
+    leaf = ip4_fib_forwarding_lookup_step_one (fib_index, mtrie_24, addr);
+    leaf = ip4_fib_forwarding_lookup_step_two (mtrie_24, leaf, addr);
     leaf = ip4_mtrie_8_lookup_step (leaf, addr, 2);
     leaf = ip4_mtrie_8_lookup_step (leaf, addr, 3);
 
@@ -244,16 +376,18 @@ ip4_fib_forwarding_lookup_x2 (u32 fib_index0,
                               index_t *lb0,
                               index_t *lb1)
 {
+    const ip4_mtrie_24_t * mtrie_24[2];
     ip4_mtrie_leaf_t leaf[2];
-    ip4_mtrie_8_t * mtrie[2];
 
-    mtrie[0] = &ip4_fib_get(fib_index0)->mtrie;
-    mtrie[1] = &ip4_fib_get(fib_index1)->mtrie;
+    mtrie_24[0] = ip4_fib_mtrie_24_get(fib_index0);
+    mtrie_24[1] = ip4_fib_mtrie_24_get(fib_index1);
 
-    leaf[0] = ip4_mtrie_8_lookup_step_one (mtrie[0], addr0);
-    leaf[1] = ip4_mtrie_8_lookup_step_one (mtrie[1], addr1);
-    leaf[0] = ip4_mtrie_8_lookup_step (leaf[0], addr0, 1);
-    leaf[1] = ip4_mtrie_8_lookup_step (leaf[1], addr1, 1);
+    leaf[0] = ip4_fib_forwarding_lookup_step_one (fib_index0, mtrie_24[0],
+                                                  addr0);
+    leaf[1] = ip4_fib_forwarding_lookup_step_one (fib_index1, mtrie_24[1],
+                                                  addr1);
+    leaf[0] = ip4_fib_forwarding_lookup_step_two (mtrie_24[0], leaf[0], addr0);
+    leaf[1] = ip4_fib_forwarding_lookup_step_two (mtrie_24[1], leaf[1], addr1);
     leaf[0] = ip4_mtrie_8_lookup_step (leaf[0], addr0, 2);
     leaf[1] = ip4_mtrie_8_lookup_step (leaf[1], addr1, 2);
     leaf[0] = ip4_mtrie_8_lookup_step (leaf[0], addr0, 3);
@@ -277,23 +411,27 @@ ip4_fib_forwarding_lookup_x4 (u32 fib_index0,
                               index_t *lb2,
                               index_t *lb3)
 {
+    const ip4_mtrie_24_t * mtrie_24[4];
     ip4_mtrie_leaf_t leaf[4];
-    ip4_mtrie_8_t * mtrie[4];
-
-    mtrie[0] = &ip4_fib_get(fib_index0)->mtrie;
-    mtrie[1] = &ip4_fib_get(fib_index1)->mtrie;
-    mtrie[2] = &ip4_fib_get(fib_index2)->mtrie;
-    mtrie[3] = &ip4_fib_get(fib_index3)->mtrie;
-
-    leaf[0] = ip4_mtrie_8_lookup_step_one (mtrie[0], addr0);
-    leaf[1] = ip4_mtrie_8_lookup_step_one (mtrie[1], addr1);
-    leaf[2] = ip4_mtrie_8_lookup_step_one (mtrie[2], addr2);
-    leaf[3] = ip4_mtrie_8_lookup_step_one (mtrie[3], addr3);
-
-    leaf[0] = ip4_mtrie_8_lookup_step (leaf[0], addr0, 1);
-    leaf[1] = ip4_mtrie_8_lookup_step (leaf[1], addr1, 1);
-    leaf[2] = ip4_mtrie_8_lookup_step (leaf[2], addr2, 1);
-    leaf[3] = ip4_mtrie_8_lookup_step (leaf[3], addr3, 1);
+
+    mtrie_24[0] = ip4_fib_mtrie_24_get(fib_index0);
+    mtrie_24[1] = ip4_fib_mtrie_24_get(fib_index1);
+    mtrie_24[2] = ip4_fib_mtrie_24_get(fib_index2);
+    mtrie_24[3] = ip4_fib_mtrie_24_get(fib_index3);
+
+    leaf[0] = ip4_fib_forwarding_lookup_step_one (fib_index0, mtrie_24[0],
+                                                  addr0);
+    leaf[1] = ip4_fib_forwarding_lookup_step_one (fib_index1, mtrie_24[1],
+                                                  addr1);
+    leaf[2] = ip4_fib_forwarding_lookup_step_one (fib_index2, mtrie_24[2],
+                                                  addr2);
+    leaf[3] = ip4_fib_forwarding_lookup_step_one (fib_index3, mtrie_24[3],
+                                                  addr3);
+
+    leaf[0] = ip4_fib_forwarding_lookup_step_two (mtrie_24[0], leaf[0], addr0);
+    leaf[1] = ip4_fib_forwarding_lookup_step_two (mtrie_24[1], leaf[1], addr1);
+    leaf[2] = ip4_fib_forwarding_lookup_step_two (mtrie_24[2], leaf[2], addr2);
+    leaf[3] = ip4_fib_forwarding_lookup_step_two (mtrie_24[3], leaf[3], addr3);
 
     leaf[0] = ip4_mtrie_8_lookup_step (leaf[0], addr0, 2);
     leaf[1] = ip4_mtrie_8_lookup_step (leaf[1], addr1, 2);
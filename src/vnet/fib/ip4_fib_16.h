@@ -44,6 +44,14 @@ typedef struct ip4_fib_16_t_
    */
   ip4_mtrie_16_t mtrie;
 
+  /**
+   * The table's opt-in DIR-24-8 mtrie, NULL if not enabled. When present it
+   * is kept up to date alongside the mtrie and serves the lookups. The
+   * data-plane reads it from ip4_fib_mtrie_24s, which is dense and hot,
+   * rather than from here, past the mtrie's root.
+   */
+  ip4_mtrie_24_t *mtrie_24;
+
   /**
    * The hash table DB
    */
@@ -93,6 +93,9 @@ ip4_fib_8_table_fwding_dpo_update (ip4_fib_8_t *fib,
                                    const dpo_id_t *dpo)
 {
     ip4_mtrie_8_route_add(&fib->mtrie, addr, len, dpo->dpoi_index);
+
+    if (NULL != fib->mtrie_24)
+        ip4_mtrie_24_route_add(fib->mtrie_24, addr, len, dpo->dpoi_index);
 }
 
 void
@@ -117,6 +120,12 @@ ip4_fib_8_table_fwding_dpo_remove (ip4_fib_8_t *fib,
                             addr, len, dpo->dpoi_index,
                             cover_prefix->fp_len,
                             cover_dpo->dpoi_index);
+
+    if (NULL != fib->mtrie_24)
+        ip4_mtrie_24_route_del(fib->mtrie_24,
+                               addr, len, dpo->dpoi_index,
+                               cover_prefix->fp_len,
+                               cover_dpo->dpoi_index);
 }
 
 void
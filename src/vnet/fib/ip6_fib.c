@@ -25,6 +25,8 @@ ip6_fib_table_instance_t ip6_fib_table[IP6_FIB_NUM_TABLES];
 /* ip6 lookup table config parameters */
 u32 ip6_fib_table_nbuckets;
 uword ip6_fib_table_size;
+/* new tables use an mtrie for forwarding */
+u8 ip6_fib_table_mtrie_default;
 
 static void
 vnet_ip6_fib_init (u32 fib_index)
@@ -92,6 +94,13 @@ create_fib_with_table_id (u32 table_id,
     fib_table->ft_flags = flags;
     fib_table->ft_desc = desc;
 
+    /*
+     * link-local tables hold a handful of host routes per interface, the
+     * hash lookup is as fast and the 320KB root ply would be wasted
+     */
+    if (ip6_fib_table_mtrie_default && !(flags & FIB_TABLE_FLAG_IP6_LL))
+        v6_fib->mtrie = ip6_mtrie_alloc();
+
     vnet_ip6_fib_init(fib_table->ft_index);
     fib_table_lock(fib_table->ft_index, FIB_PROTOCOL_IP6, src);
 
@@ -176,6 +185,7 @@ ip6_fib_table_destroy (u32 fib_index)
     }
     vec_free (fib_table->ft_locks);
     vec_free(fib_table->ft_src_route_counts);
+    ip6_fib_table_mtrie_disable(fib_table->ft_index);
     pool_put_index(ip6_main.v6_fibs, fib_table->ft_index);
     pool_put(ip6_main.fibs, fib_table);
 }
@@ -373,6 +383,7 @@ ip6_fib_table_fwding_dpo_update (u32 fib_index,
     ip6_fib_table_instance_t *table;
     clib_bihash_kv_24_8_t kv;
     ip6_address_t *mask;
+    ip6_fib_t *v6_fib;
     u64 fib;
 
     table = &ip6_fib_table[IP6_FIB_TABLE_FWDING];
@@ -386,6 +397,11 @@ ip6_fib_table_fwding_dpo_update (u32 fib_index,
 
     clib_bihash_add_del_24_8(&table->ip6_hash, &kv, 1);
 
+    v6_fib = ip6_fib_get(fib_index);
+
+    if (NULL != v6_fib->mtrie)
+        ip6_mtrie_route_add(v6_fib->mtrie, addr, len, dpo->dpoi_index);
+
     if (0 == table->dst_address_length_refcounts[len]++)
     {
         table->non_empty_dst_address_length_bitmap =
@@ -404,6 +420,7 @@ ip6_fib_table_fwding_dpo_remove (u32 fib_index,
     ip6_fib_table_instance_t *table;
     clib_bihash_kv_24_8_t kv;
     ip6_address_t *mask;
+    ip6_fib_t *v6_fib;
     u64 fib;
 
     table = &ip6_fib_table[IP6_FIB_TABLE_FWDING];
@@ -417,6 +434,30 @@ ip6_fib_table_fwding_dpo_remove (u32 fib_index,
 
     clib_bihash_add_del_24_8(&table->ip6_hash, &kv, 0);
 
+    v6_fib = ip6_fib_get(fib_index);
+
+    if (NULL != v6_fib->mtrie)
+    {
+        const fib_prefix_t pfx = {
+            .fp_proto = FIB_PROTOCOL_IP6,
+            .fp_len = len,
+            .fp_addr.ip6 = *addr,
+        };
+        fib_node_index_t cover_index;
+        const dpo_id_t *cover_dpo;
+
+        /*
+         * As for the IPv4 mtrie, the plys are refilled with the LB and
+         * length of the covering prefix
+         */
+        cover_index = fib_table_get_less_specific(fib_index, &pfx);
+        cover_dpo = fib_entry_contribute_ip_forwarding(cover_index);
+
+        ip6_mtrie_route_del(v6_fib->mtrie, addr, len, dpo->dpoi_index,
+                            fib_entry_get_prefix(cover_index)->fp_len,
+                            cover_dpo->dpoi_index);
+    }
+
     /* refcount accounting */
     ASSERT (table->dst_address_length_refcounts[len] > 0);
     if (--table->dst_address_length_refcounts[len] == 0)
@@ -428,6 +469,84 @@ ip6_fib_table_fwding_dpo_remove (u32 fib_index,
     }
 }
 
+typedef struct ip6_fib_mtrie_build_ctx_t_
+{
+    u32 fib_index;
+    ip6_mtrie_t *mtrie;
+} ip6_fib_mtrie_build_ctx_t;
+
+static int
+ip6_fib_mtrie_build_cb (clib_bihash_kv_24_8_t * kvp,
+                        void *arg)
+{
+    ip6_fib_mtrie_build_ctx_t *ctx = arg;
+    ip6_address_t addr;
+
+    if ((kvp->key[2] >> 32) == ctx->fib_index)
+    {
+        addr.as_u64[0] = kvp->key[0];
+        addr.as_u64[1] = kvp->key[1];
+
+        ip6_mtrie_route_add(ctx->mtrie, &addr,
+                            kvp->key[2] & 0xffffffff,
+                            kvp->value);
+    }
+
+    return (BIHASH_WALK_CONTINUE);
+}
+
+void
+ip6_fib_table_mtrie_enable (u32 fib_index)
+{
+    ip6_fib_mtrie_build_ctx_t ctx = {
+        .fib_index = fib_index,
+    };
+    ip6_fib_t *v6_fib;
+
+    v6_fib = ip6_fib_get(fib_index);
+
+    if (NULL != v6_fib->mtrie)
+        return;
+    if (fib_table_get(fib_index, FIB_PROTOCOL_IP6)->ft_flags &
+        FIB_TABLE_FLAG_IP6_LL)
+        return;
+
+    /*
+     * populate the trie from the forwarding hash before the data-plane
+     * sees it. the insertion order does not matter to the trie.
+     */
+    ctx.mtrie = ip6_mtrie_alloc();
+
+    clib_bihash_foreach_key_value_pair_24_8(
+        &ip6_fib_table[IP6_FIB_TABLE_FWDING].ip6_hash,
+        ip6_fib_mtrie_build_cb,
+        &ctx);
+
+    clib_atomic_store_rel_n(&v6_fib->mtrie, ctx.mtrie);
+}
+
+void
+ip6_fib_table_mtrie_disable (u32 fib_index)
+{
+    ip6_mtrie_t *mtrie;
+    ip6_fib_t *v6_fib;
+
+    v6_fib = ip6_fib_get(fib_index);
+    mtrie = v6_fib->mtrie;
+
+    if (NULL == mtrie)
+        return;
+
+    /*
+     * back to the hash, which is always kept up to date, then wait for
+     * the workers to finish any lookup in flight before freeing
+     */
+    clib_atomic_store_rel_n(&v6_fib->mtrie, NULL);
+    vlib_worker_wait_one_loop();
+
+    ip6_mtrie_free(mtrie);
+}
+
 /**
  * @brief Context when walking the IPv6 table. Since all VRFs are in the
  * same hash table, we need to filter only those we need as we walk
@@ -649,6 +768,7 @@ ip6_show_fib (vlib_main_t * vm,
     int table_id = -1, fib_index = ~0;
     int detail = 0;
     int hash = 0;
+    int mtrie = 0;
 
     verbose = 1;
     matching = 0;
@@ -669,6 +789,9 @@ ip6_show_fib (vlib_main_t * vm,
                  unformat (input, "memory"))
 	    hash = 1;
 
+	else if (unformat (input, "mtrie"))
+	    mtrie = 1;
+
 	else if (unformat (input, "%U/%d",
 			   unformat_ip6_address, &matching_address, &mask_len))
 	    matching = 1;
@@ -710,14 +833,15 @@ ip6_show_fib (vlib_main_t * vm,
         if (fib_table->ft_flags & FIB_TABLE_FLAG_IP6_LL)
             continue;
 
-	s = format(s, "%U, fib_index:%d, flow hash:[%U] epoch:%d flags:%U locks:[",
+	s = format(s, "%U, fib_index:%d, flow hash:[%U] epoch:%d flags:%U lookup:%s locks:[",
                    format_fib_table_name, fib->index,
                    FIB_PROTOCOL_IP6,
                    fib->index,
                    format_ip_flow_hash_config,
                    fib_table->ft_flow_hash_config,
                    fib_table->ft_epoch,
-                   format_fib_table_flags, fib_table->ft_flags);
+                   format_fib_table_flags, fib_table->ft_flags,
+                   (fib->mtrie ? "mtrie" : "hash"));
 
         vec_foreach_index(source, fib_table->ft_locks)
         {
@@ -732,6 +856,14 @@ ip6_show_fib (vlib_main_t * vm,
         vlib_cli_output (vm, "%v", s);
         vec_free(s);
 
+	if (mtrie)
+	{
+	    if (fib->mtrie)
+		vlib_cli_output (vm, "%U", format_ip6_mtrie,
+                                 fib->mtrie, verbose);
+	    continue;
+	}
+
 	/* Show summary? */
 	if (! verbose)
 	{
@@ -865,11 +997,64 @@ ip6_show_fib (vlib_main_t * vm,
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (ip6_show_fib_command, static) = {
     .path = "show ip6 fib",
-    .short_help = "show ip6 fib [summary] [table <table-id>] [index <fib-id>] [<ip6-addr>[/<width>]] [detail]",
+    .short_help = "show ip6 fib [summary] [table <table-id>] [index <fib-id>] [<ip6-addr>[/<width>]] [mtrie] [detail]",
     .function = ip6_show_fib,
 };
 /* *INDENT-ON* */
 
+static clib_error_t *
+ip6_fib_lookup_set (vlib_main_t * vm,
+                    unformat_input_t * input,
+                    vlib_cli_command_t * cmd)
+{
+    u32 table_id = 0, fib_index;
+    int enable = -1;
+
+    while (unformat_check_input (input) != UNFORMAT_END_OF_INPUT)
+    {
+	if (unformat (input, "table %d", &table_id))
+	    ;
+	else if (unformat (input, "mtrie"))
+	    enable = 1;
+	else if (unformat (input, "hash"))
+	    enable = 0;
+	else
+	    return (clib_error_return (0, "unknown input '%U'",
+                                       format_unformat_error, input));
+    }
+
+    if (-1 == enable)
+        return (clib_error_return (0, "specify mtrie or hash"));
+
+    fib_index = ip6_fib_index_from_table_id(table_id);
+
+    if (~0 == fib_index)
+        return (clib_error_return (0, "no such table %d", table_id));
+
+    if (enable)
+        ip6_fib_table_mtrie_enable(fib_index);
+    else
+        ip6_fib_table_mtrie_disable(fib_index);
+
+    return (NULL);
+}
+
+/*?
+ * Select the data-plane lookup for an IPv6 table. By default the
+ * forwarding hash is probed once for each prefix length present in the
+ * table. With 'mtrie' the table also maintains a 16-8-8-...-8 stride
+ * trie, bounding a lookup to one memory access per 8 bits of prefix, at
+ * the cost of 320KB per table plus 1344 bytes per 8 bit ply.
+ *
+ * @cliexpar
+ * @cliexcmd{set ip6 fib lookup table 0 mtrie}
+ ?*/
+VLIB_CLI_COMMAND (ip6_fib_lookup_set_command, static) = {
+    .path = "set ip6 fib lookup",
+    .short_help = "set ip6 fib lookup [table <table-id>] mtrie|hash",
+    .function = ip6_fib_lookup_set,
+};
+
 static clib_error_t *
 ip6_config (vlib_main_t * vm, unformat_input_t * input)
 {
@@ -883,6 +1068,8 @@ ip6_config (vlib_main_t * vm, unformat_input_t * input)
       else if (unformat (input, "heap-size %U",
 			 unformat_memory_size, &heapsize))
 	;
+      else if (unformat (input, "mtrie-lookup"))
+	ip6_fib_table_mtrie_default = 1;
       else
 	return clib_error_return (0, "unknown input '%U'",
 				  format_unformat_error, input);
@@ -22,6 +22,7 @@
 #include <vnet/fib/fib_table.h>
 #include <vnet/ip/lookup.h>
 #include <vnet/dpo/load_balance.h>
+#include <vnet/ip/ip6_mtrie.h>
 #include <vppinfra/bihash_24_8.h>
 #include <vppinfra/bihash_template.h>
 
@@ -111,16 +112,31 @@ extern void ip6_fib_table_walk(u32 fib_index,
                                fib_table_walk_fn_t fn,
                                void *ctx);
 
+/**
+ * @brief Switch a table's forwarding lookup between the shared hash
+ * (probed once per prefix length in use) and a per-table mtrie.
+ */
+extern void ip6_fib_table_mtrie_enable(u32 fib_index);
+extern void ip6_fib_table_mtrie_disable(u32 fib_index);
+
 always_inline u32
 ip6_fib_table_fwding_lookup (u32 fib_index,
                              const ip6_address_t * dst)
 {
     ip6_fib_table_instance_t *table;
     clib_bihash_kv_24_8_t kv, value;
+    const ip6_mtrie_t *mtrie;
     int i, len;
     int rv;
     u64 fib;
 
+    /* pairs with the release store publishing a fully built trie */
+    mtrie = clib_atomic_load_acq_n(
+        &pool_elt_at_index(ip6_main.v6_fibs, fib_index)->mtrie);
+
+    if (NULL != mtrie)
+        return (ip6_mtrie_lookup(mtrie, dst));
+
     table = &ip6_fib_table[IP6_FIB_TABLE_FWDING];
     len = vec_len (table->prefix_lengths_in_search_order);
 
@@ -149,6 +165,45 @@ ip6_fib_table_fwding_lookup (u32 fib_index,
     return 0;
 }
 
+always_inline void
+ip6_fib_table_fwding_lookup_x4 (u32 fib_index0,
+                                u32 fib_index1,
+                                u32 fib_index2,
+                                u32 fib_index3,
+                                const ip6_address_t * dst0,
+                                const ip6_address_t * dst1,
+                                const ip6_address_t * dst2,
+                                const ip6_address_t * dst3,
+                                u32 *lbi0,
+                                u32 *lbi1,
+                                u32 *lbi2,
+                                u32 *lbi3)
+{
+    const ip6_mtrie_t *mtrie[4];
+
+    mtrie[0] = clib_atomic_load_acq_n(
+        &pool_elt_at_index(ip6_main.v6_fibs, fib_index0)->mtrie);
+    mtrie[1] = clib_atomic_load_acq_n(
+        &pool_elt_at_index(ip6_main.v6_fibs, fib_index1)->mtrie);
+    mtrie[2] = clib_atomic_load_acq_n(
+        &pool_elt_at_index(ip6_main.v6_fibs, fib_index2)->mtrie);
+    mtrie[3] = clib_atomic_load_acq_n(
+        &pool_elt_at_index(ip6_main.v6_fibs, fib_index3)->mtrie);
+
+    if (PREDICT_TRUE(mtrie[0] && mtrie[1] && mtrie[2] && mtrie[3]))
+    {
+        ip6_mtrie_lookup_x4(mtrie[0], mtrie[1], mtrie[2], mtrie[3],
+                            dst0, dst1, dst2, dst3,
+                            lbi0, lbi1, lbi2, lbi3);
+        return;
+    }
+
+    *lbi0 = ip6_fib_table_fwding_lookup(fib_index0, dst0);
+    *lbi1 = ip6_fib_table_fwding_lookup(fib_index1, dst1);
+    *lbi2 = ip6_fib_table_fwding_lookup(fib_index2, dst2);
+    *lbi3 = ip6_fib_table_fwding_lookup(fib_index3, dst3);
+}
+
 /**
  * @brief Walk all entries in a sub-tree of the FIB table
  * N.B: This is NOT safe to deletes. If you need to delete walk the whole
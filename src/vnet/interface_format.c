@@ -701,6 +701,9 @@ format_vnet_buffer_opaque2 (u8 * s, va_list * args)
 	      (u32) (o->gso_size), (u32) (o->gso_l4_hdr_sz));
   vec_add1 (s, '\n');
 
+  s = format (s, "rx_flow_hash: %x", o->rx_flow_hash);
+  vec_add1 (s, '\n');
+
   for (i = 0; i < vec_len (im->buffer_opaque2_format_helpers); i++)
     {
       helper_fp = im->buffer_opaque2_format_helpers[i];
@@ -172,7 +172,8 @@ VLIB_NODE_FN (ip4_load_balance_node) (vlib_main_t * vm,
 	  else
 	    {
 	      hc0 = vnet_buffer (b[0])->ip.flow_hash =
-		ip4_compute_flow_hash (ip0, lb0->lb_hash_config);
+		ip4_compute_buffer_flow_hash (b[0], ip0,
+					      lb0->lb_hash_config);
 	    }
 	  dpo0 = load_balance_get_fwd_bucket
 	    (lb0, (hc0 & (lb0->lb_n_buckets_minus_1)));
@@ -191,7 +192,8 @@ VLIB_NODE_FN (ip4_load_balance_node) (vlib_main_t * vm,
 	  else
 	    {
 	      hc1 = vnet_buffer (b[1])->ip.flow_hash =
-		ip4_compute_flow_hash (ip1, lb1->lb_hash_config);
+		ip4_compute_buffer_flow_hash (b[1], ip1,
+					      lb1->lb_hash_config);
 	    }
 	  dpo1 = load_balance_get_fwd_bucket
 	    (lb1, (hc1 & (lb1->lb_n_buckets_minus_1)));
@@ -240,7 +242,8 @@ VLIB_NODE_FN (ip4_load_balance_node) (vlib_main_t * vm,
 	  else
 	    {
 	      hc0 = vnet_buffer (b[0])->ip.flow_hash =
-		ip4_compute_flow_hash (ip0, lb0->lb_hash_config);
+		ip4_compute_buffer_flow_hash (b[0], ip0,
+					      lb0->lb_hash_config);
 	    }
 	  dpo0 = load_balance_get_fwd_bucket
 	    (lb0, (hc0 & (lb0->lb_n_buckets_minus_1)));
@@ -2751,7 +2754,9 @@ set_ip_flow_hash_command_fn (vlib_main_t * vm,
 }
 
 /*?
- * Configure the set of IPv4 fields used by the flow hash.
+ * Configure the set of IPv4 fields used by the flow hash. With 'rxhash',
+ * a packet that arrives with a flow hash computed by the NIC, e.g. its RSS
+ * hash, uses that instead.
  *
  * @cliexpar
  * Example of how to set the flow hash on a given table:
@@ -2837,7 +2842,7 @@ set_ip_flow_hash_command_fn (vlib_main_t * vm,
 VLIB_CLI_COMMAND (set_ip_flow_hash_command, static) = {
   .path = "set ip flow-hash",
   .short_help = "set ip flow-hash table <table-id> [src] [dst] [sport] "
-		"[dport] [proto] [reverse] [gtpv1teid]",
+		"[dport] [proto] [reverse] [gtpv1teid] [rxhash]",
   .function = set_ip_flow_hash_command_fn,
 };
 /* *INDENT-ON* */
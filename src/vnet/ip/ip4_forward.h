@@ -76,9 +76,7 @@ ip4_lookup_inline (vlib_main_t * vm,
       const load_balance_t *lb0, *lb1, *lb2, *lb3;
       ip4_address_t *dst_addr0, *dst_addr1, *dst_addr2, *dst_addr3;
       u32 lb_index0, lb_index1, lb_index2, lb_index3;
-      flow_hash_config_t flow_hash_config0, flow_hash_config1;
-      flow_hash_config_t flow_hash_config2, flow_hash_config3;
-      u32 hash_c0, hash_c1, hash_c2, hash_c3;
+      u32 hash_c[4], all_multipath;
       const dpo_id_t *dpo0, *dpo1, *dpo2, *dpo3;
 
       /* Prefetch next iteration. */
@@ -132,18 +130,27 @@ ip4_lookup_inline (vlib_main_t * vm,
       ASSERT (is_pow2 (lb3->lb_n_buckets));
 
       /* Use flow hash to compute multipath adjacency. */
-      hash_c0 = vnet_buffer (b[0])->ip.flow_hash = 0;
-      hash_c1 = vnet_buffer (b[1])->ip.flow_hash = 0;
-      hash_c2 = vnet_buffer (b[2])->ip.flow_hash = 0;
-      hash_c3 = vnet_buffer (b[3])->ip.flow_hash = 0;
+      vnet_buffer (b[0])->ip.flow_hash = 0;
+      vnet_buffer (b[1])->ip.flow_hash = 0;
+      vnet_buffer (b[2])->ip.flow_hash = 0;
+      vnet_buffer (b[3])->ip.flow_hash = 0;
+      /* the four are hashed together when all are multipath, otherwise
+	 only those that are, one at a time */
+      all_multipath = ((lb0->lb_n_buckets > 1) & (lb1->lb_n_buckets > 1) &
+		       (lb2->lb_n_buckets > 1) & (lb3->lb_n_buckets > 1));
+      if (PREDICT_FALSE (all_multipath))
+	ip4_compute_buffer_flow_hash_x4 (
+	  b, ip0, ip1, ip2, ip3, lb0->lb_hash_config, lb1->lb_hash_config,
+	  lb2->lb_hash_config, lb3->lb_hash_config, hash_c);
       if (PREDICT_FALSE (lb0->lb_n_buckets > 1))
 	{
-	  flow_hash_config0 = lb0->lb_hash_config;
-	  hash_c0 = vnet_buffer (b[0])->ip.flow_hash =
-	    ip4_compute_flow_hash (ip0, flow_hash_config0);
+	  if (!all_multipath)
+	    hash_c[0] = ip4_compute_buffer_flow_hash (b[0], ip0,
+						      lb0->lb_hash_config);
+	  vnet_buffer (b[0])->ip.flow_hash = hash_c[0];
 	  dpo0 =
 	    load_balance_get_fwd_bucket (lb0,
-					 (hash_c0 &
+					 (hash_c[0] &
 					  (lb0->lb_n_buckets_minus_1)));
 	}
       else
@@ -152,12 +159,13 @@ ip4_lookup_inline (vlib_main_t * vm,
 	}
       if (PREDICT_FALSE (lb1->lb_n_buckets > 1))
 	{
-	  flow_hash_config1 = lb1->lb_hash_config;
-	  hash_c1 = vnet_buffer (b[1])->ip.flow_hash =
-	    ip4_compute_flow_hash (ip1, flow_hash_config1);
+	  if (!all_multipath)
+	    hash_c[1] = ip4_compute_buffer_flow_hash (b[1], ip1,
+						      lb1->lb_hash_config);
+	  vnet_buffer (b[1])->ip.flow_hash = hash_c[1];
 	  dpo1 =
 	    load_balance_get_fwd_bucket (lb1,
-					 (hash_c1 &
+					 (hash_c[1] &
 					  (lb1->lb_n_buckets_minus_1)));
 	}
       else
@@ -166,12 +174,13 @@ ip4_lookup_inline (vlib_main_t * vm,
 	}
       if (PREDICT_FALSE (lb2->lb_n_buckets > 1))
 	{
-	  flow_hash_config2 = lb2->lb_hash_config;
-	  hash_c2 = vnet_buffer (b[2])->ip.flow_hash =
-	    ip4_compute_flow_hash (ip2, flow_hash_config2);
+	  if (!all_multipath)
+	    hash_c[2] = ip4_compute_buffer_flow_hash (b[2], ip2,
+						      lb2->lb_hash_config);
+	  vnet_buffer (b[2])->ip.flow_hash = hash_c[2];
 	  dpo2 =
 	    load_balance_get_fwd_bucket (lb2,
-					 (hash_c2 &
+					 (hash_c[2] &
 					  (lb2->lb_n_buckets_minus_1)));
 	}
       else
@@ -180,12 +189,13 @@ ip4_lookup_inline (vlib_main_t * vm,
 	}
       if (PREDICT_FALSE (lb3->lb_n_buckets > 1))
 	{
-	  flow_hash_config3 = lb3->lb_hash_config;
-	  hash_c3 = vnet_buffer (b[3])->ip.flow_hash =
-	    ip4_compute_flow_hash (ip3, flow_hash_config3);
+	  if (!all_multipath)
+	    hash_c[3] = ip4_compute_buffer_flow_hash (b[3], ip3,
+						      lb3->lb_hash_config);
+	  vnet_buffer (b[3])->ip.flow_hash = hash_c[3];
 	  dpo3 =
 	    load_balance_get_fwd_bucket (lb3,
-					 (hash_c3 &
+					 (hash_c[3] &
 					  (lb3->lb_n_buckets_minus_1)));
 	}
       else
@@ -268,7 +278,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	{
 	  flow_hash_config0 = lb0->lb_hash_config;
 	  hash_c0 = vnet_buffer (b[0])->ip.flow_hash =
-	    ip4_compute_flow_hash (ip0, flow_hash_config0);
+	    ip4_compute_buffer_flow_hash (b[0], ip0, flow_hash_config0);
 	  dpo0 =
 	    load_balance_get_fwd_bucket (lb0,
 					 (hash_c0 &
@@ -282,7 +292,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	{
 	  flow_hash_config1 = lb1->lb_hash_config;
 	  hash_c1 = vnet_buffer (b[1])->ip.flow_hash =
-	    ip4_compute_flow_hash (ip1, flow_hash_config1);
+	    ip4_compute_buffer_flow_hash (b[1], ip1, flow_hash_config1);
 	  dpo1 =
 	    load_balance_get_fwd_bucket (lb1,
 					 (hash_c1 &
@@ -340,7 +350,7 @@ ip4_lookup_inline (vlib_main_t * vm,
 	  flow_hash_config0 = lb0->lb_hash_config;
 
 	  hash_c0 = vnet_buffer (b[0])->ip.flow_hash =
-	    ip4_compute_flow_hash (ip0, flow_hash_config0);
+	    ip4_compute_buffer_flow_hash (b[0], ip0, flow_hash_config0);
 	  dpo0 =
 	    load_balance_get_fwd_bucket (lb0,
 					 (hash_c0 &
@@ -47,11 +47,11 @@
 
 #define IP_DF 0x4000		/* don't fragment */
 
-/* Compute flow hash.  We'll use it to select which adjacency to use for this
-   flow.  And other things. */
-always_inline u32
-ip4_compute_flow_hash (const ip4_header_t * ip,
-		       flow_hash_config_t flow_hash_config)
+/* Gather the words of the flow hash, ready to be mixed. */
+always_inline void
+ip4_flow_hash_words (const ip4_header_t *ip,
+		     flow_hash_config_t flow_hash_config, u32 *ap, u32 *bp,
+		     u32 *cp)
 {
   tcp_header_t *tcp = (void *) (ip + 1);
   udp_header_t *udp = (void *) (ip + 1);
@@ -102,12 +102,81 @@ ip4_compute_flow_hash (const ip4_header_t * ip,
     }
   a ^= ip_flow_hash_router_id;
 
+  *ap = a;
+  *bp = b;
+  *cp = c;
+}
+
+/* Compute flow hash.  We'll use it to select which adjacency to use for this
+   flow.  And other things. */
+always_inline u32
+ip4_compute_flow_hash (const ip4_header_t * ip,
+		       flow_hash_config_t flow_hash_config)
+{
+  u32 a, b, c;
+
+  ip4_flow_hash_words (ip, flow_hash_config, &a, &b, &c);
+
   hash_v3_mix32 (a, b, c);
   hash_v3_finalize32 (a, b, c);
 
   return c;
 }
 
+/* The flow hash for a received packet; the device's, if it has one and the
+   config allows it, otherwise as ip4_compute_flow_hash. */
+always_inline u32
+ip4_compute_buffer_flow_hash (const vlib_buffer_t *b, const ip4_header_t *ip,
+			      flow_hash_config_t flow_hash_config)
+{
+  u32 hash;
+
+  hash = ip_flow_hash_rx (b, flow_hash_config);
+
+  if (PREDICT_TRUE (0 == hash))
+    hash = ip4_compute_flow_hash (ip, flow_hash_config);
+
+  return hash;
+}
+
+/* ip4_compute_buffer_flow_hash for four packets, the headers of which are
+   mixed together, a packet per vector lane. */
+always_inline void
+ip4_compute_buffer_flow_hash_x4 (
+  vlib_buffer_t **b, const ip4_header_t *ip0, const ip4_header_t *ip1,
+  const ip4_header_t *ip2, const ip4_header_t *ip3,
+  flow_hash_config_t flow_hash_config0, flow_hash_config_t flow_hash_config1,
+  flow_hash_config_t flow_hash_config2, flow_hash_config_t flow_hash_config3,
+  u32 *hash)
+{
+  u32x4_union_t va, vb, vc;
+  int i;
+
+  hash[0] = ip_flow_hash_rx (b[0], flow_hash_config0);
+  hash[1] = ip_flow_hash_rx (b[1], flow_hash_config1);
+  hash[2] = ip_flow_hash_rx (b[2], flow_hash_config2);
+  hash[3] = ip_flow_hash_rx (b[3], flow_hash_config3);
+
+  if (PREDICT_FALSE (hash[0] && hash[1] && hash[2] && hash[3]))
+    return;
+
+  ip4_flow_hash_words (ip0, flow_hash_config0, &va.as_u32[0], &vb.as_u32[0],
+		       &vc.as_u32[0]);
+  ip4_flow_hash_words (ip1, flow_hash_config1, &va.as_u32[1], &vb.as_u32[1],
+		       &vc.as_u32[1]);
+  ip4_flow_hash_words (ip2, flow_hash_config2, &va.as_u32[2], &vb.as_u32[2],
+		       &vc.as_u32[2]);
+  ip4_flow_hash_words (ip3, flow_hash_config3, &va.as_u32[3], &vb.as_u32[3],
+		       &vc.as_u32[3]);
+
+  hash_v3_mix_u32x (va.as_u32x4, vb.as_u32x4, vc.as_u32x4);
+  hash_v3_finalize_u32x (va.as_u32x4, vb.as_u32x4, vc.as_u32x4);
+
+  for (i = 0; i < 4; i++)
+    if (PREDICT_TRUE (0 == hash[i]))
+      hash[i] = vc.as_u32[i];
+}
+
 always_inline void *
 vlib_buffer_push_ip4_custom (vlib_main_t *vm, vlib_buffer_t *b,
 			     ip4_address_t *src, ip4_address_t *dst, int proto,
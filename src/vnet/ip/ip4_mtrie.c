@@ -47,6 +47,12 @@
  */
 ip4_mtrie_8_ply_t *ip4_ply_pool;
 
+/**
+ * Plies emptied while their release is deferred
+ */
+static u8 ip4_ply_free_deferred;
+static u32 *ip4_ply_free_pending;
+
 always_inline u32
 ip4_mtrie_leaf_is_non_empty (ip4_mtrie_8_ply_t *p, u8 dst_byte)
 {
@@ -111,6 +117,14 @@ ply_16_init (ip4_mtrie_16_ply_t *p, ip4_mtrie_leaf_t init, uword prefix_len)
   clib_memset_u32 (p->leaves, init, ARRAY_LEN (p->leaves));
 }
 
+static void
+ply_24_init (ip4_mtrie_24_ply_t *p, ip4_mtrie_leaf_t init, uword prefix_len)
+{
+  clib_memset_u8 (p->dst_address_bits_of_leaves, prefix_len,
+		  sizeof (p->dst_address_bits_of_leaves));
+  clib_memset_u32 (p->leaves, init, ARRAY_LEN (p->leaves));
+}
+
 static ip4_mtrie_leaf_t
 ply_create (ip4_mtrie_leaf_t init_leaf, u32 leaf_prefix_len, u32 ply_base_len)
 {
@@ -143,6 +157,77 @@ get_next_ply_for_leaf (ip4_mtrie_leaf_t l)
   return pool_elt_at_index (ip4_ply_pool, n);
 }
 
+static void
+ply_free (ip4_mtrie_8_ply_t *p)
+{
+  if (ip4_ply_free_deferred)
+    vec_add1 (ip4_ply_free_pending, p - ip4_ply_pool);
+  else
+    pool_put (ip4_ply_pool, p);
+}
+
+void
+ip4_mtrie_ply_free_defer (u8 defer)
+{
+  ip4_ply_free_deferred = defer;
+}
+
+void
+ip4_mtrie_ply_free_flush (void)
+{
+  u32 *pi;
+
+  vec_foreach (pi, ip4_ply_free_pending)
+    pool_put_index (ip4_ply_pool, *pi);
+
+  vec_reset_length (ip4_ply_free_pending);
+}
+
+ip4_mtrie_24_t *
+ip4_mtrie_24_alloc (void)
+{
+  ip4_mtrie_24_t *m;
+
+  m = clib_mem_alloc (sizeof (*m));
+  clib_memset (m, 0, sizeof (*m));
+
+  /* prefer hugepages, the root ply is 80MB and randomly accessed */
+  m->root_ply = clib_mem_vm_map (0, sizeof (*m->root_ply),
+				 CLIB_MEM_PAGE_SZ_DEFAULT_HUGE, "ip4-mtrie-24");
+
+  if (CLIB_MEM_VM_MAP_FAILED == m->root_ply)
+    m->root_ply = clib_mem_vm_map (0, sizeof (*m->root_ply),
+				   CLIB_MEM_PAGE_SZ_DEFAULT, "ip4-mtrie-24");
+
+  if (CLIB_MEM_VM_MAP_FAILED == m->root_ply)
+    os_out_of_memory ();
+
+  ply_24_init (m->root_ply, IP4_MTRIE_LEAF_EMPTY, 0);
+
+  return m;
+}
+
+void
+ip4_mtrie_24_free (ip4_mtrie_24_t *m)
+{
+  ip4_mtrie_leaf_t l;
+  u32 i;
+
+  /* the plies are all in the root, stop once they are all found */
+  for (i = 0; m->n_plies && i < ARRAY_LEN (m->root_ply->leaves); i++)
+    {
+      l = m->root_ply->leaves[i];
+      if (ip4_mtrie_leaf_is_next_ply (l))
+	{
+	  ply_free (get_next_ply_for_leaf (l));
+	  m->n_plies--;
+	}
+    }
+
+  clib_mem_vm_unmap (m->root_ply);
+  clib_mem_free (m);
+}
+
 void
 ip4_mtrie_16_free (ip4_mtrie_16_t *m)
 {
@@ -473,6 +558,104 @@ set_root_leaf (ip4_mtrie_16_t *m, const ip4_mtrie_set_unset_leaf_args_t *a)
     }
 }
 
+static void
+set_root_24_leaf (ip4_mtrie_24_t *m, const ip4_mtrie_set_unset_leaf_args_t *a)
+{
+  ip4_mtrie_leaf_t old_leaf, new_leaf;
+  ip4_mtrie_24_ply_t *old_ply;
+  i32 n_dst_bits_next_plies;
+  u32 dst_slot;
+
+  old_ply = m->root_ply;
+
+  ASSERT (a->dst_address_length <= 32);
+
+  /* how many bits of the destination address are in the next PLY */
+  n_dst_bits_next_plies = a->dst_address_length - 24;
+
+  /* the root ply is indexed in host order */
+  dst_slot = clib_net_to_host_u32 (a->dst_address.as_u32) >> 8;
+
+  /* Number of bits next plies <= 0 => insert leaves this ply. */
+  if (n_dst_bits_next_plies <= 0)
+    {
+      /* The mask length of the address to insert maps to this ply */
+      uword old_leaf_is_terminal;
+      u32 i, slot, n_dst_bits_this_ply;
+
+      /* The number of bits, and hence slots/buckets, we will fill */
+      n_dst_bits_this_ply = 24 - a->dst_address_length;
+      ASSERT ((dst_slot & pow2_mask (n_dst_bits_this_ply)) == 0);
+
+      for (i = 0; i < (1 << n_dst_bits_this_ply); i++)
+	{
+	  ip4_mtrie_8_ply_t *new_ply;
+
+	  slot = dst_slot + i;
+
+	  old_leaf = old_ply->leaves[slot];
+	  old_leaf_is_terminal = ip4_mtrie_leaf_is_terminal (old_leaf);
+
+	  if (a->dst_address_length >=
+	      old_ply->dst_address_bits_of_leaves[slot])
+	    {
+	      /* The new leaf is more or equally specific than the one currently
+	       * occupying the slot */
+	      new_leaf = ip4_mtrie_leaf_set_adj_index (a->adj_index);
+
+	      if (old_leaf_is_terminal)
+		{
+		  /* The current leaf is terminal, we can replace it with
+		   * the new one */
+		  old_ply->dst_address_bits_of_leaves[slot] =
+		    a->dst_address_length;
+		  clib_atomic_store_rel_n (&old_ply->leaves[slot], new_leaf);
+		}
+	      else
+		{
+		  /* Existing leaf points to another ply.  We need to place
+		   * new_leaf into all more specific slots. */
+		  new_ply = get_next_ply_for_leaf (old_leaf);
+		  set_ply_with_more_specific_leaf (new_ply, new_leaf,
+						   a->dst_address_length);
+		}
+	    }
+	  else if (!old_leaf_is_terminal)
+	    {
+	      /* The current leaf is less specific and not termial (i.e. a ply),
+	       * recurse on down the trie */
+	      new_ply = get_next_ply_for_leaf (old_leaf);
+	      set_leaf (a, new_ply - ip4_ply_pool, 3);
+	    }
+	}
+    }
+  else
+    {
+      /* The address to insert requires us to move down at a lower level of
+       * the trie - recurse on down */
+      ip4_mtrie_8_ply_t *new_ply;
+
+      old_leaf = old_ply->leaves[dst_slot];
+
+      if (ip4_mtrie_leaf_is_terminal (old_leaf))
+	{
+	  /* There is a leaf occupying the slot. Replace it with a new ply */
+	  new_leaf = ply_create (old_leaf,
+				 old_ply->dst_address_bits_of_leaves[dst_slot],
+				 24);
+	  new_ply = get_next_ply_for_leaf (new_leaf);
+	  m->n_plies++;
+
+	  clib_atomic_store_rel_n (&old_ply->leaves[dst_slot], new_leaf);
+	  old_ply->dst_address_bits_of_leaves[dst_slot] = 24;
+	}
+      else
+	new_ply = get_next_ply_for_leaf (old_leaf);
+
+      set_leaf (a, new_ply - ip4_ply_pool, 3);
+    }
+}
+
 static uword
 unset_leaf (const ip4_mtrie_set_unset_leaf_args_t *a,
 	    ip4_mtrie_8_ply_t *old_ply, u32 dst_address_byte_index)
@@ -522,7 +705,7 @@ unset_leaf (const ip4_mtrie_set_unset_leaf_args_t *a,
 	  ASSERT (old_ply->n_non_empty_leafs >= 0);
 	  if (old_ply->n_non_empty_leafs == 0 && dst_address_byte_index > 0)
 	    {
-	      pool_put (ip4_ply_pool, old_ply);
+	      ply_free (old_ply);
 	      /* Old ply was deleted. */
 	      return 1;
 	    }
@@ -590,6 +773,65 @@ unset_root_leaf (ip4_mtrie_16_t *m, const ip4_mtrie_set_unset_leaf_args_t *a)
     }
 }
 
+static void
+unset_root_24_leaf (ip4_mtrie_24_t *m,
+		    const ip4_mtrie_set_unset_leaf_args_t *a)
+{
+  ip4_mtrie_leaf_t old_leaf, del_leaf;
+  i32 n_dst_bits_next_plies;
+  i32 i, n_dst_bits_this_ply, old_leaf_is_terminal;
+  ip4_mtrie_24_ply_t *old_ply;
+  u32 dst_slot, slot;
+
+  ASSERT (a->dst_address_length <= 32);
+
+  old_ply = m->root_ply;
+  n_dst_bits_next_plies = a->dst_address_length - 24;
+
+  dst_slot = clib_net_to_host_u32 (a->dst_address.as_u32) >> 8;
+
+  n_dst_bits_this_ply = (n_dst_bits_next_plies <= 0 ?
+			 (24 - a->dst_address_length) : 0);
+
+  del_leaf = ip4_mtrie_leaf_set_adj_index (a->adj_index);
+
+  for (i = 0; i < (1 << n_dst_bits_this_ply); i++)
+    {
+      slot = dst_slot + i;
+
+      old_leaf = old_ply->leaves[slot];
+      old_leaf_is_terminal = ip4_mtrie_leaf_is_terminal (old_leaf);
+
+      if (old_leaf == del_leaf ||
+	  (!old_leaf_is_terminal &&
+	   unset_leaf (a, get_next_ply_for_leaf (old_leaf), 3)))
+	{
+	  /* a ply below the root is only replaced once it has been freed */
+	  m->n_plies -= !old_leaf_is_terminal;
+	  clib_atomic_store_rel_n (
+	    &old_ply->leaves[slot],
+	    ip4_mtrie_leaf_set_adj_index (a->cover_adj_index));
+	  old_ply->dst_address_bits_of_leaves[slot] = a->cover_address_length;
+	}
+    }
+}
+
+void
+ip4_mtrie_24_route_add (ip4_mtrie_24_t *m, const ip4_address_t *dst_address,
+			u32 dst_address_length, u32 adj_index)
+{
+  ip4_mtrie_set_unset_leaf_args_t a;
+  ip4_main_t *im = &ip4_main;
+
+  /* Honor dst_address_length. Fib masks are in network byte order */
+  a.dst_address.as_u32 = (dst_address->as_u32 &
+			  im->fib_masks[dst_address_length]);
+  a.dst_address_length = dst_address_length;
+  a.adj_index = adj_index;
+
+  set_root_24_leaf (m, &a);
+}
+
 void
 ip4_mtrie_16_route_add (ip4_mtrie_16_t *m, const ip4_address_t *dst_address,
 			u32 dst_address_length, u32 adj_index)
@@ -624,6 +866,26 @@ ip4_mtrie_8_route_add (ip4_mtrie_8_t *m, const ip4_address_t *dst_address,
   set_leaf (&a, root - ip4_ply_pool, 0);
 }
 
+void
+ip4_mtrie_24_route_del (ip4_mtrie_24_t *m, const ip4_address_t *dst_address,
+			u32 dst_address_length, u32 adj_index,
+			u32 cover_address_length, u32 cover_adj_index)
+{
+  ip4_mtrie_set_unset_leaf_args_t a;
+  ip4_main_t *im = &ip4_main;
+
+  /* Honor dst_address_length. Fib masks are in network byte order */
+  a.dst_address.as_u32 = (dst_address->as_u32 &
+			  im->fib_masks[dst_address_length]);
+  a.dst_address_length = dst_address_length;
+  a.adj_index = adj_index;
+  a.cover_adj_index = cover_adj_index;
+  a.cover_address_length = cover_address_length;
+
+  /* the top level ply is never removed */
+  unset_root_24_leaf (m, &a);
+}
+
 void
 ip4_mtrie_16_route_del (ip4_mtrie_16_t *m, const ip4_address_t *dst_address,
 			u32 dst_address_length, u32 adj_index,
@@ -684,6 +946,15 @@ mtrie_ply_memory_usage (ip4_mtrie_8_ply_t *p)
   return bytes;
 }
 
+/* Returns number of bytes of memory used by mtrie. */
+uword
+ip4_mtrie_24_memory_usage (ip4_mtrie_24_t *m)
+{
+  /* the plies below the root are all /32 plies, with no plies below them */
+  return (sizeof (*m) + sizeof (*m->root_ply) +
+	  m->n_plies * sizeof (ip4_mtrie_8_ply_t));
+}
+
 /* Returns number of bytes of memory used by mtrie. */
 uword
 ip4_mtrie_16_memory_usage (ip4_mtrie_16_t *m)
@@ -774,6 +1045,42 @@ format_ip4_mtrie_ply (u8 *s, va_list *va)
   return s;
 }
 
+u8 *
+format_ip4_mtrie_24 (u8 *s, va_list *va)
+{
+  ip4_mtrie_24_t *m = va_arg (*va, ip4_mtrie_24_t *);
+  int verbose = va_arg (*va, int);
+  ip4_mtrie_24_ply_t *p;
+  u32 base_address = 0;
+  int i;
+
+  s = format (s, "24-8: %d plies, memory usage %U\n", m->n_plies,
+	      format_memory_size, ip4_mtrie_24_memory_usage (m));
+  p = m->root_ply;
+
+  if (verbose)
+    {
+      s = format (s, "root-ply");
+
+      for (i = 0; i < ARRAY_LEN (p->leaves); i++)
+	{
+	  /* a prefix fills a run of slots, show only the first */
+	  if (i && ip4_mtrie_leaf_is_terminal (p->leaves[i]) &&
+	      p->leaves[i] == p->leaves[i - 1] &&
+	      p->dst_address_bits_of_leaves[i] ==
+		p->dst_address_bits_of_leaves[i - 1])
+	    continue;
+
+	  if (p->dst_address_bits_of_leaves[i] > 0)
+	    {
+	      s = FORMAT_PLY (s, p, i, i, base_address, 24, 0);
+	    }
+	}
+    }
+
+  return s;
+}
+
 u8 *
 format_ip4_mtrie_16 (u8 *s, va_list *va)
 {
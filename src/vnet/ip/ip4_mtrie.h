@@ -73,6 +73,26 @@ typedef struct ip4_mtrie_16_ply_t_
   u8 dst_address_bits_of_leaves[PLY_16_SIZE];
 } ip4_mtrie_16_ply_t;
 
+/**
+ * @brief the 24 way stride that is the top PLY of the DIR-24-8 mtrie.
+ * At 80MB it is too large to embed in the FIB, so it is mapped, from
+ * hugepages when there are any.
+ */
+#define PLY_24_SIZE (1<<24)
+typedef struct ip4_mtrie_24_ply_t_
+{
+  /**
+   * The leaves/slots/buckets to be filed with leafs, indexed by the
+   * first 3 bytes of the address in host order
+   */
+  ip4_mtrie_leaf_t leaves[PLY_24_SIZE];
+
+  /**
+   * Prefix length for terminal leaves.
+   */
+  u8 dst_address_bits_of_leaves[PLY_24_SIZE];
+} ip4_mtrie_24_ply_t;
+
 /**
  * @brief One ply of the 4 ply mtrie fib.
  */
@@ -119,6 +139,21 @@ typedef struct
   ip4_mtrie_16_ply_t root_ply;
 } ip4_mtrie_16_t;
 
+/**
+ * @brief The mutiway-TRIE with a 24-8 stride, a.k.a. DIR-24-8.
+ * Prefixes up to /24 are found with one memory access, longer ones with two.
+ */
+typedef struct
+{
+  ip4_mtrie_24_ply_t *root_ply;
+
+  /**
+   * The number of 8 bit plies below the root, so the memory used is known
+   * without walking the 16M root slots
+   */
+  u32 n_plies;
+} ip4_mtrie_24_t;
+
 /**
  * @brief The mutiway-TRIE with a 8-8-8-8 stride.
  * There is no data associated with the mtrie apart from the top PLY
@@ -141,9 +176,20 @@ void ip4_mtrie_8_init (ip4_mtrie_8_t *m);
 void ip4_mtrie_16_free (ip4_mtrie_16_t *m);
 void ip4_mtrie_8_free (ip4_mtrie_8_t *m);
 
+/**
+ * @brief Allocate a DIR-24-8 mtrie, its 80MB root ply is mapped from
+ * hugepages when there are any. It is a copy of a table's forwarding, so
+ * it is free'd with its routes.
+ */
+ip4_mtrie_24_t *ip4_mtrie_24_alloc (void);
+void ip4_mtrie_24_free (ip4_mtrie_24_t *m);
+
 /**
  * @brief Add a route/entry to the mtrie
  */
+void ip4_mtrie_24_route_add (ip4_mtrie_24_t *m,
+			     const ip4_address_t *dst_address,
+			     u32 dst_address_length, u32 adj_index);
 void ip4_mtrie_16_route_add (ip4_mtrie_16_t *m,
 			     const ip4_address_t *dst_address,
 			     u32 dst_address_length, u32 adj_index);
@@ -153,6 +199,10 @@ void ip4_mtrie_8_route_add (ip4_mtrie_8_t *m, const ip4_address_t *dst_address,
 /**
  * @brief remove a route/entry to the mtrie
  */
+void ip4_mtrie_24_route_del (ip4_mtrie_24_t *m,
+			     const ip4_address_t *dst_address,
+			     u32 dst_address_length, u32 adj_index,
+			     u32 cover_address_length, u32 cover_adj_index);
 void ip4_mtrie_16_route_del (ip4_mtrie_16_t *m,
 			     const ip4_address_t *dst_address,
 			     u32 dst_address_length, u32 adj_index,
@@ -161,15 +211,25 @@ void ip4_mtrie_8_route_del (ip4_mtrie_8_t *m, const ip4_address_t *dst_address,
 			    u32 dst_address_length, u32 adj_index,
 			    u32 cover_address_length, u32 cover_adj_index);
 
+/**
+ * @brief Defer the release of plies emptied by route deletes. For updates
+ * made while the workers are forwarding, the plies are released by
+ * ip4_mtrie_ply_free_flush once the workers can no longer be using them.
+ */
+void ip4_mtrie_ply_free_defer (u8 defer);
+void ip4_mtrie_ply_free_flush (void);
+
 /**
  * @brief return the memory used by the table
  */
+uword ip4_mtrie_24_memory_usage (ip4_mtrie_24_t *m);
 uword ip4_mtrie_16_memory_usage (ip4_mtrie_16_t *m);
 uword ip4_mtrie_8_memory_usage (ip4_mtrie_8_t *m);
 
 /**
  * @brief Format/display the contents of the mtrie
  */
+format_function_t format_ip4_mtrie_24;
 format_function_t format_ip4_mtrie_16;
 format_function_t format_ip4_mtrie_8;
 
@@ -232,6 +292,41 @@ ip4_mtrie_16_lookup_step_one (const ip4_mtrie_16_t *m,
   return next_leaf;
 }
 
+/**
+ * @brief Lookup step.  Processes the last byte of 4 byte ip4 address.
+ */
+always_inline ip4_mtrie_leaf_t
+ip4_mtrie_24_lookup_step (ip4_mtrie_leaf_t current_leaf,
+			  const ip4_address_t *dst_address)
+{
+  ip4_mtrie_8_ply_t *ply;
+
+  uword current_is_terminal = ip4_mtrie_leaf_is_terminal (current_leaf);
+
+  if (!current_is_terminal)
+    {
+      ply = ip4_ply_pool + (current_leaf >> 1);
+      return (ply->leaves[dst_address->as_u8[3]]);
+    }
+
+  return current_leaf;
+}
+
+/**
+ * @brief Lookup step number 1.  Processes 3 bytes of 4 byte ip4 address.
+ */
+always_inline ip4_mtrie_leaf_t
+ip4_mtrie_24_lookup_step_one (const ip4_mtrie_24_t *m,
+			      const ip4_address_t *dst_address)
+{
+  ip4_mtrie_leaf_t next_leaf;
+
+  next_leaf =
+    m->root_ply->leaves[clib_net_to_host_u32 (dst_address->as_u32) >> 8];
+
+  return next_leaf;
+}
+
 always_inline ip4_mtrie_leaf_t
 ip4_mtrie_8_lookup_step (ip4_mtrie_leaf_t current_leaf,
 			 const ip4_address_t *dst_address,
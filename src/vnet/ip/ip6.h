@@ -68,6 +68,9 @@ typedef struct
 
   /* Index into FIB vector. */
   u32 index;
+
+  /* Optional mtrie forwarding lookup, hash lookup when NULL. */
+  struct ip6_mtrie_t_ *mtrie;
 } ip6_fib_t;
 
 typedef struct ip6_mfib_t
@@ -818,7 +818,8 @@ VLIB_NODE_FN (ip6_load_balance_node) (vlib_main_t * vm,
 	  else
 	    {
 	      hc0 = vnet_buffer (b[0])->ip.flow_hash =
-		ip6_compute_flow_hash (ip0, lb0->lb_hash_config);
+		ip6_compute_buffer_flow_hash (b[0], ip0,
+					      lb0->lb_hash_config);
 	    }
 	  dpo0 = load_balance_get_fwd_bucket
 	    (lb0, (hc0 & (lb0->lb_n_buckets_minus_1)));
@@ -837,7 +838,8 @@ VLIB_NODE_FN (ip6_load_balance_node) (vlib_main_t * vm,
 	  else
 	    {
 	      hc1 = vnet_buffer (b[1])->ip.flow_hash =
-		ip6_compute_flow_hash (ip1, lb1->lb_hash_config);
+		ip6_compute_buffer_flow_hash (b[1], ip1,
+					      lb1->lb_hash_config);
 	    }
 	  dpo1 = load_balance_get_fwd_bucket
 	    (lb1, (hc1 & (lb1->lb_n_buckets_minus_1)));
@@ -899,7 +901,8 @@ VLIB_NODE_FN (ip6_load_balance_node) (vlib_main_t * vm,
 	  else
 	    {
 	      hc0 = vnet_buffer (b[0])->ip.flow_hash =
-		ip6_compute_flow_hash (ip0, lb0->lb_hash_config);
+		ip6_compute_buffer_flow_hash (b[0], ip0,
+					      lb0->lb_hash_config);
 	    }
 	  dpo0 = load_balance_get_fwd_bucket
 	    (lb0, (hc0 & (lb0->lb_n_buckets_minus_1)));
@@ -2931,7 +2934,9 @@ set_ip6_flow_hash_command_fn (vlib_main_t * vm,
 }
 
 /*?
- * Configure the set of IPv6 fields used by the flow hash.
+ * Configure the set of IPv6 fields used by the flow hash. With 'rxhash',
+ * a packet that arrives with a flow hash computed by the NIC, e.g. its RSS
+ * hash, uses that instead.
  *
  * @cliexpar
  * @parblock
@@ -3009,7 +3014,7 @@ set_ip6_flow_hash_command_fn (vlib_main_t * vm,
 VLIB_CLI_COMMAND (set_ip6_flow_hash_command, static) = {
   .path = "set ip6 flow-hash",
   .short_help = "set ip6 flow-hash table <table-id> [src] [dst] [sport] "
-		"[dport] [proto] [reverse] [flowlabel]",
+		"[dport] [proto] [reverse] [flowlabel] [rxhash]",
   .function = set_ip6_flow_hash_command_fn,
 };
 /* *INDENT-ON* */
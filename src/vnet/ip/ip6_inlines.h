@@ -126,6 +126,22 @@ ip6_compute_flow_hash (const ip6_header_t * ip,
   return (u32) c;
 }
 
+/* The flow hash for a received packet; the device's, if it has one and the
+   config allows it, otherwise as ip6_compute_flow_hash. */
+always_inline u32
+ip6_compute_buffer_flow_hash (const vlib_buffer_t *b, const ip6_header_t *ip,
+			      flow_hash_config_t flow_hash_config)
+{
+  u32 hash;
+
+  hash = ip_flow_hash_rx (b, flow_hash_config);
+
+  if (PREDICT_TRUE (0 == hash))
+    hash = ip6_compute_flow_hash (ip, flow_hash_config);
+
+  return hash;
+}
+
 /* ip6_locate_header
  *
  * This function is to search for the header specified by the protocol number
@@ -287,9 +287,9 @@ ip6_ll_show_fib (vlib_main_t * vm,
     if (!(fib_table->ft_flags & FIB_TABLE_FLAG_IP6_LL))
       continue;
 
-    s = format (s, "%U, fib_index:%d, locks:[",
-		format_fib_table_name, fib_index,
-		FIB_PROTOCOL_IP6, fib_index);
+    s = format (s, "%U, fib_index:%d, lookup:%s, locks:[",
+		format_fib_table_name, fib_index, FIB_PROTOCOL_IP6, fib_index,
+		(ip6_fib_get (fib_index)->mtrie ? "mtrie" : "hash"));
     vec_foreach_index (source, fib_table->ft_locks)
     {
       if (0 != fib_table->ft_locks[source])
@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2024 Cisco and/or its affiliates.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at:
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+/*
+ * ip/ip6_mtrie.h: ip6 mtrie fib
+ *
+ * An optional forwarding structure for IPv6 tables, in the image of the
+ * IPv4 16-8-8 mtrie: a 16 bit root ply followed by up to 14 8 bit plies.
+ * A lookup costs one memory access per ply traversed, i.e. 5 for a /48
+ * and never more than 15, instead of one hash probe per distinct prefix
+ * length present in the table.
+ */
+
+#ifndef included_ip_ip6_mtrie_h
+#define included_ip_ip6_mtrie_h
+
+#include <vppinfra/cache.h>
+#include <vppinfra/pool.h>
+#include <vnet/ip/ip6_packet.h> /* for ip6_address_t */
+
+/* ip6 fib leafs, encoded as for ip4.
+   1 + 2*adj_index for terminal leaves.
+   0 + 2*next_ply_index for non-terminals, i.e. PLYs */
+typedef u32 ip6_mtrie_leaf_t;
+
+#define IP6_MTRIE_LEAF_EMPTY (1 + 2 * 0)
+
+/**
+ * @brief the 16 way stride that is the top PLY of the mtrie
+ */
+#define IP6_MTRIE_PLY_16_SIZE (1 << 16)
+typedef struct ip6_mtrie_16_ply_t_
+{
+  ip6_mtrie_leaf_t leaves[IP6_MTRIE_PLY_16_SIZE];
+
+  /**
+   * Prefix length for terminal leaves.
+   */
+  u8 dst_address_bits_of_leaves[IP6_MTRIE_PLY_16_SIZE];
+} ip6_mtrie_16_ply_t;
+
+/**
+ * @brief One 8 bit ply of the mtrie.
+ */
+typedef struct ip6_mtrie_8_ply_t_
+{
+  CLIB_CACHE_LINE_ALIGN_MARK (cacheline0);
+  ip6_mtrie_leaf_t leaves[256];
+
+  /**
+   * Prefix length for leaves/ply.
+   */
+  u8 dst_address_bits_of_leaves[256];
+
+  /**
+   * Number of non-empty leafs (whether terminal or not).
+   */
+  i32 n_non_empty_leafs;
+
+  /**
+   * The length of the ply's covering prefix.
+   */
+  i32 dst_address_bits_base;
+} ip6_mtrie_8_ply_t;
+
+STATIC_ASSERT (0 == sizeof (ip6_mtrie_8_ply_t) % CLIB_CACHE_LINE_BYTES,
+	       "IP6 Mtrie ply cache line");
+
+/**
+ * @brief The mutiway-TRIE with a 16-8-...-8 stride.
+ */
+typedef struct ip6_mtrie_t_
+{
+  ip6_mtrie_16_ply_t root_ply;
+} ip6_mtrie_t;
+
+/**
+ * @brief Allocate and initialise an mtrie
+ */
+ip6_mtrie_t *ip6_mtrie_alloc (void);
+
+/**
+ * @brief Free an mtrie and all its plies. The caller must ensure the
+ * data-plane no longer uses it.
+ */
+void ip6_mtrie_free (ip6_mtrie_t *m);
+
+/**
+ * @brief Add a route/entry to the mtrie
+ */
+void ip6_mtrie_route_add (ip6_mtrie_t *m, const ip6_address_t *dst_address,
+			  u32 dst_address_length, u32 adj_index);
+
+/**
+ * @brief remove a route/entry from the mtrie
+ */
+void ip6_mtrie_route_del (ip6_mtrie_t *m, const ip6_address_t *dst_address,
+			  u32 dst_address_length, u32 adj_index,
+			  u32 cover_address_length, u32 cover_adj_index);
+
+/**
+ * @brief return the memory used by the table
+ */
+uword ip6_mtrie_memory_usage (ip6_mtrie_t *m);
+
+/**
+ * @brief Format/display the contents of the mtrie
+ */
+format_function_t format_ip6_mtrie;
+
+/**
+ * @brief A global pool of 8bit stride plys
+ */
+extern ip6_mtrie_8_ply_t *ip6_ply_pool;
+
+always_inline u32
+ip6_mtrie_leaf_is_terminal (ip6_mtrie_leaf_t n)
+{
+  return n & 1;
+}
+
+always_inline u32
+ip6_mtrie_leaf_get_adj_index (ip6_mtrie_leaf_t n)
+{
+  ASSERT (ip6_mtrie_leaf_is_terminal (n));
+  return n >> 1;
+}
+
+always_inline ip6_mtrie_leaf_t
+ip6_mtrie_lookup_step_one (const ip6_mtrie_t *m,
+			   const ip6_address_t *dst_address)
+{
+  return m->root_ply.leaves[dst_address->as_u16[0]];
+}
+
+/**
+ * @brief Lookup step. Processes 1 byte of the address, a no-op once the
+ * leaf is terminal.
+ */
+always_inline ip6_mtrie_leaf_t
+ip6_mtrie_lookup_step (ip6_mtrie_leaf_t current_leaf,
+		       const ip6_address_t *dst_address,
+		       u32 dst_address_byte_index)
+{
+  ip6_mtrie_8_ply_t *ply;
+
+  if (!ip6_mtrie_leaf_is_terminal (current_leaf))
+    {
+      ply = ip6_ply_pool + (current_leaf >> 1);
+      return (ply->leaves[dst_address->as_u8[dst_address_byte_index]]);
+    }
+
+  return current_leaf;
+}
+
+always_inline u32
+ip6_mtrie_lookup (const ip6_mtrie_t *m, const ip6_address_t *dst_address)
+{
+  ip6_mtrie_leaf_t leaf;
+  u32 i = 2;
+
+  leaf = ip6_mtrie_lookup_step_one (m, dst_address);
+
+  while (!ip6_mtrie_leaf_is_terminal (leaf))
+    leaf = ip6_mtrie_lookup_step (leaf, dst_address, i++);
+
+  return ip6_mtrie_leaf_get_adj_index (leaf);
+}
+
+/**
+ * @brief Four lookups interleaved, so the memory accesses of each step
+ * overlap, rather than four chains of dependent loads.
+ */
+always_inline void
+ip6_mtrie_lookup_x4 (const ip6_mtrie_t *m0, const ip6_mtrie_t *m1,
+		     const ip6_mtrie_t *m2, const ip6_mtrie_t *m3,
+		     const ip6_address_t *a0, const ip6_address_t *a1,
+		     const ip6_address_t *a2, const ip6_address_t *a3,
+		     u32 *lbi0, u32 *lbi1, u32 *lbi2, u32 *lbi3)
+{
+  ip6_mtrie_leaf_t l0, l1, l2, l3;
+  u32 i;
+
+  l0 = ip6_mtrie_lookup_step_one (m0, a0);
+  l1 = ip6_mtrie_lookup_step_one (m1, a1);
+  l2 = ip6_mtrie_lookup_step_one (m2, a2);
+  l3 = ip6_mtrie_lookup_step_one (m3, a3);
+
+  for (i = 2; i < 16; i++)
+    {
+      if (ip6_mtrie_leaf_is_terminal (l0 & l1 & l2 & l3))
+	break;
+      l0 = ip6_mtrie_lookup_step (l0, a0, i);
+      l1 = ip6_mtrie_lookup_step (l1, a1, i);
+      l2 = ip6_mtrie_lookup_step (l2, a2, i);
+      l3 = ip6_mtrie_lookup_step (l3, a3, i);
+    }
+
+  *lbi0 = ip6_mtrie_leaf_get_adj_index (l0);
+  *lbi1 = ip6_mtrie_leaf_get_adj_index (l1);
+  *lbi2 = ip6_mtrie_leaf_get_adj_index (l2);
+  *lbi3 = ip6_mtrie_leaf_get_adj_index (l3);
+}
+
+#endif /* included_ip_ip6_mtrie_h */
+
+/*
+ * fd.io coding-style-patch-verification: ON
+ *
+ * Local Variables:
+ * eval: (c-set-style "gnu")
+ * End:
+ */
@@ -31,6 +31,7 @@
 #include <vnet/ip/ip_path_mtu.h>
 #include <vnet/fib/fib_table.h>
 #include <vnet/fib/fib_api.h>
+#include <vnet/fib/fib_route_queue.h>
 #include <vnet/ethernet/arp_packet.h>
 #include <vnet/mfib/ip6_mfib.h>
 #include <vnet/mfib/ip4_mfib.h>
@@ -206,6 +207,8 @@ send_ip_route_v2_details (vpe_api_main_t *am, vl_api_registration_t *reg,
     fib_entry_get_fib_index (fib_entry_index), pfx->fp_proto));
   mp->route.n_paths = path_count;
   mp->route.src = fib_entry_get_best_source (fib_entry_index);
+  if (fib_entry_get_flags (fib_entry_index) & FIB_ENTRY_FLAG_RESILIENT)
+    mp->route.flags |= IP_API_ROUTE_FLAG_RESILIENT;
   mp->route.stats_index = htonl (fib_table_entry_get_stats_index (
     fib_entry_get_fib_index (fib_entry_index), pfx));
 
@@ -709,6 +712,9 @@ ip_route_add_del_t_handler (vl_api_ip_route_add_del_t * mp, u32 * stats_index)
 	goto out;
     }
 
+  /* the routes queued for the table must not override this one later */
+  fib_route_queue_drain (fib_index, pfx.fp_proto);
+
   rv = fib_api_route_add_del (mp->is_add, mp->is_multipath, fib_index, &pfx,
 			      FIB_SOURCE_API, entry_flags, rpaths);
 
@@ -761,6 +767,12 @@ ip_route_add_del_v2_t_handler (vl_api_ip_route_add_del_v2_t *mp,
 
   src = (0 == mp->route.src ? FIB_SOURCE_API : mp->route.src);
 
+  if (mp->route.flags & IP_API_ROUTE_FLAG_RESILIENT)
+    entry_flags |= FIB_ENTRY_FLAG_RESILIENT;
+
+  /* the routes queued for the table must not override this one later */
+  fib_route_queue_drain (fib_index, pfx.fp_proto);
+
   rv = fib_api_route_add_del (mp->is_add, mp->is_multipath, fib_index, &pfx,
 			      src, entry_flags, rpaths);
 
@@ -807,6 +819,148 @@ vl_api_ip_route_add_del_v2_t_handler (vl_api_ip_route_add_del_v2_t *mp)
   /* clang-format on */
 }
 
+/*
+ * Tell the client that its queued bulk routes are done with
+ */
+static void
+ip_route_add_del_bulk_done (u32 client_index, u32 context, u32 fib_index,
+			    fib_protocol_t fproto, u32 n_applied, u32 n_failed,
+			    int rv)
+{
+  vl_api_ip_route_add_del_bulk_event_t *mp;
+  vl_api_registration_t *reg;
+
+  /* Client can cancel, die, etc. */
+  reg = vl_api_client_index_to_registration (client_index);
+  if (!reg || !vl_api_can_send_msg (reg))
+    return;
+
+  mp = vl_msg_api_alloc (sizeof (*mp));
+  clib_memset (mp, 0, sizeof (*mp));
+  mp->_vl_msg_id =
+    ntohs (REPLY_MSG_ID_BASE + VL_API_IP_ROUTE_ADD_DEL_BULK_EVENT);
+  mp->client_index = client_index;
+  mp->request_context = context;
+  mp->table_id = htonl (fib_table_get_table_id (fib_index, fproto));
+  mp->retval = htonl (rv);
+  mp->n_applied = htonl (n_applied);
+  mp->n_failed = htonl (n_failed);
+
+  vl_api_send_msg (reg, (u8 *) mp);
+}
+
+static int
+ip_route_add_del_bulk_t_handler (vl_api_ip_route_add_del_bulk_t *mp,
+				 u32 *n_done)
+{
+  fib_route_path_t *paths = NULL, *rpaths = NULL, *rpath;
+  fib_entry_flag_t entry_flags;
+  u32 fib_index, n_prefixes;
+  fib_protocol_t fproto;
+  fib_prefix_t pfx;
+  int rv = 0, ii;
+
+  n_prefixes = ntohl (mp->n_prefixes);
+  entry_flags = FIB_ENTRY_FLAG_NONE;
+
+  if (0 == n_prefixes)
+    return (0);
+  if (mp->n_paths > ARRAY_LEN (mp->paths))
+    return (VNET_API_ERROR_INVALID_VALUE);
+
+  ip_prefix_decode (&mp->prefixes[0], &pfx);
+  fproto = pfx.fp_proto;
+
+  rv = fib_api_table_id_decode (fproto, ntohl (mp->table_id), &fib_index);
+  if (0 != rv)
+    return (rv);
+
+  if (0 != mp->n_paths)
+    vec_validate (paths, mp->n_paths - 1);
+
+  for (ii = 0; ii < mp->n_paths; ii++)
+    {
+      rpath = &paths[ii];
+
+      rv = fib_api_path_decode (&mp->paths[ii], rpath);
+
+      if ((rpath->frp_flags & FIB_ROUTE_PATH_LOCAL) &&
+	  (~0 == rpath->frp_sw_if_index))
+	entry_flags |= (FIB_ENTRY_FLAG_CONNECTED | FIB_ENTRY_FLAG_LOCAL);
+
+      if (0 != rv)
+	goto out;
+    }
+
+  if (mp->is_async)
+    {
+      u32 request = fib_route_queue_request_begin (
+	ip_route_add_del_bulk_done, mp->client_index, mp->context);
+
+      for (*n_done = 0; *n_done < n_prefixes; (*n_done)++)
+	{
+	  ip_prefix_decode (&mp->prefixes[*n_done], &pfx);
+
+	  if (pfx.fp_proto != fproto)
+	    {
+	      rv = VNET_API_ERROR_INVALID_ADDRESS_FAMILY;
+	      break;
+	    }
+
+	  fib_route_queue_add (fib_index, &pfx, mp->is_add, mp->is_multipath,
+			       FIB_SOURCE_API, entry_flags, paths, request);
+	}
+      fib_route_queue_request_end (request);
+      goto out;
+    }
+
+  /* the routes queued for the table must not override these later */
+  fib_route_queue_drain (fib_index, fproto);
+
+  fib_table_batch_begin ();
+
+  for (*n_done = 0; *n_done < n_prefixes; (*n_done)++)
+    {
+      ip_prefix_decode (&mp->prefixes[*n_done], &pfx);
+
+      if (pfx.fp_proto != fproto)
+	{
+	  rv = VNET_API_ERROR_INVALID_ADDRESS_FAMILY;
+	  break;
+	}
+
+      /* the FIB fixes up the paths it is given, so each route gets a copy */
+      vec_reset_length (rpaths);
+      vec_append (rpaths, paths);
+
+      rv = fib_api_route_add_del (mp->is_add, mp->is_multipath, fib_index,
+				  &pfx, FIB_SOURCE_API, entry_flags, rpaths);
+      if (0 != rv)
+	break;
+    }
+
+  fib_table_batch_end ();
+
+out:
+  vec_free (paths);
+  vec_free (rpaths);
+
+  return (rv);
+}
+
+void
+vl_api_ip_route_add_del_bulk_t_handler (vl_api_ip_route_add_del_bulk_t *mp)
+{
+  vl_api_ip_route_add_del_bulk_reply_t *rmp;
+  u32 n_done = 0;
+  int rv;
+
+  rv = ip_route_add_del_bulk_t_handler (mp, &n_done);
+
+  REPLY_MACRO2 (VL_API_IP_ROUTE_ADD_DEL_BULK_REPLY,
+		({ rmp->n_done = htonl (n_done); }))
+}
+
 void
 vl_api_ip_route_lookup_t_handler (vl_api_ip_route_lookup_t * mp)
 {
@@ -907,6 +1061,8 @@ vl_api_ip_route_lookup_v2_t_handler (vl_api_ip_route_lookup_v2_t *mp)
         rmp->route.table_id = mp->table_id;
         rmp->route.n_paths = npaths;
         rmp->route.src = src;
+        if (fib_entry_get_flags (fib_entry_index) & FIB_ENTRY_FLAG_RESILIENT)
+          rmp->route.flags |= IP_API_ROUTE_FLAG_RESILIENT;
         rmp->route.stats_index = fib_table_entry_get_stats_index (fib_index, pfx);
         rmp->route.stats_index = htonl (rmp->route.stats_index);
 
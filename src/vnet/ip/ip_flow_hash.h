@@ -17,6 +17,7 @@
 #define __IP_FLOW_HASH_H__
 
 #include <vnet/ip/ip_types.h>
+#include <vnet/buffer.h>
 
 /** Default: 5-tuple + flowlabel without the "reverse" bit */
 #define IP_FLOW_HASH_DEFAULT (0x9F)
@@ -39,7 +40,8 @@
   _ (reverse, 5, IP_FLOW_HASH_REVERSE_SRC_DST)                                \
   _ (symmetric, 6, IP_FLOW_HASH_SYMMETRIC)                                    \
   _ (flowlabel, 7, IP_FLOW_HASH_FL)                                           \
-  _ (gtpv1teid, 8, IP_FLOW_HASH_GTPV1_TEID)
+  _ (gtpv1teid, 8, IP_FLOW_HASH_GTPV1_TEID)                                   \
+  _ (rxhash, 9, IP_FLOW_HASH_RX_HASH)
 
 typedef struct
 {
@@ -67,6 +69,20 @@ int ip_flow_hash_set (ip_address_family_t af, u32 table_id,
 		      flow_hash_config_t flow_hash_config);
 void ip_flow_hash_router_id_set (u32 router_id);
 
+/**
+ * The flow hash the device computed for the packet on receive, if it has
+ * one and the config allows it to be used, otherwise 0.
+ */
+static_always_inline u32
+ip_flow_hash_rx (const vlib_buffer_t *b, flow_hash_config_t flow_hash_config)
+{
+  if ((flow_hash_config & IP_FLOW_HASH_RX_HASH) &&
+      (b->flags & VNET_BUFFER_F_RX_FLOW_HASH))
+    return (vnet_buffer2 (b)->rx_flow_hash);
+
+  return (0);
+}
+
 #endif /* __IP_TYPES_H__ */
 
 /*
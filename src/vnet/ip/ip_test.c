@@ -55,6 +55,12 @@ api_ip_route_add_del_v2 (vat_main_t *vam)
   return -1;
 }
 
+static int
+api_ip_route_add_del_bulk (vat_main_t *vam)
+{
+  return -1;
+}
+
 static void
 set_ip4_address (vl_api_address_t *a, u32 v)
 {
@@ -544,6 +550,18 @@ vl_api_ip_route_add_del_v2_reply_t_handler (
 {
 }
 
+static void
+vl_api_ip_route_add_del_bulk_reply_t_handler (
+  vl_api_ip_route_add_del_bulk_reply_t *mp)
+{
+}
+
+static void
+vl_api_ip_route_add_del_bulk_event_t_handler (
+  vl_api_ip_route_add_del_bulk_event_t *mp)
+{
+}
+
 static void
 vl_api_ip_route_details_t_handler (vl_api_ip_route_details_t *mp)
 {
@@ -229,10 +229,12 @@ vnet_ip_route_cmd (vlib_main_t * vm,
   dpo_id_t dpo = DPO_INVALID, *dpos = NULL;
   fib_route_path_t *rpaths = NULL, rpath;
   fib_prefix_t *prefixs = NULL, pfx;
+  fib_entry_flag_t entry_flags;
   clib_error_t *error = NULL;
   f64 count;
   int i;
 
+  entry_flags = FIB_ENTRY_FLAG_NONE;
   is_del = 0;
   table_id = 0;
   count = 1;
@@ -250,6 +252,8 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 	;
       else if (unformat (line_input, "count %f", &count))
 	;
+      else if (unformat (line_input, "resilient"))
+	entry_flags |= FIB_ENTRY_FLAG_RESILIENT;
 
       else if (unformat (line_input, "%U/%d",
 			 unformat_ip4_address, &pfx.fp_addr.ip4, &pfx.fp_len))
@@ -345,6 +349,7 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 	  n = count;
 	  t[0] = vlib_time_now (vm);
 
+	  fib_table_batch_begin ();
 	  for (k = 0; k < n; k++)
 	    {
 	      fib_prefix_t rpfx = {
@@ -357,13 +362,12 @@ vnet_ip_route_cmd (vlib_main_t * vm,
 		fib_table_entry_path_remove2 (fib_index,
 					      &rpfx, FIB_SOURCE_CLI, rpaths);
 	      else
-		fib_table_entry_path_add2 (fib_index,
-					   &rpfx,
-					   FIB_SOURCE_CLI,
-					   FIB_ENTRY_FLAG_NONE, rpaths);
+		fib_table_entry_path_add2 (fib_index, &rpfx, FIB_SOURCE_CLI,
+					   entry_flags, rpaths);
 
 	      fib_prefix_increment (&prefixs[i]);
 	    }
+	  fib_table_batch_end ();
 
 	  t[1] = vlib_time_now (vm);
 	  if (count > 1)
@@ -584,11 +588,17 @@ VLIB_CLI_COMMAND (vlib_cli_show_ip6_command, static) = {
  * @cliexcmd{ip route add 7.0.0.1/32 via 6.0.0.2 GigabitEthernet2/0/0 weight 3}
  * To add a route to a particular FIB table (VRF), use:
  * @cliexcmd{ip route add 172.16.24.0/24 table 7 via GigabitEthernet2/0/0}
+ * A resilient route spreads its flows over a large fixed set of buckets,
+ * so adding or removing a path later moves only the flows that must move,
+ * e.g. to keep flows through stateful middleboxes in place. It is chosen
+ * when the route is first added:
+ * @cliexcmd{ip route add 7.0.0.2/32 resilient via 6.0.0.1 GigabitEthernet2/0/0}
  ?*/
 /* *INDENT-OFF* */
 VLIB_CLI_COMMAND (ip_route_command, static) = {
   .path = "ip route",
-  .short_help = "ip route [add|del] [count <n>] <dst-ip-addr>/<width> [table "
+  .short_help = "ip route [add|del] [count <n>] [resilient] "
+		"<dst-ip-addr>/<width> [table "
 		"<table-id>] via [next-hop-address] [next-hop-interface] "
 		"[next-hop-table <value>] [weight <value>] [preference "
 		"<value>] [udp-encap <value>] [ip4-lookup-in-table <value>] "
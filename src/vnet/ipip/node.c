@@ -155,6 +155,7 @@ ipip_input (vlib_main_t * vm, vlib_node_runtime_t * node,
 
 	  len = vlib_buffer_length_in_chain (vm, b0);
 	  vnet_buffer (b0)->sw_if_index[VLIB_RX] = tunnel_sw_if_index;
+	  vnet_buffer_rx_flow_hash_clear (b0);
 
 	  if (inner_protocol0 == IP_PROTOCOL_IPV6)
 	    {
@@ -319,6 +319,7 @@ ipsec_tun_protect_input_inline (vlib_main_t * vm, vlib_node_runtime_t * node,
 
       sw_if_index0 = itr0.sw_if_index;
       vnet_buffer (b[0])->sw_if_index[VLIB_RX] = sw_if_index0;
+      vnet_buffer_rx_flow_hash_clear (b[0]);
 
       if (PREDICT_FALSE (!vnet_sw_interface_is_admin_up (vnm, sw_if_index0)))
 	{
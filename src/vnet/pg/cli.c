@@ -399,6 +399,8 @@ new_stream (vlib_main_t * vm,
       else if (unformat (input, "buffer-offload-flags %U",
 			 unformat_vnet_buffer_offload_flags, &s.buffer_oflags))
 	;
+      else if (unformat (input, "rx-flow-hash %x", &s.rx_flow_hash))
+	s.buffer_flags |= VNET_BUFFER_F_RX_FLOW_HASH;
       else if (unformat (input, "node %U",
 			 unformat_vlib_node, vm, &s.node_index))
 	;
@@ -521,7 +523,8 @@ VLIB_CLI_COMMAND (new_stream_cli, static) = {
   "data STRING          specifies packet data\n"
   "pcap FILENAME        read packet data from pcap file\n"
   "rate PPS             rate to transfer packet data\n"
-  "maxframe NPKTS       maximum number of packets per frame\n",
+  "maxframe NPKTS       maximum number of packets per frame\n"
+  "rx-flow-hash HASH    the flow hash a device computed on receive\n",
 };
 /* *INDENT-ON* */
 
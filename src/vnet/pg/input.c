@@ -1728,6 +1728,11 @@ pg_generate_packets (vlib_node_runtime_t * node,
 				     pi->gso_size);
 	}
 
+      if (PREDICT_FALSE (s->buffer_flags & VNET_BUFFER_F_RX_FLOW_HASH))
+	for (i = 0; i < n_this_frame; i++)
+	  vnet_buffer2 (vlib_get_buffer (vm, to_next[i]))->rx_flow_hash =
+	    s->rx_flow_hash;
+
       n_trace = vlib_get_trace_count (vm, node);
       if (PREDICT_FALSE (n_trace > 0))
 	{
@@ -131,6 +131,9 @@ typedef struct pg_stream_t
   /* Buffer offload flags to set in each packet e.g. checksum offload flags */
   u32 buffer_oflags;
 
+  /* Flow hash given to each packet, as a device computes it on receive */
+  u32 rx_flow_hash;
+
   /* Last packet length if packet size edit type is increment. */
   u32 last_increment_packet_size;
 
@@ -1099,6 +1099,8 @@ end_decaps_srh_processing (vlib_node_runtime_t * node,
       return;
     }
 
+  vnet_buffer_rx_flow_hash_clear (b0);
+
   switch (next_proto)
     {
     case IP_PROTOCOL_IPV6:
@@ -328,6 +328,7 @@ vxlan_gpe_input (vlib_main_t * vm,
 
 	  /* Set packet input sw_if_index to unicast VXLAN tunnel for learning */
 	  vnet_buffer (b0)->sw_if_index[VLIB_RX] = t0->sw_if_index;
+	  vnet_buffer_rx_flow_hash_clear (b0);
 
       /**
        * ip[46] lookup in the configured FIB
@@ -383,6 +384,7 @@ vxlan_gpe_input (vlib_main_t * vm,
 
 	  /* Set packet input sw_if_index to unicast VXLAN tunnel for learning */
 	  vnet_buffer (b1)->sw_if_index[VLIB_RX] = t1->sw_if_index;
+	  vnet_buffer_rx_flow_hash_clear (b1);
 
 	  /*
 	   * ip[46] lookup in the configured FIB
@@ -495,6 +497,7 @@ vxlan_gpe_input (vlib_main_t * vm,
 
 	  /* Set packet input sw_if_index to unicast VXLAN tunnel for learning */
 	  vnet_buffer (b0)->sw_if_index[VLIB_RX] = t0->sw_if_index;
+	  vnet_buffer_rx_flow_hash_clear (b0);
 
 	  /*
 	   * ip[46] lookup in the configured FIB
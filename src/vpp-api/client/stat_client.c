@@ -219,6 +219,14 @@ stat_vec_combined_init (vlib_counter_t c)
   return v;
 }
 
+static uint64_t **
+stat_vec_histogram_init (uint64_t *h)
+{
+  uint64_t **v = 0;
+  vec_add1 (v, h);
+  return v;
+}
+
 /*
  * If index2 is specified copy out the column (the indexed value across all
  * threads), otherwise copy out all values.
@@ -231,6 +239,7 @@ copy_data (vlib_stats_entry_t *ep, u32 index2, char *name,
   int i;
   vlib_counter_t **combined_c;	/* Combined counter */
   counter_t **simple_c;		/* Simple counter */
+  uint64_t ***histogram_c;	/* Histogram */
 
   assert (sm->shared_header);
 
@@ -271,6 +280,32 @@ copy_data (vlib_stats_entry_t *ep, u32 index2, char *name,
 	}
       break;
 
+    case STAT_DIR_TYPE_HISTOGRAM:
+      histogram_c = stat_segment_adjust (sm, ep->data);
+      result.histogram_vec = stat_vec_dup (sm, histogram_c);
+      for (i = 0; i < vec_len (histogram_c); i++)
+	{
+	  uint64_t **hb = stat_segment_adjust (sm, histogram_c[i]);
+	  uint64_t *h;
+	  if (index2 != ~0)
+	    {
+	      h = stat_segment_adjust (sm, hb[index2]);
+	      result.histogram_vec[i] =
+		stat_vec_histogram_init (stat_vec_dup (sm, h));
+	    }
+	  else
+	    {
+	      int j;
+	      result.histogram_vec[i] = stat_vec_dup (sm, hb);
+	      for (j = 0; j < vec_len (hb); j++)
+		{
+		  h = stat_segment_adjust (sm, hb[j]);
+		  result.histogram_vec[i][j] = stat_vec_dup (sm, h);
+		}
+	    }
+	}
+      break;
+
     case STAT_DIR_TYPE_NAME_VECTOR:
       {
 	uint8_t **name_vector = stat_segment_adjust (sm, ep->data);
@@ -325,6 +360,16 @@ stat_segment_data_free (stat_segment_data_t * res)
 	    vec_free (res[i].name_vector[j]);
 	  vec_free (res[i].name_vector);
 	  break;
+	case STAT_DIR_TYPE_HISTOGRAM:
+	  for (j = 0; j < vec_len (res[i].histogram_vec); j++)
+	    {
+	      int k;
+	      for (k = 0; k < vec_len (res[i].histogram_vec[j]); k++)
+		vec_free (res[i].histogram_vec[j][k]);
+	      vec_free (res[i].histogram_vec[j]);
+	    }
+	  vec_free (res[i].histogram_vec);
+	  break;
 	case STAT_DIR_TYPE_SCALAR_INDEX:
 	case STAT_DIR_TYPE_EMPTY:
 	  break;
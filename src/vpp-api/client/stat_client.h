@@ -44,6 +44,7 @@ typedef struct
     counter_t **simple_counter_vec;
     vlib_counter_t **combined_counter_vec;
     uint8_t **name_vector;
+    uint64_t ***histogram_vec;
   };
 } stat_segment_data_t;
 
@@ -406,6 +406,8 @@ class StatsEntry:
             self.function = self.name
         elif stattype == 6:
             self.function = self.symlink
+        elif stattype == 7:
+            self.function = self.histogram
         else:
             self.function = self.illegal
 
@@ -433,6 +435,17 @@ class StatsEntry:
             counter.append(clist)
         return counter
 
+    def histogram(self, stats):
+        """Histogram counter, [sum, bucket0, bucket1, ...] per index"""
+        counter = StatsSimpleList()
+        for threads in StatsVector(stats, self.value, "P"):
+            hlist = [
+                [v[0] for v in StatsVector(stats, h[0], "Q")]
+                for h in StatsVector(stats, threads[0], "P")
+            ]
+            counter.append(hlist)
+        return counter
+
     def name(self, stats):
         """Name counter"""
         counter = []
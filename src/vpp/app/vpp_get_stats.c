@@ -20,6 +20,17 @@
 #include <vpp-api/client/stat_client.h>
 #include <vlib/vlib.h>
 
+static u64
+histogram_count (u64 *h)
+{
+  u64 count = 0;
+  int b;
+
+  for (b = 1; b < vec_len (h); b++)
+    count += h[b];
+  return count;
+}
+
 static int
 stat_poll_loop (u8 ** patterns)
 {
@@ -83,6 +94,14 @@ stat_poll_loop (u8 ** patterns)
 	      fformat (stdout, "%.2f %s\n", res[i].scalar_value, res[i].name);
 	      break;
 
+	    case STAT_DIR_TYPE_HISTOGRAM:
+	      for (k = 0; k < vec_len (res[i].histogram_vec); k++)
+		for (j = 0; j < vec_len (res[i].histogram_vec[k]); j++)
+		  fformat (stdout, "[%d]: %llu samples, %llu sum %s\n", j,
+			   histogram_count (res[i].histogram_vec[k][j]),
+			   res[i].histogram_vec[k][j][0], res[i].name);
+	      break;
+
 	    case STAT_DIR_TYPE_EMPTY:
 	      break;
 
@@ -217,6 +236,27 @@ reconnect:
 	      fformat (stdout, "%.2f %s\n", res[i].scalar_value, res[i].name);
 	      break;
 
+	    case STAT_DIR_TYPE_HISTOGRAM:
+	      if (res[i].histogram_vec == 0)
+		continue;
+	      for (k = 0; k < vec_len (res[i].histogram_vec); k++)
+		for (j = 0; j < vec_len (res[i].histogram_vec[k]); j++)
+		  {
+		    u64 *h = res[i].histogram_vec[k][j];
+		    int b;
+
+		    if (h == 0)
+		      continue;
+		    fformat (stdout, "[%d @ %d]: %llu samples, %llu sum %s\n",
+			     j, k, histogram_count (h), h[0], res[i].name);
+		    for (b = 1; b < vec_len (h); b++)
+		      if (h[b])
+			fformat (stdout, "  [%llu, ...): %llu\n",
+				 stat_histogram_bucket_lower_bound (b - 1),
+				 h[b]);
+		  }
+	      break;
+
 	    case STAT_DIR_TYPE_NAME_VECTOR:
 	      if (res[i].name_vector == 0)
 		continue;
@@ -48,6 +48,39 @@ prom_string (char *s)
   return s;
 }
 
+static void
+dump_histogram (FILE * stream, char *name, u64 *** histogram_vec)
+{
+  int j, k, b;
+
+  fformat (stream, "# TYPE %s histogram\n", name);
+  for (k = 0; k < vec_len (histogram_vec); k++)
+    for (j = 0; j < vec_len (histogram_vec[k]); j++)
+      {
+	u64 *h = histogram_vec[k][j];
+	u32 n_buckets = vec_len (h) - 1;
+	u64 count = 0;
+
+	for (b = 0; b + 1 < n_buckets; b++)
+	  {
+	    count += h[1 + b];
+	    fformat (stream,
+		     "%s_bucket{thread=\"%d\",index=\"%d\",le=\"%llu\"} "
+		     "%llu\n",
+		     name, k, j, stat_histogram_bucket_lower_bound (b + 1) - 1,
+		     count);
+	  }
+	count += h[n_buckets];
+	fformat (stream,
+		 "%s_bucket{thread=\"%d\",index=\"%d\",le=\"+Inf\"} %llu\n",
+		 name, k, j, count);
+	fformat (stream, "%s_sum{thread=\"%d\",index=\"%d\"} %llu\n", name,
+		 k, j, h[0]);
+	fformat (stream, "%s_count{thread=\"%d\",index=\"%d\"} %llu\n",
+		 name, k, j, count);
+      }
+}
+
 static void
 dump_metrics (FILE * stream, u8 ** patterns)
 {
@@ -102,6 +135,11 @@ retry:
 		   res[i].scalar_value);
 	  break;
 
+	case STAT_DIR_TYPE_HISTOGRAM:
+	  dump_histogram (stream, prom_string (res[i].name),
+			  res[i].histogram_vec);
+	  break;
+
 	case STAT_DIR_TYPE_NAME_VECTOR:
 	  fformat (stream, "# TYPE %s_info gauge\n",
 		   prom_string (res[i].name));
@@ -619,7 +619,10 @@ do {							\
   (c) ^= (b); (c) -= hash32_rotate_left ((b), 24);	\
 } while (0)
 
-/* Vector v3 mixing/finalize. */
+/* Vector v3 mixing/finalize, on any u32xN. Each lane gets the result
+   hash_v3_mix32 / hash_v3_finalize32 would give for its words. */
+#define u32x_irotate_left(x,i) (((x) << (i)) | ((x) >> (32 - (i))))
+
 #define hash_v3_mix_step_1_u32x(a,b,c)				\
 do {								\
   (a) -= (c); (a) ^= u32x_irotate_left ((c), 4); (c) += (b);	\
@@ -74,3 +74,82 @@ _pool_init_fixed (void **pool_ptr, uword elt_size, uword max_elts, uword align)
   *pool_ptr = v;
 }
 
+
+__clib_export uword
+pool_free_tail_elts (void *p)
+{
+  pool_header_t *ph;
+  uword len;
+
+  if (!p)
+    return 0;
+
+  ph = pool_header (p);
+  len = vec_len (p);
+
+  while (len && clib_bitmap_get (ph->free_bitmap, len - 1))
+    len--;
+
+  return vec_len (p) - len;
+}
+
+static int
+pool_free_index_cmp (void *a1, void *a2)
+{
+  u32 *i1 = a1, *i2 = a2;
+
+  /* descending, so the lowest free index is the next allocated */
+  return (*i1 < *i2) - (*i1 > *i2);
+}
+
+__clib_export void *
+_pool_shrink (void *p, uword elt_sz)
+{
+  vec_attr_t va = { .hdr_sz = sizeof (pool_header_t), .elt_sz = elt_sz };
+  pool_header_t *nph, *ph;
+  uword len;
+  u32 *fi;
+  void *n;
+
+  if (!p)
+    return p;
+
+  ph = pool_header (p);
+
+  /* Fixed-size pools are preallocated */
+  if (ph->max_elts)
+    return p;
+
+  len = vec_len (p) - pool_free_tail_elts (p);
+
+  if (0 == len)
+    {
+      _pool_free (&p);
+      return p;
+    }
+
+  vec_foreach (fi, ph->free_indices)
+    clib_mem_unpoison (p + elt_sz * fi[0], elt_sz);
+
+  va.align = vec_get_align (p);
+  n = _vec_alloc_internal (len, &va);
+  nph = pool_header (n);
+  clib_memcpy_fast (n, p, len * elt_sz);
+
+  clib_bitmap_alloc (nph->free_bitmap, len);
+  vec_foreach (fi, ph->free_indices)
+    {
+      if (fi[0] >= len)
+	continue;
+      vec_add1 (nph->free_indices, fi[0]);
+      nph->free_bitmap = clib_bitmap_ori_notrim (nph->free_bitmap, fi[0]);
+    }
+  vec_sort_with_function (nph->free_indices, pool_free_index_cmp);
+
+  vec_foreach (fi, nph->free_indices)
+    clib_mem_poison (n + elt_sz * fi[0], elt_sz);
+
+  _pool_free (&p);
+
+  return n;
+}
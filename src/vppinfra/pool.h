@@ -419,6 +419,22 @@ _pool_free (void **v)
 }
 #define pool_free(p) _pool_free ((void **) &(p))
 
+/** Number of free elements at the end of a pool, i.e. the elements that
+    pool_shrink() releases. */
+uword pool_free_tail_elts (void *p);
+
+void *_pool_shrink (void *p, uword elt_sz);
+
+/** Release the free elements at the end of pool P and any unused
+    allocation, and order its free list so that the lowest free indices
+    are allocated first. The in-use elements keep their indices but the
+    pool may move, so no reference to an element may be held across the
+    call.
+
+    @param P pool to shrink, updated in place
+*/
+#define pool_shrink(P) ((P) = _pool_shrink ((void *) (P), _vec_elt_sz (P)))
+
 static_always_inline uword
 pool_get_first_index (void *pool)
 {
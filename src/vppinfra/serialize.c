@@ -41,7 +41,7 @@
 #include <vppinfra/pool.h>
 #include <vppinfra/serialize.h>
 
-void
+__clib_export void
 serialize_64 (serialize_main_t * m, va_list * va)
 {
   u64 x = va_arg (*va, u64);
@@ -73,7 +73,7 @@ serialize_8 (serialize_main_t * m, va_list * va)
   serialize_integer (m, x, sizeof (u8));
 }
 
-void
+__clib_export void
 unserialize_64 (serialize_main_t * m, va_list * va)
 {
   u64 *x = va_arg (*va, u64 *);
@@ -108,7 +108,7 @@ unserialize_8 (serialize_main_t * m, va_list * va)
   x[0] = t;
 }
 
-void
+__clib_export void
 serialize_f64 (serialize_main_t * m, va_list * va)
 {
   f64 x = va_arg (*va, f64);
@@ -134,7 +134,7 @@ serialize_f32 (serialize_main_t * m, va_list * va)
   serialize_integer (m, y.i, sizeof (y.i));
 }
 
-void
+__clib_export void
 unserialize_f64 (serialize_main_t * m, va_list * va)
 {
   f64 *x = va_arg (*va, f64 *);
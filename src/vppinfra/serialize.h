@@ -288,7 +288,7 @@ unserialize_likely_small_unsigned_integer (serialize_main_t * m)
 always_inline void
 serialize_likely_small_signed_integer (serialize_main_t * m, i64 s)
 {
-  u64 u = s < 0 ? -(2 * s + 1) : 2 * s;
+  u64 u = s < 0 ? -(2 * (u64) s + 1) : 2 * (u64) s;
   serialize_likely_small_unsigned_integer (m, u);
 }
 
@@ -297,7 +297,7 @@ unserialize_likely_small_signed_integer (serialize_main_t * m)
 {
   u64 u = unserialize_likely_small_unsigned_integer (m);
   i64 s = u / 2;
-  return (u & 1) ? -s : s;
+  return (u & 1) ? -s - 1 : s;
 }
 
 void
@@ -51,6 +51,27 @@ main (int argc, char *argv[])
 
   pool_validate (tp);
 
+  /* release the top half, the rest keep their index and contents */
+  for (i = NELTS / 2; i < NELTS; i++)
+    pool_put_index (tp, indices[i]);
+
+  fformat (stdout, "%d free tail elts\n", pool_free_tail_elts (tp));
+
+  pool_shrink (tp);
+  pool_validate (tp);
+
+  fformat (stdout, "%d pool len after shrink\n", pool_len (tp));
+  ASSERT (pool_len (tp) == NELTS / 2);
+  ASSERT (pool_elts (tp) == NELTS / 2 - 2);
+
+  for (i = 0; i < NELTS / 2; i++)
+    if (i != 12 && i != 43)
+      ASSERT (*pool_elt_at_index (tp, indices[i]) == i);
+
+  /* the lowest hole is reused first */
+  pool_get (tp, junk);
+  ASSERT (junk - tp == indices[12]);
+
   pool_free (tp);
   return 0;
 }
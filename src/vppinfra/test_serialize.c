@@ -176,6 +176,31 @@ test_serialize_not_inline_double_vector_expand (void)
   return;
 }
 
+static void
+test_serialize_likely_small_signed (void)
+{
+  i64 values[] = { 0, 1, -1, 63, -64, -65, 127, -128, 8191, -8192,
+		   1 << 20, -(1 << 20), 1LL << 40, -(1LL << 40),
+		   CLIB_I64_MAX, -CLIB_I64_MAX - 1 };
+  serialize_main_t _m, *m = &_m;
+  u8 *serialized;
+  int i;
+
+  serialize_open_vector (m, 0);
+  for (i = 0; i < ARRAY_LEN (values); i++)
+    serialize_likely_small_signed_integer (m, values[i]);
+  serialized = serialize_close_vector (m);
+
+  unserialize_open_data (m, serialized, vec_len (serialized));
+  for (i = 0; i < ARRAY_LEN (values); i++)
+    if (unserialize_likely_small_signed_integer (m) != values[i])
+      {
+	fformat (stderr, "BUG! %lld\n", values[i]);
+	exit (1);
+      }
+  vec_free (serialized);
+}
+
 int
 test_serialize_main (unformat_input_t * input)
 {
@@ -214,6 +239,12 @@ test_serialize_main (unformat_input_t * input)
 	  clib_warning ("serialize_not_inline double vector expand OK");
 	  exit (0);
 	}
+      else if (unformat (input, "signed"))
+	{
+	  test_serialize_likely_small_signed ();
+	  clib_warning ("likely small signed integers OK");
+	  exit (0);
+	}
       else
 	{
 	  error = clib_error_create ("unknown input `%U'\n",
@@ -37,3 +37,19 @@ class TestCounters(VppTestCase):
         if error:
             self.logger.critical(error)
             self.assertNotIn("failed", error)
+
+    def test_stats_delta_stream(self):
+        """Stats Delta Stream Round Trip"""
+        error = self.vapi.cli("test stats delta-stream")
+
+        if error:
+            self.logger.critical(error)
+            self.assertNotIn("failed", error)
+
+    def test_stats_histogram(self):
+        """Stats Histogram Buckets"""
+        error = self.vapi.cli("test stats histogram")
+
+        if error:
+            self.logger.critical(error)
+            self.assertNotIn("failed", error)
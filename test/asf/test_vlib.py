@@ -7,6 +7,7 @@ import signal
 from config import config
 from asfframework import VppTestCase, VppTestRunner
 from vpp_ip_route import VppIpTable, VppIpRoute, VppRoutePath
+from vpp_papi_provider import CliFailedCommandError
 from scapy.layers.inet import IP, ICMP
 from scapy.layers.l2 import Ether
 from scapy.packet import Raw
@@ -323,5 +324,121 @@ class TestVlibFrameLeak(VppTestCase):
             self.assertEqual(frame_allocated[key], alloc)
 
 
+class TestVlibFlightRecorder(VppTestCase):
+    """Vlib Flight Recorder Test Cases"""
+
+    vpp_worker_count = 1
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestVlibFlightRecorder, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestVlibFlightRecorder, cls).tearDownClass()
+
+    def test_flight_recorder_snapshot(self):
+        """Flight recorder snapshot, clear and show"""
+
+        # keep the worker busy while the ring is read and cleared
+        self.vapi.cli("loopback create")
+        self.vapi.cli(
+            "packet-generator new {\n"
+            " name fr\n"
+            " limit 0\n"
+            " rate 100000\n"
+            " size 128-128\n"
+            " interface loop0\n"
+            " node ethernet-input\n"
+            " data {\n"
+            "   IP4: 00:d0:2d:5e:86:85 -> 00:0d:ea:d0:00:00\n"
+            "   UDP: 192.168.1.1 -> 192.168.1.2\n"
+            "   UDP: 1234 -> 2345\n"
+            "   incrementing 100\n"
+            "   }\n"
+            "}\n"
+        )
+        self.vapi.cli("packet-generator enable-stream fr")
+
+        for thread in range(2):
+            r = self.vapi.cli("show flight-recorder thread %d" % thread)
+            self.assertIn("Node", r)
+
+        # every main loop iteration takes longer than a microsecond
+        self.vapi.cli("set flight-recorder trigger-loop-time 1")
+        self.sleep(0.1)
+        r = self.vapi.cli("show flight-recorder thread 0 snapshot")
+        self.assertIn("snapshot: loop took", r)
+        r = self.vapi.cli("show flight-recorder thread 1 snapshot")
+        self.assertIn("snapshot: loop took", r)
+
+        # clearing and reading race with the worker writing its ring
+        for i in range(100):
+            self.vapi.cli("clear flight-recorder")
+            r = self.vapi.cli("show flight-recorder thread 1 snapshot count 5")
+            self.assertIn("triggers", r)
+            r = self.vapi.cli("show flight-recorder thread 1 count 5")
+            self.assertIn("Node", r)
+
+        self.vapi.cli("set flight-recorder trigger-loop-time 0")
+        self.vapi.cli("clear flight-recorder")
+        for thread in range(2):
+            r = self.vapi.cli("show flight-recorder thread %d snapshot" % thread)
+            self.assertIn("no snapshot, 0 triggers", r)
+
+        with self.assertRaises(CliFailedCommandError):
+            self.vapi.cli("show flight-recorder thread 2")
+
+        self.vapi.cli("packet-generator disable-stream fr")
+        self.vapi.cli("packet-generator delete fr")
+
+
+class TestVlibBarrierStats(VppTestCase):
+    """Vlib Barrier Stats Test Cases"""
+
+    vpp_worker_count = 1
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestVlibBarrierStats, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestVlibBarrierStats, cls).tearDownClass()
+
+    def test_barrier_stats(self):
+        """Barrier holds are attributed only when enabled"""
+
+        # off by default, nothing is accounted
+        self.vapi.cli("clear barrier-stats")
+        self.vapi.cli("create loopback interface")
+        r = self.vapi.cli("show barrier-stats")
+        self.assertIn("barrier stats disabled", r)
+        self.assertNotIn("create loopback interface", r)
+
+        # CLI commands and API messages are named as the hold site
+        self.vapi.cli("set barrier-stats on stall-threshold 0")
+        self.vapi.cli("create loopback interface")
+        self.vapi.create_loopback()
+        r = self.vapi.cli("show barrier-stats verbose")
+        self.assertNotIn("barrier stats disabled", r)
+        self.assertIn("create loopback interface", r)
+        self.assertIn("create_loopback", r)
+        self.assertIn("hold (us)", r)
+
+        names = self.statistics.get_counter("/sys/barrier/names")
+        self.assertTrue(any("create loopback interface" in n for n in names))
+        holds = self.statistics.get_counter("/sys/barrier/hold-usec")
+        self.assertGreater(len(holds[0]), 0)
+
+        # off again, the counts stay where they were
+        self.vapi.cli("set barrier-stats off")
+        self.vapi.cli("clear barrier-stats")
+        self.vapi.cli("create loopback interface")
+        r = self.vapi.cli("show barrier-stats")
+        self.assertIn("barrier stats disabled", r)
+        self.assertNotIn("create loopback interface", r)
+
+
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
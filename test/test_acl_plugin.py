@@ -2,6 +2,7 @@
 """ACL plugin Test Case HLD:
 """
 
+import re
 import unittest
 import random
 
@@ -13,7 +14,7 @@ from scapy.layers.inet6 import IPv6ExtHdrFragment
 from framework import VppTestCase, VppTestRunner
 from framework import tag_fixme_vpp_workers
 from util import Host, ppp
-from ipaddress import IPv4Network, IPv6Network
+from ipaddress import IPv4Network, IPv6Network, ip_address
 
 from vpp_lo_interface import VppLoInterface
 from vpp_acl import AclRule, VppAcl, VppAclInterface, VppEtypeWhitelist
@@ -1259,6 +1260,431 @@ class TestACLplugin(VppTestCase):
 
         self.logger.info("ACLP_TEST_FINISH_0023")
 
+    def test_0024_udp_deny_port_compiled_lookup(self):
+        """deny single UDPv4/v6 with the compiled lookup"""
+        self.logger.info("ACLP_TEST_START_0024")
+
+        self.vapi.cli("set acl-plugin use-compiled-lookup 1")
+
+        port = random.randint(16384, 65535)
+        # Add an ACL
+        rules = []
+        rules.append(
+            self.create_rule(self.IPV4, self.DENY, port, self.proto[self.IP][self.UDP])
+        )
+        rules.append(
+            self.create_rule(self.IPV6, self.DENY, port, self.proto[self.IP][self.UDP])
+        )
+        # Permit ip any any in the end
+        rules.append(self.create_rule(self.IPV4, self.PERMIT, self.PORTS_ALL, 0))
+        rules.append(self.create_rule(self.IPV6, self.PERMIT, self.PORTS_ALL, 0))
+
+        # Apply rules
+        self.apply_rules(rules, "deny ip4/ip6 udp %d" % port)
+
+        # the classifier is built in the background
+        for i in range(10):
+            reply = self.vapi.cli("show acl-plugin tables compiled")
+            if "applied entries" in reply:
+                break
+            self.sleep(0.1)
+        self.assertIn("applied entries", reply)
+
+        # Traffic should not pass
+        self.run_verify_negat_test(
+            self.IP, self.IPRANDOM, self.proto[self.IP][self.UDP], port
+        )
+
+        self.vapi.cli("set acl-plugin use-compiled-lookup 0")
+        self.logger.info("ACLP_TEST_FINISH_0024")
+
+    def test_0025_port_ranges_compiled_lookup(self):
+        """mixed IPv4/v6 port ranges, compiled lookup against hash"""
+        self.logger.info("ACLP_TEST_START_0025")
+
+        src_hosts = self.hosts_by_pg_idx[self.pg0.sw_if_index]
+        dst_hosts = self.hosts_by_pg_idx[self.pg1.sw_if_index]
+        any4 = IPv4Network("0.0.0.0/0")
+        any6 = IPv6Network("::/0")
+
+        # more rules than fit in one leaf, so the tree has to cut them
+        rules = []
+        for i in range(5):
+            lo = 1000 * (i + 1)
+            for ip, net in ((self.IPV4, any4), (self.IPV6, any6)):
+                proto = self.proto[self.IP][(i + ip) % 2]
+                # a narrow permit in front of a wider deny
+                rules.append(
+                    AclRule(
+                        self.PERMIT,
+                        net,
+                        net,
+                        proto,
+                        dport_from=lo + 100,
+                        dport_to=lo + 199,
+                    )
+                )
+                rules.append(
+                    AclRule(
+                        self.DENY,
+                        net,
+                        net,
+                        proto,
+                        dport_from=lo,
+                        dport_to=lo + 499,
+                    )
+                )
+        rules.append(
+            AclRule(
+                self.DENY,
+                IPv4Network((src_hosts[0].ip4, 32)),
+                any4,
+                self.proto[self.IP][self.UDP],
+                sport_from=2000,
+                sport_to=2999,
+            )
+        )
+        rules.append(
+            AclRule(
+                self.DENY,
+                IPv6Network((src_hosts[0].ip6, 128)),
+                any6,
+                self.proto[self.IP][self.TCP],
+                sport_from=2000,
+                sport_to=2999,
+            )
+        )
+        rules.append(self.create_rule(self.IPV4, self.PERMIT, self.PORTS_ALL, 0))
+        rules.append(self.create_rule(self.IPV6, self.PERMIT, self.PORTS_ALL, 0))
+
+        def first_match(ip, src, proto, sport, dport):
+            for r in rules:
+                if r.src_prefix.version != (6 if ip else 4):
+                    continue
+                if ip_address(src) not in r.src_prefix:
+                    continue
+                if r.proto and (
+                    r.proto != proto
+                    or not r.sport_from <= sport <= r.sport_to
+                    or not r.dport_from <= dport <= r.dport_to
+                ):
+                    continue
+                return r.is_permit
+            return self.DENY
+
+        pkts = []
+        expected = []
+        for i in range(400):
+            info = self.create_packet_info(self.pg0, self.pg1)
+            info.ip = random.choice([self.IPV4, self.IPV6])
+            info.proto = random.choice(self.proto[self.IP])
+            src = random.choice(src_hosts[:2])
+            dst = random.choice(dst_hosts)
+            sport = random.choice([1234, random.randint(2000, 2999)])
+            dport = random.randint(900, 6099)
+            p = Ether(dst=dst.mac, src=src.mac)
+            if info.ip:
+                p /= IPv6(src=src.ip6, dst=dst.ip6)
+            else:
+                p /= IP(src=src.ip4, dst=dst.ip4)
+            if info.proto == self.proto[self.IP][self.TCP]:
+                p /= TCP(sport=sport, dport=dport)
+            else:
+                p /= UDP(sport=sport, dport=dport)
+            p /= Raw(self.info_to_payload(info))
+            pkts.append(p)
+            addr = src.ip6 if info.ip else src.ip4
+            if first_match(info.ip, addr, info.proto, sport, dport):
+                expected.append(info.index)
+
+        self.vapi.cli("set acl-plugin use-compiled-lookup 1")
+        self.apply_rules(rules, "mixed port ranges")
+
+        # the classifier is built in the background
+        for i in range(10):
+            reply = self.vapi.cli("show acl-plugin tables compiled")
+            if "applied entries" in reply and "not built" not in reply:
+                break
+            self.sleep(0.1)
+        self.assertIn("applied entries", reply)
+        self.assertNotIn("not built", reply)
+
+        def passed():
+            self.pg0.add_stream(pkts)
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            rx = self.pg1.get_capture(len(expected))
+            return sorted(self.payload_to_info(p[Raw]).index for p in rx)
+
+        compiled = passed()
+        self.assertEqual(compiled, expected)
+
+        # the hash lookup passes the same packets
+        self.vapi.cli("set acl-plugin use-compiled-lookup 0")
+        self.assertEqual(passed(), compiled)
+
+        self.logger.info("ACLP_TEST_FINISH_0025")
+
+    def applied_entries(self, acls):
+        """
+        The applied hash entries by lc_index of the lookup contexts with the
+        given ACLs, as (acl, rule, action, hash ace info, hitcount, acl pos).
+        """
+        contexts = {}
+        entries = None
+        for line in self.vapi.cli("show acl-plugin tables applied").splitlines():
+            m = re.match(r"lc_index (\d+):", line)
+            if m:
+                lc_index = int(m.group(1))
+                continue
+            m = re.match(r"\s+applied acls: (.*)", line)
+            if m:
+                applied = [int(a) for a in re.findall(r"\d+", m.group(1))]
+                entries = [] if applied == acls else None
+                if entries is not None:
+                    contexts[lc_index] = entries
+                continue
+            m = re.match(
+                r"\s+\d+: acl (\d+) rule (\d+) action (\d+) bitmask-ready rule "
+                r"(\d+) .* hitcount (\d+) acl_pos: (\d+)",
+                line,
+            )
+            if m and entries is not None:
+                entries.append(tuple(int(v) for v in m.groups()))
+        return contexts
+
+    def test_0026_acl_replace_incremental(self):
+        """replace applied ACLs in place, compared to a full reapply"""
+        self.logger.info("ACLP_TEST_START_0026")
+
+        src_host = self.hosts_by_pg_idx[self.pg0.sw_if_index][0]
+        dst_host = self.hosts_by_pg_idx[self.pg1.sw_if_index][0]
+        udp = self.proto[self.IP][self.UDP]
+
+        # the rules are (is_permit, first dport, last dport) here
+        def rule(lo, is_permit=self.PERMIT):
+            return (is_permit, lo, lo + 9)
+
+        def acl_rules(specs):
+            return [
+                AclRule(
+                    is_permit,
+                    proto=udp if lo or hi < 65535 else 0,
+                    dport_from=lo,
+                    dport_to=hi,
+                )
+                for is_permit, lo, hi in specs
+            ]
+
+        def first_match(acls, dport):
+            for specs in acls:
+                for is_permit, lo, hi in specs:
+                    if lo <= dport <= hi:
+                        return is_permit
+            return self.DENY
+
+        dports = range(900, 3200, 5)
+        pkts = [
+            Ether(dst=dst_host.mac, src=src_host.mac)
+            / IP(src=src_host.ip4, dst=dst_host.ip4)
+            / UDP(sport=1234, dport=dport)
+            / Raw(b"\xa5" * 64)
+            for dport in dports
+        ]
+
+        def send_and_check(acls):
+            expected = [d for d in dports if first_match(acls, d)]
+            self.pg0.add_stream(pkts)
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            rx = self.pg1.get_capture(len(expected))
+            self.assertEqual(sorted(p[UDP].dport for p in rx), expected)
+
+        front = [rule(1000), rule(1100, self.DENY), rule(1200)]
+        back = [rule(2000 + 100 * i, i % 3 != 0) for i in range(10)]
+        back.append((self.DENY, 0, 65535))
+        acl_front = VppAcl(self, acl_rules(front), tag="front")
+        acl_front.add_vpp_config()
+        acl_back = VppAcl(self, acl_rules(back), tag="back")
+        acl_back.add_vpp_config()
+        acl_indices = [acl_front.acl_index, acl_back.acl_index]
+
+        # only pg0 has the ACLs applied, so it has the one lookup context
+        VppAclInterface(
+            self,
+            sw_if_index=self.pg0.sw_if_index,
+            n_input=2,
+            acls=[acl_front, acl_back],
+        ).add_vpp_config()
+
+        def replace(new_front, new_back):
+            nonlocal front, back
+            send_and_check([front, back])
+            [(lc_index, old)] = self.applied_entries(acl_indices).items()
+
+            if new_front != front:
+                acl_front.modify_vpp_config(acl_rules(new_front))
+            if new_back != back:
+                acl_back.modify_vpp_config(acl_rules(new_back))
+            new = self.applied_entries(acl_indices)[lc_index]
+
+            # a full apply of the same ACLs on pg1 gives the same entries
+            ref_if = VppAclInterface(
+                self,
+                sw_if_index=self.pg1.sw_if_index,
+                n_input=2,
+                acls=[acl_front, acl_back],
+            )
+            ref_if.add_vpp_config()
+            contexts = self.applied_entries(acl_indices)
+            ref_if.remove_vpp_config()
+            [ref] = [e for lc, e in contexts.items() if lc != lc_index]
+            self.assertEqual(contexts[lc_index], new)
+            self.assertEqual([e[:4] + e[5:] for e in new], [e[:4] + e[5:] for e in ref])
+
+            # the unchanged head and tail of each ACL keep their hitcounts
+            for acl_index, old_specs, new_specs in (
+                (acl_front.acl_index, front, new_front),
+                (acl_back.acl_index, back, new_back),
+            ):
+                n = min(len(old_specs), len(new_specs))
+                head = 0
+                while head < n and old_specs[head] == new_specs[head]:
+                    head += 1
+                tail = 0
+                while tail < n - head and old_specs[-1 - tail] == new_specs[-1 - tail]:
+                    tail += 1
+                old_hits = [e[4] for e in old if e[0] == acl_index]
+                new_hits = [e[4] for e in new if e[0] == acl_index]
+                shift = len(old_specs) - len(new_specs)
+                for i, hits in enumerate(new_hits):
+                    if i < head:
+                        self.assertEqual(hits, old_hits[i])
+                    elif i >= len(new_specs) - tail:
+                        self.assertEqual(hits, old_hits[i + shift])
+                    else:
+                        self.assertEqual(hits, 0)
+
+            front, back = new_front, new_back
+            send_and_check([front, back])
+
+        # replace a range in the middle
+        new_back = list(back)
+        new_back[4:6] = [rule(2450), rule(2550, self.DENY)]
+        replace(front, new_back)
+
+        # grow and shrink in the middle, at the head and at the tail
+        replace(front, back[:3] + [rule(2310, self.DENY), rule(2320)] + back[3:])
+        replace(front, back[:2] + back[7:])
+        replace(front, [rule(2000)] + back)
+        replace(front, back[:-2] + back[-1:])
+
+        # replace the ACL in front of another one in the lookup context
+        replace([rule(1000), rule(2005, self.DENY), rule(1150), rule(1250)], back)
+
+        self.logger.info("ACLP_TEST_FINISH_0026")
+
+    def test_0027_match_batch(self):
+        """batched 5-tuple matching against the single-tuple lookup"""
+        self.logger.info("ACLP_TEST_START_0027")
+
+        tcp = self.proto[self.IP][self.TCP]
+        udp = self.proto[self.IP][self.UDP]
+        net4 = IPv4Network
+        net6 = IPv6Network
+        any4 = net4("0.0.0.0/0")
+        any6 = net6("::/0")
+
+        acls = []
+        for rules in (
+            [
+                AclRule(self.DENY, net4("10.0.0.0/8"), net4("10.1.0.0/16"), tcp),
+                AclRule(
+                    self.PERMIT,
+                    net4("10.0.0.0/8"),
+                    net4("192.168.1.0/24"),
+                    tcp,
+                    sport_from=1000,
+                    sport_to=2000,
+                    dport_from=80,
+                    dport_to=90,
+                ),
+                AclRule(self.DENY, net6("2001:db8::/32"), any6, udp),
+                AclRule(self.PERMIT, any4, any4, 1, self.PORTS_RANGE),
+            ],
+            [
+                AclRule(
+                    self.PERMIT,
+                    net6("2001:db8:5::/48"),
+                    net6("2001:db8:1::/48"),
+                    tcp,
+                    dport_from=443,
+                    dport_to=443,
+                ),
+                AclRule(self.DENY, net4("172.16.0.0/12"), net4("10.0.0.0/8")),
+                AclRule(self.PERMIT, any6, any6, 58, self.PORTS_RANGE),
+                AclRule(self.PERMIT, net4("10.2.0.0/16"), any4, udp, sport_from=53),
+            ],
+            [
+                AclRule(self.DENY, net6("2001:db8::/64"), net6("2001:db8:2::/56")),
+                AclRule(self.PERMIT, net4("10.0.0.0/8"), any4),
+                AclRule(self.PERMIT, any6, any6, udp, dport_from=5000),
+            ],
+        ):
+            acl = VppAcl(self, rules)
+            acl.add_vpp_config()
+            acls.append(acl)
+
+        # three lookup contexts with some of the ACLs in common
+        VppAclInterface(
+            self,
+            sw_if_index=self.pg0.sw_if_index,
+            n_input=2,
+            acls=acls[:2] + acls[::-1],
+        ).add_vpp_config()
+        VppAclInterface(
+            self, sw_if_index=self.pg1.sw_if_index, n_input=2, acls=acls[1:]
+        ).add_vpp_config()
+        lc_indices = []
+        for applied in (acls[:2], acls[1:], acls[::-1]):
+            [lc_index] = self.applied_entries([a.acl_index for a in applied])
+            lc_indices.append(lc_index)
+
+        # one of them uses the compiled lookup, the others the hash lookup
+        self.vapi.cli("set acl-plugin compiled-lookup lc_index %d 1" % lc_indices[0])
+        for i in range(10):
+            reply = self.vapi.cli("show acl-plugin tables compiled")
+            if "lc_index %d: " % lc_indices[0] in reply and "not built" not in reply:
+                break
+            self.sleep(0.1)
+        self.assertIn("lc_index %d: " % lc_indices[0], reply)
+        cmd = "test acl-plugin match-batch count 3001 " + " ".join(
+            "lc_index %d" % lc_index for lc_index in lc_indices
+        )
+
+        def check():
+            reply = self.vapi.cli(cmd)
+            self.logger.info(reply)
+            for af in ("ip4", "ip6"):
+                m = re.search(
+                    r"%s: (\d+) tuples, (\d+) matched, (\d+) mism" % af, reply
+                )
+                self.assertIsNotNone(m, reply)
+                n, n_matched, n_mismatch = (int(v) for v in m.groups())
+                self.assertGreater(n_matched, 0, reply)
+                self.assertLess(n_matched, n, reply)
+                self.assertEqual(n_mismatch, 0, reply)
+
+        check()
+
+        # and everything goes through the linear lookup without the hash
+        self.vapi.cli("set acl-plugin use-hash-acl-matching 0")
+        check()
+        self.vapi.cli("set acl-plugin use-hash-acl-matching 1")
+
+        self.vapi.cli("set acl-plugin compiled-lookup lc_index %d 0" % lc_indices[0])
+        self.logger.info("ACLP_TEST_FINISH_0027")
+
     def test_0108_tcp_permit_v4(self):
         """permit TCPv4 + non-match range"""
         self.logger.info("ACLP_TEST_START_0108")
@@ -0,0 +1,268 @@
+#!/usr/bin/env python3
+"""ACL plugin session table variants"""
+
+import re
+import unittest
+
+from framework import VppTestCase, VppTestRunner
+from scapy.layers.l2 import Ether
+from scapy.layers.inet import IP, UDP
+from scapy.layers.inet6 import IPv6
+from scapy.packet import Raw
+from ipaddress import ip_network
+
+from vpp_acl import AclRule, VppAcl, VppAclInterface
+
+
+class ACLSessionsTestCase(VppTestCase):
+    """Common setup: reflect UDP from pg0 to pg1, deny the rest"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(ACLSessionsTestCase, cls).setUpClass()
+        cls.create_pg_interfaces(range(2))
+        for i in cls.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.config_ip6()
+            i.resolve_arp()
+            i.resolve_ndp()
+
+    @classmethod
+    def tearDownClass(cls):
+        for i in cls.pg_interfaces:
+            i.unconfig_ip4()
+            i.unconfig_ip6()
+            i.admin_down()
+        super(ACLSessionsTestCase, cls).tearDownClass()
+
+    def setUp(self):
+        super(ACLSessionsTestCase, self).setUp()
+        any4 = ip_network("0.0.0.0/0")
+        any6 = ip_network("::/0")
+        reflect = VppAcl(
+            self,
+            [
+                AclRule(
+                    is_permit=2,
+                    proto=17,
+                    src_prefix=ip_network((self.pg0.remote_ip4, 32)),
+                    dst_prefix=ip_network((self.pg1.remote_ip4, 32)),
+                ),
+                AclRule(
+                    is_permit=2,
+                    proto=17,
+                    src_prefix=ip_network((self.pg0.remote_ip6, 128)),
+                    dst_prefix=ip_network((self.pg1.remote_ip6, 128)),
+                ),
+                AclRule(is_permit=0, src_prefix=any4, dst_prefix=any4),
+                AclRule(is_permit=0, src_prefix=any6, dst_prefix=any6),
+            ],
+        )
+        reflect.add_vpp_config()
+        deny = VppAcl(
+            self,
+            [
+                AclRule(is_permit=0, src_prefix=any4, dst_prefix=any4),
+                AclRule(is_permit=0, src_prefix=any6, dst_prefix=any6),
+            ],
+        )
+        deny.add_vpp_config()
+        # reflect on the input of pg0, the replies are let out by the session
+        VppAclInterface(
+            self, self.pg0.sw_if_index, [reflect, deny], n_input=1
+        ).add_vpp_config()
+
+    def tearDown(self):
+        self.clear_sessions()
+        super(ACLSessionsTestCase, self).tearDown()
+
+    def show_commands_at_teardown(self):
+        self.logger.info(self.vapi.cli("show acl-plugin sessions"))
+        self.logger.info(self.vapi.cli("show acl-plugin interface"))
+        self.logger.info(self.vapi.cli("show errors"))
+
+    def flows(self, sports, reply=False, is_ip6=False):
+        src, dst = (self.pg1, self.pg0) if reply else (self.pg0, self.pg1)
+        if is_ip6:
+            ip = IPv6(src=src.remote_ip6, dst=dst.remote_ip6)
+        else:
+            ip = IP(src=src.remote_ip4, dst=dst.remote_ip4)
+        pkts = []
+        for sport in sports:
+            ports = (4242, sport) if reply else (sport, 4242)
+            pkts.append(
+                Ether(dst=src.local_mac, src=src.remote_mac)
+                / ip
+                / UDP(sport=ports[0], dport=ports[1])
+                / Raw(b"\xa5" * 100)
+            )
+        return pkts
+
+    def show_sessions(self, pattern):
+        """values of a field of show acl-plugin sessions, on all threads"""
+        reply = self.vapi.cli("show acl-plugin sessions")
+        return [int(v) for v in re.findall(pattern, reply)]
+
+    def n_sessions(self):
+        return self.show_sessions(r"Sessions total: add \d+ - del \d+ = (\d+)")[0]
+
+    def clear_sessions(self):
+        # the sessions are cleared by the cleaner process
+        self.vapi.cli("clear acl-plugin sessions")
+        for i in range(10):
+            if self.n_sessions() == 0:
+                break
+            self.sleep(0.1)
+        self.assertEqual(self.n_sessions(), 0)
+
+    def err(self, node, name):
+        """per-thread values of a node error counter"""
+        return self.statistics.get_counter("/err/%s/%s" % (node, name))
+
+
+class TestACLPerWorkerSessions(ACLSessionsTestCase):
+    """ACL plugin per-worker session tables with handoff"""
+
+    vpp_worker_count = 2
+    extra_vpp_config = ["acl-plugin", "{", "per-worker", "sessions", "handoff", "}"]
+
+    def counters(self):
+        return [
+            self.err("acl-plugin-in-ip4-fa", "new sessions added"),
+            self.err("acl-plugin-out-ip4-fa", "existing session packets"),
+            self.err("acl-plugin-in-ip4-fa", "packets handed off to the session owner"),
+            self.err("acl-plugin-in-ip4-fa", "session owner handoff congestion drops"),
+        ]
+
+    def counters_diff(self, before):
+        return [
+            [a - b for a, b in zip(after, prev)]
+            for after, prev in zip(self.counters(), before)
+        ]
+
+    def test_owner_both_directions(self):
+        """both directions of a flow are handled by its owner"""
+        sports = range(1000, 1032)
+        before = self.counters()
+
+        # the flows are set up from worker 0 and answered from worker 1
+        self.send_and_expect(self.pg0, self.flows(sports), self.pg1, worker=0)
+        self.send_and_expect(
+            self.pg1, self.flows(sports, reply=True), self.pg0, worker=1
+        )
+
+        added, found, handoff, dropped = self.counters_diff(before)
+
+        # the sessions are spread over the workers, never on main, and
+        # each reply was checked on the thread which holds its session
+        self.assertEqual(sum(added), len(sports))
+        self.assertEqual(added[0], 0)
+        self.assertNotEqual(added[1], 0)
+        self.assertNotEqual(added[2], 0)
+        self.assertEqual(found, added)
+        self.assertEqual(handoff[1], added[2])
+
+    def test_handoff_congestion(self):
+        """packets dropped on handoff congestion are counted"""
+        sports = range(2000, 2064)
+        self.send_and_expect(self.pg0, self.flows(sports), self.pg1, worker=0)
+        before = self.counters()
+
+        # both workers send a burst of the same flows at the same time
+        pkts = self.flows(sports) * 64
+        for worker in [0, 1]:
+            self.pg0.add_stream(pkts, worker=worker)
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+
+        added, found, handoff, dropped = self.counters_diff(before)
+
+        # every packet is either forwarded or counted as dropped
+        self.pg1.get_capture(2 * len(pkts) - sum(dropped))
+        self.assertEqual(sum(added), 0)
+        self.assertNotEqual(handoff[1], 0)
+        self.assertNotEqual(handoff[2], 0)
+
+
+class TestACLSessionTimerWheel(ACLSessionsTestCase):
+    """ACL plugin session aging with a timer wheel"""
+
+    extra_vpp_config = ["acl-plugin", "{", "use", "session", "timer", "wheel", "1", "}"]
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestACLSessionTimerWheel, cls).setUpClass()
+        cls.vapi.cli("set acl-plugin session timeout udp idle 1")
+
+    def test_idle_and_active(self):
+        """idle sessions expire, traffic re-arms the timer"""
+        self.assertIn(
+            "Session aging: timer wheel", self.vapi.cli("show acl-plugin sessions")
+        )
+        self.send_and_expect(self.pg0, self.flows([1000, 1001]), self.pg1)
+        self.assertEqual(self.n_sessions(), 2)
+        restarted = sum(self.show_sessions(r"Session timers restarted: (\d+)"))
+
+        # keep the first flow active for longer than the idle timeout
+        active = self.flows([1000], reply=True)
+        for i in range(6):
+            self.send_and_expect(self.pg1, active, self.pg0)
+            self.sleep(0.4)
+
+        # its timer fired and was armed again, the idle flow is gone
+        self.assertEqual(self.n_sessions(), 1)
+        self.assertGreater(
+            sum(self.show_sessions(r"Session timers restarted: (\d+)")), restarted
+        )
+        self.send_and_assert_no_replies(self.pg1, self.flows([1001], reply=True))
+        self.send_and_expect(self.pg1, active, self.pg0)
+
+        # left idle, the first flow expires as well
+        self.sleep(2.5)
+        self.assertEqual(self.n_sessions(), 0)
+        self.send_and_assert_no_replies(self.pg1, active)
+
+    def test_interface_clear(self):
+        """clearing the interface sessions"""
+        sports = range(2000, 2016)
+        self.send_and_expect(self.pg0, self.flows(sports), self.pg1)
+        self.assertEqual(self.n_sessions(), len(sports))
+
+        self.clear_sessions()
+        self.send_and_assert_no_replies(self.pg1, self.flows(sports, reply=True))
+
+
+class TestACLCompactSessions(ACLSessionsTestCase):
+    """ACL plugin compact sessions"""
+
+    extra_vpp_config = ["acl-plugin", "{", "use", "compact", "sessions", "1", "}"]
+
+    def test_ip4_sessions(self):
+        """IPv4 sessions in the compact layout"""
+        self.assertIn(
+            "Session layout: compact", self.vapi.cli("show acl-plugin sessions")
+        )
+        sports = range(3000, 3016)
+        self.send_and_expect(self.pg0, self.flows(sports), self.pg1)
+        self.assertEqual(self.n_sessions(), len(sports))
+
+        # the replies pass on the sessions, other traffic does not
+        self.send_and_expect(self.pg1, self.flows(sports, reply=True), self.pg0)
+        self.send_and_assert_no_replies(
+            self.pg1, self.flows(range(4000, 4016), reply=True)
+        )
+
+    def test_no_ip6_sessions(self):
+        """IPv6 flows needing a session are dropped and counted"""
+        no_ip6 = "/err/acl-plugin-in-ip6-fa/no IPv6 sessions in compact mode"
+        before = self.statistics.get_err_counter(no_ip6)
+        sports = range(5000, 5016)
+
+        self.send_and_assert_no_replies(self.pg0, self.flows(sports, is_ip6=True))
+        self.assertEqual(self.statistics.get_err_counter(no_ip6) - before, len(sports))
+        self.assertEqual(self.n_sessions(), 0)
+
+
+if __name__ == "__main__":
+    unittest.main(testRunner=VppTestRunner)
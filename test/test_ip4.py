@@ -18,6 +18,7 @@ from framework import VppTestCase, VppTestRunner
 from util import ppp
 from vpp_ip_route import (
     VppIpRoute,
+    VppIpRouteV2,
     VppRoutePath,
     VppIpMRoute,
     VppMRoutePath,
@@ -35,6 +36,7 @@ from vpp_sub_interface import VppSubInterface, VppDot1QSubint, VppDot1ADSubint
 from vpp_papi import vpp_papi, VppEnum
 from vpp_neighbor import VppNeighbor
 from vpp_lo_interface import VppLoInterface
+from vpp_ipip_tun_interface import VppIpIpTunInterface
 from vpp_policer import VppPolicer, PolicerAction
 
 NUM_PKTS = 67
@@ -1373,6 +1375,25 @@ class TestIPLoadBalance(VppTestCase):
 
         self.send_and_expect_only(self.pg0, port_gtp_pkts, self.pg2)
 
+        #
+        # use the NIC's flow hash. the pg interfaces don't provide one
+        # so the hash is computed from the configured fields
+        #
+        self.vapi.set_ip_flow_hash_v3(
+            af=af.ADDRESS_IP4,
+            table_id=0,
+            flow_hash_config=(
+                fhcv2.IP_API_V2_FLOW_HASH_SRC_IP
+                | fhcv2.IP_API_V2_FLOW_HASH_DST_IP
+                | fhcv2.IP_API_V2_FLOW_HASH_PROTO
+                | fhcv2.IP_API_V2_FLOW_HASH_RX_HASH
+            ),
+        )
+        self.assertIn("rxhash", self.vapi.cli("show ip fib summary"))
+
+        self.send_and_expect_load_balancing(self.pg0, src_ip_pkts, [self.pg1, self.pg2])
+        self.send_and_expect_only(self.pg0, port_ip_pkts, self.pg2)
+
         #
         # change the flow hash config back to defaults
         #
@@ -1557,6 +1578,150 @@ class TestIPLoadBalance(VppTestCase):
         )
         self.assertEqual(len(src_pkts), self.total_len(rx))
 
+    def test_ip_load_balance_resilient(self):
+        """IP Resilient Load-Balancing"""
+
+        rf = VppEnum.vl_api_ip_route_flags_t
+
+        pkts = []
+        for ii in range(NUM_PKTS):
+            pkts.append(
+                Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+                / IP(dst="10.0.0.1", src="20.0.0.1")
+                / UDP(sport=1234 + ii, dport=1234)
+                / Raw(b"\xa5" * 100)
+            )
+
+        def flows(outputs):
+            rxs = self.send_and_expect_load_balancing(self.pg0, pkts, outputs)
+            by_port = {}
+            for itf, rx in zip(outputs, rxs):
+                for p in rx:
+                    by_port[p[UDP].sport] = itf
+            self.assertEqual(len(by_port), NUM_PKTS)
+            return by_port
+
+        paths = [
+            VppRoutePath(self.pg1.remote_ip4, self.pg1.sw_if_index),
+            VppRoutePath(self.pg2.remote_ip4, self.pg2.sw_if_index),
+        ]
+        route = VppIpRouteV2(
+            self, "10.0.0.1", 32, paths, flags=rf.IP_API_ROUTE_FLAG_RESILIENT
+        )
+        route.add_vpp_config()
+
+        routes = self.vapi.ip_route_v2_dump(0)
+        for r in routes:
+            if str(r.route.prefix) == "10.0.0.1/32":
+                self.assertEqual(r.route.flags, rf.IP_API_ROUTE_FLAG_RESILIENT)
+                break
+        else:
+            self.fail("resilient route not dumped")
+
+        before = flows([self.pg1, self.pg2])
+
+        #
+        # a new path only takes flows, those that stay on the old paths
+        # are not moved between them
+        #
+        route.modify(paths + [VppRoutePath(self.pg3.remote_ip4, self.pg3.sw_if_index)])
+        after = flows([self.pg1, self.pg2, self.pg3])
+
+        for port, itf in after.items():
+            if itf != self.pg3:
+                self.assertEqual(before[port], itf)
+
+        #
+        # removing it moves only its flows
+        #
+        route.modify(paths)
+        for port, itf in flows([self.pg1, self.pg2]).items():
+            if after[port] != self.pg3:
+                self.assertEqual(after[port], itf)
+
+        route.remove_vpp_config()
+
+    def test_ip_load_balance_rx_hash(self):
+        """IP Load-Balancing on the device's flow hash"""
+
+        fhcv2 = VppEnum.vl_api_ip_flow_hash_config_v2_t
+        af = VppEnum.vl_api_address_family_t
+
+        #
+        # packets that differ in the source address, sent directly and
+        # through an IPIP tunnel
+        #
+        pkts = []
+        tun_pkts = []
+        for ii in range(NUM_PKTS):
+            ip_hdr = (
+                IP(dst="10.0.0.1", src="20.0.0.%d" % ii)
+                / UDP(sport=1234, dport=1234)
+                / Raw(b"\xa5" * 100)
+            )
+            pkts.append(Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac) / ip_hdr)
+            tun_pkts.append(
+                Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+                / IP(src=self.pg0.remote_ip4, dst=self.pg0.local_ip4)
+                / ip_hdr
+            )
+
+        route = VppIpRoute(
+            self,
+            "10.0.0.1",
+            32,
+            [
+                VppRoutePath(self.pg1.remote_ip4, self.pg1.sw_if_index),
+                VppRoutePath(self.pg2.remote_ip4, self.pg2.sw_if_index),
+            ],
+        )
+        route.add_vpp_config()
+
+        self.vapi.set_ip_flow_hash_v3(
+            af=af.ADDRESS_IP4,
+            table_id=0,
+            flow_hash_config=(
+                fhcv2.IP_API_V2_FLOW_HASH_SRC_IP
+                | fhcv2.IP_API_V2_FLOW_HASH_DST_IP
+                | fhcv2.IP_API_V2_FLOW_HASH_PROTO
+                | fhcv2.IP_API_V2_FLOW_HASH_RX_HASH
+            ),
+        )
+
+        def send(pkts, rx_flow_hash):
+            self.pg0.add_stream(pkts, rx_flow_hash=rx_flow_hash)
+            self.pg_enable_capture(self.pg_interfaces)
+            self.pg_start()
+            return [len(itf._get_capture(1) or []) for itf in (self.pg1, self.pg2)]
+
+        #
+        # with the device's hash the packets of one hash all take the
+        # same path, those of the next hash the other
+        #
+        n_rx = send(pkts, 0x10)
+        self.assertEqual(sorted(n_rx), [0, NUM_PKTS])
+        self.assertEqual(send(pkts, 0x11), n_rx[::-1])
+
+        #
+        # a tunnel drops the hash of the outer header, the inner packets
+        # are hashed on their own
+        #
+        tun = VppIpIpTunInterface(
+            self, self.pg0, self.pg0.local_ip4, self.pg0.remote_ip4
+        )
+        tun.add_vpp_config()
+        tun.admin_up()
+        tun.config_ip4()
+
+        n_rx = send(tun_pkts, 0x10)
+        self.assertEqual(sum(n_rx), NUM_PKTS)
+        self.assertNotIn(0, n_rx)
+
+        tun.unconfig_ip4()
+        tun.remove_vpp_config()
+        route.remove_vpp_config()
+        self.vapi.set_ip_flow_hash(vrf_id=0, src=1, dst=1, proto=1, sport=1, dport=1)
+
 
 class TestIPVlan0(VppTestCase):
     """IPv4 VLAN-0"""
@@ -2831,6 +2996,337 @@ class TestIPCover(VppTestCase):
         a.remove_vpp_config()
 
 
+class TestIPBulk(VppTestCase):
+    """IPv4 Bulk Routes"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestIPBulk, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestIPBulk, cls).tearDownClass()
+
+    def setUp(self):
+        super(TestIPBulk, self).setUp()
+
+        self.create_pg_interfaces(range(2))
+
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+    def tearDown(self):
+        super(TestIPBulk, self).tearDown()
+        for i in self.pg_interfaces:
+            i.unconfig_ip4()
+            i.admin_down()
+
+    def test_bulk(self):
+        """IP Bulk Routes"""
+
+        #
+        # a recursive route whose via resolves through the default route
+        # until the bulk add gives it a better cover
+        #
+        r = VppIpRoute(
+            self, "1.1.1.1", 32, [VppRoutePath("10.10.10.10", 0xFFFFFFFF)]
+        ).add_vpp_config()
+
+        prefixes = ["10.%d.0.0/16" % i for i in range(16)]
+        # the paths are a fixed size array
+        path = VppRoutePath(self.pg1.remote_ip4, self.pg1.sw_if_index)
+        paths = [path.encode()] * 16
+
+        rv = self.vapi.ip_route_add_del_bulk(
+            is_add=1,
+            table_id=0,
+            n_paths=1,
+            paths=paths,
+            n_prefixes=len(prefixes),
+            prefixes=prefixes,
+        )
+        self.assertEqual(rv.n_done, len(prefixes))
+
+        for pfx in prefixes:
+            a, l = pfx.split("/")
+            self.assertTrue(find_route(self, a, int(l)))
+
+        pkt = (
+            Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+            / IP(src=self.pg0.remote_ip4, dst="1.1.1.1")
+            / UDP(sport=1234, dport=1234)
+            / Raw(b"\xa5" * 100)
+        )
+        self.send_and_expect(self.pg0, pkt * NUM_PKTS, self.pg1)
+
+        #
+        # a prefix of the wrong family stops the batch
+        #
+        with self.vapi.assert_negative_api_retval():
+            rv = self.vapi.ip_route_add_del_bulk(
+                is_add=1,
+                table_id=0,
+                n_paths=1,
+                paths=paths,
+                n_prefixes=2,
+                prefixes=["11.0.0.0/8", "2001::/16"],
+            )
+        self.assertEqual(rv.n_done, 1)
+        self.assertTrue(find_route(self, "11.0.0.0", 8))
+
+        rv = self.vapi.ip_route_add_del_bulk(
+            is_add=0,
+            table_id=0,
+            n_paths=1,
+            paths=paths,
+            n_prefixes=len(prefixes) + 1,
+            prefixes=prefixes + ["11.0.0.0/8"],
+        )
+        self.assertEqual(rv.n_done, len(prefixes) + 1)
+
+        for pfx in prefixes:
+            a, l = pfx.split("/")
+            self.assertFalse(find_route(self, a, int(l)))
+
+        self.send_and_assert_no_replies(self.pg0, pkt * NUM_PKTS)
+        r.remove_vpp_config()
+
+    def wait_for_mtrie_updates(self):
+        for i in range(100):
+            if " 0 pending" in self.vapi.cli("show ip fib mtrie-stats"):
+                return
+            self.sleep(0.1)
+        self.fail("mtrie updates still pending")
+
+    def test_bulk_background(self):
+        """IP Bulk Routes with background mtrie updates"""
+
+        self.vapi.cli("set ip fib mtrie-update background")
+
+        #
+        # enough prefixes that the mtrie is updated in several chunks
+        #
+        prefixes = ["20.%d.%d.0/24" % (i // 256, i % 256) for i in range(3000)]
+        path = VppRoutePath(self.pg1.remote_ip4, self.pg1.sw_if_index)
+        paths = [path.encode()] * 16
+
+        rv = self.vapi.ip_route_add_del_bulk(
+            is_add=1,
+            table_id=0,
+            n_paths=1,
+            paths=paths,
+            n_prefixes=len(prefixes),
+            prefixes=prefixes,
+        )
+        self.assertEqual(rv.n_done, len(prefixes))
+        self.wait_for_mtrie_updates()
+
+        pkts = [
+            (
+                Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+                / IP(src=self.pg0.remote_ip4, dst="20.%d.%d.1" % (i // 256, i % 256))
+                / UDP(sport=1234, dport=1234)
+                / Raw(b"\xa5" * 100)
+            )
+            for i in range(0, 3000, 97)
+        ]
+        self.send_and_expect(self.pg0, pkts, self.pg1)
+
+        rv = self.vapi.ip_route_add_del_bulk(
+            is_add=0,
+            table_id=0,
+            n_paths=1,
+            paths=paths,
+            n_prefixes=len(prefixes),
+            prefixes=prefixes,
+        )
+        self.assertEqual(rv.n_done, len(prefixes))
+        self.wait_for_mtrie_updates()
+
+        self.send_and_assert_no_replies(self.pg0, pkts)
+
+        self.vapi.cli("set ip fib mtrie-update inline")
+
+    def wait_for_route_queue(self, n_requests):
+        """the events of the asynchronous bulk requests, by context"""
+        events = {}
+        for i in range(n_requests):
+            e = self.vapi.wait_for_event(10, "ip_route_add_del_bulk_event")
+            events[e.request_context] = e
+        self.assertTrue(self.vapi.cli("show fib route-queue").startswith("0 pending"))
+        return events
+
+    def test_bulk_async(self):
+        """IP Bulk Routes queued on several tables"""
+
+        tables = [VppIpTable(self, t).add_vpp_config() for t in range(1, 4)]
+        prefixes = ["20.%d.%d.0/24" % (i // 256, i % 256) for i in range(1000)]
+        path = VppRoutePath(self.pg1.remote_ip4, self.pg1.sw_if_index)
+        paths = [path.encode()] * 16
+
+        for t in tables:
+            rv = self.vapi.ip_route_add_del_bulk(
+                is_add=1,
+                is_async=1,
+                table_id=t.table_id,
+                n_paths=1,
+                paths=paths,
+                n_prefixes=len(prefixes),
+                prefixes=prefixes,
+                context=100 + t.table_id,
+            )
+            self.assertEqual(rv.n_done, len(prefixes))
+        events = self.wait_for_route_queue(len(tables))
+
+        for t in tables:
+            e = events[100 + t.table_id]
+            self.assertEqual(e.table_id, t.table_id)
+            self.assertEqual(e.retval, 0)
+            self.assertEqual(e.n_applied, len(prefixes))
+            self.assertEqual(e.n_failed, 0)
+            for i in range(0, 1000, 97):
+                self.assertTrue(
+                    find_route(self, "20.%d.%d.0" % (i // 256, i % 256), 24, t.table_id)
+                )
+
+        #
+        # the updates to a table are applied in order
+        #
+        for is_add in [0, 1]:
+            rv = self.vapi.ip_route_add_del_bulk(
+                is_add=is_add,
+                is_async=1,
+                table_id=2,
+                n_paths=1,
+                paths=paths,
+                n_prefixes=len(prefixes),
+                prefixes=prefixes,
+            )
+        self.wait_for_route_queue(2)
+        self.assertTrue(find_route(self, "20.0.0.0", 24, 2))
+
+        #
+        # the queued routes that fail are reported to the client
+        #
+        rv = self.vapi.ip_route_add_del_bulk(
+            is_add=1,
+            is_async=1,
+            table_id=1,
+            n_paths=0,
+            paths=paths,
+            n_prefixes=10,
+            prefixes=["21.0.0.%d/32" % i for i in range(10)],
+            context=200,
+        )
+        self.assertEqual(rv.n_done, 10)
+        e = self.wait_for_route_queue(1)[200]
+        self.assertEqual(e.retval, -52)  # NO_PATHS_IN_ROUTE
+        self.assertEqual(e.n_applied, 0)
+        self.assertEqual(e.n_failed, 10)
+
+        #
+        # a synchronous update applies the table's queued routes first,
+        # so they do not override it
+        #
+        rv = self.vapi.ip_route_add_del_bulk(
+            is_add=0,
+            is_async=1,
+            table_id=3,
+            n_paths=1,
+            paths=paths,
+            n_prefixes=len(prefixes),
+            prefixes=prefixes,
+        )
+        route = VppIpRoute(self, "20.0.5.0", 24, [path], table_id=3)
+        route.add_vpp_config()
+        self.wait_for_route_queue(1)
+        self.assertTrue(find_route(self, "20.0.5.0", 24, 3))
+        self.assertFalse(find_route(self, "20.0.6.0", 24, 3))
+        route.remove_vpp_config()
+
+        for t in tables[:2]:
+            rv = self.vapi.ip_route_add_del_bulk(
+                is_add=0,
+                is_async=1,
+                table_id=t.table_id,
+                n_paths=1,
+                paths=paths,
+                n_prefixes=len(prefixes),
+                prefixes=prefixes,
+            )
+        self.wait_for_route_queue(2)
+
+        for t in tables:
+            self.assertFalse(find_route(self, "20.0.0.0", 24, t.table_id))
+            t.remove_vpp_config()
+
+    def test_bulk_compact(self):
+        """IP Bulk Routes memory compaction"""
+
+        prefixes = ["20.%d.%d.0/24" % (i // 256, i % 256) for i in range(2000)]
+        path = VppRoutePath(self.pg1.remote_ip4, self.pg1.sw_if_index)
+        paths = [path.encode()] * 16
+
+        self.vapi.ip_route_add_del_bulk(
+            is_add=1,
+            table_id=0,
+            n_paths=1,
+            paths=paths,
+            n_prefixes=len(prefixes),
+            prefixes=prefixes,
+        )
+
+        #
+        # remove all but the first 10 routes, the pools' tails are then free
+        #
+        self.vapi.ip_route_add_del_bulk(
+            is_add=0,
+            table_id=0,
+            n_paths=1,
+            paths=paths,
+            n_prefixes=len(prefixes) - 10,
+            prefixes=prefixes[10:],
+        )
+        self.assertIn("released", self.vapi.cli("clear fib memory"))
+
+        #
+        # the remaining routes still forward, and the removed ones can
+        # be added back
+        #
+        pkts = [
+            (
+                Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+                / IP(src=self.pg0.remote_ip4, dst="20.0.%d.1" % i)
+                / UDP(sport=1234, dport=1234)
+                / Raw(b"\xa5" * 100)
+            )
+            for i in range(10)
+        ]
+        self.send_and_expect(self.pg0, pkts, self.pg1)
+
+        self.vapi.ip_route_add_del_bulk(
+            is_add=1,
+            table_id=0,
+            n_paths=1,
+            paths=paths,
+            n_prefixes=len(prefixes) - 10,
+            prefixes=prefixes[10:],
+        )
+        self.assertTrue(find_route(self, "20.7.207.0", 24))
+
+        self.vapi.ip_route_add_del_bulk(
+            is_add=0,
+            table_id=0,
+            n_paths=1,
+            paths=paths,
+            n_prefixes=len(prefixes),
+            prefixes=prefixes,
+        )
+        self.vapi.cli("clear fib memory")
+
+
 class TestIP4Replace(VppTestCase):
     """IPv4 Interface Address Replace"""
 
@@ -2071,6 +2071,155 @@ class TestIP6Null(VppTestCase):
         self.assertEqual(icmp.code, 1)
 
 
+class TestIP6Mtrie(VppTestCase):
+    """IPv6 mtrie forwarding lookup"""
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestIP6Mtrie, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestIP6Mtrie, cls).tearDownClass()
+
+    def setUp(self):
+        super(TestIP6Mtrie, self).setUp()
+
+        self.create_pg_interfaces(range(3))
+
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip6()
+            i.resolve_ndp()
+
+    def tearDown(self):
+        self.vapi.cli("set ip6 fib lookup table 0 hash")
+        super(TestIP6Mtrie, self).tearDown()
+        for i in self.pg_interfaces:
+            i.unconfig_ip6()
+            i.admin_down()
+
+    def send_and_expect_lpm(self, expected):
+        for dst, itf in expected.items():
+            p = (
+                Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+                / IPv6(src=self.pg0.remote_ip6, dst=dst)
+                / inet6.UDP(sport=1234, dport=1234)
+                / Raw(b"\xa5" * 100)
+            )
+            # enough packets to use the batched lookup
+            rx = self.send_and_expect(self.pg0, p * 7, itf)
+            for r in rx:
+                self.assertEqual(r[IPv6].dst, dst)
+
+    def test_ip6_mtrie(self):
+        """IPv6 mtrie lookup"""
+
+        routes = [
+            ("2001:db8:1::", 48, self.pg1),
+            ("2001:db8:1:2::8", 126, self.pg2),
+            ("2001:db8:1:2::a", 128, self.pg1),
+            ("2001:db8:1:2:300::", 72, self.pg2),
+        ]
+        for addr, plen, itf in routes:
+            VppIpRoute(
+                self,
+                addr,
+                plen,
+                [VppRoutePath(itf.remote_ip6, itf.sw_if_index)],
+            ).add_vpp_config()
+
+        expected = {
+            "2001:db8:1:2::5": self.pg1,
+            "2001:db8:1:2::8": self.pg2,
+            "2001:db8:1:2::a": self.pg1,
+            "2001:db8:1:2::b": self.pg2,
+            "2001:db8:1:2:3ff::1": self.pg2,
+            "2001:db8:1:2:400::1": self.pg1,
+        }
+
+        #
+        # the mtrie, built from the existing routes, and the hash agree
+        #
+        self.send_and_expect_lpm(expected)
+        self.vapi.cli("set ip6 fib lookup table 0 mtrie")
+        self.assertIn("lookup:mtrie", self.vapi.cli("show ip6 fib summary"))
+        self.send_and_expect_lpm(expected)
+
+        #
+        # routes added and removed while the mtrie is in use
+        #
+        r = VppIpRoute(
+            self,
+            "2001:db8:1:2::",
+            64,
+            [VppRoutePath(self.pg2.remote_ip6, self.pg2.sw_if_index)],
+        )
+        r.add_vpp_config()
+        expected["2001:db8:1:2::5"] = self.pg2
+        expected["2001:db8:1:2:400::1"] = self.pg2
+        self.send_and_expect_lpm(expected)
+
+        r.remove_vpp_config()
+        expected["2001:db8:1:2::5"] = self.pg1
+        expected["2001:db8:1:2:400::1"] = self.pg1
+        self.send_and_expect_lpm(expected)
+
+        self.vapi.cli("set ip6 fib lookup table 0 hash")
+        self.send_and_expect_lpm(expected)
+
+
+class TestIP6MtrieDefault(VppTestCase):
+    """IPv6 mtrie lookup in new tables"""
+
+    extra_vpp_config = ["ip6", "{", "mtrie-lookup", "}"]
+
+    @classmethod
+    def setUpClass(cls):
+        super(TestIP6MtrieDefault, cls).setUpClass()
+
+    @classmethod
+    def tearDownClass(cls):
+        super(TestIP6MtrieDefault, cls).tearDownClass()
+
+    def setUp(self):
+        super(TestIP6MtrieDefault, self).setUp()
+
+        self.create_pg_interfaces(range(2))
+
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip6()
+            i.resolve_ndp()
+
+    def tearDown(self):
+        super(TestIP6MtrieDefault, self).tearDown()
+        for i in self.pg_interfaces:
+            i.unconfig_ip6()
+            i.admin_down()
+
+    def test_ip6_mtrie_link_local(self):
+        """IPv6 link-local tables keep the hash lookup"""
+
+        self.assertIn("lookup:mtrie", self.vapi.cli("show ip6 fib summary"))
+
+        # the per-interface link-local tables don't pay for a root ply
+        ll = self.vapi.cli("show ip6-ll summary")
+        self.assertIn("lookup:hash", ll)
+        self.assertNotIn("lookup:mtrie", ll)
+
+        # and link-local addresses are still reachable
+        p = (
+            Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+            / IPv6(src=self.pg0.remote_ip6, dst=self.pg0.local_ip6_ll)
+            / ICMPv6EchoRequest()
+        )
+        rx = self.send_and_expect(self.pg0, p * 7, self.pg0)
+        for r in rx:
+            self.assertEqual(r[IPv6].src, self.pg0.local_ip6_ll)
+            self.assertEqual(r[IPv6].dst, self.pg0.remote_ip6)
+
+
 class TestIP6Disabled(VppTestCase):
     """IPv6 disabled"""
 
@@ -8,11 +8,13 @@ import re
 import scapy.compat
 from framework import tag_fixme_ubuntu2204, is_distro_ubuntu2204
 from framework import VppTestCase, VppTestRunner, VppLoInterface
+from ipaddress import IPv4Address
+from ipfix import IPFIX, Set, Template, Data, IPFIXDecoder
 from scapy.data import IP_PROTOS
 from scapy.layers.inet import IP, TCP, UDP, ICMP, GRE
 from scapy.layers.inet import IPerror, TCPerror
 from scapy.layers.l2 import Ether
-from scapy.packet import Raw
+from scapy.packet import Raw, bind_layers
 from statistics import variance
 from syslog_rfc5424_parser import SyslogMessage, ParseError
 from syslog_rfc5424_parser.constants import SyslogSeverity
@@ -20,6 +22,7 @@ from util import ppp, pr, ip4_range
 from vpp_acl import AclRule, VppAcl, VppAclInterface
 from vpp_ip_route import VppIpRoute, VppRoutePath
 from vpp_papi import VppEnum
+from vpp_pg_interface import CaptureTimeoutError
 from util import StatsDiff
 
 
@@ -57,6 +60,29 @@ class TestNAT44ED(VppTestCase):
     def plugin_disable(self):
         self.vapi.nat44_ed_plugin_enable_disable(enable=0)
 
+    def port_blocks_enable(self, port_block_size, max_sessions=None):
+        self.plugin_disable()
+        self.vapi.nat44_ed_plugin_enable_disable_v2(
+            sessions=max_sessions or self.max_sessions,
+            port_block_size=port_block_size,
+            enable=1,
+        )
+
+    def expiry_timer_wheel_enable(self):
+        self.plugin_disable()
+        self.vapi.cli(
+            "nat44 plugin enable sessions %d expiry-timer-wheel" % self.max_sessions
+        )
+
+    def n_sessions(self):
+        return self.statistics["/nat44-ed/total-sessions"][:, 0].sum()
+
+    def port_blocks_in_use(self):
+        """ports, blocks and subscribers in use, summed over the threads"""
+        reply = self.vapi.cli("show nat44 addresses")
+        rx = r"thread \d+: (\d+) ports in use in (\d+) blocks of (\d+) subscribers"
+        return [sum(int(m[i]) for m in re.findall(rx, reply)) for i in range(3)]
+
     @property
     def config_flags(self):
         return VppEnum.vl_api_nat_config_flags_t
@@ -1025,6 +1051,51 @@ class TestNAT44ED(VppTestCase):
             self.assertEqual(sd_params.get("XDADDR"), self.pg1.remote_ip4)
             self.assertEqual(sd_params.get("XDPORT"), "%d" % self.tcp_external_port)
 
+    def verify_syslog_port_block(self, data, msgid, port_block_size):
+        message = data.decode("utf-8")
+        try:
+            message = SyslogMessage.parse(message)
+        except ParseError as e:
+            self.logger.error(e)
+            raise
+        else:
+            self.assertEqual(message.severity, SyslogSeverity.info)
+            self.assertEqual(message.appname, "NAT")
+            self.assertEqual(message.msgid, msgid)
+            sd_params = message.sd.get("npblk")
+            self.assertTrue(sd_params is not None)
+            self.assertEqual(sd_params.get("IATYP"), "IPv4")
+            self.assertEqual(sd_params.get("ISADDR"), self.pg0.remote_ip4)
+            self.assertEqual(sd_params.get("XATYP"), "IPv4")
+            self.assertEqual(sd_params.get("XSADDR"), self.nat_addr)
+            first = int(sd_params.get("XSPORT"))
+            last = int(sd_params.get("XEPORT"))
+            self.assertEqual(last - first + 1, port_block_size)
+            self.assertTrue(first <= self.tcp_port_out <= last)
+
+    def expiry_events(self, ipfix):
+        """SDEL syslog messages and IPFIX session delete records on pg3"""
+        sdel = []
+        deleted = []
+        self.vapi.ipfix_flush()
+        while True:
+            try:
+                p = self.pg3.wait_for_packet(1)
+            except CaptureTimeoutError:
+                return sdel, deleted
+            if p.haslayer(IPFIX):
+                if p.haslayer(Template):
+                    ipfix.add_template(p.getlayer(Template))
+                if p.haslayer(Data):
+                    for record in ipfix.decode_data_set(p.getlayer(Set)):
+                        # natEvent NAT44 session delete
+                        if scapy.compat.orb(record[230]) == 5:
+                            deleted.append(record)
+            elif p.haslayer(UDP) and p[UDP].dport == 514:
+                message = SyslogMessage.parse(p[Raw].load.decode("utf-8"))
+                if message.msgid == "SDEL":
+                    sdel.append(message)
+
     def test_icmp_error(self):
         """NAT44ED test ICMP error message with inner header"""
 
@@ -3018,6 +3089,32 @@ class TestNAT44EDMW(TestNAT44ED):
         self.pg_start()
         self.pg1.get_capture(len(pkts))
 
+    def test_expiry_timer_wheel(self):
+        """NAT44ED sessions expire on time with the expiry timer wheel"""
+        self.expiry_timer_wheel_enable()
+        self.nat_add_address(self.nat_addr)
+        self.nat_add_inside_interface(self.pg0)
+        self.nat_add_outside_interface(self.pg1)
+        self.vapi.nat_set_timeouts(
+            udp=5, tcp_established=7440, tcp_transitory=240, icmp=60
+        )
+
+        pkts = self.create_udp_stream(self.pg0, self.pg1, 8)
+        self.send_and_expect(self.pg0, pkts, self.pg1)
+
+        # nothing expires before the timeout
+        self.virtual_sleep(4)
+        self.assertEqual(self.n_sessions(), len(pkts))
+
+        # the idle flows expire without any new flow, the active one stays
+        self.send_and_expect(self.pg0, pkts[:1], self.pg1)
+        self.virtual_sleep(2)
+        self.assertEqual(self.n_sessions(), 1)
+
+        # its timer was armed again for the time left, it expires as well
+        self.virtual_sleep(4)
+        self.assertEqual(self.n_sessions(), 0)
+
     def test_session_rst_timeout(self):
         """NAT44ED session RST timeouts"""
 
@@ -3676,6 +3773,98 @@ class TestNAT44EDMW(TestNAT44ED):
         self.verify_syslog_sess(capture[0][Raw].load, "SDEL")
         self.verify_syslog_sess(capture[1][Raw].load, "SADD")
 
+    # put zzz in front of syslog test name so that it runs as a last test
+    # setting syslog sender cannot be undone and if it is set, it messes
+    # with self.send_and_assert_no_replies functionality
+    def test_zzz_syslog_ipfix_expiry_timer_wheel(self):
+        """NAT44ED Test delete events of sessions expired by the timer wheel"""
+        n_sessions = 4
+        collector_port = 30303
+        bind_layers(UDP, IPFIX, dport=collector_port)
+
+        self.expiry_timer_wheel_enable()
+        self.vapi.syslog_set_filter(self.syslog_severity.SYSLOG_API_SEVERITY_INFO)
+        self.vapi.syslog_set_sender(self.pg3.local_ip4, self.pg3.remote_ip4)
+        self.vapi.set_ipfix_exporter(
+            collector_address=self.pg3.remote_ip4,
+            src_address=self.pg3.local_ip4,
+            path_mtu=512,
+            template_interval=10,
+            collector_port=collector_port,
+        )
+        self.vapi.nat_ipfix_enable_disable(domain_id=10, src_port=20202, enable=1)
+
+        self.nat_add_address(self.nat_addr)
+        self.nat_add_inside_interface(self.pg0)
+        self.nat_add_outside_interface(self.pg1)
+        self.vapi.nat_set_timeouts(
+            udp=5, tcp_established=7440, tcp_transitory=240, icmp=60
+        )
+
+        pkts = self.create_udp_stream(self.pg0, self.pg1, n_sessions)
+        self.send_and_expect(self.pg0, pkts, self.pg1)
+        ipfix = IPFIXDecoder()
+
+        # nothing is deleted before the timeout
+        self.virtual_sleep(4)
+        sdel, deleted = self.expiry_events(ipfix)
+        self.assertEqual(len(sdel), 0)
+        self.assertEqual(len(deleted), 0)
+
+        # the events follow the timeout without any new flow to trigger them
+        self.virtual_sleep(2)
+        sdel, deleted = self.expiry_events(ipfix)
+        self.vapi.nat_ipfix_enable_disable(domain_id=10, src_port=20202, enable=0)
+        self.assertEqual(len(sdel), n_sessions)
+        self.assertEqual(len(deleted), n_sessions)
+        for message in sdel:
+            sd_params = message.sd.get("nsess")
+            self.assertEqual(sd_params.get("ISADDR"), self.pg0.remote_ip4)
+            self.assertEqual(sd_params.get("XSADDR"), self.nat_addr)
+        for record in deleted:
+            # sourceIPv4Address
+            self.assertEqual(record[8], IPv4Address(self.pg0.remote_ip4).packed)
+            # postNATSourceIPv4Address
+            self.assertEqual(record[225], IPv4Address(self.nat_addr).packed)
+        self.assertEqual(self.n_sessions(), 0)
+
+    # put zzz in front of syslog test name so that it runs as a last test
+    # setting syslog sender cannot be undone and if it is set, it messes
+    # with self.send_and_assert_no_replies functionality
+    def test_zzz_syslog_port_block(self):
+        """NAT44ED Test syslog port block assignment and release"""
+        port_block_size = 64
+        self.port_blocks_enable(port_block_size)
+        self.vapi.syslog_set_filter(self.syslog_severity.SYSLOG_API_SEVERITY_INFO)
+        self.vapi.syslog_set_sender(self.pg3.local_ip4, self.pg3.remote_ip4)
+
+        self.nat_add_address(self.nat_addr)
+        self.nat_add_inside_interface(self.pg0)
+        self.nat_add_outside_interface(self.pg1)
+
+        # the first session of the subscriber takes a block
+        p = (
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+            / TCP(sport=self.tcp_port_in, dport=self.tcp_external_port)
+        )
+        capture = self.send_and_expect(self.pg0, p, self.pg1)
+        self.tcp_port_out = capture[0][TCP].sport
+        capture = self.pg3.get_capture(2)
+        logs = {SyslogMessage.parse(c[Raw].load.decode()).msgid: c for c in capture}
+        self.assertEqual(sorted(logs), ["PBADD", "SADD"])
+        self.verify_syslog_port_block(logs["PBADD"][Raw].load, "PBADD", port_block_size)
+        self.assertEqual(self.port_blocks_in_use(), [1, 1, 1])
+
+        # the block is released with its last session
+        self.pg_enable_capture(self.pg_interfaces)
+        self.pg_start()
+        self.nat_add_address(self.nat_addr, is_add=0)
+        capture = self.pg3.get_capture(2)
+        logs = {SyslogMessage.parse(c[Raw].load.decode()).msgid: c for c in capture}
+        self.assertEqual(sorted(logs), ["PBDEL", "SDEL"])
+        self.verify_syslog_port_block(logs["PBDEL"][Raw].load, "PBDEL", port_block_size)
+
     def test_twice_nat_interface_addr(self):
         """NAT44ED Acquire twice NAT addresses from interface"""
         flags = self.config_flags.NAT_IS_TWICE_NAT
@@ -4832,6 +5021,45 @@ class TestNAT44EDMW(TestNAT44ED):
         )
         self.send_and_expect(self.pg0, p, self.pg1)
 
+    def test_new_flows_in_one_frame(self):
+        """NAT44ED new flows and their retransmits in one frame"""
+        self.nat_add_address(self.nat_addr)
+        self.nat_add_inside_interface(self.pg0)
+        self.nat_add_outside_interface(self.pg1)
+        sessions = self.n_sessions()
+
+        # the retransmitted SYNs of some flows among single new flows, the
+        # source address sends them all to the same worker in one frame
+        syn_flows = range(6000, 6004)
+        udp_flows = range(7000, 7016)
+        pkts = []
+        for i in range(3):
+            pkts += [
+                Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+                / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+                / TCP(sport=port, dport=port, flags="S")
+                for port in syn_flows
+            ]
+            pkts += [
+                Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+                / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+                / UDP(sport=port, dport=port)
+                for port in udp_flows[i::3]
+            ]
+        capture = self.send_and_expect(self.pg0, pkts, self.pg1)
+
+        # one session per flow, every packet of a flow translated the same
+        self.assertEqual(self.n_sessions() - sessions, 4 + 16)
+        translations = {}
+        for c in capture:
+            self.assertEqual(c[IP].src, self.nat_addr)
+            l4 = c[TCP] if c.haslayer(TCP) else c[UDP]
+            translations.setdefault(l4.dport, set()).add(l4.sport)
+        self.assertEqual(sorted(translations), [*syn_flows, *udp_flows])
+        for ports in translations.values():
+            self.assertEqual(len(ports), 1)
+        self.assertEqual(len(set.union(*translations.values())), 4 + 16)
+
     def test_dynamic_ports_exhausted(self):
         """NAT44ED dynamic translation test: address ports exhaused"""
 
@@ -4891,6 +5119,223 @@ class TestNAT44EDMW(TestNAT44ED):
 
         self.assertGreaterEqual(err, sessions_per_batch)
 
+    def fill_port_blocks(self, port_block_size):
+        """take every port of a thread with the flows of one subscriber"""
+        batch = 128
+        port_per_thread = (65536 - 1024) // self.vpp_worker_count
+        self.assertEqual(port_per_thread % batch, 0)
+
+        self.port_blocks_enable(port_block_size, port_per_thread + 2 * batch)
+        self.nat_add_address(self.nat_addr)
+        self.nat_add_inside_interface(self.pg0)
+        self.nat_add_outside_interface(self.pg1)
+
+        ports = set()
+        for i in range(port_per_thread // batch):
+            pkts = self.create_udp_stream(
+                self.pg0, self.pg1, batch, base_port=i * batch + 100
+            )
+            capture = self.send_and_expect(self.pg0, pkts, self.pg1)
+            ports.update(c[UDP].sport for c in capture)
+        return ports
+
+    def test_port_blocks_high_utilisation(self):
+        """NAT44ED port blocks: every port of a thread is allocated"""
+        port_block_size = 64
+        port_per_thread = (65536 - 1024) // self.vpp_worker_count
+        out_of_ports = "/err/nat44-ed-in2out-slowpath/out of ports"
+        err = self.statistics.get_err_counter(out_of_ports)
+
+        # each flow got its own port, all of them from the same thread range
+        ports = self.fill_port_blocks(port_block_size)
+        self.assertEqual(len(ports), port_per_thread)
+        self.assertEqual(max(ports) - min(ports), port_per_thread - 1)
+        self.assertEqual(self.statistics.get_err_counter(out_of_ports), err)
+        self.assertEqual(
+            self.port_blocks_in_use(),
+            [port_per_thread, port_per_thread // port_block_size, 1],
+        )
+
+        # no port is left for new flows to the same destination
+        pkts = self.create_udp_stream(self.pg0, self.pg1, 16, base_port=30000)
+        self.send_and_assert_no_replies(self.pg0, pkts)
+        self.assertEqual(self.statistics.get_err_counter(out_of_ports), err + 16)
+
+    def test_port_blocks_sharing(self):
+        """NAT44ED port blocks: ports shared once all blocks are in use"""
+        port_per_thread = (65536 - 1024) // self.vpp_worker_count
+        ports = self.fill_port_blocks(1024)
+
+        # flows to another destination share the ports of the subscriber
+        pkts = [
+            Ether(dst=self.pg0.local_mac, src=self.pg0.remote_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_hosts[1].ip4)
+            / UDP(sport=sport, dport=20)
+            for sport in range(30000, 30064)
+        ]
+        capture = self.send_and_expect(self.pg0, pkts, self.pg1)
+        for c in capture:
+            self.assertEqual(c[IP].src, self.nat_addr)
+            self.assertIn(c[UDP].sport, ports)
+        self.assertEqual(self.port_blocks_in_use()[0], port_per_thread)
+
+        # the replies reach the flows sharing a port
+        pkts = [
+            Ether(dst=self.pg1.local_mac, src=self.pg1.remote_mac)
+            / IP(src=c[IP].dst, dst=self.nat_addr)
+            / UDP(sport=20, dport=c[UDP].sport)
+            for c in capture
+        ]
+        capture = self.send_and_expect(self.pg1, pkts, self.pg0)
+        self.assertEqual(
+            sorted(c[UDP].dport for c in capture), list(range(30000, 30064))
+        )
+
+
+class TestNAT44EDPerThreadFlowHash(TestNAT44EDMW):
+    """NAT44ED MW per-thread flow hash Test Case"""
+
+    def plugin_enable(self, max_sessions=None):
+        max_sessions = max_sessions or self.max_sessions
+        self.vapi.nat44_ed_plugin_enable_disable(
+            sessions=max_sessions,
+            flags=self.nat44_config_flags.NAT44_IS_PER_THREAD_FLOW_HASH,
+            enable=1,
+        )
+
+    @staticmethod
+    def icmp_errors(capture, src_if, router):
+        """errors sent back by a router about the captured packets"""
+        return [
+            Ether(src=src_if.remote_mac, dst=src_if.local_mac)
+            / IP(src=router, dst=c[IP].src)
+            / ICMP(type="dest-unreach", code="port-unreachable")
+            / c[IP:]
+            for c in capture
+        ]
+
+    def test_icmp_error_from_router(self):
+        """NAT44ED per-thread flow hash: ICMP errors from routers"""
+
+        flags = self.vapi.nat44_show_running_config().flags
+        self.assertTrue(flags & self.nat44_config_flags.NAT44_IS_PER_THREAD_FLOW_HASH)
+
+        self.nat_add_address(self.nat_addr)
+        self.nat_add_inside_interface(self.pg0)
+        self.nat_add_outside_interface(self.pg1)
+
+        hosts = [h.ip4 for h in self.pg0.remote_hosts]
+        outside_router = self.pg1.remote_hosts[1].ip4
+
+        for worker, host in enumerate(hosts):
+            out = self.send_and_expect(
+                self.pg0,
+                [
+                    Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+                    / IP(src=host, dst=self.pg1.remote_ip4)
+                    / UDP(sport=sport, dport=20)
+                    for sport in range(1100, 1108)
+                ],
+                self.pg1,
+                worker=worker,
+            )
+            replies = self.send_and_expect(
+                self.pg1,
+                [
+                    Ether(src=self.pg1.remote_mac, dst=self.pg1.local_mac)
+                    / IP(src=self.pg1.remote_ip4, dst=self.nat_addr)
+                    / UDP(sport=20, dport=c[UDP].sport)
+                    for c in out
+                ],
+                self.pg0,
+            )
+
+            # the sessions are owned by the worker the host hashes to, the
+            # errors sent by the other inside hosts are handed off to it
+            for router in hosts:
+                if router == host:
+                    continue
+                capture = self.send_and_expect(
+                    self.pg0, self.icmp_errors(replies, self.pg0, router), self.pg1
+                )
+                for c in capture:
+                    self.assertEqual(c[IP].src, self.nat_addr)
+                    self.assertEqual(c[IP].dst, self.pg1.remote_ip4)
+                    self.assertEqual(c[IPerror].dst, self.nat_addr)
+                    self.assert_packet_checksums_valid(c)
+
+            capture = self.send_and_expect(
+                self.pg1, self.icmp_errors(out, self.pg1, outside_router), self.pg0
+            )
+            for c in capture:
+                self.assertEqual(c[IP].src, outside_router)
+                self.assertEqual(c[IP].dst, host)
+                self.assertEqual(c[IPerror].src, host)
+                self.assert_packet_checksums_valid(c)
+
+    def test_static_mapping_icmp_error(self):
+        """NAT44ED per-thread flow hash: static mapping sessions"""
+
+        external_port = 80
+        local_port = 8080
+        server = self.pg0.remote_ip4
+        inside_router = self.pg0.remote_hosts[1].ip4
+        outside_router = self.pg1.remote_hosts[1].ip4
+
+        self.nat_add_address(self.nat_addr)
+        self.nat_add_static_mapping(
+            server,
+            self.nat_addr,
+            local_port,
+            external_port,
+            proto=IP_PROTOS.tcp,
+        )
+        self.nat_add_inside_interface(self.pg0)
+        self.nat_add_outside_interface(self.pg1)
+
+        # the clients are received by all workers, the sessions are created
+        # by the worker of the static mapping and found from the other ones
+        for worker in range(self.vpp_worker_count):
+            client_port = 2000 + worker
+            p = (
+                Ether(src=self.pg1.remote_mac, dst=self.pg1.local_mac)
+                / IP(src=self.pg1.remote_ip4, dst=self.nat_addr)
+                / TCP(sport=client_port, dport=external_port, flags="S")
+            )
+            rx = self.send_and_expect(self.pg1, [p], self.pg0, worker=worker)
+            self.assertEqual(rx[0][IP].dst, server)
+            self.assertEqual(rx[0][TCP].dport, local_port)
+            self.assert_packet_checksums_valid(rx[0])
+
+            p = (
+                Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+                / IP(src=server, dst=self.pg1.remote_ip4)
+                / TCP(sport=local_port, dport=client_port, flags="SA")
+            )
+            tx = self.send_and_expect(self.pg0, [p], self.pg1, worker=worker)
+            self.assertEqual(tx[0][IP].src, self.nat_addr)
+            self.assertEqual(tx[0][TCP].sport, external_port)
+            self.assert_packet_checksums_valid(tx[0])
+
+            capture = self.send_and_expect(
+                self.pg0, self.icmp_errors(rx, self.pg0, inside_router), self.pg1
+            )
+            self.assertEqual(capture[0][IP].src, self.nat_addr)
+            self.assertEqual(capture[0][IPerror].dst, self.nat_addr)
+            self.assertEqual(capture[0][TCPerror].dport, external_port)
+            self.assert_packet_checksums_valid(capture[0])
+
+            capture = self.send_and_expect(
+                self.pg1, self.icmp_errors(tx, self.pg1, outside_router), self.pg0
+            )
+            self.assertEqual(capture[0][IP].dst, server)
+            self.assertEqual(capture[0][IPerror].src, server)
+            self.assertEqual(capture[0][TCPerror].sport, local_port)
+            self.assert_packet_checksums_valid(capture[0])
+
+        sc = self.statistics["/nat44-ed/total-sessions"]
+        self.assertEqual(sc[:, 0].sum(), self.vpp_worker_count)
+
 
 if __name__ == "__main__":
     unittest.main(testRunner=VppTestRunner)
@@ -149,6 +149,39 @@ class StatsClientTestCase(VppTestCase):
         for i in self.lo_interfaces:
             i.remove_vpp_config()
 
+    def test_node_histograms(self):
+        """Test per-node dispatch histograms"""
+        self.vapi.cli("set statistics node-histograms on")
+        self.create_pg_interfaces(range(2))
+
+        for i in self.pg_interfaces:
+            i.admin_up()
+            i.config_ip4()
+            i.resolve_arp()
+
+        p = [
+            Ether(src=self.pg0.remote_mac, dst=self.pg0.local_mac)
+            / IP(src=self.pg0.remote_ip4, dst=self.pg1.remote_ip4)
+            for i in range(5)
+        ]
+        self.send_and_expect(self.pg0, p, self.pg1)
+
+        names = self.statistics.get_counter("/sys/node/names")
+        index = names.index("ip4-lookup")
+        vectors = self.statistics.get_counter("/sys/node/vectors-per-call")
+        clocks = self.statistics.get_counter("/sys/node/clocks-per-call")
+
+        # element 0 holds the sum of recorded values, then the buckets
+        n_vectors = sum(vectors[t][index][0] for t in range(len(vectors)))
+        n_calls = sum(sum(vectors[t][index][1:]) for t in range(len(vectors)))
+        self.assertEqual(n_vectors, 5)
+        self.assertGreaterEqual(n_calls, 1)
+        self.assertEqual(
+            n_calls, sum(sum(clocks[t][index][1:]) for t in range(len(clocks)))
+        )
+        self.assertIn("ip4-lookup", self.vapi.cli("show statistics node-histograms"))
+        self.vapi.cli("set statistics node-histograms off")
+
     @unittest.skip("Manual only")
     def test_mem_leak(self):
         def loop():
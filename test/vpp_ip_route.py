@@ -625,7 +625,15 @@ class VppIpRouteV2(VppObject):
     """
 
     def __init__(
-        self, test, dest_addr, dest_addr_len, paths, table_id=0, register=True, src=0
+        self,
+        test,
+        dest_addr,
+        dest_addr_len,
+        paths,
+        table_id=0,
+        register=True,
+        src=0,
+        flags=0,
     ):
         self._test = test
         self.paths = paths
@@ -635,6 +643,7 @@ class VppIpRouteV2(VppObject):
         self.stats_index = None
         self.modified = False
         self.src = src
+        self.flags = flags
 
         self.encoded_paths = []
         for path in self.paths:
@@ -657,6 +666,7 @@ class VppIpRouteV2(VppObject):
                 "table_id": self.table_id,
                 "prefix": self.prefix,
                 "src": self.src,
+                "flags": self.flags,
                 "n_paths": len(self.encoded_paths),
                 "paths": self.encoded_paths,
             },
@@ -672,6 +682,7 @@ class VppIpRouteV2(VppObject):
                 "n_paths": len(self.encoded_paths),
                 "paths": self.encoded_paths,
                 "src": self.src,
+                "flags": self.flags,
             },
             is_add=1,
             is_multipath=0,
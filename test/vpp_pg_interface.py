@@ -97,13 +97,15 @@ class VppPGInterface(VppInterface):
             return self._cap_name + "-worker%d" % worker
         return self._cap_name
 
-    def get_input_cli(self, nb_replays=None, worker=None):
+    def get_input_cli(self, nb_replays=None, worker=None, rx_flow_hash=None):
         """return CLI string to load the injected packets"""
         input_cli = "packet-generator new pcap %s source pg%u name %s" % (
             self.get_in_path(worker),
             self.pg_index,
             self.get_cap_name(worker),
         )
+        if rx_flow_hash is not None:
+            input_cli = "%s rx-flow-hash %x" % (input_cli, rx_flow_hash)
         if nb_replays is not None:
             return "%s limit %d" % (input_cli, nb_replays)
         if worker is not None:
@@ -197,17 +199,18 @@ class VppPGInterface(VppInterface):
         self._coalesce_enabled = 0
         self.test.vapi.pg_interface_enable_disable_coalesce(self.sw_if_index, 0)
 
-    def add_stream(self, pkts, nb_replays=None, worker=None):
+    def add_stream(self, pkts, nb_replays=None, worker=None, rx_flow_hash=None):
         """
         Add a stream of packets to this packet-generator
 
         :param pkts: iterable packets
+        :param rx_flow_hash: the flow hash the device computed, if any
 
         """
         wrpcap(self.get_in_path(worker), pkts)
         self.test.register_pcap(self, worker)
         # FIXME this should be an API, but no such exists atm
-        self.test.vapi.cli(self.get_input_cli(nb_replays, worker))
+        self.test.vapi.cli(self.get_input_cli(nb_replays, worker, rx_flow_hash))
 
     def generate_debug_aid(self, kind):
         """Create a hardlink to the out file with a counter and a file